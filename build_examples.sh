@@ -9,3 +9,24 @@ clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/disk_prod
 clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/disk_consumer.cpp -o bin/disk_consumer -DRSP_ENABLE
 clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -O3 -march=native -mtune=native -Iinclude/ examples/speedtest.cpp -o bin/speedtest -DRSP_ENABLE
 clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -O3 -march=native -mtune=native -Iinclude/ examples/speedtest.cpp -o bin/speedtest_no_profiler
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -O3 -march=native -mtune=native -Iinclude/ examples/scaling.cpp -o bin/scaling -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -O3 -march=native -mtune=native -Iinclude/ examples/sink_throughput.cpp -o bin/sink_throughput -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -O3 -march=native -mtune=native -Iinclude/ examples/capture_generator.cpp -o bin/capture_generator -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/shm_producer.cpp -o bin/shm_producer -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/shm_consumer.cpp -o bin/shm_consumer -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/flight_recorder.cpp -o bin/flight_recorder -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -O3 -march=native -mtune=native -Iinclude/ examples/capture_windows.cpp -o bin/capture_windows -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/call_sites.cpp -o bin/call_sites -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/counters.cpp -o bin/counters -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/async_spans.cpp -o bin/async_spans -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/flows.cpp -o bin/flows -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -O2 -Iinclude/ examples/perf_counters.cpp -o bin/perf_counters -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/allocations.cpp -o bin/allocations -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/resource_usage.cpp -o bin/resource_usage -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/typed_metadata.cpp -o bin/typed_metadata -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/string_metadata.cpp -o bin/string_metadata -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/fan_out.cpp -o bin/fan_out -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/rotation.cpp -o bin/rotation -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/prefork.cpp -o bin/prefork -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/socket_sink.cpp -o bin/socket_sink -DRSP_ENABLE
+clang++ -std=c++23 -Wall -Wextra -Werror -pedantic -Iinclude/ examples/sink_placement.cpp -o bin/sink_placement -DRSP_ENABLE
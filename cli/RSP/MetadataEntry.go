@@ -73,8 +73,16 @@ func (rcv *MetadataEntry) MutateValue(n uint64) bool {
 	return rcv._tab.MutateUint64Slot(8, n)
 }
 
+func (rcv *MetadataEntry) Text() []byte {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(10))
+	if o != 0 {
+		return rcv._tab.ByteVector(o + rcv._tab.Pos)
+	}
+	return nil
+}
+
 func MetadataEntryStart(builder *flatbuffers.Builder) {
-	builder.StartObject(3)
+	builder.StartObject(4)
 }
 func MetadataEntryAddTag(builder *flatbuffers.Builder, tag flatbuffers.UOffsetT) {
 	builder.PrependUOffsetTSlot(0, flatbuffers.UOffsetT(tag), 0)
@@ -85,6 +93,9 @@ func MetadataEntryAddType(builder *flatbuffers.Builder, type_ MetadataType) {
 func MetadataEntryAddValue(builder *flatbuffers.Builder, value uint64) {
 	builder.PrependUint64Slot(2, value, 0)
 }
+func MetadataEntryAddText(builder *flatbuffers.Builder, text flatbuffers.UOffsetT) {
+	builder.PrependUOffsetTSlot(3, flatbuffers.UOffsetT(text), 0)
+}
 func MetadataEntryEnd(builder *flatbuffers.Builder) flatbuffers.UOffsetT {
 	return builder.EndObject()
 }
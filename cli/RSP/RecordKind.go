@@ -0,0 +1,35 @@
+// Code generated by the FlatBuffers compiler. DO NOT EDIT.
+
+package RSP
+
+import "strconv"
+
+type RecordKind byte
+
+const (
+	RecordKindSCOPE   RecordKind = 0
+	RecordKindCOUNTER RecordKind = 1
+	RecordKindGAUGE   RecordKind = 2
+	RecordKindINSTANT RecordKind = 3
+)
+
+var EnumNamesRecordKind = map[RecordKind]string{
+	RecordKindSCOPE:   "SCOPE",
+	RecordKindCOUNTER: "COUNTER",
+	RecordKindGAUGE:   "GAUGE",
+	RecordKindINSTANT: "INSTANT",
+}
+
+var EnumValuesRecordKind = map[string]RecordKind{
+	"SCOPE":   RecordKindSCOPE,
+	"COUNTER": RecordKindCOUNTER,
+	"GAUGE":   RecordKindGAUGE,
+	"INSTANT": RecordKindINSTANT,
+}
+
+func (v RecordKind) String() string {
+	if s, ok := EnumNamesRecordKind[v]; ok {
+		return s
+	}
+	return "RecordKind(" + strconv.FormatInt(int64(v), 10) + ")"
+}
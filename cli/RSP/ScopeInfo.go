@@ -129,8 +129,212 @@ func (rcv *ScopeInfo) MetadataLength() int {
 	return 0
 }
 
+func (rcv *ScopeInfo) Kind() RecordKind {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(18))
+	if o != 0 {
+		return RecordKind(rcv._tab.GetByte(o + rcv._tab.Pos))
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateKind(n RecordKind) bool {
+	return rcv._tab.MutateByteSlot(18, byte(n))
+}
+
+func (rcv *ScopeInfo) Value() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(20))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateValue(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(20, n)
+}
+
+func (rcv *ScopeInfo) Flow() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(22))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateFlow(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(22, n)
+}
+
+func (rcv *ScopeInfo) PerfCycles() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(24))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutatePerfCycles(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(24, n)
+}
+
+func (rcv *ScopeInfo) PerfInstructions() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(26))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutatePerfInstructions(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(26, n)
+}
+
+func (rcv *ScopeInfo) PerfLlcMisses() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(28))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutatePerfLlcMisses(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(28, n)
+}
+
+func (rcv *ScopeInfo) PerfBranchMisses() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(30))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutatePerfBranchMisses(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(30, n)
+}
+
+func (rcv *ScopeInfo) AllocsTracked() bool {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(32))
+	if o != 0 {
+		return rcv._tab.GetBool(o + rcv._tab.Pos)
+	}
+	return false
+}
+
+func (rcv *ScopeInfo) MutateAllocsTracked(n bool) bool {
+	return rcv._tab.MutateBoolSlot(32, n)
+}
+
+func (rcv *ScopeInfo) AllocCount() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(34))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateAllocCount(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(34, n)
+}
+
+func (rcv *ScopeInfo) AllocBytes() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(36))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateAllocBytes(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(36, n)
+}
+
+func (rcv *ScopeInfo) AllocSelfCount() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(38))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateAllocSelfCount(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(38, n)
+}
+
+func (rcv *ScopeInfo) AllocSelfBytes() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(40))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateAllocSelfBytes(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(40, n)
+}
+
+func (rcv *ScopeInfo) RusageSampled() bool {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(42))
+	if o != 0 {
+		return rcv._tab.GetBool(o + rcv._tab.Pos)
+	}
+	return false
+}
+
+func (rcv *ScopeInfo) MutateRusageSampled(n bool) bool {
+	return rcv._tab.MutateBoolSlot(42, n)
+}
+
+func (rcv *ScopeInfo) VoluntarySwitches() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(44))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateVoluntarySwitches(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(44, n)
+}
+
+func (rcv *ScopeInfo) InvoluntarySwitches() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(46))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateInvoluntarySwitches(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(46, n)
+}
+
+func (rcv *ScopeInfo) MinorFaults() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(48))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateMinorFaults(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(48, n)
+}
+
+func (rcv *ScopeInfo) MajorFaults() uint64 {
+	o := flatbuffers.UOffsetT(rcv._tab.Offset(50))
+	if o != 0 {
+		return rcv._tab.GetUint64(o + rcv._tab.Pos)
+	}
+	return 0
+}
+
+func (rcv *ScopeInfo) MutateMajorFaults(n uint64) bool {
+	return rcv._tab.MutateUint64Slot(50, n)
+}
+
 func ScopeInfoStart(builder *flatbuffers.Builder) {
-	builder.StartObject(7)
+	builder.StartObject(24)
 }
 func ScopeInfoAddTag(builder *flatbuffers.Builder, tag flatbuffers.UOffsetT) {
 	builder.PrependUOffsetTSlot(0, flatbuffers.UOffsetT(tag), 0)
@@ -156,6 +360,57 @@ func ScopeInfoAddMetadata(builder *flatbuffers.Builder, metadata flatbuffers.UOf
 func ScopeInfoStartMetadataVector(builder *flatbuffers.Builder, numElems int) flatbuffers.UOffsetT {
 	return builder.StartVector(4, numElems, 4)
 }
+func ScopeInfoAddKind(builder *flatbuffers.Builder, kind RecordKind) {
+	builder.PrependByteSlot(7, byte(kind), 0)
+}
+func ScopeInfoAddValue(builder *flatbuffers.Builder, value uint64) {
+	builder.PrependUint64Slot(8, value, 0)
+}
+func ScopeInfoAddFlow(builder *flatbuffers.Builder, flow uint64) {
+	builder.PrependUint64Slot(9, flow, 0)
+}
+func ScopeInfoAddPerfCycles(builder *flatbuffers.Builder, perfCycles uint64) {
+	builder.PrependUint64Slot(10, perfCycles, 0)
+}
+func ScopeInfoAddPerfInstructions(builder *flatbuffers.Builder, perfInstructions uint64) {
+	builder.PrependUint64Slot(11, perfInstructions, 0)
+}
+func ScopeInfoAddPerfLlcMisses(builder *flatbuffers.Builder, perfLlcMisses uint64) {
+	builder.PrependUint64Slot(12, perfLlcMisses, 0)
+}
+func ScopeInfoAddPerfBranchMisses(builder *flatbuffers.Builder, perfBranchMisses uint64) {
+	builder.PrependUint64Slot(13, perfBranchMisses, 0)
+}
+func ScopeInfoAddAllocsTracked(builder *flatbuffers.Builder, allocsTracked bool) {
+	builder.PrependBoolSlot(14, allocsTracked, false)
+}
+func ScopeInfoAddAllocCount(builder *flatbuffers.Builder, allocCount uint64) {
+	builder.PrependUint64Slot(15, allocCount, 0)
+}
+func ScopeInfoAddAllocBytes(builder *flatbuffers.Builder, allocBytes uint64) {
+	builder.PrependUint64Slot(16, allocBytes, 0)
+}
+func ScopeInfoAddAllocSelfCount(builder *flatbuffers.Builder, allocSelfCount uint64) {
+	builder.PrependUint64Slot(17, allocSelfCount, 0)
+}
+func ScopeInfoAddAllocSelfBytes(builder *flatbuffers.Builder, allocSelfBytes uint64) {
+	builder.PrependUint64Slot(18, allocSelfBytes, 0)
+}
+func ScopeInfoAddRusageSampled(builder *flatbuffers.Builder, rusageSampled bool) {
+	builder.PrependBoolSlot(19, rusageSampled, false)
+}
+func ScopeInfoAddVoluntarySwitches(builder *flatbuffers.Builder, voluntarySwitches uint64) {
+	builder.PrependUint64Slot(20, voluntarySwitches, 0)
+}
+func ScopeInfoAddInvoluntarySwitches(builder *flatbuffers.Builder, involuntarySwitches uint64) {
+	builder.PrependUint64Slot(21, involuntarySwitches, 0)
+}
+func ScopeInfoAddMinorFaults(builder *flatbuffers.Builder, minorFaults uint64) {
+	builder.PrependUint64Slot(22, minorFaults, 0)
+}
+func ScopeInfoAddMajorFaults(builder *flatbuffers.Builder, majorFaults uint64) {
+	builder.PrependUint64Slot(23, majorFaults, 0)
+}
 func ScopeInfoEnd(builder *flatbuffers.Builder) flatbuffers.UOffsetT {
 	return builder.EndObject()
 }
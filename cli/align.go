@@ -0,0 +1,516 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"io"
+	"log"
+	"os"
+	"sort"
+	"strings"
+	"time"
+
+	"github.com/jedib0t/go-pretty/v6/table"
+	"github.com/urfave/cli/v2"
+)
+
+// Clock anchors (see ClockAnchor.hpp): a pair of counters on one tick,
+// holding CLOCK_REALTIME and CLOCK_MONOTONIC in nanoseconds.
+const (
+	clockAnchorRealtimeTag  = "rsp.clock.realtime"
+	clockAnchorMonotonicTag = "rsp.clock.monotonic"
+)
+
+// IsClockAnchor reports whether s is half of a clock anchor rather than
+// one of the program's own counters.
+func IsClockAnchor(s ScopeInfo) bool {
+	return s.Kind == RecordKindCounter && (s.Tag == clockAnchorRealtimeTag || s.Tag == clockAnchorMonotonicTag)
+}
+
+type clockAnchor struct {
+	ticks     uint64
+	realtime  int64
+	monotonic int64
+}
+
+// captureClock maps one capture's ticks to wall clock nanoseconds. Ticks
+// are interpolated between the anchors either side (extrapolated past the
+// ends) onto CLOCK_MONOTONIC, which runs smoothly, so the TSC's drift from
+// its nominal frequency is corrected piece by piece. The median distance
+// from CLOCK_MONOTONIC to CLOCK_REALTIME over the anchors then puts that
+// on the wall clock, without following any step the wall clock took.
+type captureClock struct {
+	anchors []clockAnchor // Sorted by ticks.
+	freq    uint64        // Nominal; used with fewer than two anchors.
+	offset  int64         // CLOCK_REALTIME - CLOCK_MONOTONIC.
+
+	// Added on top, to line hosts' wall clocks up with each other.
+	correction int64
+}
+
+func newCaptureClock(anchors []clockAnchor, freq uint64) *captureClock {
+	sort.Slice(anchors, func(i, j int) bool { return anchors[i].ticks < anchors[j].ticks })
+
+	c := &captureClock{freq: freq}
+	for _, a := range anchors {
+		if n := len(c.anchors); n > 0 && (a.ticks == c.anchors[n-1].ticks || a.monotonic <= c.anchors[n-1].monotonic) {
+			continue
+		}
+		c.anchors = append(c.anchors, a)
+	}
+
+	if len(c.anchors) > 0 {
+		offsets := make([]int64, len(c.anchors))
+		for i, a := range c.anchors {
+			offsets[i] = a.realtime - a.monotonic
+		}
+		sort.Slice(offsets, func(i, j int) bool { return offsets[i] < offsets[j] })
+		c.offset = offsets[len(offsets)/2]
+	}
+
+	return c
+}
+
+// Ns is the wall clock time of ticks, in nanoseconds since the Unix epoch.
+// Without anchors, it is just ticks at the nominal frequency.
+func (c *captureClock) Ns(ticks uint64) int64 {
+	n := len(c.anchors)
+	if n == 0 {
+		return int64(float64(ticks)/float64(c.freq)*1e9) + c.correction
+	}
+
+	a, rate := c.anchors[0], 1e9/float64(c.freq)
+	if n > 1 {
+		i := sort.Search(n, func(i int) bool { return c.anchors[i].ticks > ticks })
+		i = min(max(i, 1), n-1)
+
+		a = c.anchors[i-1]
+		b := c.anchors[i]
+		rate = float64(b.monotonic-a.monotonic) / float64(b.ticks-a.ticks)
+	}
+
+	return a.monotonic + int64(float64(int64(ticks-a.ticks))*rate) + c.offset + c.correction
+}
+
+// DriftPPM is how far the tick rate observed between the first and last
+// anchors is from the nominal frequency, in parts per million.
+func (c *captureClock) DriftPPM() float64 {
+	n := len(c.anchors)
+	if n < 2 || c.freq == 0 {
+		return 0
+	}
+
+	first, last := c.anchors[0], c.anchors[n-1]
+	observed := float64(last.ticks-first.ticks) / float64(last.monotonic-first.monotonic) * 1e9
+	return (observed/float64(c.freq) - 1) * 1e6
+}
+
+type tickSpan struct {
+	start, end uint64
+}
+
+// alignInput is one capture to align: a file, or a rotated series.
+type alignInput struct {
+	files []string
+	host  string
+	clock *captureClock
+
+	// First start and last end of each flow's scopes, with --flows.
+	flows map[uint64]tickSpan
+}
+
+// scanAlignInput reads an input once for its host, anchors and flows.
+func scanAlignInput(files []string, withFlows bool) (*alignInput, error) {
+	stream, err := newScopeInfoStreamFiles(files)
+	if err != nil {
+		return nil, err
+	}
+	defer stream.Close()
+
+	in := &alignInput{files: files, host: files[0]}
+	if stream.Header != nil {
+		in.host = stream.Header.Host
+	}
+	if withFlows {
+		in.flows = make(map[uint64]tickSpan)
+	}
+
+	var anchors []clockAnchor
+	halves := make(map[uint64]clockAnchor)
+	var freq uint64
+
+	for {
+		s, err := stream.NextScope()
+		if err == io.EOF {
+			break
+		}
+		if err != nil {
+			return nil, err
+		}
+
+		if freq == 0 {
+			freq = s.MachineNominalFreq
+		}
+
+		if IsClockAnchor(s) {
+			a, ok := halves[s.TicksStart]
+			if s.Tag == clockAnchorRealtimeTag {
+				a.realtime = int64(s.Value)
+			} else {
+				a.monotonic = int64(s.Value)
+			}
+			if ok {
+				a.ticks = s.TicksStart
+				anchors = append(anchors, a)
+				delete(halves, s.TicksStart)
+			} else {
+				halves[s.TicksStart] = a
+			}
+			continue
+		}
+
+		if in.flows != nil && s.Flow != 0 && s.Kind == RecordKindScope {
+			span, ok := in.flows[s.Flow]
+			if !ok {
+				span = tickSpan{start: s.TicksStart, end: s.TicksEnd}
+			}
+			in.flows[s.Flow] = tickSpan{start: min(span.start, s.TicksStart), end: max(span.end, s.TicksEnd)}
+		}
+	}
+
+	if freq == 0 {
+		return nil, fmt.Errorf("%s: no records", files[0])
+	}
+
+	in.clock = newCaptureClock(anchors, freq)
+	return in, nil
+}
+
+type nsSpan struct {
+	start, end int64
+}
+
+// flowOffset estimates how far host b's clock is behind host a's from the
+// flows seen on both, assuming they are calls: the host that spent longer
+// on a flow called the other, so its span contains the other's. Each flow
+// then bounds the correction to b; where the bounds all overlap we take the
+// middle of the overlap (the network's delay either way being about the
+// same), and otherwise the median of each flow's middle.
+func flowOffset(a, b map[uint64]nsSpan) (offset int64, flows int) {
+	lo, hi := int64(-1<<63), int64(1<<63-1)
+	var mids []int64
+
+	for id, sa := range a {
+		sb, ok := b[id]
+		if !ok {
+			continue
+		}
+
+		l, h := sa.start-sb.start, sa.end-sb.end
+		if sb.end-sb.start > sa.end-sa.start {
+			l, h = h, l
+		}
+
+		lo, hi = max(lo, l), min(hi, h)
+		mids = append(mids, l+(h-l)/2)
+	}
+
+	if len(mids) == 0 {
+		return 0, 0
+	}
+
+	if lo <= hi {
+		return lo + (hi-lo)/2, len(mids)
+	}
+
+	sort.Slice(mids, func(i, j int) bool { return mids[i] < mids[j] })
+	return mids[len(mids)/2], len(mids)
+}
+
+// parseOffsets parses --offset host=duration values.
+func parseOffsets(values []string) (map[string]int64, error) {
+	offsets := make(map[string]int64, len(values))
+	for _, v := range values {
+		host, d, ok := strings.Cut(v, "=")
+		if !ok {
+			return nil, fmt.Errorf("bad offset %q, expected host=duration (e.g. db1=-1.5ms)", v)
+		}
+		duration, err := time.ParseDuration(d)
+		if err != nil {
+			return nil, fmt.Errorf("bad offset %q: %w", v, err)
+		}
+		offsets[host] = duration.Nanoseconds()
+	}
+	return offsets, nil
+}
+
+// AlignCaptures puts captures from several hosts on one timeline and
+// writes them out as a columnar capture, in nanoseconds since the Unix
+// epoch (so a nominal frequency of 1 GHz). Each scope gains a Host
+// metadata entry; clock anchors are dropped.
+//
+// Each host's wall clock is taken as is, plus its entry in offsets and,
+// with withFlows, a correction estimated from the flows it shares with
+// other hosts (see flowOffset). Hosts with a user offset, or else the
+// first host, are the reference the others are corrected against.
+func AlignCaptures(args []string, output string, offsets map[string]int64, withFlows bool,
+	chunkRows int) ([]*alignInput, int, error) {
+	series, err := mergeSeries(args)
+	if err != nil {
+		return nil, 0, err
+	}
+
+	names := make([]string, len(series))
+	for i, files := range series {
+		names[i] = files[0]
+	}
+
+	inputs := make([]*alignInput, len(series))
+	err = forEachCapture(names, func(i int, _ string) error {
+		in, err := scanAlignInput(series[i], withFlows)
+		if err != nil {
+			return err
+		}
+		inputs[i] = in
+		return nil
+	})
+	if err != nil {
+		return nil, 0, err
+	}
+
+	var hosts []string
+	corrections := make(map[string]int64)
+	fixed := make(map[string]bool)
+	for _, in := range inputs {
+		if _, ok := corrections[in.host]; !ok {
+			hosts = append(hosts, in.host)
+			corrections[in.host] = 0
+		}
+		if len(in.clock.anchors) == 0 {
+			log.Printf("Warning: %s has no clock anchors; using its ticks at the nominal frequency", in.files[0])
+		}
+	}
+
+	for host, offset := range offsets {
+		if _, ok := corrections[host]; !ok {
+			log.Printf("Warning: no captures from %s, ignoring its offset", host)
+			continue
+		}
+		corrections[host] = offset
+		fixed[host] = true
+	}
+
+	if withFlows && len(hosts) > 1 {
+		//
+		// Each host's flow spans on its own wall clock, then corrections
+		// spread out from the reference hosts, one pair of hosts at a time.
+		//
+
+		spans := make(map[string]map[uint64]nsSpan)
+		for _, in := range inputs {
+			m := spans[in.host]
+			if m == nil {
+				m = make(map[uint64]nsSpan)
+				spans[in.host] = m
+			}
+			for id, t := range in.flows {
+				s := nsSpan{start: in.clock.Ns(t.start), end: in.clock.Ns(t.end)}
+				if prev, ok := m[id]; ok {
+					s = nsSpan{start: min(prev.start, s.start), end: max(prev.end, s.end)}
+				}
+				m[id] = s
+			}
+		}
+
+		if len(fixed) == 0 {
+			fixed[hosts[0]] = true
+		}
+
+		queue := make([]string, 0, len(hosts))
+		for _, h := range hosts {
+			if fixed[h] {
+				queue = append(queue, h)
+			}
+		}
+
+		for len(queue) > 0 {
+			a := queue[0]
+			queue = queue[1:]
+
+			for _, b := range hosts {
+				if fixed[b] {
+					continue
+				}
+				offset, flows := flowOffset(spans[a], spans[b])
+				if flows == 0 {
+					continue
+				}
+				corrections[b] = corrections[a] + offset
+				fixed[b] = true
+				queue = append(queue, b)
+				log.Printf("%s: %+.3f ms relative to %s, from %d flows", b, float64(offset)/1e6, a, flows)
+			}
+		}
+
+		for _, h := range hosts {
+			if !fixed[h] {
+				log.Printf("Warning: %s shares no flows with the other hosts; leaving its clock as is", h)
+			}
+		}
+	}
+
+	for _, in := range inputs {
+		in.clock.correction = corrections[in.host]
+	}
+
+	f, err := os.Create(output)
+	if err != nil {
+		return nil, 0, err
+	}
+	defer f.Close()
+
+	cw, err := newColumnarWriter(f, chunkRows)
+	if err != nil {
+		return nil, 0, err
+	}
+
+	var streams []*ScopeInfoStream
+	defer func() {
+		for _, stream := range streams {
+			stream.Close()
+		}
+	}()
+
+	merged := make([]*mergeInput, len(inputs))
+	for i, in := range inputs {
+		stream, err := newScopeInfoStreamFiles(in.files)
+		if err != nil {
+			return nil, 0, err
+		}
+		streams = append(streams, stream)
+
+		merged[i] = &mergeInput{
+			name:  in.files[0],
+			order: i,
+			next: func() (ScopeInfo, error) {
+				for {
+					s, err := stream.NextScope()
+					if err != nil {
+						return s, err
+					}
+					if IsClockAnchor(s) {
+						continue
+					}
+
+					start, end := in.clock.Ns(s.TicksStart), in.clock.Ns(s.TicksEnd)
+					s.TicksStart, s.TicksEnd = uint64(start), uint64(max(end, start))
+					s.MachineNominalFreq = 1e9
+					s.ElapsedSeconds = float64(s.TicksEnd-s.TicksStart) / 1e9
+
+					if s.Kind == RecordKindScope {
+						host := MetadataEntry{Tag: "Host", Type: MetadataTypeStringID, Text: in.host}
+						s.Metadata = append(s.Metadata[:len(s.Metadata):len(s.Metadata)], host)
+					}
+					return s, nil
+				}
+			},
+		}
+	}
+
+	records, err := mergeRecords(merged, cw)
+	if err != nil {
+		return nil, records, err
+	}
+
+	if err := cw.finish(); err != nil {
+		return nil, records, err
+	}
+
+	return inputs, records, f.Close()
+}
+
+func Align(args []string, output string, offsets map[string]int64, withFlows bool, chunkRows int) {
+	inputs, records, err := AlignCaptures(args, output, offsets, withFlows, chunkRows)
+	if err != nil {
+		os.Remove(output)
+		log.Fatal(err)
+	}
+
+	t := table.NewWriter()
+	t.SetOutputMirror(os.Stdout)
+	t.AppendHeader(table.Row{"Capture", "Host", "Anchors", "Drift (ppm)", "Correction (ms)"})
+
+	for _, in := range inputs {
+		t.AppendRow(table.Row{
+			in.files[0],
+			in.host,
+			len(in.clock.anchors),
+			fmt.Sprintf("%+.2f", in.clock.DriftPPM()),
+			fmt.Sprintf("%+.3f", float64(in.clock.correction)/1e6),
+		})
+	}
+
+	t.Render()
+
+	log.Printf("Aligned %d records from %d captures -> %s", records, len(inputs), output)
+}
+
+var AlignCommand = &cli.Command{
+	Name:      "align",
+	Usage:     "Put captures from several hosts on one wall clock timeline, correcting for clock drift.",
+	ArgsUsage: "-o <output> <capture>...",
+	Flags: []cli.Flag{
+		&cli.StringFlag{
+			Name:     "output",
+			Aliases:  []string{"o"},
+			Usage:    "Columnar capture to write.",
+			Required: true,
+		},
+		&cli.StringSliceFlag{
+			Name:  "offset",
+			Usage: "Shift a host's clock, e.g. 'db1=-1.5ms' (repeatable).",
+		},
+		&cli.BoolFlag{
+			Name:  "flows",
+			Usage: "Estimate each host's clock offset from the flows it shares with the others.",
+		},
+		&cli.IntFlag{
+			Name:  "chunk-rows",
+			Usage: "Maximum records per tag chunk.",
+			Value: columnarChunkRows,
+		},
+	},
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 1 {
+			return fmt.Errorf("missing filename\nUsage: rsp align -o <output> [--offset host=duration] [--flows] <capture>...")
+		}
+
+		if c.Int("chunk-rows") < 1 {
+			return fmt.Errorf("--chunk-rows must be at least 1")
+		}
+
+		offsets, err := parseOffsets(c.StringSlice("offset"))
+		if err != nil {
+			return err
+		}
+
+		Align(c.Args().Slice(), c.String("output"), offsets, c.Bool("flows"), c.Int("chunk-rows"))
+
+		return nil
+	},
+}
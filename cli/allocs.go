@@ -0,0 +1,168 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"io"
+	"log"
+	"os"
+	"sort"
+
+	"github.com/jedib0t/go-pretty/v6/table"
+	"github.com/urfave/cli/v2"
+)
+
+// ScopeAllocationStats sums the allocation counts of one scope's records
+// (see rsp::EnableAllocationTracking).
+type ScopeAllocationStats struct {
+	Tag       string
+	Calls     int
+	Count     uint64
+	Bytes     uint64
+	SelfCount uint64
+	SelfBytes uint64
+}
+
+func (a *ScopeAllocationStats) perCall(v uint64) float64 {
+	return float64(v) / float64(a.Calls)
+}
+
+// SelectAllocations sums the allocation counts of every scope record that
+// was tracked, for the scopes in scopes (all of them if empty), ranked by
+// allocations per call - inclusive of nested scopes, or exclusive of them
+// with self set.
+func SelectAllocations(filename string, scopes []string, self bool) ([]*ScopeAllocationStats, error) {
+	wanted := make(map[string]struct{}, len(scopes))
+	for _, s := range scopes {
+		wanted[s] = struct{}{}
+	}
+
+	stream, err := NewScopeInfoStream(filename)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open scope stream: %w", err)
+	}
+	defer stream.Close()
+
+	byTag := make(map[string]*ScopeAllocationStats)
+
+	for {
+		s, err := stream.NextScope()
+		if err != nil {
+			if err == io.EOF {
+				break
+			}
+			return nil, fmt.Errorf("failed reading record: %w", err)
+		}
+
+		if s.Kind != RecordKindScope || !s.Allocs.Tracked {
+			continue
+		}
+
+		if _, ok := wanted[s.Tag]; !ok && len(scopes) > 0 {
+			continue
+		}
+
+		a, ok := byTag[s.Tag]
+		if !ok {
+			a = &ScopeAllocationStats{Tag: s.Tag}
+			byTag[s.Tag] = a
+		}
+
+		a.Calls++
+		a.Count += s.Allocs.Count
+		a.Bytes += s.Allocs.Bytes
+		a.SelfCount += s.Allocs.SelfCount
+		a.SelfBytes += s.Allocs.SelfBytes
+	}
+
+	result := make([]*ScopeAllocationStats, 0, len(byTag))
+	for _, a := range byTag {
+		result = append(result, a)
+	}
+
+	rank := func(a *ScopeAllocationStats) float64 {
+		if self {
+			return a.perCall(a.SelfCount)
+		}
+		return a.perCall(a.Count)
+	}
+
+	sort.Slice(result, func(i, j int) bool {
+		ri, rj := rank(result[i]), rank(result[j])
+		if ri != rj {
+			return ri > rj
+		}
+		return result[i].Tag < result[j].Tag
+	})
+
+	return result, nil
+}
+
+func PrintAllocations(stats []*ScopeAllocationStats) {
+	t := table.NewWriter()
+	t.SetOutputMirror(os.Stdout)
+	t.AppendHeader(table.Row{"Scope", "Calls", "Allocs/call", "Bytes/call", "Self allocs/call", "Self bytes/call",
+		"Total allocs", "Total bytes"})
+
+	for _, a := range stats {
+		t.AppendRow(table.Row{
+			a.Tag,
+			a.Calls,
+			fmt.Sprintf("%.2f", a.perCall(a.Count)),
+			fmt.Sprintf("%.1f", a.perCall(a.Bytes)),
+			fmt.Sprintf("%.2f", a.perCall(a.SelfCount)),
+			fmt.Sprintf("%.1f", a.perCall(a.SelfBytes)),
+			a.Count,
+			a.Bytes,
+		})
+	}
+
+	t.Render()
+}
+
+var AllocsCommand = &cli.Command{
+	Name:      "allocs",
+	Usage:     "Rank scopes by heap allocations per call (see rsp::EnableAllocationTracking).",
+	ArgsUsage: "<filename> [scope...]",
+	Flags: []cli.Flag{
+		&cli.BoolFlag{
+			Name:  "self",
+			Usage: "Rank by allocations made by the scope itself, excluding nested scopes.",
+		},
+	},
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 1 {
+			return fmt.Errorf("missing filename\nUsage: rsp allocs [--self] <filename> [scope...]")
+		}
+
+		filename := c.Args().Get(0)
+
+		stats, err := SelectAllocations(filename, c.Args().Slice()[1:], c.Bool("self"))
+		if err != nil {
+			log.Fatal(err)
+		}
+
+		if len(stats) == 0 {
+			log.Fatalf("No scopes with allocation counts found in %s (was tracking enabled?)", filename)
+		}
+
+		PrintAllocations(stats)
+
+		return nil
+	},
+}
@@ -0,0 +1,193 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"io"
+	"log"
+	"os"
+	"testing"
+
+	"github.com/jedib0t/go-pretty/v6/table"
+	"github.com/urfave/cli/v2"
+)
+
+// benchCase is a single ingestion path to benchmark. Each op processes the
+// whole capture (or, for the in-memory cases, the whole selected scope), so
+// throughput and allocations can be normalized by the record count.
+type benchCase struct {
+	name    string
+	records int
+	bytes   int64
+	fn      func(b *testing.B)
+}
+
+// mostFrequentScope picks the scope with the most entries, so that the
+// selection/percentile benchmarks have the most work to do.
+func mostFrequentScope(counts map[string]int) string {
+	best, bestCount := "", -1
+	for tag, n := range counts {
+		if n > bestCount || (n == bestCount && tag < best) {
+			best, bestCount = tag, n
+		}
+	}
+	return best
+}
+
+func Bench(filename string) {
+	st, err := os.Stat(filename)
+	if err != nil {
+		log.Fatal(err)
+	}
+
+	counts, err := CountByScope(filename)
+	if err != nil {
+		log.Fatal(err)
+	}
+
+	total := 0
+	for _, n := range counts {
+		total += n
+	}
+
+	if total == 0 {
+		log.Fatalf("No records found in %s", filename)
+	}
+
+	scope := mostFrequentScope(counts)
+	selected, err := SelectScopes(filename, []string{scope})
+	if err != nil {
+		log.Fatal(err)
+	}
+
+	timesMs := ExtractTimesAsMilliseconds(selected[scope])
+
+	log.Printf("Benchmarking %s: %d bytes, %d records, %d scopes (hot scope %q with %d entries)",
+		filename, st.Size(), total, len(counts), scope, counts[scope])
+
+	var cases []benchCase
+
+	stream, err := NewScopeInfoStream(filename)
+	if err != nil {
+		log.Fatal(err)
+	}
+	isFlatBufferCapture := stream.hasFlatBuffers()
+	stream.Close()
+
+	// BatchReadCapture hands back the raw FlatBuffers, which block, columnar
+	// and flight recorder captures don't have.
+	if isFlatBufferCapture {
+		cases = append(cases, benchCase{"BatchReadCapture", total, st.Size(), func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				if _, err := BatchReadCapture(filename); err != nil {
+					b.Fatal(err)
+				}
+			}
+		}})
+	}
+
+	cases = append(cases, []benchCase{
+		{"NewScopeInfoStream", total, st.Size(), func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				stream, err := NewScopeInfoStream(filename)
+				if err != nil {
+					b.Fatal(err)
+				}
+				for {
+					if _, err := stream.NextScope(); err != nil {
+						if err == io.EOF {
+							break
+						}
+						b.Fatal(err)
+					}
+				}
+				stream.Close()
+			}
+		}},
+		{"SelectScopes", total, st.Size(), func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				if _, err := SelectScopes(filename, []string{scope}); err != nil {
+					b.Fatal(err)
+				}
+			}
+		}},
+		{"CountByScope", total, st.Size(), func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				if _, err := CountByScope(filename); err != nil {
+					b.Fatal(err)
+				}
+			}
+		}},
+		{"ComputePercentiles", len(timesMs), 0, func(b *testing.B) {
+			for i := 0; i < b.N; i++ {
+				ComputePercentiles(timesMs)
+			}
+		}},
+	}...)
+
+	t := table.NewWriter()
+	t.SetOutputMirror(os.Stdout)
+	t.AppendHeader(table.Row{"Benchmark", "Iterations", "ms/op", "MB/s", "Records/s", "Allocs/record", "Bytes/record"})
+
+	for _, c := range cases {
+		res := testing.Benchmark(func(b *testing.B) {
+			b.ReportAllocs()
+			c.fn(b)
+		})
+
+		secondsPerOp := float64(res.NsPerOp()) / 1e9
+		records := float64(c.records)
+
+		mbPerSec := "-"
+		if c.bytes > 0 && secondsPerOp > 0 {
+			mbPerSec = fmt.Sprintf("%.1f", float64(c.bytes)/(1024*1024)/secondsPerOp)
+		}
+
+		recordsPerSec := 0.0
+		if secondsPerOp > 0 {
+			recordsPerSec = records / secondsPerOp
+		}
+
+		t.AppendRow(table.Row{
+			c.name,
+			res.N,
+			fmt.Sprintf("%.3f", secondsPerOp*1e3),
+			mbPerSec,
+			fmt.Sprintf("%.0f", recordsPerSec),
+			fmt.Sprintf("%.2f", float64(res.AllocsPerOp())/records),
+			fmt.Sprintf("%.1f", float64(res.AllocedBytesPerOp())/records),
+		})
+	}
+
+	t.Render()
+}
+
+var BenchCommand = &cli.Command{
+	Name:      "bench",
+	Usage:     "Benchmark the capture ingestion paths against a capture file (see examples/capture_generator.cpp).",
+	ArgsUsage: "<filename>",
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 1 {
+			return fmt.Errorf("missing filename\nUsage: rsp bench <filename>")
+		}
+
+		Bench(c.Args().Get(0))
+
+		return nil
+	},
+}
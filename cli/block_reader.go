@@ -0,0 +1,499 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+	"math"
+)
+
+// Decoder for the block capture format written by rsp::BlockDiskSink (see
+// include/afware/rsp/BlockDiskSink.hpp for the layout).
+
+var (
+	blockCaptureMagic   = []byte("RSPBLK02")
+	blockCaptureMagicV1 = []byte("RSPBLK01") // Before the layout field; see below.
+)
+
+const (
+	blockHeaderSize   = 16
+	blockHeaderSizeV1 = 12
+	blockLayout       = 1
+
+	// No writer makes blocks anywhere near this big; a header claiming one
+	// is corrupt, and mustn't have us allocate gigabytes to find out.
+	maxBlockSize = 64 << 20
+
+	// Flags beyond LZ4 only mean something in RSPBLK01 blocks, which told
+	// record layouts apart by them. Layout 1 is all of them set.
+	blockFlagLZ4         = 1
+	blockFlagRecordKinds = 2
+	blockFlagFlows       = 4
+	blockFlagPerf        = 8
+	blockFlagAllocs      = 16
+	blockFlagRusage      = 32
+	blockFlagSchemas     = 64
+	blockFlagStrings     = 128
+
+	blockLayout1Flags = blockFlagRecordKinds | blockFlagFlows | blockFlagPerf | blockFlagAllocs |
+		blockFlagRusage | blockFlagSchemas | blockFlagStrings
+)
+
+var errCorruptBlock = errors.New("corrupt capture block")
+
+// blockReader yields the records of a block capture, a block at a time.
+type blockReader struct {
+	r          io.Reader
+	v1         bool // An RSPBLK01 capture.
+	header     [blockHeaderSize]byte
+	stored     []byte
+	raw        []byte
+	records    []ScopeInfo
+	next       int
+	tags, keys []string
+	schemas    [][]blockSchemaField
+	strings    []string // Interned strings, by block index.
+	process    uint64   // The writer's pid, from the block header; 0 if unknown.
+}
+
+// blockSchemaField is one field of a typed metadata schema: its key in the
+// block's key dictionary and its type.
+type blockSchemaField struct {
+	key uint64
+	typ MetadataType
+}
+
+func newBlockReader(r io.Reader, v1 bool) *blockReader {
+	return &blockReader{r: r, v1: v1}
+}
+
+func (b *blockReader) Next() (ScopeInfo, error) {
+	for b.next >= len(b.records) {
+		if err := b.readBlock(); err != nil {
+			return ScopeInfo{}, err
+		}
+	}
+
+	s := b.records[b.next]
+	b.next++
+	return s, nil
+}
+
+func (b *blockReader) readBlock() error {
+	header := b.header[:]
+	if b.v1 {
+		header = header[:blockHeaderSizeV1]
+	}
+
+	if _, err := io.ReadFull(b.r, header); err != nil {
+		if err == io.ErrUnexpectedEOF {
+			return fmt.Errorf("truncated block header: %w", err)
+		}
+		return err
+	}
+
+	rawSize := binary.LittleEndian.Uint32(header[0:])
+	storedSize := binary.LittleEndian.Uint32(header[4:])
+	flags := header[8]
+	b.process = uint64(header[9]) | uint64(header[10])<<8 | uint64(header[11])<<16
+
+	if !b.v1 {
+		layout := binary.LittleEndian.Uint16(header[12:])
+		if layout != blockLayout {
+			return fmt.Errorf("unsupported block layout %d", layout)
+		}
+
+		// Header fields from later writers.
+		extension := int64(binary.LittleEndian.Uint16(header[14:]))
+		if n, err := io.CopyN(io.Discard, b.r, extension); n < extension {
+			return fmt.Errorf("truncated block header: %w", err)
+		}
+
+		flags = flags&blockFlagLZ4 | blockLayout1Flags
+	}
+
+	if rawSize > maxBlockSize || storedSize > maxBlockSize {
+		return errCorruptBlock
+	}
+
+	b.stored = grow(b.stored, int(storedSize))
+	if _, err := io.ReadFull(b.r, b.stored); err != nil {
+		return fmt.Errorf("truncated block: %w", err)
+	}
+
+	payload := b.stored
+	if flags&blockFlagLZ4 != 0 {
+		b.raw = grow(b.raw, int(rawSize))
+		if err := lz4DecompressBlock(b.stored, b.raw); err != nil {
+			return err
+		}
+		payload = b.raw
+	} else if storedSize != rawSize {
+		return errCorruptBlock
+	}
+
+	return b.decode(payload, flags)
+}
+
+func grow(buf []byte, n int) []byte {
+	if cap(buf) < n {
+		return make([]byte, n)
+	}
+	return buf[:n]
+}
+
+// blockDecoder walks a decompressed block payload.
+type blockDecoder struct {
+	buf []byte
+	pos int
+	err error
+}
+
+func (d *blockDecoder) varint() uint64 {
+	v, n := binary.Uvarint(d.buf[d.pos:])
+	if n <= 0 {
+		d.err = errCorruptBlock
+		d.pos = len(d.buf)
+		return 0
+	}
+	d.pos += n
+	return v
+}
+
+func (d *blockDecoder) zigzag() int64 {
+	v := d.varint()
+	return int64(v>>1) ^ -int64(v&1)
+}
+
+func (d *blockDecoder) bytes(n uint64) []byte {
+	if n > uint64(len(d.buf)-d.pos) {
+		d.err = errCorruptBlock
+		d.pos = len(d.buf)
+		return nil
+	}
+	s := d.buf[d.pos : d.pos+int(n)]
+	d.pos += int(n)
+	return s
+}
+
+func (d *blockDecoder) strings(dst []string) []string {
+	n := d.varint()
+	dst = dst[:0]
+	for i := uint64(0); i < n && d.err == nil; i++ {
+		dst = append(dst, string(d.bytes(d.varint())))
+	}
+	return dst
+}
+
+// metadataValue reproduces the 8 byte payload a FlatBuffer capture would
+// carry: the value's own width, zero extended.
+func (d *blockDecoder) metadataValue(typ byte) uint64 {
+	switch MetadataType(typ) {
+	case MetadataTypeUnset:
+		return 0
+	case MetadataTypeInt8:
+		return uint64(uint8(d.zigzag()))
+	case MetadataTypeInt16:
+		return uint64(uint16(d.zigzag()))
+	case MetadataTypeInt32:
+		return uint64(uint32(d.zigzag()))
+	case MetadataTypeInt64:
+		return uint64(d.zigzag())
+	case MetadataTypeDouble, MetadataTypeFloat:
+		return binary.LittleEndian.Uint64(d.bytes(8))
+	default:
+		if MetadataType(typ) > MetadataTypeUint64 {
+			d.err = errCorruptBlock
+			return 0
+		}
+		return d.varint()
+	}
+}
+
+// metadataEntry decodes one value of type typ. Strings are written out
+// (STRING) or refer to the block's dictionary (STRING_ID, whose Value is
+// then the block index).
+func (d *blockDecoder) metadataEntry(tag string, typ MetadataType, strings []string) MetadataEntry {
+	m := MetadataEntry{Tag: tag, Type: typ}
+	switch typ {
+	case MetadataTypeString:
+		m.Text = string(d.bytes(d.varint()))
+		if len(m.Text) > 8 {
+			d.err = errCorruptBlock
+		}
+		m.Value = packMetadataString(m.Text)
+	case MetadataTypeStringID:
+		m.Value = d.varint()
+		if m.Value >= uint64(len(strings)) {
+			d.err = errCorruptBlock
+			return m
+		}
+		m.Text = strings[m.Value]
+	default:
+		m.Value = d.metadataValue(byte(typ))
+	}
+	return m
+}
+
+func (b *blockReader) decode(payload []byte, flags byte) error {
+	d := blockDecoder{buf: payload}
+
+	freq := d.varint()
+	count := d.varint()
+	ticks := d.varint()
+	b.tags = d.strings(b.tags)
+	b.keys = d.strings(b.keys)
+
+	b.schemas = b.schemas[:0]
+	if flags&blockFlagSchemas != 0 {
+		n := d.varint()
+		for j := uint64(0); j < n && d.err == nil; j++ {
+			fieldCount := d.varint()
+			if fieldCount > math.MaxUint8 {
+				return errCorruptBlock
+			}
+			fields := make([]blockSchemaField, fieldCount)
+			for k := range fields {
+				fields[k].key = d.varint()
+				typ := d.bytes(1)
+				if d.err != nil || fields[k].key >= uint64(len(b.keys)) {
+					return errCorruptBlock
+				}
+				fields[k].typ = MetadataType(typ[0])
+			}
+			b.schemas = append(b.schemas, fields)
+		}
+	}
+
+	b.strings = b.strings[:0]
+	if flags&blockFlagStrings != 0 {
+		b.strings = d.strings(b.strings)
+	}
+
+	if d.err != nil || count > uint64(len(payload)) {
+		return errCorruptBlock
+	}
+
+	b.records = b.records[:0]
+	b.next = 0
+
+	for i := uint64(0); i < count; i++ {
+		tagID := d.varint()
+		ticks += uint64(d.zigzag())
+
+		var duration, metadataCount, value, flow uint64
+		var perf PerfCounts
+		var allocs ScopeAllocations
+		var rusage ResourceUsage
+		var schema []blockSchemaField
+		kind := RecordKindScope
+
+		if flags&blockFlagRecordKinds != 0 {
+			header := d.varint()
+			kind = RecordKind(header & 3)
+
+			// Each optional field the block's writer knew about has a
+			// presence bit, in flag order, between the kind and the
+			// metadata count.
+			bit := 2
+			present := func(flag byte) bool {
+				if flags&flag == 0 {
+					return false
+				}
+				bit++
+				return header>>(bit-1)&1 != 0
+			}
+
+			if present(blockFlagFlows) {
+				flow = d.varint()
+			}
+
+			if present(blockFlagPerf) {
+				perf.Cycles = d.varint()
+				perf.Instructions = d.varint()
+				perf.LLCMisses = d.varint()
+				perf.BranchMisses = d.varint()
+			}
+
+			if present(blockFlagAllocs) {
+				allocs.Tracked = true
+				allocs.Count = d.varint()
+				allocs.Bytes = d.varint()
+				allocs.SelfCount = d.varint()
+				allocs.SelfBytes = d.varint()
+			}
+
+			if present(blockFlagRusage) {
+				rusage.Sampled = true
+				rusage.VoluntarySwitches = d.varint()
+				rusage.InvoluntarySwitches = d.varint()
+				rusage.MinorFaults = d.varint()
+				rusage.MajorFaults = d.varint()
+			}
+
+			hasSchema := present(blockFlagSchemas)
+
+			metadataCount = header >> bit
+
+			switch kind {
+			case RecordKindScope:
+				duration = d.varint()
+				if hasSchema {
+					id := d.varint()
+					if d.err != nil || id >= uint64(len(b.schemas)) {
+						return errCorruptBlock
+					}
+					schema = b.schemas[id]
+				}
+			case RecordKindCounter:
+				value = uint64(d.zigzag())
+			case RecordKindGauge:
+				value = d.metadataValue(byte(MetadataTypeDouble))
+			}
+		} else {
+			duration = d.varint()
+			metadataCount = d.varint()
+		}
+
+		metadataCount += uint64(len(schema))
+
+		if d.err != nil || tagID >= uint64(len(b.tags)) || metadataCount > math.MaxUint8 ||
+			(kind != RecordKindScope && metadataCount != 0) {
+			return errCorruptBlock
+		}
+
+		s := ScopeInfo{
+			Tag:                b.tags[tagID],
+			Kind:               kind,
+			Value:              value,
+			Flow:               flow,
+			Perf:               perf,
+			Allocs:             allocs,
+			Rusage:             rusage,
+			TicksStart:         ticks,
+			TicksEnd:           ticks + duration,
+			MachineNominalFreq: freq,
+			MaxBufferSize:      metadataCount,
+			MaxOffset:          byte(metadataCount),
+			Metadata:           make([]MetadataEntry, metadataCount),
+			Process:            b.process,
+		}
+
+		if freq > 0 {
+			s.ElapsedSeconds = float64(duration) / float64(freq)
+		}
+
+		// Typed metadata comes first, values only, in schema order.
+		for j, field := range schema {
+			s.Metadata[j] = d.metadataEntry(b.keys[field.key], field.typ, b.strings)
+		}
+
+		for j := len(schema); j < len(s.Metadata); j++ {
+			keyID := d.varint()
+			typ := d.bytes(1)
+			if d.err != nil || keyID >= uint64(len(b.keys)) {
+				return errCorruptBlock
+			}
+			s.Metadata[j] = d.metadataEntry(b.keys[keyID], MetadataType(typ[0]), b.strings)
+		}
+
+		if d.err != nil {
+			return errCorruptBlock
+		}
+
+		b.records = append(b.records, s)
+	}
+
+	return nil
+}
+
+// lz4DecompressBlock decodes an LZ4 block (no frame) into dst, which must be
+// exactly the uncompressed size.
+func lz4DecompressBlock(src, dst []byte) error {
+	var ip, op int
+
+	length := func(n int) (int, bool) {
+		if n != 15 {
+			return n, true
+		}
+		for {
+			if ip >= len(src) {
+				return 0, false
+			}
+			b := src[ip]
+			ip++
+			n += int(b)
+			if b != 255 {
+				return n, true
+			}
+		}
+	}
+
+	for ip < len(src) {
+		token := src[ip]
+		ip++
+
+		literals, ok := length(int(token >> 4))
+		if !ok || literals > len(src)-ip || literals > len(dst)-op {
+			return errCorruptBlock
+		}
+		op += copy(dst[op:], src[ip:ip+literals])
+		ip += literals
+
+		// The last sequence is literals only.
+		if ip == len(src) {
+			break
+		}
+
+		if ip+2 > len(src) {
+			return errCorruptBlock
+		}
+		offset := int(src[ip]) | int(src[ip+1])<<8
+		ip += 2
+
+		matchLen, ok := length(int(token & 15))
+		if !ok {
+			return errCorruptBlock
+		}
+		matchLen += 4
+
+		if offset == 0 || offset > op || matchLen > len(dst)-op {
+			return errCorruptBlock
+		}
+
+		// Matches may overlap their own output, so copy forwards byte-wise
+		// when they do.
+		from := op - offset
+		if offset >= matchLen {
+			op += copy(dst[op:op+matchLen], dst[from:from+matchLen])
+		} else {
+			for k := 0; k < matchLen; k++ {
+				dst[op] = dst[from+k]
+				op++
+			}
+		}
+	}
+
+	if op != len(dst) {
+		return errCorruptBlock
+	}
+
+	return nil
+}
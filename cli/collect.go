@@ -0,0 +1,447 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"bytes"
+	"errors"
+	"fmt"
+	"io"
+	"log"
+	"net"
+	"os"
+	"os/signal"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"syscall"
+	"time"
+
+	"github.com/jedib0t/go-pretty/v6/table"
+	"github.com/urfave/cli/v2"
+)
+
+// The collector for rsp::UnixSocketSink: every connection is a framed
+// capture stream from one process. Records from all of them are funnelled
+// into one goroutine, which writes rotating columnar captures and/or keeps
+// live per-scope histograms.
+
+type CollectOptions struct {
+	Socket         string
+	Output         string // Empty for none.
+	RotateBytes    int64
+	RotateInterval time.Duration
+	MaxSegments    int
+	ChunkRows      int
+	Histogram      time.Duration // 0 for none.
+}
+
+// readConnection decodes one process' stream onto records, tagging each
+// record with the process from the stream's header.
+func readConnection(conn net.Conn, records chan<- ScopeInfo) {
+	defer conn.Close()
+
+	magic := make([]byte, len(framedCaptureMagic))
+	if _, err := io.ReadFull(conn, magic); err != nil || !bytes.Equal(magic, framedCaptureMagic) {
+		log.Printf("Ignoring a connection that isn't a capture stream")
+		return
+	}
+
+	header, err := readCaptureHeader(conn)
+	if err != nil {
+		log.Printf("Ignoring a connection: %v", err)
+		return
+	}
+
+	log.Printf("pid %d connected (%s)", header.Process, header.Host)
+
+	fr := newFramedReader(conn, header.Size, -1)
+	strings := make(stringResolver)
+	count := 0
+
+	for {
+		fb, err := fr.Next()
+		if err != nil {
+			if err != io.EOF {
+				log.Printf("pid %d: %v", header.Process, err)
+			}
+			break
+		}
+
+		s := ConvertScopeInfo(fb)
+		strings.resolve(&s)
+		s.Process = uint64(header.Process)
+		records <- s
+		count++
+	}
+
+	log.Printf("pid %d disconnected after %d records", header.Process, count)
+}
+
+// segmentWriter writes records into a series of columnar captures named
+// like a rotating rsp::BinaryDiskSink's segments, so they read back as one
+// capture from their directory or a glob.
+type segmentWriter struct {
+	base     string
+	opts     CollectOptions
+	sequence int
+
+	f       *os.File
+	cw      *columnarWriter
+	opened  time.Time
+	records int
+}
+
+func newSegmentWriter(opts CollectOptions) (*segmentWriter, error) {
+	if err := os.MkdirAll(filepath.Dir(opts.Output), 0755); err != nil {
+		return nil, err
+	}
+
+	w := &segmentWriter{base: opts.Output, opts: opts}
+	for _, path := range w.segments() {
+		if m := segmentName.FindStringSubmatch(path); m != nil {
+			n, _ := strconv.Atoi(m[2])
+			w.sequence = max(w.sequence, n)
+		}
+	}
+
+	return w, nil
+}
+
+// segments lists this series' segments on disk, oldest first.
+func (w *segmentWriter) segments() []string {
+	ext := filepath.Ext(w.base)
+	stem := w.base[:len(w.base)-len(ext)]
+
+	matches, _ := filepath.Glob(stem + ".*" + ext)
+
+	var paths []string
+	for _, m := range matches {
+		if s := segmentName.FindStringSubmatch(m); s != nil && s[1] == stem && s[4] == ext {
+			paths = append(paths, m)
+		}
+	}
+
+	sort.Slice(paths, func(i, j int) bool { return segmentKey(paths[i]) < segmentKey(paths[j]) })
+	return paths
+}
+
+func (w *segmentWriter) open() error {
+	w.sequence++
+
+	ext := filepath.Ext(w.base)
+	path := fmt.Sprintf("%s.%06d.%s%s", w.base[:len(w.base)-len(ext)], w.sequence,
+		time.Now().UTC().Format("20060102T150405Z"), ext)
+
+	f, err := os.Create(path)
+	if err != nil {
+		return err
+	}
+
+	cw, err := newColumnarWriter(f, w.opts.ChunkRows)
+	if err != nil {
+		f.Close()
+		return err
+	}
+
+	w.f, w.cw, w.opened, w.records = f, cw, time.Now(), 0
+	return nil
+}
+
+func (w *segmentWriter) add(s ScopeInfo) error {
+	if w.cw == nil {
+		if err := w.open(); err != nil {
+			return err
+		}
+	}
+
+	if err := w.cw.add(s); err != nil {
+		return err
+	}
+	w.records++
+
+	if w.opts.RotateBytes > 0 && w.cw.offset >= w.opts.RotateBytes {
+		return w.rotate()
+	}
+	return nil
+}
+
+// tick rotates on age, even if nothing has arrived since.
+func (w *segmentWriter) tick() error {
+	if w.cw != nil && w.opts.RotateInterval > 0 && time.Since(w.opened) >= w.opts.RotateInterval {
+		return w.rotate()
+	}
+	return nil
+}
+
+// rotate finishes the current segment (the next opens with the next
+// record) and deletes the oldest past MaxSegments.
+func (w *segmentWriter) rotate() error {
+	if err := w.close(); err != nil {
+		return err
+	}
+
+	if w.opts.MaxSegments > 0 {
+		segments := w.segments()
+		for len(segments) > w.opts.MaxSegments {
+			os.Remove(segments[0])
+			segments = segments[1:]
+		}
+	}
+	return nil
+}
+
+func (w *segmentWriter) close() error {
+	if w.cw == nil {
+		return nil
+	}
+
+	err := w.cw.finish()
+	if cerr := w.f.Close(); err == nil {
+		err = cerr
+	}
+	log.Printf("Wrote %d records to %s", w.records, w.f.Name())
+
+	w.f, w.cw = nil, nil
+	return err
+}
+
+// liveHistograms keeps each scope's durations over the current interval.
+type liveHistograms struct {
+	durations map[string][]float64
+	processes map[string]map[uint64]bool
+}
+
+func newLiveHistograms() *liveHistograms {
+	return &liveHistograms{durations: make(map[string][]float64), processes: make(map[string]map[uint64]bool)}
+}
+
+func (h *liveHistograms) add(s ScopeInfo) {
+	if s.Kind != RecordKindScope {
+		return
+	}
+
+	h.durations[s.Tag] = append(h.durations[s.Tag], s.ElapsedSeconds*1000)
+	if h.processes[s.Tag] == nil {
+		h.processes[s.Tag] = make(map[uint64]bool)
+	}
+	h.processes[s.Tag][s.Process] = true
+}
+
+func (h *liveHistograms) print(interval time.Duration) {
+	if len(h.durations) == 0 {
+		return
+	}
+
+	tags := make([]string, 0, len(h.durations))
+	for tag := range h.durations {
+		tags = append(tags, tag)
+	}
+	sort.Strings(tags)
+
+	t := table.NewWriter()
+	t.SetOutputMirror(os.Stdout)
+	t.SetTitle(time.Now().Format("15:04:05") + ", last " + interval.String())
+	t.AppendHeader(table.Row{"Scope", "Processes", "Calls", "p50 (ms)", "p95 (ms)", "p99 (ms)"})
+
+	for _, tag := range tags {
+		p50, p95, p99 := ComputePercentiles(h.durations[tag])
+		t.AppendRow(table.Row{
+			tag,
+			len(h.processes[tag]),
+			len(h.durations[tag]),
+			fmt.Sprintf("%.3f", p50),
+			fmt.Sprintf("%.3f", p95),
+			fmt.Sprintf("%.3f", p99),
+		})
+	}
+
+	t.Render()
+
+	clear(h.durations)
+	clear(h.processes)
+}
+
+// Collect listens on opts.Socket until interrupted.
+func Collect(opts CollectOptions) error {
+	// A socket left behind by a collector that didn't shut down cleanly.
+	if st, err := os.Lstat(opts.Socket); err == nil && st.Mode()&os.ModeSocket != 0 {
+		os.Remove(opts.Socket)
+	}
+
+	listener, err := net.Listen("unix", opts.Socket)
+	if err != nil {
+		return err
+	}
+	defer os.Remove(opts.Socket)
+
+	var writer *segmentWriter
+	if opts.Output != "" {
+		if writer, err = newSegmentWriter(opts); err != nil {
+			listener.Close()
+			return err
+		}
+	}
+
+	var histograms *liveHistograms
+	if opts.Histogram > 0 {
+		histograms = newLiveHistograms()
+	}
+
+	records := make(chan ScopeInfo, 4096)
+
+	go func() {
+		for {
+			conn, err := listener.Accept()
+			if err != nil {
+				if !errors.Is(err, net.ErrClosed) {
+					log.Printf("Accept: %v", err)
+				}
+				return
+			}
+			go readConnection(conn, records)
+		}
+	}()
+
+	log.Printf("Collecting on %s", opts.Socket)
+
+	stop := make(chan os.Signal, 1)
+	signal.Notify(stop, os.Interrupt, syscall.SIGTERM)
+
+	ticker := time.NewTicker(time.Second)
+	defer ticker.Stop()
+
+	var printTicks <-chan time.Time
+	if histograms != nil {
+		printTicker := time.NewTicker(opts.Histogram)
+		defer printTicker.Stop()
+		printTicks = printTicker.C
+	}
+
+	total := 0
+
+	for {
+		select {
+		case s := <-records:
+			total++
+			if histograms != nil {
+				histograms.add(s)
+			}
+			if writer != nil {
+				if err := writer.add(s); err != nil {
+					listener.Close()
+					return err
+				}
+			}
+
+		case <-ticker.C:
+			if writer != nil {
+				if err := writer.tick(); err != nil {
+					listener.Close()
+					return err
+				}
+			}
+
+		case <-printTicks:
+			histograms.print(opts.Histogram)
+
+		case <-stop:
+			listener.Close()
+
+			// Whatever the readers already handed over.
+			for drained := false; !drained; {
+				select {
+				case s := <-records:
+					total++
+					if writer != nil {
+						if err := writer.add(s); err != nil {
+							return err
+						}
+					}
+				default:
+					drained = true
+				}
+			}
+
+			log.Printf("Collected %d records", total)
+
+			if writer != nil {
+				return writer.close()
+			}
+			return nil
+		}
+	}
+}
+
+var CollectCommand = &cli.Command{
+	Name:  "collect",
+	Usage: "Receive records streamed by rsp::UnixSocketSink from any number of local processes.",
+	Flags: []cli.Flag{
+		&cli.StringFlag{
+			Name:  "socket",
+			Usage: "Unix socket to listen on.",
+			Value: "/tmp/rsp.sock",
+		},
+		&cli.StringFlag{
+			Name:    "output",
+			Aliases: []string{"o"},
+			Usage:   "Write columnar capture segments named after this path, e.g. /var/log/rsp/rsp.col.",
+		},
+		&cli.Int64Flag{
+			Name:  "rotate-bytes",
+			Usage: "Start a new segment once one reaches this size.",
+		},
+		&cli.DurationFlag{
+			Name:  "rotate-interval",
+			Usage: "Start a new segment once one is this old.",
+		},
+		&cli.IntFlag{
+			Name:  "max-segments",
+			Usage: "Delete the oldest segments past this many (0 keeps them all).",
+		},
+		&cli.IntFlag{
+			Name:  "chunk-rows",
+			Usage: "Maximum records per tag chunk.",
+			Value: columnarChunkRows,
+		},
+		&cli.DurationFlag{
+			Name:  "histogram",
+			Usage: "Print each scope's latency percentiles over this interval, e.g. 5s.",
+		},
+	},
+	Action: func(c *cli.Context) error {
+		opts := CollectOptions{
+			Socket:         c.String("socket"),
+			Output:         c.String("output"),
+			RotateBytes:    c.Int64("rotate-bytes"),
+			RotateInterval: c.Duration("rotate-interval"),
+			MaxSegments:    c.Int("max-segments"),
+			ChunkRows:      c.Int("chunk-rows"),
+			Histogram:      c.Duration("histogram"),
+		}
+
+		if opts.Output == "" && opts.Histogram == 0 {
+			return fmt.Errorf("nothing to do\nUsage: rsp collect [--socket path] [-o output [--rotate-bytes N] [--rotate-interval D] [--max-segments N]] [--histogram D]")
+		}
+
+		if opts.ChunkRows < 1 {
+			return fmt.Errorf("--chunk-rows must be at least 1")
+		}
+
+		return Collect(opts)
+	},
+}
@@ -0,0 +1,941 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/binary"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"io"
+	"math"
+	"os"
+	"slices"
+	"sort"
+)
+
+// Columnar capture layout, produced by `rsp convert`.
+//
+// Analyses boil down to "durations of tag X, filtered by metadata Y", so
+// records are grouped per tag into chunks of up to columnarChunkRows rows,
+// and each chunk stores every field as its own column:
+//
+//   "RSPCOL01"
+//   column data...
+//   footer (JSON)
+//   [uint64 footer length]["RSPCOL01"]
+//
+// Columns within a chunk (rows are sorted by start tick):
+//
+//   start     zigzag varint deltas from the previous row (the first from 0)
+//   duration  varint ticks_end - ticks_start
+//   metadata  one column per (key, type, occurrence): a presence bitmap,
+//             then a value per present row, encoded as in the block format;
+//             interned strings index the column's own dictionary, which
+//             is kept in the footer
+//   value     event chunks only: a zigzag varint delta per row for
+//             counters, the raw 8 bytes of the double for gauges, and
+//             nothing for instants
+//   flow      only if some row has a flow id: a varint per row, 0 for none
+//   process   only if some row has a process id: a varint per row, 0 for
+//             unknown (merged multi-process captures)
+//
+// Counter, gauge and instant records get chunks of their own (per tag and
+// kind); their durations are all zero.
+//
+// The footer lists every chunk's tag, row count and frequency, and each
+// column's location plus min/max, so queries only read the columns they
+// need and skip chunks whose tag or metadata range (or dictionary) can't
+// match.
+
+var columnarMagic = []byte("RSPCOL01")
+
+const (
+	columnarVersion   = 3
+	columnarChunkRows = 64 * 1024
+	columnarTrailer   = 16
+)
+
+type columnMeta struct {
+	// Metadata columns only.
+	Key        string       `json:",omitempty"`
+	Type       MetadataType `json:",omitempty"`
+	Occurrence int          `json:",omitempty"`
+
+	Offset int64
+	Length int64
+
+	// Numeric range of the column, for chunk skipping; zero for strings.
+	// A column holding NaN or an infinity is Unbounded instead: JSON can't
+	// carry those, and a range wouldn't tell filters anything about them.
+	Min       float64
+	Max       float64
+	Unbounded bool `json:",omitempty"`
+
+	// The distinct interned strings of a STRING_ID column, in the order
+	// its values index them.
+	Strings []string `json:",omitempty"`
+}
+
+type columnChunk struct {
+	Tag         string
+	Kind        RecordKind `json:",omitempty"`
+	Rows        int
+	NominalFreq uint64
+	Start       columnMeta
+	Duration    columnMeta
+	Metadata    []columnMeta
+	Value       *columnMeta `json:",omitempty"`
+	Flow        *columnMeta `json:",omitempty"`
+	Perf        *columnMeta `json:",omitempty"`
+	Allocs      *columnMeta `json:",omitempty"`
+	Rusage      *columnMeta `json:",omitempty"`
+	Process     *columnMeta `json:",omitempty"`
+}
+
+type columnarFooter struct {
+	Version int
+	Chunks  []columnChunk
+}
+
+//
+// Writing.
+//
+
+type chunkKey struct {
+	tag  string
+	kind RecordKind
+}
+
+type columnarWriter struct {
+	w         *bufio.Writer
+	offset    int64
+	chunkRows int
+	pending   map[chunkKey][]ScopeInfo
+	footer    columnarFooter
+}
+
+// ConvertToColumnar rewrites any capture the CLI can read as a columnar one.
+// Memory use is bounded by one chunk per distinct tag.
+func ConvertToColumnar(input, output string, chunkRows int) (records int, err error) {
+	stream, err := NewScopeInfoStream(input)
+	if err != nil {
+		return 0, err
+	}
+	defer stream.Close()
+
+	f, err := os.Create(output)
+	if err != nil {
+		return 0, err
+	}
+	defer f.Close()
+
+	cw, err := newColumnarWriter(f, chunkRows)
+	if err != nil {
+		return 0, err
+	}
+
+	for {
+		s, err := stream.NextScope()
+		if err != nil {
+			if err == io.EOF {
+				break
+			}
+			return records, err
+		}
+
+		if err := cw.add(s); err != nil {
+			return records, err
+		}
+		records++
+	}
+
+	if err := cw.finish(); err != nil {
+		return records, err
+	}
+
+	return records, f.Close()
+}
+
+// newColumnarWriter starts a columnar capture on w; add records, then
+// finish it.
+func newColumnarWriter(w io.Writer, chunkRows int) (*columnarWriter, error) {
+	cw := &columnarWriter{
+		w:         bufio.NewWriterSize(w, 1<<20),
+		chunkRows: chunkRows,
+		pending:   make(map[chunkKey][]ScopeInfo),
+		footer:    columnarFooter{Version: columnarVersion},
+	}
+
+	if err := cw.write(columnarMagic); err != nil {
+		return nil, err
+	}
+
+	return cw, nil
+}
+
+func (cw *columnarWriter) write(b []byte) error {
+	n, err := cw.w.Write(b)
+	cw.offset += int64(n)
+	return err
+}
+
+func (cw *columnarWriter) add(s ScopeInfo) error {
+	key := chunkKey{tag: s.Tag, kind: s.Kind}
+	rows := cw.pending[key]
+
+	// A chunk has a single frequency; appended captures from different
+	// runs can disagree.
+	if len(rows) > 0 && rows[0].MachineNominalFreq != s.MachineNominalFreq {
+		if err := cw.writeChunk(rows); err != nil {
+			return err
+		}
+		rows = rows[:0]
+	}
+
+	rows = append(rows, s)
+	if len(rows) >= cw.chunkRows {
+		if err := cw.writeChunk(rows); err != nil {
+			return err
+		}
+		rows = rows[:0]
+	}
+
+	cw.pending[key] = rows
+	return nil
+}
+
+func (cw *columnarWriter) finish() error {
+	keys := make([]chunkKey, 0, len(cw.pending))
+	for key := range cw.pending {
+		keys = append(keys, key)
+	}
+	sort.Slice(keys, func(i, j int) bool {
+		if keys[i].tag != keys[j].tag {
+			return keys[i].tag < keys[j].tag
+		}
+		return keys[i].kind < keys[j].kind
+	})
+
+	for _, key := range keys {
+		if rows := cw.pending[key]; len(rows) > 0 {
+			if err := cw.writeChunk(rows); err != nil {
+				return err
+			}
+		}
+	}
+
+	footer, err := json.Marshal(cw.footer)
+	if err != nil {
+		return err
+	}
+
+	if err := cw.write(footer); err != nil {
+		return err
+	}
+
+	var trailer [columnarTrailer]byte
+	binary.LittleEndian.PutUint64(trailer[:], uint64(len(footer)))
+	copy(trailer[8:], columnarMagic)
+	if err := cw.write(trailer[:]); err != nil {
+		return err
+	}
+
+	return cw.w.Flush()
+}
+
+func (cw *columnarWriter) writeColumn(meta *columnMeta, data []byte) error {
+	if meta.Unbounded {
+		meta.Min, meta.Max = -math.MaxFloat64, math.MaxFloat64
+	}
+	meta.Offset = cw.offset
+	meta.Length = int64(len(data))
+	return cw.write(data)
+}
+
+type columnKey struct {
+	key        string
+	typ        MetadataType
+	occurrence int
+}
+
+type metadataColumn struct {
+	meta    columnMeta
+	present []byte
+	values  []byte
+	strings map[string]uint64 // Index into meta.Strings.
+}
+
+func (col *metadataColumn) appendValue(m MetadataEntry) {
+	switch m.Type {
+	case MetadataTypeString:
+		col.values = binary.AppendUvarint(col.values, uint64(len(m.Text)))
+		col.values = append(col.values, m.Text...)
+	case MetadataTypeStringID:
+		id, ok := col.strings[m.Text]
+		if !ok {
+			id = uint64(len(col.meta.Strings))
+			col.strings[m.Text] = id
+			col.meta.Strings = append(col.meta.Strings, m.Text)
+		}
+		col.values = binary.AppendUvarint(col.values, id)
+	default:
+		col.values = appendMetadataValue(col.values, m.Type, m.Value)
+		widen(&col.meta, MetadataNumericValue(m))
+	}
+}
+
+func (cw *columnarWriter) writeChunk(rows []ScopeInfo) error {
+	sort.SliceStable(rows, func(i, j int) bool { return rows[i].TicksStart < rows[j].TicksStart })
+
+	chunk := columnChunk{
+		Tag:         rows[0].Tag,
+		Kind:        rows[0].Kind,
+		Rows:        len(rows),
+		NominalFreq: rows[0].MachineNominalFreq,
+		Start:       columnMeta{Min: math.Inf(1), Max: math.Inf(-1)},
+		Duration:    columnMeta{Min: math.Inf(1), Max: math.Inf(-1)},
+	}
+
+	var starts, durations, values, flows, perf, allocs, rusage, processes []byte
+	var prev uint64
+	hasFlows, hasPerf, hasAllocs, hasRusage, hasProcesses := false, false, false, false, false
+
+	var value *columnMeta
+	if chunk.Kind != RecordKindScope {
+		value = &columnMeta{Min: math.Inf(1), Max: math.Inf(-1)}
+	}
+
+	var columns []*metadataColumn
+	byKey := make(map[columnKey]*metadataColumn)
+	seen := make(map[columnKey]int)
+
+	for i, s := range rows {
+		starts = binary.AppendUvarint(starts, zigzag(int64(s.TicksStart-prev)))
+		prev = s.TicksStart
+		widen(&chunk.Start, float64(s.TicksStart))
+
+		duration := s.TicksEnd - s.TicksStart
+		durations = binary.AppendUvarint(durations, duration)
+		widen(&chunk.Duration, float64(duration))
+
+		if value != nil {
+			values = appendEventValue(values, s.Kind, s.Value)
+			widen(value, EventValue(s))
+		}
+
+		flows = binary.AppendUvarint(flows, s.Flow)
+		hasFlows = hasFlows || s.Flow != 0
+
+		perf = binary.AppendUvarint(perf, s.Perf.Cycles)
+		perf = binary.AppendUvarint(perf, s.Perf.Instructions)
+		perf = binary.AppendUvarint(perf, s.Perf.LLCMisses)
+		perf = binary.AppendUvarint(perf, s.Perf.BranchMisses)
+		hasPerf = hasPerf || !s.Perf.Empty()
+
+		tracked := uint64(0)
+		if s.Allocs.Tracked {
+			tracked = 1
+		}
+		allocs = binary.AppendUvarint(allocs, tracked)
+		allocs = binary.AppendUvarint(allocs, s.Allocs.Count)
+		allocs = binary.AppendUvarint(allocs, s.Allocs.Bytes)
+		allocs = binary.AppendUvarint(allocs, s.Allocs.SelfCount)
+		allocs = binary.AppendUvarint(allocs, s.Allocs.SelfBytes)
+		hasAllocs = hasAllocs || s.Allocs.Tracked
+
+		sampled := uint64(0)
+		if s.Rusage.Sampled {
+			sampled = 1
+		}
+		rusage = binary.AppendUvarint(rusage, sampled)
+		rusage = binary.AppendUvarint(rusage, s.Rusage.VoluntarySwitches)
+		rusage = binary.AppendUvarint(rusage, s.Rusage.InvoluntarySwitches)
+		rusage = binary.AppendUvarint(rusage, s.Rusage.MinorFaults)
+		rusage = binary.AppendUvarint(rusage, s.Rusage.MajorFaults)
+		hasRusage = hasRusage || s.Rusage.Sampled
+
+		processes = binary.AppendUvarint(processes, s.Process)
+		hasProcesses = hasProcesses || s.Process != 0
+
+		for k := range seen {
+			delete(seen, k)
+		}
+
+		for _, m := range s.Metadata {
+			base := columnKey{key: m.Tag, typ: m.Type}
+			ck := columnKey{key: m.Tag, typ: m.Type, occurrence: seen[base]}
+			seen[base]++
+
+			col, ok := byKey[ck]
+			if !ok {
+				col = &metadataColumn{
+					meta: columnMeta{
+						Key:        ck.key,
+						Type:       ck.typ,
+						Occurrence: ck.occurrence,
+						Min:        math.Inf(1),
+						Max:        math.Inf(-1),
+					},
+					present: make([]byte, (len(rows)+7)/8),
+					strings: make(map[string]uint64),
+				}
+				if m.IsString() {
+					col.meta.Min, col.meta.Max = 0, 0
+				}
+				byKey[ck] = col
+				columns = append(columns, col)
+			}
+
+			col.present[i/8] |= 1 << (i % 8)
+			col.appendValue(m)
+		}
+	}
+
+	if err := cw.writeColumn(&chunk.Start, starts); err != nil {
+		return err
+	}
+	if err := cw.writeColumn(&chunk.Duration, durations); err != nil {
+		return err
+	}
+
+	for _, col := range columns {
+		if err := cw.writeColumn(&col.meta, append(col.present, col.values...)); err != nil {
+			return err
+		}
+		chunk.Metadata = append(chunk.Metadata, col.meta)
+	}
+
+	if value != nil {
+		if err := cw.writeColumn(value, values); err != nil {
+			return err
+		}
+		chunk.Value = value
+	}
+
+	if hasFlows {
+		flow := &columnMeta{}
+		if err := cw.writeColumn(flow, flows); err != nil {
+			return err
+		}
+		chunk.Flow = flow
+	}
+
+	if hasPerf {
+		p := &columnMeta{}
+		if err := cw.writeColumn(p, perf); err != nil {
+			return err
+		}
+		chunk.Perf = p
+	}
+
+	if hasAllocs {
+		a := &columnMeta{}
+		if err := cw.writeColumn(a, allocs); err != nil {
+			return err
+		}
+		chunk.Allocs = a
+	}
+
+	if hasRusage {
+		r := &columnMeta{}
+		if err := cw.writeColumn(r, rusage); err != nil {
+			return err
+		}
+		chunk.Rusage = r
+	}
+
+	if hasProcesses {
+		p := &columnMeta{}
+		if err := cw.writeColumn(p, processes); err != nil {
+			return err
+		}
+		chunk.Process = p
+	}
+
+	cw.footer.Chunks = append(cw.footer.Chunks, chunk)
+	return nil
+}
+
+func widen(meta *columnMeta, v float64) {
+	if math.IsNaN(v) || math.IsInf(v, 0) {
+		meta.Unbounded = true
+		return
+	}
+	meta.Min = math.Min(meta.Min, v)
+	meta.Max = math.Max(meta.Max, v)
+}
+
+func zigzag(v int64) uint64 {
+	return uint64(v<<1) ^ uint64(v>>63)
+}
+
+func unzigzag(v uint64) int64 {
+	return int64(v>>1) ^ -int64(v&1)
+}
+
+// appendMetadataValue encodes a value the way the block format does:
+// zigzag for signed types (sign extended from their width), raw 8 bytes
+// for floating point, plain varints otherwise.
+func appendMetadataValue(buf []byte, typ MetadataType, value uint64) []byte {
+	switch typ {
+	case MetadataTypeInt8:
+		return binary.AppendUvarint(buf, zigzag(int64(int8(value))))
+	case MetadataTypeInt16:
+		return binary.AppendUvarint(buf, zigzag(int64(int16(value))))
+	case MetadataTypeInt32:
+		return binary.AppendUvarint(buf, zigzag(int64(int32(value))))
+	case MetadataTypeInt64:
+		return binary.AppendUvarint(buf, zigzag(int64(value)))
+	case MetadataTypeDouble, MetadataTypeFloat:
+		return binary.LittleEndian.AppendUint64(buf, value)
+	default:
+		return binary.AppendUvarint(buf, value)
+	}
+}
+
+// appendEventValue encodes an event's value like the metadata of the
+// matching type: counters as int64, gauges as double, instants not at all.
+func appendEventValue(buf []byte, kind RecordKind, value uint64) []byte {
+	switch kind {
+	case RecordKindCounter:
+		return appendMetadataValue(buf, MetadataTypeInt64, value)
+	case RecordKindGauge:
+		return appendMetadataValue(buf, MetadataTypeDouble, value)
+	default:
+		return buf
+	}
+}
+
+//
+// Reading.
+//
+
+var errCorruptColumnar = errors.New("corrupt columnar capture")
+
+type columnarFile struct {
+	f      *os.File
+	footer columnarFooter
+}
+
+// openColumnar reads the footer of a columnar capture.
+func openColumnar(f *os.File) (*columnarFile, error) {
+	st, err := f.Stat()
+	if err != nil {
+		return nil, err
+	}
+
+	size := st.Size()
+	if size < int64(len(columnarMagic))+columnarTrailer {
+		return nil, errCorruptColumnar
+	}
+
+	var trailer [columnarTrailer]byte
+	if _, err := f.ReadAt(trailer[:], size-columnarTrailer); err != nil {
+		return nil, err
+	}
+
+	footerLen := int64(binary.LittleEndian.Uint64(trailer[:]))
+	if !bytes.Equal(trailer[8:], columnarMagic) || footerLen <= 0 || footerLen > size-columnarTrailer {
+		return nil, fmt.Errorf("%w: bad trailer (truncated conversion?)", errCorruptColumnar)
+	}
+
+	footer := make([]byte, footerLen)
+	if _, err := f.ReadAt(footer, size-columnarTrailer-footerLen); err != nil {
+		return nil, err
+	}
+
+	cf := &columnarFile{f: f}
+	if err := json.Unmarshal(footer, &cf.footer); err != nil {
+		return nil, fmt.Errorf("%w: %v", errCorruptColumnar, err)
+	}
+
+	// Version 1 predates event records and version 2 string metadata, and
+	// they read the same otherwise.
+	if cf.footer.Version < 1 || cf.footer.Version > columnarVersion {
+		return nil, fmt.Errorf("unsupported columnar capture version %d", cf.footer.Version)
+	}
+
+	return cf, nil
+}
+
+func (cf *columnarFile) readColumn(meta columnMeta, buf []byte) ([]byte, error) {
+	if cap(buf) < int(meta.Length) {
+		buf = make([]byte, meta.Length)
+	}
+	buf = buf[:meta.Length]
+	_, err := cf.f.ReadAt(buf, meta.Offset)
+	return buf, err
+}
+
+// Counts answers "how many entries per scope" from the footer alone.
+func (cf *columnarFile) Counts() map[string]int {
+	counts := make(map[string]int)
+	for _, c := range cf.footer.Chunks {
+		if c.Kind == RecordKindScope {
+			counts[c.Tag] += c.Rows
+		}
+	}
+	return counts
+}
+
+// Durations returns the elapsed times, in milliseconds, of every entry for
+// tag that passes filter (which may be nil). Only the duration column, and
+// the filter's metadata column, are read, and chunks whose footer range
+// rules out the filter aren't read at all.
+func (cf *columnarFile) Durations(tag string, filter *MetadataFilter) ([]float64, error) {
+	var times []float64
+	var durations, metadata []byte
+
+	for _, c := range cf.footer.Chunks {
+		if c.Tag != tag || c.Kind != RecordKindScope || c.NominalFreq == 0 {
+			continue
+		}
+
+		var keep []bool
+		if filter != nil {
+			var err error
+			keep, metadata, err = cf.filterChunk(c, filter, metadata)
+			if err != nil {
+				return nil, err
+			}
+			if keep == nil {
+				continue
+			}
+		}
+
+		var err error
+		durations, err = cf.readColumn(c.Duration, durations)
+		if err != nil {
+			return nil, err
+		}
+
+		d := blockDecoder{buf: durations}
+		for i := 0; i < c.Rows; i++ {
+			v := d.varint()
+			if keep == nil || keep[i] {
+				times = append(times, float64(v)/float64(c.NominalFreq)*1000)
+			}
+		}
+
+		if d.err != nil {
+			return nil, errCorruptColumnar
+		}
+	}
+
+	return times, nil
+}
+
+// filterChunk returns which rows of the chunk pass the filter, or nil if
+// none can.
+func (cf *columnarFile) filterChunk(c columnChunk, filter *MetadataFilter, buf []byte) ([]bool, []byte, error) {
+	keep := make([]bool, c.Rows)
+	any := false
+
+	for _, col := range c.Metadata {
+		if col.Key != filter.Key || !mayMatchColumn(filter, col) {
+			continue
+		}
+
+		var err error
+		buf, err = cf.readColumn(col, buf)
+		if err != nil {
+			return nil, buf, err
+		}
+
+		present, values, err := splitPresence(buf, c.Rows)
+		if err != nil {
+			return nil, buf, err
+		}
+
+		d := blockDecoder{buf: values}
+		for i := 0; i < c.Rows; i++ {
+			if present[i/8]&(1<<(i%8)) == 0 {
+				continue
+			}
+			if filter.Matches(d.metadataEntry(col.Key, col.Type, col.Strings)) {
+				keep[i] = true
+				any = true
+			}
+		}
+
+		if d.err != nil {
+			return nil, buf, errCorruptColumnar
+		}
+	}
+
+	if !any {
+		return nil, buf, nil
+	}
+
+	return keep, buf, nil
+}
+
+// mayMatchColumn is false only if no value in the column can match: by its
+// range for numbers, and its dictionary for interned strings.
+func mayMatchColumn(filter *MetadataFilter, col columnMeta) bool {
+	switch col.Type {
+	case MetadataTypeString:
+		return filter.Op == "=" || filter.Op == "!="
+	case MetadataTypeStringID:
+		switch filter.Op {
+		case "=":
+			return slices.Contains(col.Strings, filter.Text)
+		case "!=":
+			return len(col.Strings) != 1 || col.Strings[0] != filter.Text
+		}
+		return false
+	}
+	return filter.Numeric && (col.Unbounded || filter.MayMatch(col.Min, col.Max))
+}
+
+func splitPresence(column []byte, rows int) ([]byte, []byte, error) {
+	n := (rows + 7) / 8
+	if len(column) < n {
+		return nil, nil, errCorruptColumnar
+	}
+	return column[:n], column[n:], nil
+}
+
+// decodeChunk rebuilds full records from a chunk. Metadata comes back
+// grouped by column, which may not be the order it was attached in.
+func (cf *columnarFile) decodeChunk(c columnChunk) ([]ScopeInfo, error) {
+	starts, err := cf.readColumn(c.Start, nil)
+	if err != nil {
+		return nil, err
+	}
+
+	durations, err := cf.readColumn(c.Duration, nil)
+	if err != nil {
+		return nil, err
+	}
+
+	rows := make([]ScopeInfo, c.Rows)
+	sd := blockDecoder{buf: starts}
+	dd := blockDecoder{buf: durations}
+
+	var prev uint64
+	for i := range rows {
+		prev += uint64(unzigzag(sd.varint()))
+		duration := dd.varint()
+
+		rows[i] = ScopeInfo{
+			Tag:                c.Tag,
+			Kind:               c.Kind,
+			TicksStart:         prev,
+			TicksEnd:           prev + duration,
+			MachineNominalFreq: c.NominalFreq,
+		}
+
+		if c.NominalFreq > 0 {
+			rows[i].ElapsedSeconds = float64(duration) / float64(c.NominalFreq)
+		}
+	}
+
+	if sd.err != nil || dd.err != nil {
+		return nil, errCorruptColumnar
+	}
+
+	for _, col := range c.Metadata {
+		column, err := cf.readColumn(col, nil)
+		if err != nil {
+			return nil, err
+		}
+
+		present, values, err := splitPresence(column, c.Rows)
+		if err != nil {
+			return nil, err
+		}
+
+		d := blockDecoder{buf: values}
+		for i := range rows {
+			if present[i/8]&(1<<(i%8)) == 0 {
+				continue
+			}
+			rows[i].Metadata = append(rows[i].Metadata, d.metadataEntry(col.Key, col.Type, col.Strings))
+		}
+
+		if d.err != nil {
+			return nil, errCorruptColumnar
+		}
+	}
+
+	if c.Value != nil {
+		column, err := cf.readColumn(*c.Value, nil)
+		if err != nil {
+			return nil, err
+		}
+
+		d := blockDecoder{buf: column}
+		for i := range rows {
+			switch c.Kind {
+			case RecordKindCounter:
+				rows[i].Value = d.metadataValue(byte(MetadataTypeInt64))
+			case RecordKindGauge:
+				rows[i].Value = d.metadataValue(byte(MetadataTypeDouble))
+			}
+		}
+
+		if d.err != nil {
+			return nil, errCorruptColumnar
+		}
+	}
+
+	if c.Flow != nil {
+		column, err := cf.readColumn(*c.Flow, nil)
+		if err != nil {
+			return nil, err
+		}
+
+		d := blockDecoder{buf: column}
+		for i := range rows {
+			rows[i].Flow = d.varint()
+		}
+
+		if d.err != nil {
+			return nil, errCorruptColumnar
+		}
+	}
+
+	if c.Perf != nil {
+		column, err := cf.readColumn(*c.Perf, nil)
+		if err != nil {
+			return nil, err
+		}
+
+		d := blockDecoder{buf: column}
+		for i := range rows {
+			rows[i].Perf = PerfCounts{
+				Cycles:       d.varint(),
+				Instructions: d.varint(),
+				LLCMisses:    d.varint(),
+				BranchMisses: d.varint(),
+			}
+		}
+
+		if d.err != nil {
+			return nil, errCorruptColumnar
+		}
+	}
+
+	if c.Allocs != nil {
+		column, err := cf.readColumn(*c.Allocs, nil)
+		if err != nil {
+			return nil, err
+		}
+
+		d := blockDecoder{buf: column}
+		for i := range rows {
+			rows[i].Allocs = ScopeAllocations{
+				Tracked:   d.varint() != 0,
+				Count:     d.varint(),
+				Bytes:     d.varint(),
+				SelfCount: d.varint(),
+				SelfBytes: d.varint(),
+			}
+		}
+
+		if d.err != nil {
+			return nil, errCorruptColumnar
+		}
+	}
+
+	if c.Rusage != nil {
+		column, err := cf.readColumn(*c.Rusage, nil)
+		if err != nil {
+			return nil, err
+		}
+
+		d := blockDecoder{buf: column}
+		for i := range rows {
+			rows[i].Rusage = ResourceUsage{
+				Sampled:             d.varint() != 0,
+				VoluntarySwitches:   d.varint(),
+				InvoluntarySwitches: d.varint(),
+				MinorFaults:         d.varint(),
+				MajorFaults:         d.varint(),
+			}
+		}
+
+		if d.err != nil {
+			return nil, errCorruptColumnar
+		}
+	}
+
+	if c.Process != nil {
+		column, err := cf.readColumn(*c.Process, nil)
+		if err != nil {
+			return nil, err
+		}
+
+		d := blockDecoder{buf: column}
+		for i := range rows {
+			rows[i].Process = d.varint()
+		}
+
+		if d.err != nil {
+			return nil, errCorruptColumnar
+		}
+	}
+
+	for i := range rows {
+		rows[i].MaxOffset = byte(len(rows[i].Metadata))
+		rows[i].MaxBufferSize = uint64(len(rows[i].Metadata))
+	}
+
+	return rows, nil
+}
+
+// columnarReader walks a columnar capture record by record, a chunk at a
+// time, for the consumers that want whole records.
+type columnarReader struct {
+	file  *columnarFile
+	only  map[string]struct{} // If set, chunks for other tags are skipped.
+	chunk int
+	rows  []ScopeInfo
+	next  int
+}
+
+func (r *columnarReader) Next() (ScopeInfo, error) {
+	for r.next >= len(r.rows) {
+		if r.chunk >= len(r.file.footer.Chunks) {
+			return ScopeInfo{}, io.EOF
+		}
+
+		c := r.file.footer.Chunks[r.chunk]
+		r.chunk++
+
+		if r.only != nil {
+			if _, ok := r.only[c.Tag]; !ok {
+				continue
+			}
+		}
+
+		rows, err := r.file.decodeChunk(c)
+		if err != nil {
+			return ScopeInfo{}, err
+		}
+
+		r.rows, r.next = rows, 0
+	}
+
+	s := r.rows[r.next]
+	r.next++
+	return s, nil
+}
@@ -0,0 +1,169 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"io"
+	"log"
+	"os"
+	"slices"
+	"strconv"
+	"strings"
+
+	"github.com/urfave/cli/v2"
+)
+
+func Convert(input string, output string, chunkRows int, check bool) {
+	records, err := ConvertToColumnar(input, output, chunkRows)
+	if err != nil {
+		os.Remove(output)
+		log.Fatal(err)
+	}
+
+	if check {
+		if err := CheckConversion(input, output); err != nil {
+			log.Fatalf("%s does not match %s: %v", output, input, err)
+		}
+	}
+
+	var inSize int64
+	files, _ := CaptureFiles(input)
+	for _, file := range files {
+		if in, err := os.Stat(file); err == nil {
+			inSize += in.Size()
+		}
+	}
+
+	out, _ := os.Stat(output)
+	log.Printf("Converted %d records: %s (%d bytes) -> %s (%d bytes)", records, input, inSize, output, out.Size())
+}
+
+// CheckConversion reads both captures back and reports the first record
+// that is in one but not the other. Columnar captures regroup records and
+// their metadata, so records are compared as a multiset of recordKey.
+func CheckConversion(input, output string) error {
+	pending := make(map[string]int)
+
+	count := func(filename string, delta int) error {
+		stream, err := NewScopeInfoStream(filename)
+		if err != nil {
+			return err
+		}
+		defer stream.Close()
+
+		for {
+			s, err := stream.NextScope()
+			if err == io.EOF {
+				return nil
+			}
+			if err != nil {
+				return err
+			}
+			pending[recordKey(s)] += delta
+		}
+	}
+
+	if err := count(input, 1); err != nil {
+		return err
+	}
+	if err := count(output, -1); err != nil {
+		return err
+	}
+
+	for key, n := range pending {
+		switch {
+		case n > 0:
+			return fmt.Errorf("missing record %s", key)
+		case n < 0:
+			return fmt.Errorf("extra record %s", key)
+		}
+	}
+
+	return nil
+}
+
+// recordKey renders the fields a columnar capture keeps, with metadata in
+// a fixed order. Floating point values are compared bit for bit, so NaN
+// matches itself.
+func recordKey(s ScopeInfo) string {
+	metadata := make([]string, len(s.Metadata))
+	for i, m := range s.Metadata {
+		metadata[i] = fmt.Sprintf("%q:%d=%s", m.Tag, m.Type, metadataKeyValue(m))
+	}
+	slices.Sort(metadata)
+
+	value := uint64(0)
+	if s.Kind == RecordKindCounter || s.Kind == RecordKindGauge {
+		value = s.Value
+	}
+
+	return fmt.Sprintf("%q kind=%d start=%d end=%d freq=%d value=%#x flow=%d perf=%v allocs=%v rusage=%v process=%d {%s}",
+		s.Tag, s.Kind, s.TicksStart, s.TicksEnd, s.MachineNominalFreq, value, s.Flow, s.Perf, s.Allocs, s.Rusage,
+		s.Process, strings.Join(metadata, ", "))
+}
+
+// metadataKeyValue is the value as its type defines it: sign extended from
+// its width, the raw bits of a float, or the text of a string.
+func metadataKeyValue(m MetadataEntry) string {
+	switch m.Type {
+	case MetadataTypeString, MetadataTypeStringID:
+		return strconv.Quote(m.Text)
+	case MetadataTypeInt8:
+		return strconv.FormatInt(int64(int8(m.Value)), 10)
+	case MetadataTypeInt16:
+		return strconv.FormatInt(int64(int16(m.Value)), 10)
+	case MetadataTypeInt32:
+		return strconv.FormatInt(int64(int32(m.Value)), 10)
+	case MetadataTypeInt64:
+		return strconv.FormatInt(int64(m.Value), 10)
+	case MetadataTypeFloat:
+		return fmt.Sprintf("%#x", uint32(m.Value))
+	default:
+		return fmt.Sprintf("%#x", m.Value)
+	}
+}
+
+var ConvertCommand = &cli.Command{
+	Name:      "convert",
+	Usage:     "Rewrite a capture in the columnar layout, for fast repeated analysis.",
+	ArgsUsage: "<input> <output>",
+	Flags: []cli.Flag{
+		&cli.IntFlag{
+			Name:  "chunk-rows",
+			Usage: "Maximum records per tag chunk.",
+			Value: columnarChunkRows,
+		},
+		&cli.BoolFlag{
+			Name:  "check",
+			Usage: "Read both captures back and fail unless they hold the same records.",
+		},
+	},
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 2 {
+			return fmt.Errorf("missing filename\nUsage: rsp convert [--chunk-rows N] [--check] <input> <output>")
+		}
+
+		if c.Int("chunk-rows") < 1 {
+			return fmt.Errorf("--chunk-rows must be at least 1")
+		}
+
+		Convert(c.Args().Get(0), c.Args().Get(1), c.Int("chunk-rows"), c.Bool("check"))
+
+		return nil
+	},
+}
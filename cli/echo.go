@@ -18,7 +18,6 @@ package main
 
 import (
 	"fmt"
-	"github.com/AFWareLLC/rsp/RSP"
 	"github.com/urfave/cli/v2"
 	"io"
 	"log"
@@ -34,9 +33,25 @@ func Echo(filename string) {
 	}
 
 	defer stream.Close()
+
+	if d := stream.Flight; d != nil {
+		reason := "API call"
+		if d.Reason != 0 {
+			reason = fmt.Sprintf("signal %d", d.Reason)
+		}
+		log.Printf("Flight recorder dump (%s) at tick %d", reason, d.Ticks)
+	}
+
+	if h := stream.Header; h != nil {
+		log.Printf("Capture format version %d, recorded on %s (pid %d)", h.Version, h.Host, h.Process)
+		log.Printf("  CPU: %s", h.CPUModel)
+		log.Printf("  Clock: %s at %d Hz", h.ClockSource, h.NominalFreq)
+		log.Printf("  Build: %s", h.BuildFlags)
+	}
+
 	i := 0
 	for {
-		scope, err := stream.Next()
+		scope, err := stream.NextScope()
 		if err != nil {
 			if err == io.EOF {
 				break
@@ -45,17 +60,44 @@ func Echo(filename string) {
 		}
 
 		log.Printf("-------")
-		log.Printf("  Tag: %s", string(scope.Tag()))
-		log.Printf("  Ticks: %d - %d", scope.TicksStart(), scope.TicksEnd())
-		log.Printf("  Machine Freq: %d", scope.MachineNominalFreqHz())
-		log.Printf("  MaxOffset: %d", scope.MaxOffset())
+		log.Printf("  Tag: %s", scope.Tag)
+		log.Printf("  Ticks: %d - %d", scope.TicksStart, scope.TicksEnd)
+		log.Printf("  Machine Freq: %d", scope.MachineNominalFreq)
+		log.Printf("  MaxOffset: %d", scope.MaxOffset)
+		if scope.Process != 0 {
+			log.Printf("  Process: %d", scope.Process)
+		}
+		if scope.Thread != 0 {
+			log.Printf("  Thread: %d", scope.Thread)
+		}
+		if scope.Flow != 0 {
+			log.Printf("  Flow: %d", scope.Flow)
+		}
+		if !scope.Perf.Empty() {
+			log.Printf("  Perf: cycles=%d instructions=%d llc_misses=%d branch_misses=%d",
+				scope.Perf.Cycles, scope.Perf.Instructions, scope.Perf.LLCMisses, scope.Perf.BranchMisses)
+		}
+		if scope.Allocs.Tracked {
+			log.Printf("  Allocations: %d (%d bytes), self %d (%d bytes)",
+				scope.Allocs.Count, scope.Allocs.Bytes, scope.Allocs.SelfCount, scope.Allocs.SelfBytes)
+		}
+		if scope.Rusage.Sampled {
+			log.Printf("  Context switches: %d voluntary, %d involuntary; page faults: %d minor, %d major",
+				scope.Rusage.VoluntarySwitches, scope.Rusage.InvoluntarySwitches,
+				scope.Rusage.MinorFaults, scope.Rusage.MajorFaults)
+		}
+		if scope.Kind != RecordKindScope {
+			log.Printf("  Kind: %s Value=%g", scope.Kind, EventValue(scope))
+		}
 
-		for j := 0; j < scope.MetadataLength(); j++ {
-			m := new(RSP.MetadataEntry)
-			if scope.Metadata(m, j) {
-				log.Printf("    Metadata #%d: %s Type=%d Value=%d",
-					j, string(m.Tag()), m.Type(), m.Value())
+		for j, m := range scope.Metadata {
+			if m.IsString() {
+				log.Printf("    Metadata #%d: %s Type=%d Text=%q",
+					j, m.Tag, m.Type, m.Text)
+				continue
 			}
+			log.Printf("    Metadata #%d: %s Type=%d Value=%d",
+				j, m.Tag, m.Type, m.Value)
 		}
 		i++
 	}
@@ -0,0 +1,240 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+	"log"
+)
+
+// Reader for the dumps written by rsp::FlightRecorder (see
+// include/afware/rsp/FlightRecorder.hpp for the layout).
+
+var flightDumpMagic = []byte("RSPFLT01")
+
+// Version 1 dumps have no record kind or value (everything is a scope),
+// version 2 dumps have no flow id, version 3 dumps no perf counters,
+// version 4 dumps no allocation counts, version 5 dumps no resource usage
+// and version 6 dumps no text for interned strings.
+const flightDumpVersion = 7
+
+// FlightDump describes why and when a flight recorder dump was written.
+type FlightDump struct {
+	Version uint32
+	// The signal that triggered the dump, or 0 for an API call.
+	Reason uint32
+	// Ticks at the time of the dump.
+	Ticks uint64
+}
+
+var errCorruptFlightDump = errors.New("corrupt flight recorder dump")
+
+// flightReader yields the records of a dump, positioned just past the
+// capture header.
+type flightReader struct {
+	r       *bufio.Reader
+	freq    uint64
+	version uint32
+	buf     [256]byte
+}
+
+// newFlightReader parses the dump preamble and the capture header embedded
+// after it. r must be positioned just past the magic.
+func newFlightReader(r *bufio.Reader) (*flightReader, FlightDump, CaptureHeader, error) {
+	var dump FlightDump
+	var header CaptureHeader
+
+	var fixed [16]byte
+	if _, err := io.ReadFull(r, fixed[:]); err != nil {
+		return nil, dump, header, errCorruptFlightDump
+	}
+
+	dump.Version = binary.LittleEndian.Uint32(fixed[0:])
+	dump.Reason = binary.LittleEndian.Uint32(fixed[4:])
+	dump.Ticks = binary.LittleEndian.Uint64(fixed[8:])
+	if dump.Version < 1 || dump.Version > flightDumpVersion {
+		return nil, dump, header, fmt.Errorf("%w: version %d", errCorruptFlightDump, dump.Version)
+	}
+
+	// Dumps are written in one go, so unlike framed captures there's
+	// nothing to resync to if the header is damaged.
+	magic := make([]byte, len(framedCaptureMagic))
+	if _, err := io.ReadFull(r, magic); err != nil || !bytes.Equal(magic, framedCaptureMagic) {
+		return nil, dump, header, fmt.Errorf("%w: missing capture header", errCorruptFlightDump)
+	}
+
+	header, err := readCaptureHeader(r)
+	if err != nil {
+		return nil, dump, header, err
+	}
+
+	return &flightReader{r: r, freq: header.NominalFreq, version: dump.Version}, dump, header, nil
+}
+
+func (f *flightReader) Next() (ScopeInfo, error) {
+	var fixed [24]byte
+	if _, err := io.ReadFull(f.r, fixed[:]); err != nil {
+		if err == io.EOF {
+			return ScopeInfo{}, io.EOF
+		}
+		return f.truncated()
+	}
+
+	s := ScopeInfo{
+		Thread:             binary.LittleEndian.Uint64(fixed[0:]),
+		TicksStart:         binary.LittleEndian.Uint64(fixed[8:]),
+		TicksEnd:           binary.LittleEndian.Uint64(fixed[16:]),
+		MachineNominalFreq: f.freq,
+	}
+
+	tag, ok := f.shortString()
+	if !ok {
+		return f.truncated()
+	}
+	s.Tag = tag
+
+	if f.version >= 2 {
+		var event [9]byte
+		if _, err := io.ReadFull(f.r, event[:]); err != nil {
+			return f.truncated()
+		}
+		s.Kind = RecordKind(event[0])
+		s.Value = binary.LittleEndian.Uint64(event[1:])
+	}
+
+	if f.version >= 3 {
+		var flow [8]byte
+		if _, err := io.ReadFull(f.r, flow[:]); err != nil {
+			return f.truncated()
+		}
+		s.Flow = binary.LittleEndian.Uint64(flow[:])
+	}
+
+	if f.version >= 4 {
+		var perf [32]byte
+		if _, err := io.ReadFull(f.r, perf[:]); err != nil {
+			return f.truncated()
+		}
+		s.Perf = PerfCounts{
+			Cycles:       binary.LittleEndian.Uint64(perf[0:]),
+			Instructions: binary.LittleEndian.Uint64(perf[8:]),
+			LLCMisses:    binary.LittleEndian.Uint64(perf[16:]),
+			BranchMisses: binary.LittleEndian.Uint64(perf[24:]),
+		}
+	}
+
+	if f.version >= 5 {
+		var allocs [33]byte
+		if _, err := io.ReadFull(f.r, allocs[:]); err != nil {
+			return f.truncated()
+		}
+		s.Allocs = ScopeAllocations{
+			Tracked:   allocs[0] != 0,
+			Count:     binary.LittleEndian.Uint64(allocs[1:]),
+			Bytes:     binary.LittleEndian.Uint64(allocs[9:]),
+			SelfCount: binary.LittleEndian.Uint64(allocs[17:]),
+			SelfBytes: binary.LittleEndian.Uint64(allocs[25:]),
+		}
+	}
+
+	if f.version >= 6 {
+		var rusage [33]byte
+		if _, err := io.ReadFull(f.r, rusage[:]); err != nil {
+			return f.truncated()
+		}
+		s.Rusage = ResourceUsage{
+			Sampled:             rusage[0] != 0,
+			VoluntarySwitches:   binary.LittleEndian.Uint64(rusage[1:]),
+			InvoluntarySwitches: binary.LittleEndian.Uint64(rusage[9:]),
+			MinorFaults:         binary.LittleEndian.Uint64(rusage[17:]),
+			MajorFaults:         binary.LittleEndian.Uint64(rusage[25:]),
+		}
+	}
+
+	count, err := f.r.ReadByte()
+	if err != nil {
+		return f.truncated()
+	}
+
+	s.MaxBufferSize = uint64(count)
+	s.MaxOffset = count
+	s.Metadata = make([]MetadataEntry, count)
+
+	for i := range s.Metadata {
+		key, ok := f.shortString()
+		if !ok {
+			return f.truncated()
+		}
+
+		var value [9]byte
+		if _, err := io.ReadFull(f.r, value[:]); err != nil {
+			return f.truncated()
+		}
+
+		m := MetadataEntry{
+			Tag:   key,
+			Type:  MetadataType(value[0]),
+			Value: binary.LittleEndian.Uint64(value[1:]),
+		}
+
+		switch {
+		case m.Type == MetadataTypeString:
+			m.Text = inlineMetadataString(m.Value)
+		case m.Type == MetadataTypeStringID && f.version >= 7:
+			var n [2]byte
+			if _, err := io.ReadFull(f.r, n[:]); err != nil {
+				return f.truncated()
+			}
+			text := make([]byte, binary.LittleEndian.Uint16(n[:]))
+			if _, err := io.ReadFull(f.r, text); err != nil {
+				return f.truncated()
+			}
+			m.Text = string(text)
+		}
+
+		s.Metadata[i] = m
+	}
+
+	if f.freq > 0 && s.TicksEnd >= s.TicksStart {
+		s.ElapsedSeconds = float64(s.TicksEnd-s.TicksStart) / float64(f.freq)
+	}
+
+	return s, nil
+}
+
+func (f *flightReader) shortString() (string, bool) {
+	n, err := f.r.ReadByte()
+	if err != nil {
+		return "", false
+	}
+	if _, err := io.ReadFull(f.r, f.buf[:n]); err != nil {
+		return "", false
+	}
+	return string(f.buf[:n]), true
+}
+
+// truncated ends the stream: a process killed part way through its dump
+// leaves a partial last record, and everything before it is still good.
+func (f *flightReader) truncated() (ScopeInfo, error) {
+	log.Printf("Warning: flight recorder dump is truncated; ignoring the partial last record")
+	return ScopeInfo{}, io.EOF
+}
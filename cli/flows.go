@@ -0,0 +1,323 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"io"
+	"log"
+	"os"
+	"sort"
+
+	"github.com/jedib0t/go-pretty/v6/table"
+	"github.com/urfave/cli/v2"
+)
+
+// FlowHop is one top-level scope on a flow's path: the queue it was taken
+// from (the last RSP_FLOW_ENQUEUE marker before it, if any), how long the
+// flow waited before the scope began, and how long the scope ran.
+type FlowHop struct {
+	Queue   string
+	Scope   string
+	Wait    float64 // ms
+	Service float64 // ms
+}
+
+// Flow is the reconstructed path of one flow id through the capture.
+type Flow struct {
+	ID       uint64
+	Hops     []FlowHop
+	EndToEnd float64 // ms, first record to the end of the last scope
+}
+
+type flowRecord struct {
+	tag   string
+	kind  RecordKind
+	start uint64
+	end   uint64
+	freq  uint64
+}
+
+// SelectFlows groups every record carrying a flow id by flow and rebuilds
+// each flow's critical path.
+//
+// Within a flow, records are ordered by start time. Scopes nested inside an
+// earlier scope of the same flow are part of that hop, so only top-level
+// scopes (and any scope following an enqueue marker) become hops. A hop's wait is measured from the enqueue marker that
+// preceded it or, without one, from the end of the previous hop; the first
+// hop only waits if a marker came before it.
+func SelectFlows(filename string) ([]*Flow, error) {
+	stream, err := NewScopeInfoStream(filename)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open scope stream: %w", err)
+	}
+	defer stream.Close()
+
+	records := make(map[uint64][]flowRecord)
+
+	for {
+		s, err := stream.NextScope()
+		if err != nil {
+			if err == io.EOF {
+				break
+			}
+			return nil, fmt.Errorf("failed reading record: %w", err)
+		}
+
+		if s.Flow == 0 || s.MachineNominalFreq == 0 {
+			continue
+		}
+
+		records[s.Flow] = append(records[s.Flow], flowRecord{
+			tag:   s.Tag,
+			kind:  s.Kind,
+			start: s.TicksStart,
+			end:   s.TicksEnd,
+			freq:  s.MachineNominalFreq,
+		})
+	}
+
+	flows := make([]*Flow, 0, len(records))
+	for id, rs := range records {
+		if f := buildFlow(id, rs); f != nil {
+			flows = append(flows, f)
+		}
+	}
+
+	sort.Slice(flows, func(i, j int) bool { return flows[i].ID < flows[j].ID })
+
+	return flows, nil
+}
+
+func ticksToMs(ticks int64, freq uint64) float64 {
+	// Hand offs between cores can read a hair backwards.
+	return float64(max(ticks, 0)) / float64(freq) * 1000
+}
+
+func buildFlow(id uint64, rs []flowRecord) *Flow {
+	// Outer scopes first when two start on the same tick.
+	sort.SliceStable(rs, func(i, j int) bool {
+		if rs[i].start != rs[j].start {
+			return rs[i].start < rs[j].start
+		}
+		return rs[i].end > rs[j].end
+	})
+
+	f := &Flow{ID: id}
+
+	var (
+		queue      string
+		marked     bool
+		markTicks  uint64
+		hopStarted bool
+		hopEnd     uint64
+		lastEnd    uint64
+	)
+
+	for _, r := range rs {
+		switch r.kind {
+		case RecordKindInstant:
+			queue, marked, markTicks = r.tag, true, r.start
+			continue
+		case RecordKindScope:
+		default:
+			continue
+		}
+
+		// A scope after an enqueue marker is always the next hop, even if
+		// the consumer finished before the producer's scope closed.
+		if hopStarted && !marked && r.end <= hopEnd {
+			continue
+		}
+
+		hop := FlowHop{Scope: r.tag, Service: ticksToMs(int64(r.end-r.start), r.freq)}
+		switch {
+		case marked:
+			hop.Queue = queue
+			hop.Wait = ticksToMs(int64(r.start)-int64(markTicks), r.freq)
+		case hopStarted:
+			hop.Wait = ticksToMs(int64(r.start)-int64(hopEnd), r.freq)
+		}
+
+		f.Hops = append(f.Hops, hop)
+		hopStarted, hopEnd, marked = true, r.end, false
+		lastEnd = max(lastEnd, r.end)
+	}
+
+	if len(f.Hops) == 0 {
+		return nil
+	}
+
+	f.EndToEnd = ticksToMs(int64(lastEnd-rs[0].start), rs[0].freq)
+
+	return f
+}
+
+type hopKey struct {
+	queue string
+	scope string
+}
+
+type hopStats struct {
+	position int // sum of hop indexes, for ordering
+	waits    []float64
+	services []float64
+}
+
+func formatMs(v float64) string {
+	return fmt.Sprintf("%.3f", v)
+}
+
+// PrintFlows prints queueing delay and service time percentiles per hop,
+// then end to end latency across all flows. With slowest > 0 it also lists
+// the hops of the slowest flows.
+func PrintFlows(flows []*Flow, slowest int) {
+	stats := make(map[hopKey]*hopStats)
+	endToEnd := make([]float64, 0, len(flows))
+	totalWait, totalEndToEnd := 0.0, 0.0
+
+	for _, f := range flows {
+		for i, h := range f.Hops {
+			k := hopKey{queue: h.Queue, scope: h.Scope}
+			st, ok := stats[k]
+			if !ok {
+				st = &hopStats{}
+				stats[k] = st
+			}
+			st.position += i
+			st.waits = append(st.waits, h.Wait)
+			st.services = append(st.services, h.Service)
+			totalWait += h.Wait
+		}
+		endToEnd = append(endToEnd, f.EndToEnd)
+		totalEndToEnd += f.EndToEnd
+	}
+
+	keys := make([]hopKey, 0, len(stats))
+	for k := range stats {
+		keys = append(keys, k)
+	}
+	sort.Slice(keys, func(i, j int) bool {
+		pi := float64(stats[keys[i]].position) / float64(len(stats[keys[i]].waits))
+		pj := float64(stats[keys[j]].position) / float64(len(stats[keys[j]].waits))
+		if pi != pj {
+			return pi < pj
+		}
+		if keys[i].queue != keys[j].queue {
+			return keys[i].queue < keys[j].queue
+		}
+		return keys[i].scope < keys[j].scope
+	})
+
+	t := table.NewWriter()
+	t.SetOutputMirror(os.Stdout)
+	t.AppendHeader(table.Row{"Queue", "Scope", "Count",
+		"Wait p50 (ms)", "Wait p95 (ms)", "Wait p99 (ms)",
+		"Service p50 (ms)", "Service p95 (ms)", "Service p99 (ms)"})
+
+	for _, k := range keys {
+		st := stats[k]
+		w50, w95, w99 := ComputePercentiles(st.waits)
+		s50, s95, s99 := ComputePercentiles(st.services)
+
+		queue := k.queue
+		if queue == "" {
+			queue = "-"
+		}
+
+		t.AppendRow(table.Row{queue, k.scope, len(st.waits),
+			formatMs(w50), formatMs(w95), formatMs(w99),
+			formatMs(s50), formatMs(s95), formatMs(s99)})
+	}
+
+	t.Render()
+
+	e50, e95, e99 := ComputePercentiles(endToEnd)
+	waiting := 0.0
+	if totalEndToEnd > 0 {
+		waiting = totalWait / totalEndToEnd * 100
+	}
+
+	e := table.NewWriter()
+	e.SetOutputMirror(os.Stdout)
+	e.AppendHeader(table.Row{"Flows", "End to end p50 (ms)", "End to end p95 (ms)", "End to end p99 (ms)", "Time waiting"})
+	e.AppendRow(table.Row{len(flows), formatMs(e50), formatMs(e95), formatMs(e99), fmt.Sprintf("%.1f%%", waiting)})
+	e.Render()
+
+	if slowest <= 0 {
+		return
+	}
+
+	sorted := make([]*Flow, len(flows))
+	copy(sorted, flows)
+	sort.SliceStable(sorted, func(i, j int) bool { return sorted[i].EndToEnd > sorted[j].EndToEnd })
+
+	p := table.NewWriter()
+	p.SetOutputMirror(os.Stdout)
+	p.AppendHeader(table.Row{"Flow", "End to end (ms)", "Hop", "Queue", "Scope", "Wait (ms)", "Service (ms)"})
+
+	for _, f := range sorted[:min(slowest, len(sorted))] {
+		for i, h := range f.Hops {
+			id, total := "", ""
+			if i == 0 {
+				id, total = fmt.Sprintf("%#x", f.ID), formatMs(f.EndToEnd)
+			}
+
+			queue := h.Queue
+			if queue == "" {
+				queue = "-"
+			}
+
+			p.AppendRow(table.Row{id, total, i, queue, h.Scope, formatMs(h.Wait), formatMs(h.Service)})
+		}
+		p.AppendSeparator()
+	}
+
+	p.Render()
+}
+
+var FlowsCommand = &cli.Command{
+	Name:      "flows",
+	Usage:     "Rebuild each flow's path across threads and queues, splitting queueing delay from service time per hop.",
+	ArgsUsage: "<filename>",
+	Flags: []cli.Flag{
+		&cli.IntFlag{
+			Name:  "slowest",
+			Usage: "Also print the hops of the N slowest flows.",
+		},
+	},
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 1 {
+			return fmt.Errorf("missing filename\nUsage: rsp flows [--slowest N] <filename>")
+		}
+
+		filename := c.Args().Get(0)
+
+		flows, err := SelectFlows(filename)
+		if err != nil {
+			log.Fatal(err)
+		}
+
+		if len(flows) == 0 {
+			log.Fatalf("No records with a flow id found in %s", filename)
+		}
+
+		PrintFlows(flows, c.Int("slowest"))
+
+		return nil
+	},
+}
@@ -0,0 +1,382 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"hash/crc32"
+	"io"
+	"log"
+	"runtime"
+	"sync"
+
+	"github.com/AFWareLLC/rsp/RSP"
+)
+
+// Reader for the framed capture format written by rsp::BinaryDiskSink and
+// rsp::AsyncDiskSink (see include/afware/rsp/CaptureFormat.hpp for the
+// layout).
+
+var (
+	framedCaptureMagic = []byte("RSPCAP01")
+	frameSyncMarker    = []byte{0xF5, 0x52, 0x53, 0x50, 0x46, 0x52, 0x4D, 0xA7}
+)
+
+const (
+	framedCaptureVersion = 1
+	frameHeaderSize      = 24
+)
+
+// CaptureHeader describes where a framed capture came from.
+type CaptureHeader struct {
+	Version     uint32
+	NominalFreq uint64
+	ClockSource string
+	Host        string
+	CPUModel    string
+	BuildFlags  string
+	Process     uint32 // 0 for captures from before it was recorded.
+
+	// Size of the header on disk; frames start here.
+	Size int64
+}
+
+var errCorruptCaptureHeader = errors.New("corrupt capture header")
+
+// readCaptureHeader parses the header at the start of r, which must be
+// positioned just past the magic.
+func readCaptureHeader(r io.Reader) (CaptureHeader, error) {
+	var h CaptureHeader
+
+	var fixed [8]byte
+	if _, err := io.ReadFull(r, fixed[:]); err != nil {
+		return h, errCorruptCaptureHeader
+	}
+
+	h.Version = binary.LittleEndian.Uint32(fixed[0:])
+	fieldsLen := binary.LittleEndian.Uint32(fixed[4:])
+	if h.Version != framedCaptureVersion || fieldsLen > 1<<20 {
+		return h, fmt.Errorf("%w: version %d, %d bytes of fields", errCorruptCaptureHeader, h.Version, fieldsLen)
+	}
+
+	fields := make([]byte, fieldsLen+4)
+	if _, err := io.ReadFull(r, fields); err != nil {
+		return h, errCorruptCaptureHeader
+	}
+
+	if crc32.ChecksumIEEE(fields[:fieldsLen]) != binary.LittleEndian.Uint32(fields[fieldsLen:]) {
+		return h, fmt.Errorf("%w: bad checksum", errCorruptCaptureHeader)
+	}
+
+	d := fields[:fieldsLen]
+	str := func() string {
+		if len(d) < 2 {
+			return ""
+		}
+		n := int(binary.LittleEndian.Uint16(d))
+		if len(d) < 2+n {
+			d = nil
+			return ""
+		}
+		s := string(d[2 : 2+n])
+		d = d[2+n:]
+		return s
+	}
+
+	if len(d) >= 8 {
+		h.NominalFreq = binary.LittleEndian.Uint64(d)
+		d = d[8:]
+	}
+
+	h.ClockSource = str()
+	h.Host = str()
+	h.CPUModel = str()
+	h.BuildFlags = str()
+
+	if len(d) >= 4 {
+		h.Process = binary.LittleEndian.Uint32(d)
+	}
+
+	h.Size = int64(len(framedCaptureMagic)) + 8 + int64(fieldsLen) + 4
+
+	return h, nil
+}
+
+// framedReader yields the records of a framed capture a frame at a time.
+// Frames that fail their checksums are skipped, and reading resumes at the
+// next sync marker.
+//
+// A reader can also be limited to the frames whose sync marker starts
+// before end, so that a capture can be split into sections and read in
+// parallel (see splitFramedCapture).
+type framedReader struct {
+	r     *bufio.Reader
+	start int64 // File offset the reader started at.
+	pos   int64 // File offset of the next byte of r.
+	end   int64 // Frames starting here or later belong to someone else; -1 for none.
+
+	payload   []byte
+	remaining uint32
+
+	skipped   int64 // Bytes dropped while resyncing.
+	truncated bool  // The capture ends part way through a frame.
+	reported  bool
+}
+
+func newFramedReader(r io.Reader, pos int64, end int64) *framedReader {
+	return &framedReader{r: bufio.NewReaderSize(r, 1<<20), start: pos, pos: pos, end: end}
+}
+
+func (fr *framedReader) discard(n int) {
+	d, _ := fr.r.Discard(n)
+	fr.pos += int64(d)
+}
+
+// seek moves to the next sync marker at or after the current position,
+// returning how many bytes it passed over, and io.EOF if there isn't one
+// (in our section).
+func (fr *framedReader) seek() (int64, error) {
+	var skipped int64
+
+	for {
+		if fr.end >= 0 && fr.pos >= fr.end {
+			return skipped, io.EOF
+		}
+
+		buf, err := fr.r.Peek(fr.r.Size())
+		if i := bytes.Index(buf, frameSyncMarker); i >= 0 {
+			fr.discard(i)
+			return skipped + int64(i), nil
+		}
+
+		if err != nil {
+			fr.discard(len(buf))
+			return skipped + int64(len(buf)), err
+		}
+
+		// Keep the tail, in case it's the start of a marker.
+		n := len(buf) - len(frameSyncMarker) + 1
+		fr.discard(n)
+		skipped += int64(n)
+	}
+}
+
+func (fr *framedReader) readFrame() error {
+	for {
+		if fr.end >= 0 && fr.pos >= fr.end {
+			return io.EOF
+		}
+
+		h, err := fr.r.Peek(frameHeaderSize)
+		if err != nil && err != io.EOF {
+			return err
+		}
+
+		if len(h) < frameHeaderSize {
+			if len(h) > 0 {
+				fr.truncated = true
+				fr.skipped += int64(len(h))
+				fr.discard(len(h))
+			}
+			return io.EOF
+		}
+
+		if !bytes.Equal(h[:8], frameSyncMarker) || crc32.ChecksumIEEE(h[:20]) != binary.LittleEndian.Uint32(h[20:]) {
+			// Not a frame (or a damaged one): step past it and look for the next.
+			fr.discard(1)
+			skipped, err := fr.seek()
+			fr.skipped += skipped + 1
+			if err != nil {
+				return err
+			}
+			continue
+		}
+
+		length := binary.LittleEndian.Uint32(h[8:])
+		count := binary.LittleEndian.Uint32(h[12:])
+		crc := binary.LittleEndian.Uint32(h[16:])
+		fr.discard(frameHeaderSize)
+
+		// Records hand out slices of the payload, so it can't be reused.
+		payload := make([]byte, length)
+		n, err := io.ReadFull(fr.r, payload)
+		fr.pos += int64(n)
+		if err != nil {
+			if err == io.EOF || err == io.ErrUnexpectedEOF {
+				fr.truncated = true
+				fr.skipped += frameHeaderSize + int64(n)
+				return io.EOF
+			}
+			return err
+		}
+
+		if crc32.ChecksumIEEE(payload) != crc {
+			fr.skipped += frameHeaderSize + int64(length)
+			continue
+		}
+
+		fr.payload, fr.remaining = payload, count
+		return nil
+	}
+}
+
+// Next returns the next raw FlatBuffer record, or io.EOF when done.
+func (fr *framedReader) Next() (*RSP.ScopeInfo, error) {
+	for {
+		for fr.remaining == 0 {
+			if err := fr.readFrame(); err != nil {
+				if err == io.EOF {
+					fr.report()
+				}
+				return nil, err
+			}
+		}
+
+		if len(fr.payload) >= 4 {
+			length := binary.LittleEndian.Uint32(fr.payload)
+			if uint64(len(fr.payload)-4) >= uint64(length) {
+				scope := RSP.GetRootAsScopeInfo(fr.payload[4:4+length], 0)
+				fr.payload = fr.payload[4+length:]
+				fr.remaining--
+				return scope, nil
+			}
+		}
+
+		// A record running past the end of its frame: skip the rest of the
+		// frame and carry on with the next one.
+		fr.skipped += int64(len(fr.payload))
+		fr.payload, fr.remaining = nil, 0
+	}
+}
+
+// report logs, once, anything that was lost to corruption.
+func (fr *framedReader) report() {
+	if fr.reported {
+		return
+	}
+	fr.reported = true
+
+	if fr.skipped > 0 {
+		log.Printf("Warning: skipped %d bytes of corrupt capture data", fr.skipped)
+	}
+	if fr.truncated {
+		log.Printf("Warning: capture ends with a partial frame (truncated?)")
+	}
+}
+
+// splitFramedCapture divides the frames of a capture, from offset start to
+// size, into up to n sections of roughly equal size, as [start, end) offsets.
+// A section's reader starts at the first sync marker at or after start, and
+// owns every frame whose marker is before end.
+func splitFramedCapture(start, size int64, n int) [][2]int64 {
+	body := size - start
+
+	// Not worth splitting finer than a few frames.
+	const minSection = 4 << 20
+	if max := int(body / minSection); n > max {
+		n = max
+	}
+	if n < 1 {
+		return [][2]int64{{start, size}}
+	}
+
+	sections := make([][2]int64, 0, n)
+	for i := 0; i < n; i++ {
+		sections = append(sections, [2]int64{start + body*int64(i)/int64(n), start + body*int64(i+1)/int64(n)})
+	}
+
+	return sections
+}
+
+// framedSections splits the stream's capture for readFramedSections.
+func (s *ScopeInfoStream) framedSections() ([][2]int64, error) {
+	st, err := s.f.Stat()
+	if err != nil {
+		return nil, err
+	}
+
+	return splitFramedCapture(s.framed.start, st.Size(), runtime.GOMAXPROCS(0)), nil
+}
+
+// readFramedSections decodes sections of a framed capture concurrently. fn
+// sees the records of section i in file order, always on the same
+// goroutine, so per-section state needs no locking; concatenating the
+// sections' results in order gives the file order.
+func (s *ScopeInfoStream) readFramedSections(sections [][2]int64, fn func(i int, scope ScopeInfo)) error {
+	st, err := s.f.Stat()
+	if err != nil {
+		return err
+	}
+
+	readers := make([]*framedReader, len(sections))
+	errs := make([]error, len(sections))
+
+	var wg sync.WaitGroup
+	for i, section := range sections {
+		readers[i] = newFramedReader(io.NewSectionReader(s.f, section[0], st.Size()-section[0]), section[0], section[1])
+		readers[i].reported = true // We report for all of them below.
+
+		wg.Add(1)
+		go func(i int, fr *framedReader) {
+			defer wg.Done()
+
+			// Sections after the first start mid-frame; that's not corruption.
+			if i > 0 {
+				if _, err := fr.seek(); err != nil {
+					if err != io.EOF {
+						errs[i] = err
+					}
+					return
+				}
+			}
+
+			// Frames spell out each interned string on first use, so a
+			// section needs no text from the ones before it.
+			strings := make(stringResolver)
+
+			for {
+				fb, err := fr.Next()
+				if err != nil {
+					if err != io.EOF {
+						errs[i] = err
+					}
+					return
+				}
+				scope := ConvertScopeInfo(fb)
+				strings.resolve(&scope)
+				fn(i, scope)
+			}
+		}(i, readers[i])
+	}
+	wg.Wait()
+
+	total := &framedReader{}
+	for i, fr := range readers {
+		if errs[i] != nil {
+			return errs[i]
+		}
+		total.skipped += fr.skipped
+		total.truncated = total.truncated || fr.truncated
+	}
+	total.report()
+
+	return nil
+}
@@ -0,0 +1,174 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"io"
+	"log"
+	"os"
+	"sort"
+
+	"github.com/jedib0t/go-pretty/v6/table"
+	"github.com/urfave/cli/v2"
+)
+
+// MetadataGroup holds the durations of one scope's records that share a
+// value of the grouping key.
+type MetadataGroup struct {
+	Value   string
+	Missing bool // The records had no such key.
+	TimesMs []float64
+	TotalMs float64
+}
+
+// GroupByMetadata splits the durations of scope by the value of its key
+// metadata - the text of string metadata, the number otherwise - keeping
+// only records that pass filter (nil for all of them). Groups are ranked by
+// total time.
+func GroupByMetadata(filename, scope, key string, filter *MetadataFilter) ([]*MetadataGroup, error) {
+	stream, err := NewScopeInfoStream(filename)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open scope stream: %w", err)
+	}
+	defer stream.Close()
+
+	byValue := make(map[string]*MetadataGroup)
+	var missing *MetadataGroup
+
+	for {
+		s, err := stream.NextScope()
+		if err != nil {
+			if err == io.EOF {
+				break
+			}
+			return nil, fmt.Errorf("failed reading record: %w", err)
+		}
+
+		if s.Kind != RecordKindScope || s.Tag != scope {
+			continue
+		}
+
+		if filter != nil && !filter.MatchesScope(s) {
+			continue
+		}
+
+		var g *MetadataGroup
+		for _, m := range s.Metadata {
+			if m.Tag != key {
+				continue
+			}
+			value := MetadataDisplayValue(m)
+			if g = byValue[value]; g == nil {
+				g = &MetadataGroup{Value: value}
+				byValue[value] = g
+			}
+			break
+		}
+
+		if g == nil {
+			if missing == nil {
+				missing = &MetadataGroup{Value: fmt.Sprintf("(no %s)", key), Missing: true}
+			}
+			g = missing
+		}
+
+		ms := s.ElapsedSeconds * 1000
+		g.TimesMs = append(g.TimesMs, ms)
+		g.TotalMs += ms
+	}
+
+	result := make([]*MetadataGroup, 0, len(byValue)+1)
+	for _, g := range byValue {
+		result = append(result, g)
+	}
+	if missing != nil {
+		result = append(result, missing)
+	}
+
+	sort.Slice(result, func(i, j int) bool {
+		if result[i].TotalMs != result[j].TotalMs {
+			return result[i].TotalMs > result[j].TotalMs
+		}
+		return result[i].Value < result[j].Value
+	})
+
+	return result, nil
+}
+
+func PrintMetadataGroups(key string, groups []*MetadataGroup) {
+	t := table.NewWriter()
+	t.SetOutputMirror(os.Stdout)
+	t.AppendHeader(table.Row{key, "Calls", "Total (ms)", "Mean (ms)", "p50 (ms)", "p95 (ms)", "p99 (ms)"})
+
+	for _, g := range groups {
+		p50, p95, p99 := ComputePercentiles(g.TimesMs)
+		t.AppendRow(table.Row{
+			g.Value,
+			len(g.TimesMs),
+			fmt.Sprintf("%.3f", g.TotalMs),
+			fmt.Sprintf("%.3f", g.TotalMs/float64(len(g.TimesMs))),
+			fmt.Sprintf("%.3f", p50),
+			fmt.Sprintf("%.3f", p95),
+			fmt.Sprintf("%.3f", p99),
+		})
+	}
+
+	t.Render()
+}
+
+var GroupCommand = &cli.Command{
+	Name:      "group",
+	Usage:     "Break a scope's durations down by the value of one of its metadata keys, e.g. a shard or symbol name.",
+	ArgsUsage: "<filename> <scope> <key>",
+	Flags: []cli.Flag{
+		&cli.StringFlag{
+			Name:  "where",
+			Usage: "Only include entries with matching metadata, e.g. 'bytes>=4096' or 'shard=eu' (ops: = != < <= > >=).",
+		},
+	},
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 3 {
+			return fmt.Errorf("missing arguments\nUsage: rsp group [--where <filter>] <filename> <scope> <key>")
+		}
+
+		filename := c.Args().Get(0)
+		scope := c.Args().Get(1)
+		key := c.Args().Get(2)
+
+		var filter *MetadataFilter
+		if c.IsSet("where") {
+			var err error
+			if filter, err = ParseMetadataFilter(c.String("where")); err != nil {
+				return err
+			}
+		}
+
+		groups, err := GroupByMetadata(filename, scope, key, filter)
+		if err != nil {
+			log.Fatal(err)
+		}
+
+		if len(groups) == 0 {
+			log.Fatalf("No entries found for scope %s", scope)
+		}
+
+		PrintMetadataGroups(key, groups)
+
+		return nil
+	},
+}
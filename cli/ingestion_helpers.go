@@ -19,9 +19,40 @@ package main
 import (
 	"fmt"
 	"io"
+	"strconv"
+	"strings"
 )
 
+// SelectScopes, CountByScope and ScopeDurationsMs only look at timed scopes;
+// counter, gauge and instant records are read through SelectSeries. Given a
+// directory or glob of segments (see CaptureFiles), they read the segments
+// concurrently and combine the results in segment order.
 func SelectScopes(filename string, scopeTags []string) (map[string][]ScopeInfo, error) {
+	files, err := CaptureFiles(filename)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open scope stream: %w", err)
+	}
+
+	partial := make([]map[string][]ScopeInfo, len(files))
+	err = forEachCapture(files, func(i int, file string) (err error) {
+		partial[i], err = selectScopes(file, scopeTags)
+		return err
+	})
+	if err != nil {
+		return nil, err
+	}
+
+	result := partial[0]
+	for _, p := range partial[1:] {
+		for tag, scopes := range p {
+			result[tag] = append(result[tag], scopes...)
+		}
+	}
+
+	return result, nil
+}
+
+func selectScopes(filename string, scopeTags []string) (map[string][]ScopeInfo, error) {
 	wanted := make(map[string]struct{}, len(scopeTags))
 	for _, t := range scopeTags {
 		wanted[t] = struct{}{}
@@ -35,8 +66,42 @@ func SelectScopes(filename string, scopeTags []string) (map[string][]ScopeInfo,
 	}
 	defer stream.Close()
 
+	// Columnar captures can skip the other tags' chunks entirely.
+	if stream.columns != nil {
+		stream.columns.only = wanted
+	}
+
+	if stream.framed != nil {
+		sections, err := stream.framedSections()
+		if err != nil {
+			return nil, err
+		}
+
+		partial := make([]map[string][]ScopeInfo, len(sections))
+		for i := range partial {
+			partial[i] = make(map[string][]ScopeInfo)
+		}
+
+		err = stream.readFramedSections(sections, func(i int, s ScopeInfo) {
+			if _, ok := wanted[s.Tag]; ok && s.Kind == RecordKindScope {
+				partial[i][s.Tag] = append(partial[i][s.Tag], s)
+			}
+		})
+		if err != nil {
+			return nil, fmt.Errorf("failed reading scope: %w", err)
+		}
+
+		for _, p := range partial {
+			for tag, scopes := range p {
+				result[tag] = append(result[tag], scopes...)
+			}
+		}
+
+		return result, nil
+	}
+
 	for {
-		fbScope, err := stream.Next()
+		s, err := stream.NextScope()
 		if err != nil {
 			if err == io.EOF {
 				break
@@ -44,10 +109,8 @@ func SelectScopes(filename string, scopeTags []string) (map[string][]ScopeInfo,
 			return nil, fmt.Errorf("failed reading scope: %w", err)
 		}
 
-		s := ConvertScopeInfo(fbScope)
-
 		// Only select matching tags
-		if _, ok := wanted[s.Tag]; ok {
+		if _, ok := wanted[s.Tag]; ok && s.Kind == RecordKindScope {
 			result[s.Tag] = append(result[s.Tag], s)
 		}
 	}
@@ -56,6 +119,31 @@ func SelectScopes(filename string, scopeTags []string) (map[string][]ScopeInfo,
 }
 
 func CountByScope(filename string) (map[string]int, error) {
+	files, err := CaptureFiles(filename)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open scope stream: %w", err)
+	}
+
+	partial := make([]map[string]int, len(files))
+	err = forEachCapture(files, func(i int, file string) (err error) {
+		partial[i], err = countByScope(file)
+		return err
+	})
+	if err != nil {
+		return nil, err
+	}
+
+	counts := partial[0]
+	for _, p := range partial[1:] {
+		for tag, n := range p {
+			counts[tag] += n
+		}
+	}
+
+	return counts, nil
+}
+
+func countByScope(filename string) (map[string]int, error) {
 	counts := make(map[string]int)
 
 	stream, err := NewScopeInfoStream(filename)
@@ -65,18 +153,233 @@ func CountByScope(filename string) (map[string]int, error) {
 
 	defer stream.Close()
 
+	// Columnar captures keep the counts in their footer.
+	if stream.columns != nil {
+		return stream.columns.file.Counts(), nil
+	}
+
+	if stream.framed != nil {
+		sections, err := stream.framedSections()
+		if err != nil {
+			return nil, err
+		}
+
+		partial := make([]map[string]int, len(sections))
+		for i := range partial {
+			partial[i] = make(map[string]int)
+		}
+
+		err = stream.readFramedSections(sections, func(i int, s ScopeInfo) {
+			if s.Kind == RecordKindScope {
+				partial[i][s.Tag]++
+			}
+		})
+		if err != nil {
+			return nil, fmt.Errorf("failed reading scope entry: %w", err)
+		}
+
+		for _, p := range partial {
+			for tag, n := range p {
+				counts[tag] += n
+			}
+		}
+
+		return counts, nil
+	}
+
 	for {
-		fbScope, err := stream.Next()
+		s, err := stream.NextScope()
 		if err != nil {
 			if err == io.EOF {
 				break
 			}
 			return nil, fmt.Errorf("failed reading scope entry: %w", err)
 		}
-
-		s := ConvertScopeInfo(fbScope)
-		counts[s.Tag]++
+		if s.Kind == RecordKindScope {
+			counts[s.Tag]++
+		}
 	}
 
 	return counts, nil
 }
+
+// MetadataFilter selects entries by a metadata value, e.g. "bytes>=4096"
+// or "shard=eu-west". Numbers are compared numerically, per the entry's
+// type; string metadata only supports = and !=, against the text. Entries
+// without the key never match.
+type MetadataFilter struct {
+	Key   string
+	Op    string
+	Value float64
+	Text  string
+
+	// Whether the value parsed as a number; if not, only string metadata
+	// can match.
+	Numeric bool
+}
+
+var metadataFilterOps = []string{">=", "<=", "!=", "=", "<", ">"}
+
+func ParseMetadataFilter(expr string) (*MetadataFilter, error) {
+	for i := 0; i < len(expr); i++ {
+		for _, op := range metadataFilterOps {
+			if !strings.HasPrefix(expr[i:], op) {
+				continue
+			}
+
+			text := strings.TrimSpace(expr[i+len(op):])
+			value, err := strconv.ParseFloat(text, 64)
+			key := strings.TrimSpace(expr[:i])
+			if key == "" || (err != nil && op != "=" && op != "!=") {
+				return nil, fmt.Errorf("bad filter %q, expected <key><op><number> with op one of %v, or <key>=<text>", expr, metadataFilterOps)
+			}
+
+			return &MetadataFilter{Key: key, Op: op, Value: value, Text: text, Numeric: err == nil}, nil
+		}
+	}
+
+	return nil, fmt.Errorf("bad filter %q, expected <key><op><number> with op one of %v, or <key>=<text>", expr, metadataFilterOps)
+}
+
+func (f *MetadataFilter) compare(v float64) bool {
+	switch f.Op {
+	case "=":
+		return v == f.Value
+	case "!=":
+		return v != f.Value
+	case "<":
+		return v < f.Value
+	case "<=":
+		return v <= f.Value
+	case ">":
+		return v > f.Value
+	case ">=":
+		return v >= f.Value
+	}
+	return false
+}
+
+// Matches tests a single metadata entry.
+func (f *MetadataFilter) Matches(m MetadataEntry) bool {
+	if m.Tag != f.Key {
+		return false
+	}
+	if m.IsString() {
+		switch f.Op {
+		case "=":
+			return m.Text == f.Text
+		case "!=":
+			return m.Text != f.Text
+		}
+		return false
+	}
+	return f.Numeric && f.compare(MetadataNumericValue(m))
+}
+
+// MatchesScope is true if any of the entry's metadata matches.
+func (f *MetadataFilter) MatchesScope(s ScopeInfo) bool {
+	for _, m := range s.Metadata {
+		if f.Matches(m) {
+			return true
+		}
+	}
+	return false
+}
+
+// MayMatch is false only if no value in [min, max] can match.
+func (f *MetadataFilter) MayMatch(min, max float64) bool {
+	switch f.Op {
+	case "=":
+		return min <= f.Value && f.Value <= max
+	case "!=":
+		return !(min == f.Value && max == f.Value)
+	case "<":
+		return min < f.Value
+	case "<=":
+		return min <= f.Value
+	case ">":
+		return max > f.Value
+	case ">=":
+		return max >= f.Value
+	}
+	return true
+}
+
+// ScopeDurationsMs returns the elapsed times, in milliseconds, of the
+// entries for scope that pass filter (nil for all of them). Columnar
+// captures only read the columns involved.
+func ScopeDurationsMs(filename string, scope string, filter *MetadataFilter) ([]float64, error) {
+	files, err := CaptureFiles(filename)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open scope stream: %w", err)
+	}
+
+	partial := make([][]float64, len(files))
+	err = forEachCapture(files, func(i int, file string) (err error) {
+		partial[i], err = scopeDurationsMs(file, scope, filter)
+		return err
+	})
+	if err != nil {
+		return nil, err
+	}
+
+	var times []float64
+	for _, p := range partial {
+		times = append(times, p...)
+	}
+
+	return times, nil
+}
+
+func scopeDurationsMs(filename string, scope string, filter *MetadataFilter) ([]float64, error) {
+	stream, err := NewScopeInfoStream(filename)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open scope stream: %w", err)
+	}
+	defer stream.Close()
+
+	if stream.columns != nil {
+		return stream.columns.file.Durations(scope, filter)
+	}
+
+	var times []float64
+
+	if stream.framed != nil {
+		sections, err := stream.framedSections()
+		if err != nil {
+			return nil, err
+		}
+
+		partial := make([][]float64, len(sections))
+		err = stream.readFramedSections(sections, func(i int, s ScopeInfo) {
+			if s.Tag == scope && s.Kind == RecordKindScope && (filter == nil || filter.MatchesScope(s)) {
+				partial[i] = append(partial[i], s.ElapsedSeconds*1000)
+			}
+		})
+		if err != nil {
+			return nil, fmt.Errorf("failed reading scope: %w", err)
+		}
+
+		for _, p := range partial {
+			times = append(times, p...)
+		}
+
+		return times, nil
+	}
+
+	for {
+		s, err := stream.NextScope()
+		if err != nil {
+			if err == io.EOF {
+				break
+			}
+			return nil, fmt.Errorf("failed reading scope: %w", err)
+		}
+
+		if s.Tag == scope && s.Kind == RecordKindScope && (filter == nil || filter.MatchesScope(s)) {
+			times = append(times, s.ElapsedSeconds*1000)
+		}
+	}
+
+	return times, nil
+}
@@ -31,6 +31,18 @@ func main() {
 			TimingsCommand,
 			ScopeEntryCountCommand,
 			PercentilesOnlyCommand,
+			BenchCommand,
+			TailCommand,
+			ConvertCommand,
+			SeriesCommand,
+			FlowsCommand,
+			PerfCommand,
+			AllocsCommand,
+			OffCPUCommand,
+			GroupCommand,
+			MergeCommand,
+			AlignCommand,
+			CollectCommand,
 		},
 	}
 
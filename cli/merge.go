@@ -0,0 +1,253 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"container/heap"
+	"fmt"
+	"io"
+	"log"
+	"math"
+	"os"
+	"sort"
+
+	"github.com/urfave/cli/v2"
+)
+
+// mergeInput is one process' capture: a single file, or the segments of
+// one rotated series, read in order. next returns its records one by one,
+// and io.EOF at the end.
+type mergeInput struct {
+	name  string
+	order int
+	next  func() (ScopeInfo, error)
+	head  ScopeInfo
+}
+
+// mergeHeap orders inputs by the end tick of their next record (records
+// are written as scopes end), then by input order so that ties are stable.
+type mergeHeap []*mergeInput
+
+func (h mergeHeap) Len() int { return len(h) }
+
+func (h mergeHeap) Less(i, j int) bool {
+	if h[i].head.TicksEnd != h[j].head.TicksEnd {
+		return h[i].head.TicksEnd < h[j].head.TicksEnd
+	}
+	return h[i].order < h[j].order
+}
+
+func (h mergeHeap) Swap(i, j int) { h[i], h[j] = h[j], h[i] }
+
+func (h *mergeHeap) Push(x any) { *h = append(*h, x.(*mergeInput)) }
+
+func (h *mergeHeap) Pop() any {
+	last := (*h)[len(*h)-1]
+	*h = (*h)[:len(*h)-1]
+	return last
+}
+
+// mergeRecords streams every input's records into cw in end tick order.
+// Each input is only read one record ahead.
+func mergeRecords(inputs []*mergeInput, cw *columnarWriter) (records int, err error) {
+	h := make(mergeHeap, 0, len(inputs))
+
+	for _, in := range inputs {
+		in.head, err = in.next()
+		if err == io.EOF {
+			continue
+		}
+		if err != nil {
+			return 0, fmt.Errorf("%s: %w", in.name, err)
+		}
+		heap.Push(&h, in)
+	}
+
+	for h.Len() > 0 {
+		in := h[0]
+
+		if err := cw.add(in.head); err != nil {
+			return records, err
+		}
+		records++
+
+		in.head, err = in.next()
+		switch {
+		case err == io.EOF:
+			heap.Pop(&h)
+		case err != nil:
+			return records, fmt.Errorf("%s: %w", in.name, err)
+		default:
+			heap.Fix(&h, 0)
+		}
+	}
+
+	return records, nil
+}
+
+// mergeSeries groups the expanded capture files into inputs: the segments
+// of a rotated series (same stem and extension) are one input, anything
+// else is one input per file.
+func mergeSeries(args []string) ([][]string, error) {
+	var series [][]string
+	index := make(map[string]int)
+
+	for _, arg := range args {
+		files, err := CaptureFiles(arg)
+		if err != nil {
+			return nil, err
+		}
+
+		for _, file := range files {
+			key := file
+			if m := segmentName.FindStringSubmatch(file); m != nil {
+				key = m[1] + "\x00" + m[4]
+			}
+
+			if i, ok := index[key]; ok {
+				series[i] = append(series[i], file)
+				continue
+			}
+			index[key] = len(series)
+			series = append(series, []string{file})
+		}
+	}
+
+	return series, nil
+}
+
+// MergeCaptures combines per-process captures (as written by children
+// with fork following on) into one columnar capture on their common TSC
+// timeline. Each input is streamed, so memory use is one record per input
+// plus the columnar writer's pending chunks.
+func MergeCaptures(args []string, output string, chunkRows int) (records int, pids []uint64, err error) {
+	series, err := mergeSeries(args)
+	if err != nil {
+		return 0, nil, err
+	}
+
+	var streams []*ScopeInfoStream
+	defer func() {
+		for _, stream := range streams {
+			stream.Close()
+		}
+	}()
+
+	var first *CaptureHeader
+	seen := make(map[uint64]bool)
+
+	inputs := make([]*mergeInput, len(series))
+	for i, files := range series {
+		stream, err := newScopeInfoStreamFiles(files)
+		if err != nil {
+			return 0, nil, err
+		}
+		streams = append(streams, stream)
+
+		// Nominal frequencies are measured at start up, so differ a
+		// little from run to run even on one machine.
+		if hdr := stream.Header; hdr != nil {
+			switch {
+			case first == nil:
+				first = hdr
+			case hdr.Host != first.Host:
+				log.Printf("Warning: %s was recorded on %s, not %s; its ticks are on another clock (see rsp align)",
+					files[0], hdr.Host, first.Host)
+			case math.Abs(float64(hdr.NominalFreq)/float64(first.NominalFreq)-1) > 0.01:
+				log.Printf("Warning: %s has a nominal frequency of %d Hz, not %d Hz", files[0], hdr.NominalFreq,
+					first.NominalFreq)
+			}
+		}
+
+		inputs[i] = &mergeInput{
+			name:  files[0],
+			order: i,
+			next: func() (ScopeInfo, error) {
+				s, err := stream.NextScope()
+				if err == nil && s.Process != 0 && !seen[s.Process] {
+					seen[s.Process] = true
+					pids = append(pids, s.Process)
+				}
+				return s, err
+			},
+		}
+	}
+
+	f, err := os.Create(output)
+	if err != nil {
+		return 0, nil, err
+	}
+	defer f.Close()
+
+	cw, err := newColumnarWriter(f, chunkRows)
+	if err != nil {
+		return 0, nil, err
+	}
+
+	if records, err = mergeRecords(inputs, cw); err != nil {
+		return records, nil, err
+	}
+
+	if err := cw.finish(); err != nil {
+		return records, nil, err
+	}
+
+	sort.Slice(pids, func(i, j int) bool { return pids[i] < pids[j] })
+	return records, pids, f.Close()
+}
+
+func Merge(args []string, output string, chunkRows int) {
+	records, pids, err := MergeCaptures(args, output, chunkRows)
+	if err != nil {
+		os.Remove(output)
+		log.Fatal(err)
+	}
+
+	log.Printf("Merged %d records from %d processes %v -> %s", records, len(pids), pids, output)
+}
+
+var MergeCommand = &cli.Command{
+	Name:      "merge",
+	Usage:     "Combine per-process captures into one columnar capture on a common timeline.",
+	ArgsUsage: "-o <output> <capture>...",
+	Flags: []cli.Flag{
+		&cli.StringFlag{
+			Name:     "output",
+			Aliases:  []string{"o"},
+			Usage:    "Columnar capture to write.",
+			Required: true,
+		},
+		&cli.IntFlag{
+			Name:  "chunk-rows",
+			Usage: "Maximum records per tag chunk.",
+			Value: columnarChunkRows,
+		},
+	},
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 1 {
+			return fmt.Errorf("missing filename\nUsage: rsp merge -o <output> <capture>...")
+		}
+
+		if c.Int("chunk-rows") < 1 {
+			return fmt.Errorf("--chunk-rows must be at least 1")
+		}
+
+		Merge(c.Args().Slice(), c.String("output"), c.Int("chunk-rows"))
+
+		return nil
+	},
+}
@@ -0,0 +1,218 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"io"
+	"log"
+	"os"
+	"sort"
+
+	"github.com/jedib0t/go-pretty/v6/table"
+	"github.com/urfave/cli/v2"
+	"gonum.org/v1/gonum/stat"
+)
+
+// What a sampled call's resource usage says about where its time went. A
+// call can show several at once - a major fault usually blocks too - so
+// each is counted on its own. Minor faults are serviced on the CPU.
+const (
+	signOffCPU = iota
+	signBlocked
+	signPreempted
+	signMajorFaults
+	signMinorFaults
+	signNone
+	signCount
+)
+
+var signNames = [signCount]string{"Off CPU", "Blocked", "Preempted", "Major faults", "Minor faults", "None"}
+
+func usageSigns(r ResourceUsage) [signCount]bool {
+	var signs [signCount]bool
+	signs[signBlocked] = r.VoluntarySwitches > 0
+	signs[signPreempted] = r.InvoluntarySwitches > 0
+	signs[signMajorFaults] = r.MajorFaults > 0
+	signs[signMinorFaults] = r.MinorFaults > 0
+	signs[signOffCPU] = signs[signBlocked] || signs[signPreempted] || signs[signMajorFaults]
+	signs[signNone] = !signs[signOffCPU] && !signs[signMinorFaults]
+	return signs
+}
+
+// UsagePart summarizes one side of a scope's latency split: how many of its
+// calls show each sign.
+type UsagePart struct {
+	Calls   int
+	Seconds float64
+	Signs   [signCount]int
+}
+
+func (p *UsagePart) add(s ScopeInfo) {
+	p.Calls++
+	p.Seconds += s.ElapsedSeconds
+	for sign, present := range usageSigns(s.Rusage) {
+		if present {
+			p.Signs[sign]++
+		}
+	}
+}
+
+func (p *UsagePart) share(sign int) string {
+	if p.Calls == 0 {
+		return "-"
+	}
+	return fmt.Sprintf("%.1f%%", float64(p.Signs[sign])/float64(p.Calls)*100)
+}
+
+// ScopeOffCPU splits one scope's sampled calls at a latency percentile.
+type ScopeOffCPU struct {
+	Tag       string
+	Threshold float64 // seconds
+	Tail      UsagePart
+	Rest      UsagePart
+}
+
+// SelectOffCPU reads the records sampled for resource usage (see
+// rsp::EnableResourceUsage) of the scopes in scopes (all of them if empty),
+// and for each splits its calls into the tail, at or above the given
+// percentile of duration, and the rest.
+func SelectOffCPU(filename string, scopes []string, percentile float64) ([]*ScopeOffCPU, error) {
+	wanted := make(map[string]struct{}, len(scopes))
+	for _, s := range scopes {
+		wanted[s] = struct{}{}
+	}
+
+	stream, err := NewScopeInfoStream(filename)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open scope stream: %w", err)
+	}
+	defer stream.Close()
+
+	byTag := make(map[string][]ScopeInfo)
+
+	for {
+		s, err := stream.NextScope()
+		if err != nil {
+			if err == io.EOF {
+				break
+			}
+			return nil, fmt.Errorf("failed reading record: %w", err)
+		}
+
+		if s.Kind != RecordKindScope || !s.Rusage.Sampled {
+			continue
+		}
+
+		if _, ok := wanted[s.Tag]; !ok && len(scopes) > 0 {
+			continue
+		}
+
+		s.Metadata = nil
+		byTag[s.Tag] = append(byTag[s.Tag], s)
+	}
+
+	result := make([]*ScopeOffCPU, 0, len(byTag))
+	for tag, calls := range byTag {
+		times := ExtractTimes(calls)
+		sort.Float64s(times)
+
+		o := &ScopeOffCPU{Tag: tag, Threshold: stat.Quantile(percentile/100, stat.Empirical, times, nil)}
+		for _, s := range calls {
+			if s.ElapsedSeconds >= o.Threshold {
+				o.Tail.add(s)
+			} else {
+				o.Rest.add(s)
+			}
+		}
+		result = append(result, o)
+	}
+
+	sort.Slice(result, func(i, j int) bool {
+		return result[i].Tag < result[j].Tag
+	})
+
+	return result, nil
+}
+
+func PrintOffCPU(results []*ScopeOffCPU, percentile float64) {
+	t := table.NewWriter()
+	t.SetOutputMirror(os.Stdout)
+
+	header := table.Row{"Scope", "Calls", "Mean (ms)"}
+	for _, name := range signNames {
+		header = append(header, name)
+	}
+	t.AppendHeader(header)
+
+	row := func(label string, p *UsagePart) table.Row {
+		mean := "-"
+		if p.Calls > 0 {
+			mean = fmt.Sprintf("%.3f", p.Seconds/float64(p.Calls)*1000)
+		}
+
+		r := table.Row{label, p.Calls, mean}
+		for sign := range signNames {
+			r = append(r, p.share(sign))
+		}
+		return r
+	}
+
+	for _, o := range results {
+		t.AppendRow(row(fmt.Sprintf("%s: >= p%g (%.3f ms)", o.Tag, percentile, o.Threshold*1000), &o.Tail))
+		t.AppendRow(row(fmt.Sprintf("%s: rest", o.Tag), &o.Rest))
+	}
+
+	t.Render()
+}
+
+var OffCPUCommand = &cli.Command{
+	Name:      "offcpu",
+	Usage:     "Split each scope's tail latency into on-CPU and off-CPU causes (see rsp::EnableResourceUsage).",
+	ArgsUsage: "<filename> [scope...]",
+	Flags: []cli.Flag{
+		&cli.Float64Flag{
+			Name:  "percentile",
+			Value: 95,
+			Usage: "Calls at or above this percentile of duration count as the tail.",
+		},
+	},
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 1 {
+			return fmt.Errorf("missing filename\nUsage: rsp offcpu [--percentile P] <filename> [scope...]")
+		}
+
+		filename := c.Args().Get(0)
+		percentile := c.Float64("percentile")
+		if percentile <= 0 || percentile >= 100 {
+			return fmt.Errorf("--percentile must be between 0 and 100")
+		}
+
+		results, err := SelectOffCPU(filename, c.Args().Slice()[1:], percentile)
+		if err != nil {
+			log.Fatal(err)
+		}
+
+		if len(results) == 0 {
+			log.Fatalf("No scopes with resource usage found in %s (was it enabled?)", filename)
+		}
+
+		PrintOffCPU(results, percentile)
+
+		return nil
+	},
+}
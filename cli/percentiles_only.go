@@ -24,24 +24,21 @@ import (
 	"os"
 )
 
-func PercentilesForScope(filename string, scope string) {
+func PercentilesForScope(filename string, scope string, filter *MetadataFilter) {
 	log.Printf("Analyzing scope %s, from %s", scope, filename)
 
-	scopeInfos, err := SelectScopes(filename, []string{scope})
+	timesMs, err := ScopeDurationsMs(filename, scope, filter)
 
 	if err != nil {
 		log.Fatal(err)
 	}
 
-	infos, ok := scopeInfos[scope]
-	if !ok || len(infos) == 0 {
+	if len(timesMs) == 0 {
 		log.Fatalf("No entries found for scope %s", scope)
 		return
 	}
 
-	log.Printf("Found %d entries for scope %s", len(infos), scope)
-
-	timesMs := ExtractTimesAsMilliseconds(infos)
+	log.Printf("Found %d entries for scope %s", len(timesMs), scope)
 
 	p50, p95, p99 := ComputePercentiles(timesMs)
 
@@ -56,15 +53,29 @@ var PercentilesOnlyCommand = &cli.Command{
 	Name:      "percentiles",
 	Usage:     "Print p50, p95 and p99 for a given scope in milliseconds.",
 	ArgsUsage: "<filename> <scope>",
+	Flags: []cli.Flag{
+		&cli.StringFlag{
+			Name:  "where",
+			Usage: "Only include entries with matching metadata, e.g. 'bytes>=4096' or 'shard=eu' (ops: = != < <= > >=).",
+		},
+	},
 	Action: func(c *cli.Context) error {
 		if c.Args().Len() < 2 {
-			return fmt.Errorf("missing filename\nUsage: rsp percentiles <filename> <scope>")
+			return fmt.Errorf("missing filename\nUsage: rsp percentiles [--where <filter>] <filename> <scope>")
 		}
 
 		filename := c.Args().Get(0)
 		scope := c.Args().Get(1)
 
-		PercentilesForScope(filename, scope)
+		var filter *MetadataFilter
+		if c.IsSet("where") {
+			var err error
+			if filter, err = ParseMetadataFilter(c.String("where")); err != nil {
+				return err
+			}
+		}
+
+		PercentilesForScope(filename, scope, filter)
 
 		return nil
 	},
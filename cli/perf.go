@@ -0,0 +1,175 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"io"
+	"log"
+	"os"
+	"sort"
+
+	"github.com/jedib0t/go-pretty/v6/table"
+	"github.com/urfave/cli/v2"
+)
+
+// ScopePerf accumulates the hardware counter deltas of one scope's records
+// (see rsp::EnablePerfCounters).
+type ScopePerf struct {
+	Tag          string
+	Samples      int
+	Cycles       uint64
+	Instructions uint64
+	LLCMisses    uint64
+	BranchMisses uint64
+
+	// Per call, for percentiles.
+	CyclesPerCall []float64
+}
+
+// IPC is instructions retired per cycle over all of the scope's records.
+func (p *ScopePerf) IPC() float64 {
+	if p.Cycles == 0 {
+		return 0
+	}
+	return float64(p.Instructions) / float64(p.Cycles)
+}
+
+// perKilo is misses per thousand instructions (MPKI), which unlike a
+// per-call count is comparable between scopes doing different amounts of
+// work.
+func (p *ScopePerf) perKilo(misses uint64) float64 {
+	if p.Instructions == 0 {
+		return 0
+	}
+	return float64(misses) / float64(p.Instructions) * 1000
+}
+
+// SelectPerf sums the counters of every scope record that has them, for the
+// scopes in scopes (all of them if empty).
+func SelectPerf(filename string, scopes []string) ([]*ScopePerf, error) {
+	wanted := make(map[string]struct{}, len(scopes))
+	for _, s := range scopes {
+		wanted[s] = struct{}{}
+	}
+
+	stream, err := NewScopeInfoStream(filename)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open scope stream: %w", err)
+	}
+	defer stream.Close()
+
+	byTag := make(map[string]*ScopePerf)
+
+	for {
+		s, err := stream.NextScope()
+		if err != nil {
+			if err == io.EOF {
+				break
+			}
+			return nil, fmt.Errorf("failed reading record: %w", err)
+		}
+
+		if s.Kind != RecordKindScope || s.Perf.Empty() {
+			continue
+		}
+
+		if _, ok := wanted[s.Tag]; !ok && len(scopes) > 0 {
+			continue
+		}
+
+		p, ok := byTag[s.Tag]
+		if !ok {
+			p = &ScopePerf{Tag: s.Tag}
+			byTag[s.Tag] = p
+		}
+
+		p.Samples++
+		p.Cycles += s.Perf.Cycles
+		p.Instructions += s.Perf.Instructions
+		p.LLCMisses += s.Perf.LLCMisses
+		p.BranchMisses += s.Perf.BranchMisses
+		p.CyclesPerCall = append(p.CyclesPerCall, float64(s.Perf.Cycles))
+	}
+
+	result := make([]*ScopePerf, 0, len(byTag))
+	for _, p := range byTag {
+		result = append(result, p)
+	}
+
+	// Where the cycles went first.
+	sort.Slice(result, func(i, j int) bool {
+		if result[i].Cycles != result[j].Cycles {
+			return result[i].Cycles > result[j].Cycles
+		}
+		return result[i].Tag < result[j].Tag
+	})
+
+	return result, nil
+}
+
+func PrintPerf(perf []*ScopePerf) {
+	t := table.NewWriter()
+	t.SetOutputMirror(os.Stdout)
+	t.AppendHeader(table.Row{"Scope", "Samples", "Cycles p50", "Cycles p95", "IPC",
+		"LLC misses/call", "LLC MPKI", "Branch misses/call", "Branch MPKI"})
+
+	for _, p := range perf {
+		c50, c95, _ := ComputePercentiles(p.CyclesPerCall)
+		calls := float64(p.Samples)
+
+		t.AppendRow(table.Row{
+			p.Tag,
+			p.Samples,
+			fmt.Sprintf("%.0f", c50),
+			fmt.Sprintf("%.0f", c95),
+			fmt.Sprintf("%.2f", p.IPC()),
+			fmt.Sprintf("%.1f", float64(p.LLCMisses)/calls),
+			fmt.Sprintf("%.2f", p.perKilo(p.LLCMisses)),
+			fmt.Sprintf("%.1f", float64(p.BranchMisses)/calls),
+			fmt.Sprintf("%.2f", p.perKilo(p.BranchMisses)),
+		})
+	}
+
+	t.Render()
+}
+
+var PerfCommand = &cli.Command{
+	Name:      "perf",
+	Usage:     "Report IPC and cache/branch miss rates per scope, from hardware counters (see rsp::EnablePerfCounters).",
+	ArgsUsage: "<filename> [scope...]",
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 1 {
+			return fmt.Errorf("missing filename\nUsage: rsp perf <filename> [scope...]")
+		}
+
+		filename := c.Args().Get(0)
+
+		perf, err := SelectPerf(filename, c.Args().Slice()[1:])
+		if err != nil {
+			log.Fatal(err)
+		}
+
+		if len(perf) == 0 {
+			log.Fatalf("No scopes with perf counters found in %s (were they enabled, and available?)", filename)
+		}
+
+		PrintPerf(perf)
+
+		return nil
+	},
+}
@@ -17,59 +17,182 @@
 package main
 
 import (
+	"bufio"
+	"bytes"
 	"encoding/binary"
+	"errors"
+	"fmt"
 	"io"
+	"log"
 	"os"
 
 	"github.com/AFWareLLC/rsp/RSP"
 )
 
+// ErrNotFlatBufferCapture is returned by the FlatBuffer-only readers when
+// handed a block (rsp::BlockDiskSink), columnar (`rsp convert`) or flight
+// recorder (rsp::FlightRecorder) capture, whose records aren't FlatBuffers.
+var ErrNotFlatBufferCapture = errors.New("capture has no per-record FlatBuffers; use ScopeInfoStream.NextScope")
+
+// detectCapture works out the format of f, setting up the matching reader
+// on s. Bare FlatBuffer streams (captures from before the framed format)
+// have no magic, and are read from the start of f.
+func (s *ScopeInfoStream) detectCapture() error {
+	f := s.f
+
+	magic := make([]byte, len(blockCaptureMagic))
+	if _, err := io.ReadFull(f, magic); err == nil {
+		switch {
+		case bytes.Equal(magic, blockCaptureMagic), bytes.Equal(magic, blockCaptureMagicV1):
+			s.blocks = newBlockReader(bufio.NewReaderSize(f, 1<<20), bytes.Equal(magic, blockCaptureMagicV1))
+			return nil
+
+		case bytes.Equal(magic, columnarMagic):
+			file, err := openColumnar(f)
+			if err != nil {
+				return err
+			}
+			s.columns = &columnarReader{file: file}
+			return nil
+
+		case bytes.Equal(magic, framedCaptureMagic):
+			r := bufio.NewReader(f)
+			header, err := readCaptureHeader(r)
+			if err != nil {
+				// The frames can still be found without it.
+				log.Printf("Warning: %v; scanning for frames", err)
+				header.Size = int64(len(framedCaptureMagic))
+			} else {
+				s.Header = &header
+			}
+
+			if _, err := f.Seek(header.Size, io.SeekStart); err != nil {
+				return err
+			}
+			s.framed = newFramedReader(f, header.Size, -1)
+			return nil
+
+		case bytes.Equal(magic, flightDumpMagic):
+			flight, dump, header, err := newFlightReader(bufio.NewReaderSize(f, 1<<20))
+			if err != nil {
+				return err
+			}
+			s.flight = flight
+			s.Flight = &dump
+			s.Header = &header
+			return nil
+		}
+	} else if err != io.EOF && err != io.ErrUnexpectedEOF {
+		return err
+	}
+
+	_, err := f.Seek(0, io.SeekStart)
+	return err
+}
+
 func BatchReadCapture(filename string) ([]*RSP.ScopeInfo, error) {
-	f, err := os.Open(filename)
+	stream, err := NewScopeInfoStream(filename)
 	if err != nil {
 		return nil, err
 	}
-	defer f.Close()
+	defer stream.Close()
 
 	var infos []*RSP.ScopeInfo
 
 	for {
-		// Read the 4-byte length
-		var length uint32
-		if err := binary.Read(f, binary.LittleEndian, &length); err != nil {
+		scope, err := stream.Next()
+		if err != nil {
 			if err == io.EOF {
-				break
+				return infos, nil
 			}
 			return nil, err
 		}
-
-		// Read the FlatBuffer data
-		buf := make([]byte, length)
-		_, err := io.ReadFull(f, buf)
-		if err != nil {
-			return nil, err
-		}
-
-		// Get a ScopeInfo from the buffer
-		scope := RSP.GetRootAsScopeInfo(buf, 0)
 		infos = append(infos, scope)
 	}
-
-	return infos, nil
 }
 
-// ScopeInfoStream provides a streaming iterator over ScopeInfo entries in a file
+// ScopeInfoStream provides a streaming iterator over ScopeInfo entries in a
+// file. Framed and bare FlatBuffer, block and columnar captures, and flight
+// recorder dumps are supported. Given a directory or glob (see
+// CaptureFiles), it reads the files one after the other.
 type ScopeInfoStream struct {
-	f *os.File
+	f       *os.File
+	pending []string        // Files still to read, after f.
+	framed  *framedReader   // Set for framed captures.
+	blocks  *blockReader    // Set for block captures.
+	columns *columnarReader // Set for columnar captures.
+	flight  *flightReader   // Set for flight recorder dumps.
+
+	// Interned string text seen so far, for FlatBuffer captures.
+	strings stringResolver
+
+	// The capture's header, for framed captures with an intact one and
+	// flight recorder dumps. For several files, the current one's.
+	Header *CaptureHeader
+
+	// Set for flight recorder dumps.
+	Flight *FlightDump
 }
 
-// NewScopeInfoStream opens the file and prepares the stream
+// NewScopeInfoStream opens the file (or the first of the files filename
+// expands to) and prepares the stream
 func NewScopeInfoStream(filename string) (*ScopeInfoStream, error) {
-	f, err := os.Open(filename)
+	files, err := CaptureFiles(filename)
 	if err != nil {
 		return nil, err
 	}
-	return &ScopeInfoStream{f: f}, nil
+
+	return newScopeInfoStreamFiles(files)
+}
+
+// newScopeInfoStreamFiles reads files one after the other, as a single
+// stream.
+func newScopeInfoStreamFiles(files []string) (*ScopeInfoStream, error) {
+	s := &ScopeInfoStream{pending: files[1:]}
+	if err := s.open(files[0]); err != nil {
+		return nil, err
+	}
+
+	return s, nil
+}
+
+// open switches the stream over to filename, closing the previous file.
+// Each file is a capture of its own, with its own format and strings.
+func (s *ScopeInfoStream) open(filename string) error {
+	if s.f != nil {
+		s.f.Close()
+	}
+
+	f, err := os.Open(filename)
+	if err != nil {
+		return err
+	}
+
+	*s = ScopeInfoStream{f: f, pending: s.pending, strings: make(stringResolver)}
+	if err := s.detectCapture(); err != nil {
+		f.Close()
+		return fmt.Errorf("%s: %w", filename, err)
+	}
+
+	return nil
+}
+
+// nextFile moves on to the next pending file, returning io.EOF if there
+// are none left.
+func (s *ScopeInfoStream) nextFile() error {
+	if len(s.pending) == 0 {
+		return io.EOF
+	}
+
+	next := s.pending[0]
+	s.pending = s.pending[1:]
+	return s.open(next)
+}
+
+// hasFlatBuffers reports whether the records are FlatBuffers (framed or
+// bare captures), which Next and BatchReadCapture need.
+func (s *ScopeInfoStream) hasFlatBuffers() bool {
+	return s.blocks == nil && s.columns == nil && s.flight == nil
 }
 
 // Close closes the underlying file
@@ -77,8 +200,31 @@ func (s *ScopeInfoStream) Close() error {
 	return s.f.Close()
 }
 
-// Next reads the next ScopeInfo from the stream. Returns io.EOF when done.
+// Next reads the next raw FlatBuffer record from the stream. Returns io.EOF
+// when done, or ErrNotFlatBufferCapture for the other formats - prefer
+// NextScope, which handles all of them and fills in the text of interned
+// strings that raw records leave out after their first use.
 func (s *ScopeInfoStream) Next() (*RSP.ScopeInfo, error) {
+	for {
+		scope, err := s.next()
+		if err != io.EOF {
+			return scope, err
+		}
+		if err := s.nextFile(); err != nil {
+			return nil, err
+		}
+	}
+}
+
+func (s *ScopeInfoStream) next() (*RSP.ScopeInfo, error) {
+	if !s.hasFlatBuffers() {
+		return nil, ErrNotFlatBufferCapture
+	}
+
+	if s.framed != nil {
+		return s.framed.Next()
+	}
+
 	var length uint32
 	if err := binary.Read(s.f, binary.LittleEndian, &length); err != nil {
 		return nil, err
@@ -93,3 +239,43 @@ func (s *ScopeInfoStream) Next() (*RSP.ScopeInfo, error) {
 	scope := RSP.GetRootAsScopeInfo(buf, 0)
 	return scope, nil
 }
+
+// NextScope reads the next record, whatever the capture format. Returns
+// io.EOF when done.
+func (s *ScopeInfoStream) NextScope() (ScopeInfo, error) {
+	for {
+		scope, err := s.nextScope()
+		if err == nil && scope.Process == 0 && s.Header != nil {
+			scope.Process = uint64(s.Header.Process)
+		}
+		if err != io.EOF {
+			return scope, err
+		}
+		if err := s.nextFile(); err != nil {
+			return ScopeInfo{}, err
+		}
+	}
+}
+
+func (s *ScopeInfoStream) nextScope() (ScopeInfo, error) {
+	if s.blocks != nil {
+		return s.blocks.Next()
+	}
+
+	if s.columns != nil {
+		return s.columns.Next()
+	}
+
+	if s.flight != nil {
+		return s.flight.Next()
+	}
+
+	fb, err := s.next()
+	if err != nil {
+		return ScopeInfo{}, err
+	}
+
+	scope := ConvertScopeInfo(fb)
+	s.strings.resolve(&scope)
+	return scope, nil
+}
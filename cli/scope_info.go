@@ -17,15 +17,106 @@
 package main
 
 import (
+	"bytes"
+	"encoding/binary"
+	"fmt"
+	"math"
+	"strconv"
+
 	"github.com/AFWareLLC/rsp/RSP"
 )
 
 type MetadataType byte
 
+// Raw metadata type bytes, as written by the C++ side (Metadata.hpp).
+const (
+	MetadataTypeUnset  MetadataType = 0
+	MetadataTypeInt8   MetadataType = 1
+	MetadataTypeUint8  MetadataType = 2
+	MetadataTypeInt16  MetadataType = 3
+	MetadataTypeUint16 MetadataType = 4
+	MetadataTypeInt32  MetadataType = 5
+	MetadataTypeUint32 MetadataType = 6
+	MetadataTypeInt64  MetadataType = 7
+	MetadataTypeUint64 MetadataType = 8
+	MetadataTypeDouble MetadataType = 9
+	MetadataTypeFloat  MetadataType = 10
+
+	// Up to 8 bytes inline in the value, NUL padded.
+	MetadataTypeString MetadataType = 11
+
+	// An interned string (rsp::StringTable); the value is its id.
+	MetadataTypeStringID MetadataType = 12
+)
+
+type RecordKind byte
+
+// Raw record kind bytes, as written by the C++ side (Scope.hpp). Everything
+// that isn't a SCOPE is a point-in-time event: TicksEnd == TicksStart, no
+// metadata, and the sample in Value.
+const (
+	RecordKindScope   RecordKind = 0
+	RecordKindCounter RecordKind = 1
+	RecordKindGauge   RecordKind = 2
+	RecordKindInstant RecordKind = 3
+)
+
+func (k RecordKind) String() string {
+	switch k {
+	case RecordKindScope:
+		return "SCOPE"
+	case RecordKindCounter:
+		return "COUNTER"
+	case RecordKindGauge:
+		return "GAUGE"
+	case RecordKindInstant:
+		return "INSTANT"
+	default:
+		return fmt.Sprintf("KIND(%d)", byte(k))
+	}
+}
+
+// MetadataEntry is one key/value pair. String entries (see IsString) carry
+// their text in Text; for interned ones Value is only an id, unique within
+// the capture chunk it came from.
 type MetadataEntry struct {
 	Tag   string
 	Type  MetadataType
 	Value uint64
+	Text  string
+}
+
+func (m MetadataEntry) IsString() bool {
+	return m.Type == MetadataTypeString || m.Type == MetadataTypeStringID
+}
+
+type PerfCounts struct {
+	Cycles       uint64
+	Instructions uint64
+	LLCMisses    uint64
+	BranchMisses uint64
+}
+
+func (p PerfCounts) Empty() bool {
+	return p == PerfCounts{}
+}
+
+// ScopeAllocations are inclusive of nested scopes, except the Self ones.
+type ScopeAllocations struct {
+	Tracked   bool
+	Count     uint64
+	Bytes     uint64
+	SelfCount uint64
+	SelfBytes uint64
+}
+
+// ResourceUsage holds getrusage(RUSAGE_THREAD) deltas over a scope.
+type ResourceUsage struct {
+	Sampled             bool
+	VoluntarySwitches   uint64
+	InvoluntarySwitches uint64
+	MinorFaults         uint64
+	MajorFaults         uint64
 }
 
 type ScopeInfo struct {
@@ -37,6 +128,33 @@ type ScopeInfo struct {
 	MaxOffset          byte
 	Metadata           []MetadataEntry
 
+	// Scope or event record; Value is only meaningful for events (see
+	// EventValue).
+	Kind  RecordKind
+	Value uint64
+
+	// Flow id (see RSP_FLOW), 0 for none.
+	Flow uint64
+
+	// Hardware counter deltas over the scope (see rsp::EnablePerfCounters),
+	// all zero when they weren't captured.
+	Perf PerfCounts
+
+	// Heap allocations over the scope (see rsp::EnableAllocationTracking).
+	Allocs ScopeAllocations
+
+	// Context switches and page faults over the scope (see
+	// rsp::EnableResourceUsage), when it was sampled.
+	Rusage ResourceUsage
+
+	// OS thread id of the recording thread, where the capture has it
+	// (flight recorder dumps); otherwise 0.
+	Thread uint64
+
+	// OS process id of the recording process, where the capture has it
+	// (framed and block captures, flight recorder dumps); otherwise 0.
+	Process uint64
+
 	ElapsedSeconds float64
 }
 
@@ -48,6 +166,29 @@ func ConvertScopeInfo(fb *RSP.ScopeInfo) ScopeInfo {
 		MachineNominalFreq: fb.MachineNominalFreqHz(),
 		MaxBufferSize:      fb.MaxBufferSize(),
 		MaxOffset:          fb.MaxOffset(),
+		Kind:               RecordKind(fb.Kind()),
+		Value:              fb.Value(),
+		Flow:               fb.Flow(),
+		Perf: PerfCounts{
+			Cycles:       fb.PerfCycles(),
+			Instructions: fb.PerfInstructions(),
+			LLCMisses:    fb.PerfLlcMisses(),
+			BranchMisses: fb.PerfBranchMisses(),
+		},
+		Allocs: ScopeAllocations{
+			Tracked:   fb.AllocsTracked(),
+			Count:     fb.AllocCount(),
+			Bytes:     fb.AllocBytes(),
+			SelfCount: fb.AllocSelfCount(),
+			SelfBytes: fb.AllocSelfBytes(),
+		},
+		Rusage: ResourceUsage{
+			Sampled:             fb.RusageSampled(),
+			VoluntarySwitches:   fb.VoluntarySwitches(),
+			InvoluntarySwitches: fb.InvoluntarySwitches(),
+			MinorFaults:         fb.MinorFaults(),
+			MajorFaults:         fb.MajorFaults(),
+		},
 	}
 
 	if s.MachineNominalFreq > 0 {
@@ -62,6 +203,10 @@ func ConvertScopeInfo(fb *RSP.ScopeInfo) ScopeInfo {
 				Tag:   string(m.Tag()),
 				Type:  MetadataType(m.Type()),
 				Value: m.Value(),
+				Text:  string(m.Text()),
+			}
+			if metadata[i].Type == MetadataTypeString {
+				metadata[i].Text = inlineMetadataString(metadata[i].Value)
 			}
 		}
 	}
@@ -69,3 +214,95 @@ func ConvertScopeInfo(fb *RSP.ScopeInfo) ScopeInfo {
 	s.Metadata = metadata
 	return s
 }
+
+// inlineMetadataString unpacks a STRING value.
+func inlineMetadataString(value uint64) string {
+	var b [8]byte
+	binary.LittleEndian.PutUint64(b[:], value)
+	if i := bytes.IndexByte(b[:], 0); i >= 0 {
+		return string(b[:i])
+	}
+	return string(b[:])
+}
+
+// packMetadataString is the inverse of inlineMetadataString, for strings of
+// up to 8 bytes.
+func packMetadataString(text string) uint64 {
+	var b [8]byte
+	copy(b[:], text)
+	return binary.LittleEndian.Uint64(b[:])
+}
+
+// stringResolver fills in the text of interned strings that a record left
+// out because an earlier record in the same frame (or unframed stream)
+// already carried it. One resolver must see a stream's records in order.
+type stringResolver map[uint64]string
+
+func (r stringResolver) resolve(s *ScopeInfo) {
+	for i := range s.Metadata {
+		m := &s.Metadata[i]
+		if m.Type != MetadataTypeStringID {
+			continue
+		}
+		if m.Text != "" {
+			r[m.Value] = m.Text
+		} else {
+			m.Text = r[m.Value]
+		}
+	}
+}
+
+// MetadataDisplayValue formats a metadata value for display and grouping:
+// the text of strings, and numbers as written.
+func MetadataDisplayValue(m MetadataEntry) string {
+	switch m.Type {
+	case MetadataTypeString, MetadataTypeStringID:
+		return m.Text
+	case MetadataTypeInt8, MetadataTypeInt16, MetadataTypeInt32:
+		return strconv.FormatInt(int64(MetadataNumericValue(m)), 10)
+	case MetadataTypeInt64:
+		return strconv.FormatInt(int64(m.Value), 10)
+	case MetadataTypeUint8, MetadataTypeUint16, MetadataTypeUint32, MetadataTypeUint64:
+		return strconv.FormatUint(m.Value, 10)
+	default:
+		return strconv.FormatFloat(MetadataNumericValue(m), 'g', -1, 64)
+	}
+}
+
+// MetadataNumericValue interprets a metadata value according to its type.
+// Strings have no numeric value and read as 0.
+func MetadataNumericValue(m MetadataEntry) float64 {
+	switch m.Type {
+	case MetadataTypeInt8:
+		return float64(int8(m.Value))
+	case MetadataTypeInt16:
+		return float64(int16(m.Value))
+	case MetadataTypeInt32:
+		return float64(int32(m.Value))
+	case MetadataTypeInt64:
+		return float64(int64(m.Value))
+	case MetadataTypeDouble:
+		return math.Float64frombits(m.Value)
+	case MetadataTypeFloat:
+		return float64(math.Float32frombits(uint32(m.Value)))
+	case MetadataTypeString, MetadataTypeStringID:
+		return 0
+	default:
+		return float64(m.Value)
+	}
+}
+
+// EventValue interprets an event record's value according to its kind: the
+// signed delta for a counter, the sample for a gauge, and 1 for an instant.
+func EventValue(s ScopeInfo) float64 {
+	switch s.Kind {
+	case RecordKindCounter:
+		return float64(int64(s.Value))
+	case RecordKindGauge:
+		return math.Float64frombits(s.Value)
+	case RecordKindInstant:
+		return 1
+	default:
+		return 0
+	}
+}
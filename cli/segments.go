@@ -0,0 +1,124 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"regexp"
+	"runtime"
+	"sort"
+	"strings"
+	"sync"
+)
+
+// segmentName matches the files a rotating rsp::BinaryDiskSink writes:
+// <stem>.<sequence>.<YYYYmmddTHHMMSSZ><ext>.
+var segmentName = regexp.MustCompile(`^(.*)\.(\d+)\.(\d{8}T\d{6}Z)(.*)$`)
+
+// segmentKey sorts a series' segments by sequence number, however many
+// digits it has grown to, and anything else by name.
+func segmentKey(path string) string {
+	m := segmentName.FindStringSubmatch(path)
+	if m == nil {
+		return path
+	}
+	return fmt.Sprintf("%s\x00%s\x00%020s", m[1], m[4], m[2])
+}
+
+// CaptureFiles expands a capture argument into the files to read, in
+// order: a file is just itself, a directory is every (non-hidden) file in
+// it, and anything else is tried as a glob - so the segments of a rotated
+// capture can be read as one, with e.g. "/var/log/app" or
+// "/var/log/app/rsp.*.bin".
+func CaptureFiles(arg string) ([]string, error) {
+	st, statErr := os.Stat(arg)
+
+	var files []string
+	switch {
+	case statErr == nil && !st.IsDir():
+		return []string{arg}, nil
+
+	case statErr == nil:
+		entries, err := os.ReadDir(arg)
+		if err != nil {
+			return nil, err
+		}
+		for _, e := range entries {
+			if e.Type().IsRegular() && !strings.HasPrefix(e.Name(), ".") {
+				files = append(files, filepath.Join(arg, e.Name()))
+			}
+		}
+		if len(files) == 0 {
+			return nil, fmt.Errorf("no captures in %s", arg)
+		}
+
+	default:
+		matches, err := filepath.Glob(arg)
+		if err != nil {
+			return nil, err
+		}
+		for _, m := range matches {
+			if st, err := os.Stat(m); err == nil && st.Mode().IsRegular() {
+				files = append(files, m)
+			}
+		}
+		if len(files) == 0 {
+			return nil, statErr
+		}
+	}
+
+	sort.Slice(files, func(i, j int) bool { return segmentKey(files[i]) < segmentKey(files[j]) })
+	return files, nil
+}
+
+// forEachCapture runs fn on each of files, up to GOMAXPROCS at a time, and
+// returns the first (in file order) error. fn is handed each file's index
+// so it can keep results in file order.
+func forEachCapture(files []string, fn func(i int, file string) error) error {
+	if len(files) == 1 {
+		return fn(0, files[0])
+	}
+
+	errs := make([]error, len(files))
+	work := make(chan int)
+
+	var wg sync.WaitGroup
+	for w := 0; w < min(runtime.GOMAXPROCS(0), len(files)); w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for i := range work {
+				errs[i] = fn(i, files[i])
+			}
+		}()
+	}
+
+	for i := range files {
+		work <- i
+	}
+	close(work)
+	wg.Wait()
+
+	for i, err := range errs {
+		if err != nil {
+			return fmt.Errorf("%s: %w", files[i], err)
+		}
+	}
+	return nil
+}
@@ -0,0 +1,332 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"io"
+	"log"
+	"os"
+	"sort"
+
+	"github.com/go-echarts/go-echarts/v2/charts"
+	"github.com/go-echarts/go-echarts/v2/components"
+	"github.com/go-echarts/go-echarts/v2/opts"
+	"github.com/jedib0t/go-pretty/v6/table"
+	"github.com/urfave/cli/v2"
+)
+
+// EventSeries is one counter, gauge or instant event (or a scope's
+// durations) laid out over time. Times are seconds since the first record
+// in the capture; Values are the running total for counters, the sample for
+// gauges, 1 for instants and the duration in milliseconds for scopes.
+type EventSeries struct {
+	Name   string
+	Kind   RecordKind
+	Times  []float64
+	Values []float64
+}
+
+type seriesKey struct {
+	name string
+	kind RecordKind
+}
+
+type seriesPoint struct {
+	ticks uint64
+	freq  uint64
+	value float64
+}
+
+// SelectSeries reads the event records named in names (all of them if
+// empty), plus the durations of the scopes in scopes, in one pass.
+func SelectSeries(filename string, names []string, scopes []string) ([]*EventSeries, error) {
+	wantedNames := make(map[string]struct{}, len(names))
+	for _, n := range names {
+		wantedNames[n] = struct{}{}
+	}
+
+	wantedScopes := make(map[string]struct{}, len(scopes))
+	for _, s := range scopes {
+		wantedScopes[s] = struct{}{}
+	}
+
+	stream, err := NewScopeInfoStream(filename)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open scope stream: %w", err)
+	}
+	defer stream.Close()
+
+	points := make(map[seriesKey][]seriesPoint)
+	origin := ^uint64(0)
+
+	for {
+		s, err := stream.NextScope()
+		if err != nil {
+			if err == io.EOF {
+				break
+			}
+			return nil, fmt.Errorf("failed reading record: %w", err)
+		}
+
+		if s.MachineNominalFreq == 0 || IsClockAnchor(s) {
+			continue
+		}
+
+		origin = min(origin, s.TicksStart)
+
+		p := seriesPoint{ticks: s.TicksStart, freq: s.MachineNominalFreq}
+		if s.Kind == RecordKindScope {
+			if _, ok := wantedScopes[s.Tag]; !ok {
+				continue
+			}
+			p.value = s.ElapsedSeconds * 1000
+		} else {
+			if _, ok := wantedNames[s.Tag]; !ok && len(names) > 0 {
+				continue
+			}
+			p.value = EventValue(s)
+		}
+
+		key := seriesKey{name: s.Tag, kind: s.Kind}
+		points[key] = append(points[key], p)
+	}
+
+	keys := make([]seriesKey, 0, len(points))
+	for k := range points {
+		keys = append(keys, k)
+	}
+	sort.Slice(keys, func(i, j int) bool {
+		if keys[i].kind != keys[j].kind {
+			return keys[i].kind < keys[j].kind
+		}
+		return keys[i].name < keys[j].name
+	})
+
+	result := make([]*EventSeries, 0, len(keys))
+	for _, k := range keys {
+		ps := points[k]
+
+		// Records arrive in sink order, which is only roughly time order
+		// once there are several threads.
+		sort.SliceStable(ps, func(i, j int) bool { return ps[i].ticks < ps[j].ticks })
+
+		es := &EventSeries{
+			Name:   k.name,
+			Kind:   k.kind,
+			Times:  make([]float64, len(ps)),
+			Values: make([]float64, len(ps)),
+		}
+
+		total := 0.0
+		for i, p := range ps {
+			es.Times[i] = float64(p.ticks-origin) / float64(p.freq)
+			if k.kind == RecordKindCounter {
+				total += p.value
+				es.Values[i] = total
+			} else {
+				es.Values[i] = p.value
+			}
+		}
+
+		result = append(result, es)
+	}
+
+	return result, nil
+}
+
+func ListSeries(series []*EventSeries) {
+	t := table.NewWriter()
+	t.SetOutputMirror(os.Stdout)
+	t.AppendHeader(table.Row{"Name", "Kind", "Samples", "First (s)", "Last (s)", "Min", "Max", "Final"})
+
+	for _, s := range series {
+		lo, hi := s.Values[0], s.Values[0]
+		for _, v := range s.Values {
+			lo, hi = min(lo, v), max(hi, v)
+		}
+
+		t.AppendRow(table.Row{
+			s.Name,
+			s.Kind,
+			len(s.Values),
+			fmt.Sprintf("%.6f", s.Times[0]),
+			fmt.Sprintf("%.6f", s.Times[len(s.Times)-1]),
+			fmt.Sprintf("%.6g", lo),
+			fmt.Sprintf("%.6g", hi),
+			fmt.Sprintf("%.6g", s.Values[len(s.Values)-1]),
+		})
+	}
+
+	t.Render()
+}
+
+// seriesChartOpts are shared by every chart on the page, so their time
+// axes line up.
+func seriesChartOpts(title, yName string, end float64) []charts.GlobalOpts {
+	return []charts.GlobalOpts{
+		charts.WithInitializationOpts(opts.Initialization{
+			Width:  "100vh",
+			Height: "50vh",
+		}),
+		charts.WithGridOpts(opts.Grid{
+			Left:   "10%",
+			Right:  "10%",
+			Top:    "15%",
+			Bottom: "20%",
+		}),
+		charts.WithTitleOpts(opts.Title{Title: title}),
+		charts.WithXAxisOpts(opts.XAxis{Name: "Time (s)", Type: "value", Min: 0, Max: end}),
+		charts.WithYAxisOpts(opts.YAxis{Name: yName}),
+		charts.WithTooltipOpts(opts.Tooltip{Show: opts.Bool(true), Trigger: "axis"}),
+		charts.WithLegendOpts(opts.Legend{Show: opts.Bool(true)}),
+		charts.WithDataZoomOpts(
+			opts.DataZoom{Type: "inside", XAxisIndex: []int{0}},
+			opts.DataZoom{Type: "slider", XAxisIndex: []int{0}},
+		),
+	}
+}
+
+func seriesLine(title, yName string, end float64, series []*EventSeries) *charts.Line {
+	line := charts.NewLine()
+	line.SetGlobalOptions(seriesChartOpts(title, yName, end)...)
+
+	for _, s := range series {
+		data := make([]opts.LineData, len(s.Values))
+		for i := range s.Values {
+			data[i] = opts.LineData{Value: []interface{}{s.Times[i], s.Values[i]}}
+		}
+		line.AddSeries(s.Name, data)
+	}
+
+	return line
+}
+
+func seriesScatter(title, yName string, end float64, series []*EventSeries) *charts.Scatter {
+	scatter := charts.NewScatter()
+	scatter.SetGlobalOptions(seriesChartOpts(title, yName, end)...)
+
+	for _, s := range series {
+		data := make([]opts.ScatterData, len(s.Values))
+		for i := range s.Values {
+			data[i] = opts.ScatterData{Value: []interface{}{s.Times[i], s.Values[i]}}
+		}
+		scatter.AddSeries(s.Name, data)
+	}
+
+	return scatter
+}
+
+// PlotSeries draws one chart per record kind - counters as running totals,
+// gauges as sampled, instants as markers and scope durations against their
+// start time - on a shared time axis.
+func PlotSeries(series []*EventSeries, savePath string, bindAddr string) {
+	byKind := make(map[RecordKind][]*EventSeries)
+	end := 0.0
+	for _, s := range series {
+		byKind[s.Kind] = append(byKind[s.Kind], s)
+		end = max(end, s.Times[len(s.Times)-1])
+	}
+
+	// Instants are all 1; spread them out so each gets its own row.
+	for i, s := range byKind[RecordKindInstant] {
+		for j := range s.Values {
+			s.Values[j] = float64(i + 1)
+		}
+	}
+
+	var chartsList []components.Charter
+	if s := byKind[RecordKindCounter]; len(s) > 0 {
+		chartsList = append(chartsList, seriesLine("Counters (running total)", "Total", end, s))
+	}
+	if s := byKind[RecordKindGauge]; len(s) > 0 {
+		chartsList = append(chartsList, seriesLine("Gauges", "Value", end, s))
+	}
+	if s := byKind[RecordKindInstant]; len(s) > 0 {
+		chartsList = append(chartsList, seriesScatter("Instant events", "", end, s))
+	}
+	if s := byKind[RecordKindScope]; len(s) > 0 {
+		chartsList = append(chartsList, seriesScatter("Scope durations", "Time (ms)", end, s))
+	}
+
+	if savePath == "" {
+		ServeChartsPage(bindAddr, chartsList...)
+	} else {
+		SaveChartsPageHTML(savePath, chartsList...)
+	}
+}
+
+var SeriesCommand = &cli.Command{
+	Name:      "series",
+	Usage:     "Plot counters, gauges and instant events over time, optionally next to scope durations.",
+	ArgsUsage: "<filename> [name...]",
+	Flags: []cli.Flag{
+		&cli.StringFlag{
+			Name:    "output",
+			Aliases: []string{"o"},
+			Usage:   "Save results to the specified file",
+		},
+		&cli.StringFlag{
+			Name:    "bind",
+			Aliases: []string{"b"},
+			Usage:   "Address and port to bind to.",
+			Value:   "localhost:8080",
+		},
+		&cli.StringSliceFlag{
+			Name:  "scope",
+			Usage: "Also plot this scope's durations against time (repeatable).",
+		},
+		&cli.BoolFlag{
+			Name:    "list",
+			Aliases: []string{"l"},
+			Usage:   "Print a summary of each series instead of plotting.",
+		},
+	},
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 1 {
+			return fmt.Errorf("missing filename\nUsage: rsp series [-o | -b] [--scope <scope>]... [--list] <filename> [name...]")
+		}
+
+		filename := c.Args().Get(0)
+		names := c.Args().Slice()[1:]
+
+		savePath := c.String("output")
+		bindAddr := c.String("bind")
+
+		if savePath != "" && c.IsSet("bind") {
+			return fmt.Errorf("--output/-o and --bind/-b are mutually exclusive")
+		}
+
+		series, err := SelectSeries(filename, names, c.StringSlice("scope"))
+		if err != nil {
+			log.Fatal(err)
+		}
+
+		if len(series) == 0 {
+			log.Fatalf("No counter, gauge or instant records found in %s", filename)
+		}
+
+		if c.Bool("list") {
+			ListSeries(series)
+			return nil
+		}
+
+		PlotSeries(series, savePath, bindAddr)
+
+		return nil
+	},
+}
@@ -0,0 +1,183 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"encoding/binary"
+	"fmt"
+	"os"
+	"sync/atomic"
+	"syscall"
+	"unsafe"
+)
+
+// Reader for the shared memory ring written by rsp::SharedMemorySink (see
+// include/afware/rsp/SharedMemorySink.hpp for the layout and protocol). It
+// maps the ring read-only and never coordinates with the writer; if we fall
+// behind, we get lapped and skip ahead.
+
+const (
+	shmRingMagic        = 0x31524d4853505352 // "RSPSHMR1"
+	shmRingVersion      = 1
+	shmRingRecordHeader = 16
+
+	shmOffMagic      = 0
+	shmOffVersion    = 8
+	shmOffHeaderSize = 12
+	shmOffCapacity   = 16
+	shmOffFreq       = 24
+	shmOffWriterPid  = 32
+	shmOffWritePos   = 64
+	shmOffOldestPos  = 128
+)
+
+type ShmRingReader struct {
+	data       []byte
+	ring       []byte
+	capacity   uint64
+	pos        uint64
+	nextSeq    uint64
+	haveSeq    bool
+	dropped    uint64
+	writePos   *uint64
+	oldestPos  *uint64
+	NominalHz  uint64
+	WriterPid  uint64
+	scratchHdr [shmRingRecordHeader]byte
+}
+
+func shmRecordSize(length uint32) uint64 {
+	return (shmRingRecordHeader + uint64(length) + 7) &^ 7
+}
+
+// NewShmRingReader maps the ring at path. With fromStart, reading begins at
+// the oldest record still in the ring; otherwise only new records are seen.
+func NewShmRingReader(path string, fromStart bool) (*ShmRingReader, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+
+	st, err := f.Stat()
+	if err != nil {
+		return nil, err
+	}
+
+	if st.Size() < 4096 {
+		return nil, fmt.Errorf("%s is too small to be an RSP ring", path)
+	}
+
+	data, err := syscall.Mmap(int(f.Fd()), 0, int(st.Size()), syscall.PROT_READ, syscall.MAP_SHARED)
+	if err != nil {
+		return nil, err
+	}
+
+	r := &ShmRingReader{data: data}
+
+	magic := atomic.LoadUint64(r.word(shmOffMagic))
+	version := binary.LittleEndian.Uint32(data[shmOffVersion:])
+	headerSize := uint64(binary.LittleEndian.Uint32(data[shmOffHeaderSize:]))
+	r.capacity = binary.LittleEndian.Uint64(data[shmOffCapacity:])
+
+	if magic != shmRingMagic || version != shmRingVersion || r.capacity == 0 ||
+		r.capacity&(r.capacity-1) != 0 || headerSize+r.capacity > uint64(len(data)) {
+		syscall.Munmap(data)
+		return nil, fmt.Errorf("%s is not an RSP ring (or has an unsupported version)", path)
+	}
+
+	r.ring = data[headerSize : headerSize+r.capacity]
+	r.NominalHz = binary.LittleEndian.Uint64(data[shmOffFreq:])
+	r.WriterPid = binary.LittleEndian.Uint64(data[shmOffWriterPid:])
+	r.writePos = r.word(shmOffWritePos)
+	r.oldestPos = r.word(shmOffOldestPos)
+
+	if fromStart {
+		r.pos = atomic.LoadUint64(r.oldestPos)
+	} else {
+		r.pos = atomic.LoadUint64(r.writePos)
+	}
+
+	return r, nil
+}
+
+func (r *ShmRingReader) word(off int) *uint64 {
+	return (*uint64)(unsafe.Pointer(&r.data[off]))
+}
+
+func (r *ShmRingReader) copyOut(pos uint64, dst []byte) {
+	off := pos & (r.capacity - 1)
+	n := copy(dst, r.ring[off:])
+	copy(dst[n:], r.ring)
+}
+
+// Next copies the next record's flatbuffer into buf (growing it as needed)
+// and returns it with its sequence number. ok is false when we've caught up
+// with the writer. Records lost to being lapped are counted in Dropped().
+func (r *ShmRingReader) Next(buf []byte) (record []byte, seq uint64, ok bool) {
+	for {
+		if atomic.LoadUint64(r.writePos) == r.pos {
+			return buf, 0, false
+		}
+
+		r.copyOut(r.pos, r.scratchHdr[:])
+		seq = binary.LittleEndian.Uint64(r.scratchHdr[0:])
+		length := binary.LittleEndian.Uint32(r.scratchHdr[8:])
+
+		sane := shmRecordSize(length) <= r.capacity
+		if sane {
+			if uint32(cap(buf)) < length {
+				buf = make([]byte, length)
+			}
+			buf = buf[:length]
+			r.copyOut(r.pos+shmRingRecordHeader, buf)
+		}
+
+		// Go's atomics are sequentially consistent, so this load can't be
+		// reordered before the copies above.
+		oldest := atomic.LoadUint64(r.oldestPos)
+		if oldest > r.pos {
+			r.pos = oldest
+			continue
+		}
+
+		if !sane {
+			r.pos = atomic.LoadUint64(r.writePos)
+			r.haveSeq = false
+			continue
+		}
+
+		if r.haveSeq && seq != r.nextSeq {
+			r.dropped += seq - r.nextSeq
+		}
+
+		r.nextSeq = seq + 1
+		r.haveSeq = true
+		r.pos += shmRecordSize(length)
+
+		return buf, seq, true
+	}
+}
+
+// Dropped is the number of records overwritten before we got to them.
+func (r *ShmRingReader) Dropped() uint64 {
+	return r.dropped
+}
+
+func (r *ShmRingReader) Close() error {
+	return syscall.Munmap(r.data)
+}
@@ -0,0 +1,121 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+package main
+
+import (
+	"fmt"
+	"log"
+	"os"
+	"os/signal"
+	"time"
+
+	"github.com/AFWareLLC/rsp/RSP"
+	"github.com/urfave/cli/v2"
+)
+
+func Tail(path string, fromStart bool, poll time.Duration) {
+	reader, err := NewShmRingReader(path, fromStart)
+	if err != nil {
+		log.Fatal(err)
+	}
+	defer reader.Close()
+
+	log.Printf("Tailing %s (writer pid %d)", path, reader.WriterPid)
+
+	interrupted := make(chan os.Signal, 1)
+	signal.Notify(interrupted, os.Interrupt)
+
+	var buf []byte
+	var reported uint64
+	count := 0
+
+	for {
+		select {
+		case <-interrupted:
+			log.Printf("Read %d records, %d dropped", count, reader.Dropped())
+			return
+		default:
+		}
+
+		record, seq, ok := reader.Next(buf)
+		buf = record
+
+		if !ok {
+			time.Sleep(poll)
+			continue
+		}
+
+		if dropped := reader.Dropped(); dropped != reported {
+			log.Printf("Lapped by the writer: %d records dropped so far", dropped)
+			reported = dropped
+		}
+
+		scope := RSP.GetRootAsScopeInfo(record, 0)
+
+		log.Printf("------- #%d", seq)
+		log.Printf("  Tag: %s", string(scope.Tag()))
+		log.Printf("  Ticks: %d - %d", scope.TicksStart(), scope.TicksEnd())
+		if scope.Kind() != RSP.RecordKindSCOPE {
+			log.Printf("  Kind: %s Value=%g", scope.Kind(), EventValue(ConvertScopeInfo(scope)))
+		}
+
+		for j := 0; j < scope.MetadataLength(); j++ {
+			m := new(RSP.MetadataEntry)
+			if !scope.Metadata(m, j) {
+				continue
+			}
+			switch MetadataType(m.Type()) {
+			case MetadataTypeString:
+				log.Printf("    Metadata #%d: %s Type=%d Text=%q",
+					j, string(m.Tag()), m.Type(), inlineMetadataString(m.Value()))
+			case MetadataTypeStringID:
+				log.Printf("    Metadata #%d: %s Type=%d Text=%q",
+					j, string(m.Tag()), m.Type(), string(m.Text()))
+			default:
+				log.Printf("    Metadata #%d: %s Type=%d Value=%d",
+					j, string(m.Tag()), m.Type(), m.Value())
+			}
+		}
+		count++
+	}
+}
+
+var TailCommand = &cli.Command{
+	Name:      "tail",
+	Usage:     "Follow a live shared memory ring (see rsp::SharedMemorySink), printing records as they're published.",
+	ArgsUsage: "<ring>",
+	Flags: []cli.Flag{
+		&cli.BoolFlag{
+			Name:  "from-start",
+			Usage: "Start from the oldest record still in the ring, rather than only new ones.",
+		},
+		&cli.DurationFlag{
+			Name:  "poll",
+			Usage: "How long to sleep when caught up with the writer.",
+			Value: time.Millisecond,
+		},
+	},
+	Action: func(c *cli.Context) error {
+		if c.Args().Len() < 1 {
+			return fmt.Errorf("missing ring\nUsage: rsp tail [--from-start] [--poll=1ms] <ring>")
+		}
+
+		Tail(c.Args().Get(0), c.Bool("from-start"), c.Duration("poll"))
+
+		return nil
+	},
+}
@@ -22,24 +22,21 @@ import (
 	"log"
 )
 
-func TimingsForScope(filename string, scope string, savePath string, bindAddr string) {
+func TimingsForScope(filename string, scope string, filter *MetadataFilter, savePath string, bindAddr string) {
 	log.Printf("Analyzing scope %s, from %s", scope, filename)
 
-	scopeInfos, err := SelectScopes(filename, []string{scope})
+	timesMs, err := ScopeDurationsMs(filename, scope, filter)
 
 	if err != nil {
 		log.Fatal(err)
 	}
 
-	infos, ok := scopeInfos[scope]
-	if !ok || len(infos) == 0 {
+	if len(timesMs) == 0 {
 		log.Fatalf("No entries found for scope %s", scope)
 		return
 	}
 
-	log.Printf("Found %d entries for scope %s", len(infos), scope)
-
-	timesMs := ExtractTimesAsMilliseconds(infos)
+	log.Printf("Found %d entries for scope %s", len(timesMs), scope)
 
 	p50, p95, p99 := ComputePercentiles(timesMs)
 
@@ -69,10 +66,14 @@ var TimingsCommand = &cli.Command{
 			Usage:   "Address and port to bind to.",
 			Value:   "localhost:8080",
 		},
+		&cli.StringFlag{
+			Name:  "where",
+			Usage: "Only include entries with matching metadata, e.g. 'bytes>=4096' or 'shard=eu' (ops: = != < <= > >=).",
+		},
 	},
 	Action: func(c *cli.Context) error {
 		if c.Args().Len() < 2 {
-			return fmt.Errorf("missing filename\nUsage: rsp timings [-o | -b] <filename> <scope>")
+			return fmt.Errorf("missing filename\nUsage: rsp timings [-o | -b] [--where <filter>] <filename> <scope>")
 		}
 
 		filename := c.Args().Get(0)
@@ -85,7 +86,15 @@ var TimingsCommand = &cli.Command{
 			return fmt.Errorf("--output/-o and --bind/-b are mutually exclusive")
 		}
 
-		TimingsForScope(filename, scope, savePath, bindAddr)
+		var filter *MetadataFilter
+		if c.IsSet("where") {
+			var err error
+			if filter, err = ParseMetadataFilter(c.String("where")); err != nil {
+				return err
+			}
+		}
+
+		TimingsForScope(filename, scope, filter, savePath, bindAddr)
 
 		return nil
 	},
@@ -0,0 +1,113 @@
+#include "afware/rsp/API.hpp"
+
+//
+// This is the one translation unit that defines the allocation hooks.
+//
+
+#include "afware/rsp/AllocationHooks.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+//
+// Per-scope heap allocation counts.
+//
+// Builds the same report twice: once the naive way (a string per field,
+// concatenated, in a growing vector) and once with reserved buffers. The
+// "Build report" scopes are inclusive of the "Format row" scopes nested in
+// them, so their self counts show what the outer loop allocates on its own.
+// Rank them with:
+//
+//   rsp allocs /tmp/rsp_allocs.bin
+//
+
+namespace {
+
+constexpr const char *kOutput = "/tmp/rsp_allocs.bin";
+
+std::string FormatRow(const std::map<std::string, int> &row) {
+  RSP_SCOPE("Format row");
+
+  std::string out;
+  for (const auto &[key, value] : row) {
+    out = out + key + "=" + std::to_string(value) + ";";
+  }
+  return out;
+}
+
+void FormatRowInto(const std::map<std::string, int> &row, std::string *out) {
+  RSP_SCOPE("Format row (reused buffer)");
+
+  out->clear();
+  for (const auto &[key, value] : row) {
+    out->append(key).append("=").append(std::to_string(value)).append(";");
+  }
+}
+
+size_t NaiveReport(const std::vector<std::map<std::string, int>> &rows) {
+  RSP_SCOPE("Build report");
+
+  std::vector<std::string> lines;
+  for (const auto &row : rows) {
+    lines.push_back(FormatRow(row));
+  }
+  return lines.size();
+}
+
+size_t ReservedReport(const std::vector<std::map<std::string, int>> &rows) {
+  RSP_SCOPE("Build report (reserved)");
+
+  std::string line;
+  line.reserve(256);
+
+  size_t bytes = 0;
+  for (const auto &row : rows) {
+    FormatRowInto(row, &line);
+    bytes += line.size();
+  }
+  return bytes;
+}
+
+}  // namespace
+
+int main() {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  if (!rsp::EnableAllocationTracking()) {
+    std::cout << "Allocation hooks not compiled in\n";
+    return 1;
+  }
+
+  std::filesystem::remove(kOutput);
+  rsp::Instance().SetSinkToBinaryDisk(rsp::Profiler::CreateBinaryDiskSink(kOutput));
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  std::vector<std::map<std::string, int>> rows(200);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    rows[i] = {{"customer_identifier", static_cast<int>(i)},
+               {"outstanding_order_count", static_cast<int>(i * 7 % 13)},
+               {"loyalty_programme_score", static_cast<int>(i * i % 101)}};
+  }
+
+  size_t total = 0;
+  for (int i = 0; i < 10; ++i) {
+    total += NaiveReport(rows);
+    total += ReservedReport(rows);
+  }
+
+  rsp::Stop();
+
+  std::cout << "Done (" << total << "). Wrote " << kOutput << "\n";
+
+  return 0;
+}
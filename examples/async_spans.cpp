@@ -0,0 +1,187 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Spans that outlive a thread's stack.
+//
+// Each request below is a coroutine that hops between pool threads at every
+// co_await, so an RSP_SCOPE around it would be popped on the wrong thread.
+// Instead it holds a span token in its frame: begun on the main thread,
+// given metadata on whichever worker it's running on, and ended on another.
+// RSP_SCOPE is still fine for the parts that don't suspend.
+//
+// The last request hands its span to a plain std::thread instead.
+//
+
+namespace {
+
+class Pool {
+public:
+  explicit Pool(int threads) {
+    for (int i = 0; i < threads; ++i) {
+      workers_.emplace_back([this] { Run(); });
+    }
+  }
+
+  ~Pool() {
+    {
+      std::lock_guard lock{mutex_};
+      done_ = true;
+    }
+    cv_.notify_all();
+    for (auto &w : workers_) {
+      w.join();
+    }
+  }
+
+  //
+  // co_await pool.Schedule() resumes the coroutine on a pool thread.
+  //
+
+  auto Schedule() {
+    struct Awaiter {
+      Pool *pool;
+
+      bool await_ready() const noexcept {
+        return false;
+      }
+
+      void await_suspend(std::coroutine_handle<> h) {
+        pool->Post(h);
+      }
+
+      void await_resume() const noexcept {
+      }
+    };
+
+    return Awaiter{this};
+  }
+
+private:
+  void Post(std::coroutine_handle<> h) {
+    {
+      std::lock_guard lock{mutex_};
+      queue_.push_back(h);
+    }
+    cv_.notify_one();
+  }
+
+  void Run() {
+    for (;;) {
+      std::coroutine_handle<> h;
+      {
+        std::unique_lock lock{mutex_};
+        cv_.wait(lock, [this] { return done_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          return;
+        }
+        h = queue_.front();
+        queue_.pop_front();
+      }
+      h.resume();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::coroutine_handle<>> queue_;
+  std::vector<std::thread> workers_;
+  bool done_ = false;
+};
+
+//
+// Fire and forget: runs until its first co_await, frees itself at the end.
+//
+
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() {
+      return {};
+    }
+
+    std::suspend_never initial_suspend() noexcept {
+      return {};
+    }
+
+    std::suspend_never final_suspend() noexcept {
+      return {};
+    }
+
+    void return_void() {
+    }
+
+    void unhandled_exception() {
+      std::terminate();
+    }
+  };
+};
+
+Detached Request(Pool &pool, int id, std::latch &done) {
+  auto span = RSP_BEGIN_SPAN("Request");
+  span.AddMetadata("Request", id);
+
+  co_await pool.Schedule();
+  {
+    RSP_SCOPE("Parse");
+    RSP_SCOPE_METADATA("Request", id);
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+
+  co_await pool.Schedule();
+  {
+    RSP_SCOPE("Respond");
+    RSP_SCOPE_METADATA("Request", id);
+    std::this_thread::sleep_for(std::chrono::microseconds(300));
+  }
+
+  span.AddMetadata("Hops", 2);
+  span.End();
+  done.count_down();
+}
+
+}  // namespace
+
+int main() {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  rsp::Instance().SetSinkToCout();
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  {
+    Pool pool{3};
+    std::latch done{4};
+    for (int id = 0; id < 4; ++id) {
+      Request(pool, id, done);
+    }
+    done.wait();
+  }
+
+  auto span = RSP_BEGIN_SPAN("Handed off");
+  span.AddMetadata("Stage", 1);
+
+  std::thread{[span = std::move(span)]() mutable {
+    span.AddMetadata("Stage", 2);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }}.join();
+
+  rsp::Stop();
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+//
+// Per call site and per category switches.
+//
+// Every scope below belongs to a category. We start with only the "io"
+// category on, then flip things around from the API, and list what's
+// registered along the way. Try also:
+//
+//   RSP_SITES='-*,net' ./bin/call_sites
+//   RSP_SITES_FILE=/tmp/rsp_sites ./bin/call_sites   (and edit the file while it runs)
+//
+// and building with -DRSP_MAX_LEVEL=RSP_LEVEL_DEFAULT to strip the trace
+// scope out entirely.
+//
+
+namespace {
+
+void ReadBlock(int i) {
+  RSP_CATEGORY_SCOPE("io", "Read block");
+  RSP_SCOPE_METADATA("Block", i);
+}
+
+void Send(int i) {
+  RSP_CATEGORY_SCOPE("net", "Send");
+  RSP_SCOPE_METADATA("Packet", i);
+}
+
+void Checksum(int i) {
+  RSP_LEVEL_SCOPE(RSP_LEVEL_TRACE, "io", "Checksum");
+  RSP_SCOPE_METADATA("Block", i);
+}
+
+void Work(int rounds) {
+  for (int i = 0; i < rounds; ++i) {
+    ReadBlock(i);
+    Checksum(i);
+    Send(i);
+  }
+}
+
+void List() {
+  for (const auto &site : rsp::ListCallSites()) {
+    std::cout << "  " << (site.enabled ? "on " : "off") << "  " << site.category << " / " << site.name << " (level "
+              << site.level << ")\n";
+  }
+}
+
+}  // namespace
+
+int main() {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  rsp::Instance().SetSinkToCout();
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  rsp::DisableCallSites("*");
+  rsp::EnableCallSites("io");
+
+  std::cout << "Only io:\n";
+  Work(2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  List();
+
+  rsp::ConfigureCallSites("-io, Send");
+
+  std::cout << "Only Send:\n";
+  Work(2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  List();
+
+  rsp::Stop();
+
+  return 0;
+}
@@ -0,0 +1,256 @@
+#include "afware/rsp/API.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//
+// Generates synthetic, reproducible capture files for benchmarking the
+// analysis tooling (see `rsp bench` in the CLI).
+//
+// Records are written through the real sinks (BinaryDiskSink, or
+// BlockDiskSink for the block formats), so the output is byte-for-byte what
+// a profiled program would write. Everything is driven from a seeded PRNG:
+// the same options always produce the same file.
+//
+// Options (all optional, --key=value):
+//
+//   --output=PATH        Output file (default /tmp/rsp_synthetic.bin). Truncated first.
+//   --size-mb=N          Stop once roughly N MB have been written (default 64).
+//   --records=N          Stop after N records instead (overrides --size-mb).
+//   --tags=N             Number of distinct scope tags (default 16).
+//   --metadata-min=N     Minimum metadata entries per record (default 0).
+//   --metadata-max=N     Maximum metadata entries per record (default 4, capped at RSP_MAX_METADATA_ENTRIES).
+//   --metadata-keys=N    Number of distinct metadata keys (default 8).
+//   --duration=DIST      fixed | uniform | lognormal | bimodal (default lognormal).
+//   --duration-ns=N      Median/typical scope duration in ns (default 2000).
+//   --seed=N             PRNG seed (default 1).
+//   --non-finite=N       Every Nth record gets a double "ratio" entry of NaN, +Inf or -Inf, and the
+//                        others a finite one (default 0, no "ratio" entries). For checking that
+//                        `rsp convert --check` round trips them.
+//   --format=FORMAT      flatbuffer | flatbuffer-bare | block | block-uncompressed (default flatbuffer).
+//                        flatbuffer-bare is the unframed stream from before CaptureFormat.hpp.
+//
+
+namespace {
+
+struct Options {
+  std::filesystem::path output = "/tmp/rsp_synthetic.bin";
+  uint64_t size_mb             = 64;
+  uint64_t records             = 0;
+  uint64_t tags                = 16;
+  uint64_t metadata_min        = 0;
+  uint64_t metadata_max        = 4;
+  uint64_t metadata_keys       = 8;
+  std::string duration         = "lognormal";
+  uint64_t duration_ns         = 2000;
+  uint64_t seed                = 1;
+  uint64_t non_finite          = 0;
+  std::string format           = "flatbuffer";
+};
+
+bool ParseOptions(int argc, char **argv, Options *opts) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg{argv[i]};
+    const auto eq = arg.find('=');
+    if (arg.substr(0, 2) != "--" || eq == std::string_view::npos) {
+      std::cerr << "Bad option: " << arg << "\n";
+      return false;
+    }
+
+    const std::string_view key = arg.substr(2, eq - 2);
+    const std::string value{arg.substr(eq + 1)};
+    const uint64_t number = std::strtoull(value.c_str(), nullptr, 10);
+
+    if (key == "output") {
+      opts->output = value;
+    } else if (key == "size-mb") {
+      opts->size_mb = number;
+    } else if (key == "records") {
+      opts->records = number;
+    } else if (key == "tags") {
+      opts->tags = std::max<uint64_t>(1, number);
+    } else if (key == "metadata-min") {
+      opts->metadata_min = number;
+    } else if (key == "metadata-max") {
+      opts->metadata_max = number;
+    } else if (key == "metadata-keys") {
+      opts->metadata_keys = std::max<uint64_t>(1, number);
+    } else if (key == "duration") {
+      opts->duration = value;
+    } else if (key == "duration-ns") {
+      opts->duration_ns = std::max<uint64_t>(1, number);
+    } else if (key == "seed") {
+      opts->seed = number;
+    } else if (key == "non-finite") {
+      opts->non_finite = number;
+    } else if (key == "format") {
+      opts->format = value;
+    } else {
+      std::cerr << "Unknown option: " << key << "\n";
+      return false;
+    }
+  }
+
+  opts->metadata_max = std::min<uint64_t>(opts->metadata_max, RSP_MAX_METADATA_ENTRIES);
+  opts->metadata_min = std::min(opts->metadata_min, opts->metadata_max);
+
+  if (opts->duration != "fixed" && opts->duration != "uniform" && opts->duration != "lognormal" &&
+      opts->duration != "bimodal") {
+    std::cerr << "Unknown duration distribution: " << opts->duration << "\n";
+    return false;
+  }
+
+  if (opts->format != "flatbuffer" && opts->format != "flatbuffer-bare" && opts->format != "block" &&
+      opts->format != "block-uncompressed") {
+    std::cerr << "Unknown format: " << opts->format << "\n";
+    return false;
+  }
+
+  return true;
+}
+
+class DurationSampler {
+public:
+  DurationSampler(const Options &opts, double ticks_per_ns)
+      : kind_(opts.duration), typical_(static_cast<double>(opts.duration_ns) * ticks_per_ns) {
+  }
+
+  uint64_t operator()(std::mt19937_64 &rng) {
+    double ticks = typical_;
+    if (kind_ == "uniform") {
+      ticks = std::uniform_real_distribution<double>(0.0, 2.0 * typical_)(rng);
+    } else if (kind_ == "lognormal") {
+      ticks = typical_ * std::exp(std::normal_distribution<double>(0.0, 0.75)(rng));
+    } else if (kind_ == "bimodal") {
+      //
+      // Mostly fast, with a 5% slow mode an order of magnitude out - the
+      // kind of tail percentiles are meant to expose.
+      //
+      const double mode = std::bernoulli_distribution(0.05)(rng) ? 10.0 * typical_ : typical_;
+      ticks             = mode * std::exp(std::normal_distribution<double>(0.0, 0.25)(rng));
+    }
+    return std::max<uint64_t>(1, static_cast<uint64_t>(ticks));
+  }
+
+private:
+  std::string kind_;
+  double typical_;
+};
+
+template <typename Sink>
+uint64_t Generate(const Options &opts, Sink *sink) {
+  std::vector<std::string> tags;
+  for (uint64_t i = 0; i < opts.tags; ++i) {
+    tags.push_back("Synthetic scope " + std::to_string(i));
+  }
+
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < opts.metadata_keys; ++i) {
+    keys.push_back("key " + std::to_string(i));
+  }
+
+  const double ticks_per_ns = static_cast<double>(rsp::Instance().GetMachine()->GetNominalFreq()) / 1e9;
+
+  std::mt19937_64 rng{opts.seed};
+  DurationSampler duration{opts, ticks_per_ns};
+
+  //
+  // Tags are Zipf-ish: a few hot scopes and a long tail, like real code.
+  //
+
+  std::vector<double> tag_weights;
+  for (uint64_t i = 0; i < opts.tags; ++i) {
+    tag_weights.push_back(1.0 / static_cast<double>(i + 1));
+  }
+  std::discrete_distribution<size_t> pick_tag{tag_weights.begin(), tag_weights.end()};
+  std::uniform_int_distribution<uint64_t> pick_metadata_count{opts.metadata_min, opts.metadata_max};
+  std::uniform_int_distribution<size_t> pick_key{0, keys.size() - 1};
+
+  const uint64_t byte_budget = opts.size_mb * 1024 * 1024;
+  uint64_t records           = 0;
+  uint64_t ticks             = 1000000;
+
+  rsp::MetadataSlot slot;
+
+  while (opts.records ? records < opts.records : sink->BytesWritten() < byte_budget) {
+    rsp::ScopeInfo info{rsp::ScopeTag{tags[pick_tag(rng)].c_str()}};
+    info.metadata_ptr = &slot;
+
+    ticks += 1 + duration(rng) / 4;
+    info.ticks_start = ticks;
+    info.ticks_end   = ticks + duration(rng);
+
+    if (opts.non_finite) {
+      static constexpr double kNonFinite[] = {std::numeric_limits<double>::quiet_NaN(),
+                                              std::numeric_limits<double>::infinity(),
+                                              -std::numeric_limits<double>::infinity()};
+      const double ratio = records % opts.non_finite == 0 ? kNonFinite[(records / opts.non_finite) % 3]
+                                                          : static_cast<double>(rng() % 1000) / 1000.0;
+      info.AddMetadata(rsp::MetadataTag{"ratio"}, ratio);
+    }
+
+    const uint64_t metadata_count = pick_metadata_count(rng);
+    for (uint64_t m = 0; m < metadata_count; ++m) {
+      info.AddMetadata(rsp::MetadataTag{keys[pick_key(rng)].c_str()}, static_cast<uint64_t>(rng() % 100000));
+    }
+
+    sink->Sink(info);
+    slot.MakePristine();
+    ++records;
+  }
+
+  return records;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opts;
+  if (!ParseOptions(argc, argv, &opts)) {
+    return 1;
+  }
+
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  std::filesystem::remove(opts.output);
+
+  uint64_t records = 0;
+  if (opts.format == "flatbuffer" || opts.format == "flatbuffer-bare") {
+    rsp::BinaryDiskSinkOptions binary_options;
+    binary_options.framed = opts.format == "flatbuffer";
+
+    auto sink = rsp::Profiler::CreateBinaryDiskSink(opts.output, binary_options);
+    if (!sink->OK()) {
+      std::cerr << "Could not open " << opts.output << "\n";
+      return 1;
+    }
+    records = Generate(opts, sink.get());
+  } else {
+    rsp::BlockDiskSinkOptions block_options;
+    block_options.compress = opts.format == "block";
+
+    auto sink = rsp::Profiler::CreateBlockDiskSink(opts.output, block_options);
+    if (!sink->OK()) {
+      std::cerr << "Could not open " << opts.output << "\n";
+      return 1;
+    }
+    records = Generate(opts, sink.get());
+  }
+
+  std::cout << "Wrote " << records << " records (" << std::filesystem::file_size(opts.output) << " bytes) to "
+            << opts.output.string() << "\n";
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <thread>
+
+//
+// Counters, gauges and instant events alongside scopes.
+//
+// A toy work queue: a producer pushes items in bursts, and we record how
+// many were produced (counter), how deep the queue is (gauge), when it
+// drains (instant) and how long each item takes (scope). Plot it all on one
+// time axis with:
+//
+//   rsp series /tmp/rsp_counters.bin --scope "Process item"
+//
+// Pass "block" to write a block capture instead.
+//
+
+namespace {
+
+constexpr const char *kOutput = "/tmp/rsp_counters.bin";
+
+void Process(int item) {
+  RSP_SCOPE("Process item");
+  RSP_SCOPE_METADATA("Item", item);
+
+  std::this_thread::sleep_for(std::chrono::microseconds(50 + item % 7 * 20));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  std::filesystem::remove(kOutput);
+
+  if (argc > 1 && std::string_view{argv[1]} == "block") {
+    rsp::Instance().SetSinkToBlockDisk(rsp::Profiler::CreateBlockDiskSink(kOutput));
+  } else {
+    rsp::Instance().SetSinkToBinaryDisk(rsp::Profiler::CreateBinaryDiskSink(kOutput));
+  }
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  std::deque<int> queue;
+  int next = 0;
+
+  for (int tick = 0; tick < 200; ++tick) {
+    //
+    // Bursty arrivals: a slow sine wave of load.
+    //
+
+    const int arrivals = static_cast<int>(4 + 4 * std::sin(tick / 15.0));
+    for (int i = 0; i < arrivals; ++i) {
+      queue.push_back(next++);
+    }
+    RSP_COUNTER("Items produced", arrivals);
+    RSP_GAUGE("Queue depth", queue.size());
+
+    for (int i = 0; i < 4 && !queue.empty(); ++i) {
+      Process(queue.front());
+      queue.pop_front();
+
+      if (queue.empty()) {
+        RSP_INSTANT("Queue drained");
+      }
+    }
+  }
+
+  rsp::Stop();
+
+  std::cout << "Produced " << next << " items, " << queue.size() << " left over. Wrote " << kOutput << "\n";
+
+  return 0;
+}
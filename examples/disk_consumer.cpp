@@ -7,37 +7,29 @@
 using namespace rsp;
 
 int main() {
-  std::ifstream fd("/tmp/rsp_example.bin", std::ios::binary);
-  if (!fd) {
+  CaptureReader reader("/tmp/rsp_example.bin");
+  if (!reader.OK()) {
     std::cerr << "Could not open file. Did you run disk_producer first?\n";
     return 1;
   }
 
-  size_t count = 0;
-
-  while (true) {
-    uint32_t len = 0;
-    fd.read(reinterpret_cast<char*>(&len), sizeof(len));
-    if (fd.eof()) break;
-    if (!fd) {
-      std::cerr << "Failed to read length prefix\n";
-      break;
-    }
+  if (const auto *header = reader.Header()) {
+    std::cout << "Captured on " << header->host << " (" << header->cpu_model << "), " << header->clock_source
+              << " at " << header->nominal_freq << " Hz\n";
+  }
 
-    std::vector<uint8_t> buffer(len);
-    fd.read(reinterpret_cast<char*>(buffer.data()), len);
-    if (fd.gcount() != len) {
-      std::cerr << "Failed to read full FlatBuffer of length " << len << "\n";
-      break;
-    }
+  size_t count = 0;
 
-    flatbuffers::Verifier verifier(buffer.data(), len);
+  const uint8_t* data = nullptr;
+  uint32_t len        = 0;
+  while (reader.Next(&data, &len)) {
+    flatbuffers::Verifier verifier(data, len);
     if (!RSP::VerifyScopeInfoBuffer(verifier)) {
       std::cerr << "FlatBuffer verification failed for record #" << count << "\n";
       continue;
     }
 
-    const RSP::ScopeInfo* scope = RSP::GetScopeInfo(buffer.data());
+    const RSP::ScopeInfo* scope = RSP::GetScopeInfo(data);
     if (!scope) {
       std::cerr << "Failed to parse FlatBuffer for record #" << count << "\n";
       continue;
@@ -48,6 +40,11 @@ int main() {
     std::cout << scope << "\n";
   }
 
+  if (reader.SkippedBytes() > 0 || reader.Truncated()) {
+    std::cerr << "Skipped " << reader.SkippedBytes() << " bytes of damaged capture"
+              << (reader.Truncated() ? " (truncated)" : "") << "\n";
+  }
+
   std::cout << "Read " << count << " records\n";
   return 0;
 }
@@ -0,0 +1,113 @@
+#include "afware/rsp/API.hpp"
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+
+//
+// Several sinks at once, one of them our own.
+//
+// LatencyHistogramSink keeps a log2 histogram of durations per scope in
+// memory - enough to print a summary at exit - while a block sink writes
+// the raw records for later analysis with the CLI. Both see every batch the
+// sink thread takes off the queue; neither costs an indirect call per
+// record.
+//
+
+namespace {
+
+constexpr const char *kOutput = "/tmp/rsp_fan_out.bin";
+
+class LatencyHistogramSink {
+public:
+  static constexpr size_t kBuckets = 65;
+  using Buckets                     = std::array<uint64_t, kBuckets>;
+
+  void SinkBatch(std::span<const rsp::ScopeInfo> batch) {
+    const std::lock_guard lock{mutex_};
+    for (const auto &info : batch) {
+      if (info.kind != rsp::RecordKind::SCOPE) {
+        continue;
+      }
+      const std::string_view tag{info.tag.c_str(), info.tag.size};
+      auto it = histograms_.find(tag);
+      if (it == histograms_.end()) {
+        it = histograms_.emplace(std::string{tag}, Buckets{}).first;
+      }
+      it->second[std::bit_width(info.ticks_end - info.ticks_start)]++;
+    }
+  }
+
+  void Print(double ticks_per_us) const {
+    const std::lock_guard lock{mutex_};
+    for (const auto &[tag, buckets] : histograms_) {
+      std::cout << tag << "\n";
+      for (size_t b = 0; b < kBuckets; ++b) {
+        if (buckets[b] == 0) {
+          continue;
+        }
+        const double upper = std::ldexp(1.0, static_cast<int>(b)) / ticks_per_us;
+        std::cout << "  < " << std::setw(10) << std::fixed << std::setprecision(1) << upper << " us: " << buckets[b]
+                  << "\n";
+      }
+    }
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::map<std::string, Buckets, std::less<>> histograms_;
+};
+
+void Work(int i) {
+  RSP_SCOPE("Work");
+  RSP_SCOPE_METADATA("Item", i);
+  std::this_thread::sleep_for(std::chrono::microseconds(i % 10 == 0 ? 500 : 40));
+}
+
+}  // namespace
+
+int main() {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  std::filesystem::remove(kOutput);
+
+  auto histogram = std::make_shared<LatencyHistogramSink>();
+  rsp::Instance().SetSinks(rsp::Profiler::CreateBlockDiskSink(kOutput), histogram);
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    Work(i);
+  }
+
+  rsp::Stop();
+
+  //
+  // Dropping the profiler's references closes the block sink's file.
+  //
+
+  rsp::Instance().SetSinkToSilent();
+
+  histogram->Print(static_cast<double>(rsp::Instance().GetMachine()->GetNominalFreq()) / 1e6);
+  std::cout << "Wrote " << kOutput << "\n";
+
+  return 0;
+}
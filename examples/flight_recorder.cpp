@@ -0,0 +1,67 @@
+#include "afware/rsp/API.hpp"
+
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+//
+// Flight recorder mode: a handful of threads record scopes, only the last
+// RSP_FLIGHT_RECORDER_RECORDS per thread are kept, and nothing hits the disk
+// until we dump.
+//
+// Usage: flight_recorder [crash]
+//
+// Without arguments the rings are dumped through the API. With "crash" the
+// program segfaults instead, and the dump is written from the signal
+// handler. Either way, read it back with `rsp echo /tmp/rsp_flight.bin`.
+// While it runs, `kill -USR2 <pid>` dumps too.
+//
+
+void worker(int num) {
+  for (size_t i = 0; i < 100000; ++i) {
+    RSP_SCOPE("Worker Loop");
+    RSP_SCOPE_METADATA("Thread", num);
+    RSP_SCOPE_METADATA("Count", i);
+  }
+}
+
+int main(int argc, char **argv) {
+  const bool crash = argc > 1 && std::strcmp(argv[1], "crash") == 0;
+
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  auto recorder = rsp::Profiler::CreateFlightRecorder("/tmp/rsp_flight.bin");
+  rsp::Instance().SetSinkToFlightRecorder(recorder);
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.push_back(std::thread{worker, i});
+  }
+
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  if (crash) {
+    std::cout << "Crashing...\n" << std::flush;
+    std::raise(SIGSEGV);
+  }
+
+  if (recorder->Dump()) {
+    std::cout << "Dumped to /tmp/rsp_flight.bin\n";
+  }
+
+  rsp::Stop();
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+//
+// Following requests through a two stage pipeline with flow ids.
+//
+// The acceptor gives each request a flow id and hands it to a parse queue;
+// a pool of parsers takes it from there and hands it to a respond queue,
+// whose single responder is deliberately the bottleneck. Every scope a
+// request passes through carries its flow, and each hand off is marked, so
+//
+//   rsp flows /tmp/rsp_flows.bin
+//
+// shows, hop by hop, how long requests sat in each queue versus how long
+// they were worked on - and the end to end latency.
+//
+// Pass "block" to write a block capture instead.
+//
+
+namespace {
+
+constexpr const char *kOutput = "/tmp/rsp_flows.bin";
+
+struct Request {
+  uint64_t flow;
+  int id;
+};
+
+class Queue {
+public:
+  void Push(Request r) {
+    {
+      std::lock_guard lock{mutex_};
+      items_.push_back(r);
+    }
+    cv_.notify_one();
+  }
+
+  std::optional<Request> Pop() {
+    std::unique_lock lock{mutex_};
+    cv_.wait(lock, [this] { return closed_ || !items_.empty(); });
+    if (items_.empty()) {
+      return std::nullopt;
+    }
+    Request r = items_.front();
+    items_.pop_front();
+    return r;
+  }
+
+  void Close() {
+    {
+      std::lock_guard lock{mutex_};
+      closed_ = true;
+    }
+    cv_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request> items_;
+  bool closed_ = false;
+};
+
+void Accept(Queue &parse, int id) {
+  const uint64_t flow = rsp::NewFlowId();
+  RSP_FLOW(flow);
+
+  RSP_SCOPE("Accept");
+  RSP_SCOPE_METADATA("Request", id);
+  std::this_thread::sleep_for(std::chrono::microseconds(20));
+
+  RSP_FLOW_ENQUEUE("Parse queue", flow);
+  parse.Push({flow, id});
+}
+
+void Parser(Queue &parse, Queue &respond) {
+  while (auto r = parse.Pop()) {
+    RSP_FLOW_DEQUEUE(r->flow);
+
+    RSP_SCOPE("Parse");
+    RSP_SCOPE_METADATA("Request", r->id);
+    std::this_thread::sleep_for(std::chrono::microseconds(100 + r->id % 5 * 20));
+
+    RSP_FLOW_ENQUEUE("Respond queue", r->flow);
+    respond.Push(*r);
+  }
+}
+
+void Responder(Queue &respond) {
+  while (auto r = respond.Pop()) {
+    RSP_FLOW_DEQUEUE(r->flow);
+
+    RSP_SCOPE("Respond");
+    RSP_SCOPE_METADATA("Request", r->id);
+    std::this_thread::sleep_for(std::chrono::microseconds(60));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  std::filesystem::remove(kOutput);
+
+  if (argc > 1 && std::string_view{argv[1]} == "block") {
+    rsp::Instance().SetSinkToBlockDisk(rsp::Profiler::CreateBlockDiskSink(kOutput));
+  } else {
+    rsp::Instance().SetSinkToBinaryDisk(rsp::Profiler::CreateBinaryDiskSink(kOutput));
+  }
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  constexpr int kRequests = 500;
+
+  Queue parse;
+  Queue respond;
+
+  std::vector<std::thread> parsers;
+  for (int i = 0; i < 3; ++i) {
+    parsers.emplace_back([&] { Parser(parse, respond); });
+  }
+  std::thread responder{[&] { Responder(respond); }};
+
+  for (int id = 0; id < kRequests; ++id) {
+    Accept(parse, id);
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+
+  parse.Close();
+  for (auto &p : parsers) {
+    p.join();
+  }
+  respond.Close();
+  responder.join();
+
+  rsp::Stop();
+
+  std::cout << "Sent " << kRequests << " requests through the pipeline. Wrote " << kOutput << "\n";
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include "afware/rsp/API.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+//
+// Hardware counters on scopes.
+//
+// Three loops that take similar wall time for very different reasons: a
+// sequential sum (high IPC), a pointer chase through a buffer much larger
+// than the last level cache (LLC misses), and a branch on random data
+// (mispredictions). See which is which with:
+//
+//   rsp perf /tmp/rsp_perf.bin
+//
+// Where perf events aren't available (most containers and many VMs) the
+// capture is still written, just without counters.
+//
+
+namespace {
+
+constexpr const char *kOutput = "/tmp/rsp_perf.bin";
+
+constexpr size_t kChaseEntries = 32 * 1024 * 1024 / sizeof(uint32_t);
+
+uint64_t Sequential(const std::vector<uint32_t> &values) {
+  RSP_SCOPE("Sequential sum");
+  return std::accumulate(values.begin(), values.end(), uint64_t{0});
+}
+
+uint64_t Chase(const std::vector<uint32_t> &next, uint32_t start, size_t steps) {
+  RSP_SCOPE("Pointer chase");
+  uint32_t at = start;
+  for (size_t i = 0; i < steps; ++i) {
+    at = next[at];
+  }
+  return at;
+}
+
+uint64_t Branchy(const std::vector<uint32_t> &values) {
+  RSP_SCOPE("Random branches");
+  uint64_t sum = 0;
+  for (const uint32_t v : values) {
+    if (v & 1) {
+      sum += v;
+    } else {
+      sum ^= v;
+    }
+  }
+  return sum;
+}
+
+}  // namespace
+
+int main() {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  if (!rsp::EnablePerfCounters()) {
+    std::cout << "Perf events not available here, recording wall time only\n";
+  }
+
+  std::filesystem::remove(kOutput);
+  rsp::Instance().SetSinkToBinaryDisk(rsp::Profiler::CreateBinaryDiskSink(kOutput));
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  std::mt19937 rng{1};
+
+  std::vector<uint32_t> values(1 << 20);
+  for (auto &v : values) {
+    v = static_cast<uint32_t>(rng());
+  }
+
+  //
+  // One random cycle through the whole buffer, so every step is a miss.
+  //
+
+  std::vector<uint32_t> order(kChaseEntries);
+  std::iota(order.begin(), order.end(), 0);
+  for (size_t i = order.size() - 1; i > 0; --i) {
+    std::swap(order[i], order[std::uniform_int_distribution<size_t>{0, i}(rng)]);
+  }
+  std::vector<uint32_t> next(kChaseEntries);
+  for (size_t i = 0; i < order.size(); ++i) {
+    next[order[i]] = order[(i + 1) % order.size()];
+  }
+
+  uint64_t sink = 0;
+  for (int i = 0; i < 20; ++i) {
+    sink += Sequential(values);
+    sink += Chase(next, order[0], 1 << 16);
+    sink += Branchy(values);
+  }
+
+  rsp::Stop();
+
+  std::cout << "Done (" << sink % 10 << "). Wrote " << kOutput << "\n";
+
+  return 0;
+}
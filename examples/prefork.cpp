@@ -0,0 +1,92 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+//
+// Profiling a pre-forking server.
+//
+// The parent profiles its start up, then forks workers that each serve a
+// share of the requests. Following forks, each worker writes a capture of
+// its own next to the parent's - rsp.pid<pid>.bin - rather than stopping.
+// Put them all back on one timeline with:
+//
+//   rsp merge -o /tmp/rsp_prefork.col /tmp/rsp_prefork
+//   rsp scopes /tmp/rsp_prefork.col
+//
+
+namespace {
+
+const std::filesystem::path kDirectory = "/tmp/rsp_prefork";
+
+constexpr int kWorkers  = 3;
+constexpr int kRequests = 200;
+
+void LoadConfig() {
+  RSP_SCOPE("Load config");
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+}
+
+void Serve(int worker) {
+  for (int request = worker; request < kRequests; request += kWorkers) {
+    RSP_SCOPE("Serve request");
+    RSP_SCOPE_METADATA("Request", request);
+    RSP_SCOPE_METADATA("Worker", worker);
+    std::this_thread::sleep_for(std::chrono::microseconds(100 + worker * 50));
+  }
+}
+
+}  // namespace
+
+int main() {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  std::filesystem::remove_all(kDirectory);
+  std::filesystem::create_directories(kDirectory);
+
+  rsp::EnableForkFollowing();
+  rsp::Instance().SetSinkToBinaryDisk(rsp::Profiler::CreateBinaryDiskSink(kDirectory / "rsp.bin"));
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  LoadConfig();
+
+  std::vector<pid_t> workers;
+  for (int worker = 0; worker < kWorkers; ++worker) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      Serve(worker);
+      rsp::Stop();
+      std::exit(0);
+    }
+    workers.push_back(pid);
+  }
+
+  for (const pid_t pid : workers) {
+    waitpid(pid, nullptr, 0);
+  }
+
+  {
+    RSP_SCOPE("Shut down");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  rsp::Stop();
+
+  std::cout << "Served " << kRequests << " requests from " << kWorkers << " workers. Wrote " << kDirectory << "\n";
+
+  return 0;
+}
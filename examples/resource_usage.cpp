@@ -0,0 +1,121 @@
+#include "afware/rsp/API.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+
+//
+// Context switches and page faults on scopes.
+//
+// Most requests below are quick, but some sleep (as if waiting on a lock or
+// the disk), some touch fresh memory (page faults), some just compute for
+// longer, and on and off busy threads compete for the CPUs (preemption). All
+// their tails look alike on a timeline; see which is which with:
+//
+//   rsp offcpu /tmp/rsp_rusage.bin
+//
+// Only "Handle request" is sampled - the nested "Parse" scope isn't.
+//
+
+namespace {
+
+constexpr const char *kOutput = "/tmp/rsp_rusage.bin";
+
+void Spin(std::chrono::microseconds duration) {
+  const auto until = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < until) {
+  }
+}
+
+void Parse() {
+  RSP_SCOPE("Parse");
+  Spin(std::chrono::microseconds(20));
+}
+
+void Handle(int id) {
+  RSP_SCOPE("Handle request");
+  RSP_SCOPE_METADATA("Request", id);
+
+  Parse();
+
+  switch (id % 20) {
+    case 0:
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      break;
+    case 1: {
+      //
+      // Straight from mmap, so every page is new (malloc would recycle).
+      //
+
+      constexpr size_t kBytes = 4 * 1024 * 1024;
+      void *buffer            = mmap(nullptr, kBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (buffer != MAP_FAILED) {
+        std::memset(buffer, id, kBytes);
+        munmap(buffer, kBytes);
+      }
+      break;
+    }
+    case 2:
+      Spin(std::chrono::microseconds(1000));
+      break;
+    default:
+      Spin(std::chrono::microseconds(50));
+      break;
+  }
+}
+
+}  // namespace
+
+int main() {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  if (!rsp::EnableResourceUsage()) {
+    std::cout << "getrusage(RUSAGE_THREAD) not available here\n";
+    return 1;
+  }
+  rsp::ConfigureResourceUsageSites("-*, Handle request");
+
+  std::filesystem::remove(kOutput);
+  rsp::Instance().SetSinkToBinaryDisk(rsp::Profiler::CreateBinaryDiskSink(kOutput));
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  std::atomic<bool> done = false;
+  std::vector<std::thread> noise;
+  for (unsigned i = 0; i < std::thread::hardware_concurrency(); ++i) {
+    noise.emplace_back([&] {
+      while (!done.load(std::memory_order_relaxed)) {
+        Spin(std::chrono::microseconds(200));
+        std::this_thread::sleep_for(std::chrono::microseconds(800));
+      }
+    });
+  }
+
+  constexpr int kRequests = 2000;
+  for (int id = 0; id < kRequests; ++id) {
+    Handle(id);
+  }
+
+  done = true;
+  for (auto &t : noise) {
+    t.join();
+  }
+
+  rsp::Stop();
+
+  std::cout << "Handled " << kRequests << " requests. Wrote " << kOutput << "\n";
+
+  return 0;
+}
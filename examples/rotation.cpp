@@ -0,0 +1,81 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+//
+// Rolling a capture over into segments.
+//
+// Writes a few thousand scopes through a binary disk sink that starts a new
+// segment every 128KB, and keeps only the newest five. Afterwards the
+// directory holds the last five segments written, rsp.<seq>.<time>.bin,
+// each a capture of its own; read them all at once with:
+//
+//   rsp scopes /tmp/rsp_rotation
+//   rsp percentiles '/tmp/rsp_rotation/rsp.*.bin' --scope "Handle request"
+//
+
+namespace {
+
+const std::filesystem::path kDirectory = "/tmp/rsp_rotation";
+
+void Handle(int request) {
+  RSP_SCOPE("Handle request");
+  RSP_SCOPE_METADATA("Request", request);
+
+  {
+    RSP_SCOPE("Look up");
+    std::this_thread::sleep_for(std::chrono::microseconds(5));
+  }
+  {
+    RSP_SCOPE("Respond");
+    std::this_thread::sleep_for(std::chrono::microseconds(request % 10));
+  }
+}
+
+}  // namespace
+
+int main() {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  std::filesystem::remove_all(kDirectory);
+  std::filesystem::create_directories(kDirectory);
+
+  rsp::BinaryDiskSinkOptions options;
+  options.rotate_bytes    = 128 * 1024;
+  options.rotate_interval = std::chrono::minutes{1};
+  options.max_segments    = 5;
+
+  auto sink = rsp::Profiler::CreateBinaryDiskSink(kDirectory / "rsp.bin", options);
+  rsp::Instance().SetSinkToBinaryDisk(sink);
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  constexpr int kRequests = 4000;
+  for (int request = 0; request < kRequests; ++request) {
+    Handle(request);
+  }
+
+  rsp::Stop();
+
+  //
+  // The sink thread is done with it, so write out the last partial frame.
+  //
+
+  sink->Flush();
+
+  std::cout << "Handled " << kRequests << " requests, last segment " << sink->CurrentPath() << "\n";
+  for (const auto &segment : rsp::ListSegments(kDirectory / "rsp.bin")) {
+    std::cout << "  " << segment.path.filename().string() << " (" << segment.bytes << " bytes)\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,265 @@
+#include "afware/rsp/API.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+//
+// Multi-threaded scaling benchmark for the producer path.
+//
+// We sweep the number of producer threads (1 -> all cores) against a set
+// of per-thread scope rates (from mostly idle up to back-to-back scopes)
+// and, for every point, report:
+//
+// - The per-scope cost seen by the producers (p50/p99/p99.9/max). This is
+//   measured around the entire RSP_SCOPE lifetime, so it includes slot
+//   acquisition, the clock reads and the enqueue.
+// - How many records/sec the producers generated, and how many the sink
+//   thread actually drained during the same window.
+// - The largest queue backlog seen while producing, and how long the sink
+//   thread needed to drain what was left once the producers stopped.
+// - How many slots the metadata slot pool had to grow by.
+//
+// The sink is silent so that we are measuring the pipeline rather than I/O.
+// Where the sunk rate stops tracking the produced rate (and the backlog
+// starts to climb) is where the queue/free-list design stops scaling.
+//
+// Usage: scaling [duration_ms_per_point] [max_threads]
+//
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+//
+// A small log-linear histogram - 16 linear sub-buckets per power of two -
+// so producers can record every scope without allocating. Percentiles are
+// reported as the lower bound of the bucket they fall in (~6% resolution).
+//
+
+class LatencyHistogram {
+public:
+  static constexpr size_t kSubBucketBits = 4;
+  static constexpr size_t kSubBuckets    = 1 << kSubBucketBits;
+  static constexpr size_t kBuckets       = 64 * kSubBuckets;
+
+  void Record(uint64_t v) {
+    ++counts_[Index(v)];
+    ++total_;
+    max_ = std::max(max_, v);
+  }
+
+  void Merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    max_ = std::max(max_, other.max_);
+  }
+
+  uint64_t Percentile(double p) const {
+    if (total_ == 0) {
+      return 0;
+    }
+
+    const uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(total_ - 1)) + 1;
+    uint64_t seen       = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return LowerBound(i);
+      }
+    }
+    return max_;
+  }
+
+  uint64_t Total() const {
+    return total_;
+  }
+
+  uint64_t Max() const {
+    return max_;
+  }
+
+private:
+  static size_t Index(uint64_t v) {
+    if (v < kSubBuckets) {
+      return v;
+    }
+    const size_t msb   = 63 - std::countl_zero(v);
+    const size_t shift = msb - kSubBucketBits;
+    return ((shift + 1) << kSubBucketBits) | ((v >> shift) & (kSubBuckets - 1));
+  }
+
+  static uint64_t LowerBound(size_t idx) {
+    if (idx < kSubBuckets) {
+      return idx;
+    }
+    const size_t shift = (idx >> kSubBucketBits) - 1;
+    return (kSubBuckets | (idx & (kSubBuckets - 1))) << shift;
+  }
+
+  std::array<uint64_t, kBuckets> counts_ = {};
+  uint64_t total_                        = 0;
+  uint64_t max_                          = 0;
+};
+
+struct ProducerResult {
+  LatencyHistogram latency;
+  uint64_t scopes = 0;
+};
+
+//
+// Scopes/sec per producer thread. Zero means "as fast as possible".
+//
+
+constexpr std::array<uint64_t, 4> kRates = {1000, 10000, 100000, 0};
+
+void Producer(uint64_t rate, const std::atomic<bool> &go, const std::atomic<bool> &done, ProducerResult *result) {
+  while (!go.load(std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
+
+  const auto interval = rate ? std::chrono::nanoseconds(1000000000ull / rate) : std::chrono::nanoseconds(0);
+  auto deadline       = Clock::now();
+
+  for (uint64_t i = 0; !done.load(std::memory_order_relaxed); ++i) {
+    const uint64_t t0 = rsp::Now();
+    {
+      RSP_SCOPE("Scaling");
+      RSP_SCOPE_METADATA("Iteration", i);
+    }
+    const uint64_t t1 = rsp::Now();
+
+    result->latency.Record(t1 - t0);
+    ++result->scopes;
+
+    if (rate) {
+      deadline += interval;
+      if (interval >= std::chrono::microseconds(200)) {
+        std::this_thread::sleep_until(deadline);
+      } else {
+        while (Clock::now() < deadline) {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+}
+
+void RunPoint(unsigned num_threads, uint64_t rate, std::chrono::milliseconds duration, double ns_per_tick) {
+  std::atomic<bool> go   = false;
+  std::atomic<bool> done = false;
+
+  std::vector<ProducerResult> results(num_threads);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (unsigned i = 0; i < num_threads; ++i) {
+    threads.emplace_back(Producer, rate, std::cref(go), std::cref(done), &results[i]);
+  }
+
+  const rsp::ProfilerStats before = rsp::Instance().GetStats();
+  const auto start                = Clock::now();
+  go.store(true, std::memory_order_release);
+
+  size_t max_backlog = 0;
+  while (Clock::now() - start < duration) {
+    max_backlog = std::max(max_backlog, rsp::Instance().GetStats().queue_depth);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  done.store(true, std::memory_order_relaxed);
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  const auto stop                = Clock::now();
+  const rsp::ProfilerStats after = rsp::Instance().GetStats();
+
+  LatencyHistogram latency;
+  uint64_t produced = 0;
+  for (const auto &r : results) {
+    latency.Merge(r.latency);
+    produced += r.scopes;
+  }
+
+  //
+  // Let the sink thread catch up before the next point, so that one point's
+  // backlog doesn't pollute the next.
+  //
+
+  const uint64_t target = before.records_sunk + produced;
+  while (rsp::Instance().GetStats().records_sunk < target && Clock::now() - stop < std::chrono::seconds(30)) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  const auto drained = Clock::now();
+
+  const double window_s = std::chrono::duration<double>(stop - start).count();
+  const double drain_ms = std::chrono::duration<double, std::milli>(drained - stop).count();
+
+  auto ns = [&](uint64_t ticks) { return static_cast<uint64_t>(static_cast<double>(ticks) * ns_per_tick); };
+
+  std::cout << std::setw(7) << num_threads << std::setw(10) << (rate ? std::to_string(rate) : "max") << std::setw(13)
+            << static_cast<uint64_t>(static_cast<double>(produced) / window_s) << std::setw(13)
+            << static_cast<uint64_t>(static_cast<double>(after.records_sunk - before.records_sunk) / window_s)
+            << std::setw(8) << ns(latency.Percentile(0.50)) << std::setw(8) << ns(latency.Percentile(0.99))
+            << std::setw(9) << ns(latency.Percentile(0.999)) << std::setw(10) << ns(latency.Max()) << std::setw(12)
+            << max_backlog << std::setw(11) << after.queue_depth << std::setw(10) << std::fixed << std::setprecision(1)
+            << drain_ms << std::setw(12) << (after.slot_count - before.slot_count) << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  rsp::Instance().SetSinkToSilent();
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  const auto duration = std::chrono::milliseconds(argc > 1 ? std::atoi(argv[1]) : 250);
+
+  unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  if (argc > 2) {
+    max_threads = std::max(1, std::atoi(argv[2]));
+  }
+
+  std::vector<unsigned> thread_counts;
+  for (unsigned n = 1; n < max_threads; n *= 2) {
+    thread_counts.push_back(n);
+  }
+  thread_counts.push_back(max_threads);
+
+  const double ns_per_tick = 1e9 / static_cast<double>(rsp::Instance().GetMachine()->GetNominalFreq());
+
+  std::cout << "Point duration: " << duration.count() << " ms, max threads: " << max_threads << "\n";
+  std::cout << "Latencies are per-scope producer cost in ns.\n\n";
+  std::cout << std::setw(7) << "threads" << std::setw(10) << "rate/thr" << std::setw(13) << "produced/s" << std::setw(13)
+            << "sunk/s" << std::setw(8) << "p50" << std::setw(8) << "p99" << std::setw(9) << "p99.9" << std::setw(10)
+            << "max" << std::setw(12) << "max backlog" << std::setw(11) << "backlog" << std::setw(10) << "drain ms"
+            << std::setw(12) << "slots grown"
+            << "\n";
+
+  for (unsigned n : thread_counts) {
+    for (uint64_t rate : kRates) {
+      RunPoint(n, rate, duration, ns_per_tick);
+    }
+  }
+
+  rsp::Stop();
+
+  return 0;
+}
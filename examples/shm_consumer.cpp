@@ -0,0 +1,50 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace rsp;
+
+//
+// Tails the ring written by shm_producer, printing every record as it is
+// published. Runs until interrupted.
+//
+
+int main() {
+  SharedMemoryReader reader("/dev/shm/rsp_example.shm");
+  if (!reader.OK()) {
+    std::cerr << "Could not open ring. Is shm_producer running?\n";
+    return 1;
+  }
+
+  std::vector<uint8_t> buffer;
+  uint64_t sequence = 0;
+
+  while (true) {
+    switch (reader.Next(&buffer, &sequence)) {
+      case SharedMemoryReader::Status::EMPTY:
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      case SharedMemoryReader::Status::LAPPED:
+        std::cerr << "Lapped by the producer, " << reader.Dropped() << " records dropped so far\n";
+        continue;
+      case SharedMemoryReader::Status::OK:
+        break;
+    }
+
+    flatbuffers::Verifier verifier(buffer.data(), buffer.size());
+    if (!RSP::VerifyScopeInfoBuffer(verifier)) {
+      std::cerr << "FlatBuffer verification failed for record #" << sequence << "\n";
+      continue;
+    }
+
+    std::cout << "---------------------------------\n";
+    std::cout << "#" << sequence << "\n";
+    std::cout << RSP::GetScopeInfo(buffer.data()) << "\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,45 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+//
+// Publishes scopes into a shared memory ring for shm_consumer (or
+// `rsp tail`) to read live.
+//
+// Usage: shm_producer [seconds]
+//
+
+int main(int argc, char **argv) {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  auto sink_ptr = rsp::Profiler::CreateSharedMemorySink("/dev/shm/rsp_example.shm");
+  rsp::Instance().SetSinkToSharedMemory(sink_ptr);
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  const auto duration = std::chrono::seconds(argc > 1 ? std::atoi(argv[1]) : 10);
+  const auto deadline = std::chrono::steady_clock::now() + duration;
+
+  std::cout << "Publishing to /dev/shm/rsp_example.shm for " << duration.count() << "s\n";
+
+  for (std::size_t i = 0; std::chrono::steady_clock::now() < deadline; ++i) {
+    RSP_SCOPE("Shared memory example");
+    RSP_SCOPE_METADATA("Loop counter", i);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+
+  rsp::Stop();
+
+  std::cout << "Done\n";
+
+  return 0;
+}
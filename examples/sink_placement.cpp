@@ -0,0 +1,101 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// Keeping the sink thread out of the way.
+//
+// The sink thread is confined to the last CPU, runs under SCHED_IDLE (so it
+// only gets a CPU nothing else wants) and is named, and on a multi-socket
+// host there's one per NUMA node. Four workers record scopes meanwhile. The
+// sink threads are then looked up by name, as in
+//
+//   top -H -p <pid>
+//   ps -L -o tid,comm,psr,cls,ni -p <pid>
+//
+// with where each is allowed to run.
+//
+
+namespace {
+
+constexpr const char *kOutput = "/tmp/rsp_placement.bin";
+
+void Work(int worker) {
+  const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (std::chrono::steady_clock::now() < until) {
+    RSP_SCOPE("Work");
+    RSP_SCOPE_METADATA("Worker", worker);
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+}
+
+void PrintSinkThreads() {
+  for (const auto &task : std::filesystem::directory_iterator("/proc/self/task")) {
+    std::string name;
+    std::getline(std::ifstream(task.path() / "comm"), name);
+    if (name.rfind("rsp-sink", 0) != 0) {
+      continue;
+    }
+
+    std::ifstream status(task.path() / "status");
+    for (std::string line; std::getline(status, line);) {
+      if (line.rfind("Cpus_allowed_list:", 0) == 0) {
+        std::cout << name << " (tid " << task.path().filename().string() << "): " << line << "\n";
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  const int cpus = static_cast<int>(std::thread::hardware_concurrency());
+
+  rsp::SinkThreadOptions options;
+  options.cpus          = {cpus > 0 ? cpus - 1 : 0};
+  options.idle          = true;
+  options.per_numa_node = true;
+  rsp::SetSinkThreadOptions(options);
+
+  std::filesystem::remove(kOutput);
+  rsp::Instance().SetSinkToBlockDisk(rsp::Profiler::CreateBlockDiskSink(kOutput));
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  std::cout << rsp::NumaNodes().size() << " NUMA node(s)\n";
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < 4; ++i) {
+    workers.emplace_back(Work, i);
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  PrintSinkThreads();
+  if (!rsp::Instance().SinkThreadPlaced()) {
+    std::cout << "Some of the sink thread options couldn't be applied\n";
+  }
+
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  rsp::Stop();
+
+  std::cout << "Wrote " << kOutput << "\n";
+
+  return 0;
+}
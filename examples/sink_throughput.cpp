@@ -0,0 +1,414 @@
+#include "afware/rsp/API.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// Sink throughput benchmark.
+//
+// Synthetic ScopeInfo streams (with 0 up to RSP_MAX_METADATA_ENTRIES metadata
+// entries) are pushed through each SinkType in three ways, so that a slowdown
+// can be attributed to the right stage:
+//
+// - serialize: SerializeScopeInfo() alone, no I/O.
+// - direct:    straight into the sink object on this thread (serialization + I/O).
+// - pipeline:  through Profiler::Add(), the queue and the sink thread.
+//
+// "fan_out" (SinkType::CUSTOM) is the block sink and a silent one set
+// together with SetSinks(), to show what a second sink costs.
+//
+// For each we report records/sec, bytes/sec, ns/record and heap allocations
+// per record. File backed sinks are run once per directory given on the
+// command line - pass a tmpfs directory and one on a real disk to compare.
+// The cout sink has std::cout redirected into a file in the same directory.
+//
+// Usage: sink_throughput [records] [dir...]   (default dirs: /dev/shm /tmp)
+//
+
+namespace {
+
+std::atomic<uint64_t> g_allocations = 0;
+
+}  // namespace
+
+//
+// Kept out of line so that GCC doesn't pair the inlined malloc()/free() with
+// the allocator's new/delete and warn about a mismatch.
+//
+
+[[gnu::noinline]] void *operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+  double seconds       = 0.0;
+  uint64_t bytes       = 0;
+  uint64_t allocations = 0;
+};
+
+void Report(const char *stage, const char *sink, const std::string &where, size_t metadata, size_t records,
+            const Result &r) {
+  const double n = static_cast<double>(records);
+  std::cout << std::setw(10) << stage << std::setw(13) << sink << std::setw(12) << where << std::setw(10) << metadata
+            << std::setw(14) << static_cast<uint64_t>(n / r.seconds) << std::setw(14)
+            << static_cast<uint64_t>(static_cast<double>(r.bytes) / r.seconds) << std::setw(10) << std::fixed
+            << std::setprecision(1) << (r.seconds * 1e9 / n) << std::setw(12) << std::setprecision(2)
+            << (static_cast<double>(r.allocations) / n) << "\n";
+}
+
+//
+// Builds a ScopeInfo with `metadata` entries attached. The slot comes from the
+// profiler's storage so it looks exactly like what ActiveScope produces.
+//
+
+rsp::ScopeInfo MakeRecord(size_t metadata, uint64_t i) {
+  rsp::ScopeInfo info{"Synthetic scope"};
+  info.metadata_ptr = rsp::Instance().GetSlotStorage()->Acquire();
+  info.ticks_start  = 1000000 + i * 100;
+  info.ticks_end    = info.ticks_start + 42 + (i % 17);
+
+  for (size_t m = 0; m < metadata; ++m) {
+    info.AddMetadata(rsp::MetadataTag{"Synthetic metadata"}, static_cast<uint64_t>(i + m));
+  }
+
+  return info;
+}
+
+template <typename F>
+Result Measure(F &&f) {
+  Result r;
+  const uint64_t allocs0 = g_allocations.load(std::memory_order_relaxed);
+  const auto t0          = Clock::now();
+  r.bytes                = f();
+  r.seconds              = std::chrono::duration<double>(Clock::now() - t0).count();
+  r.allocations          = g_allocations.load(std::memory_order_relaxed) - allocs0;
+  return r;
+}
+
+Result MeasureSerialization(const rsp::ScopeInfo &info, size_t records) {
+  return Measure([&]() {
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < records; ++i) {
+      bytes += rsp::SerializeScopeInfo(&info, rsp::Instance().GetMachine()).size() + sizeof(uint32_t);
+    }
+    return bytes;
+  });
+}
+
+Result MeasureDirect(rsp::SinkType type, const rsp::ScopeInfo &info, size_t records, const std::filesystem::path &file) {
+  if (!file.empty()) {
+    std::filesystem::remove(file);
+  }
+
+  return Measure([&]() -> uint64_t {
+    switch (type) {
+      case rsp::SinkType::SILENT: {
+        rsp::SilentSink sink;
+        for (size_t i = 0; i < records; ++i) {
+          sink.Sink(info);
+        }
+        return 0;
+      }
+      case rsp::SinkType::COUT: {
+        {
+          std::ofstream out(file);
+          auto *previous = std::cout.rdbuf(out.rdbuf());
+          rsp::CoutSink sink;
+          for (size_t i = 0; i < records; ++i) {
+            sink.Sink(info);
+          }
+          std::cout.flush();
+          std::cout.rdbuf(previous);
+        }
+        return std::filesystem::file_size(file);
+      }
+      case rsp::SinkType::BINARY_DISK: {
+        {
+          rsp::BinaryDiskSink sink(file, rsp::Instance().GetMachine());
+          for (size_t i = 0; i < records; ++i) {
+            sink.Sink(info);
+          }
+        }
+        return std::filesystem::file_size(file);
+      }
+      case rsp::SinkType::ASYNC_DISK: {
+        {
+          rsp::AsyncDiskSink sink(file, rsp::Instance().GetMachine());
+          for (size_t i = 0; i < records; ++i) {
+            sink.Sink(info);
+          }
+        }
+        return std::filesystem::file_size(file);
+      }
+      case rsp::SinkType::SHARED_MEMORY: {
+        rsp::SharedMemorySink sink(file, rsp::Instance().GetMachine());
+        for (size_t i = 0; i < records; ++i) {
+          sink.Sink(info);
+        }
+        return sink.BytesWritten();
+      }
+      case rsp::SinkType::BLOCK_DISK: {
+        {
+          rsp::BlockDiskSink sink(file, rsp::Instance().GetMachine());
+          for (size_t i = 0; i < records; ++i) {
+            sink.Sink(info);
+          }
+        }
+        return std::filesystem::file_size(file);
+      }
+      case rsp::SinkType::CUSTOM: {
+        {
+          rsp::BlockDiskSink block(file, rsp::Instance().GetMachine());
+          rsp::SilentSink silent;
+          for (size_t i = 0; i < records; ++i) {
+            rsp::SinkBatch(block, {&info, 1});
+            rsp::SinkBatch(silent, {&info, 1});
+          }
+        }
+        return std::filesystem::file_size(file);
+      }
+      case rsp::SinkType::FLIGHT_RECORDER: {
+        rsp::FlightRecorderOptions options;
+        options.dump_signal   = 0;
+        options.dump_on_crash = false;
+
+        rsp::FlightRecorder recorder(file, rsp::Instance().GetMachine(), options);
+        for (size_t i = 0; i < records; ++i) {
+          recorder.Sink(info);
+        }
+        recorder.Dump();
+        return std::filesystem::file_size(file);
+      }
+      case rsp::SinkType::UNIX_SOCKET:
+        // Needs an rsp collect to talk to, so it isn't measured here.
+        return 0;
+    }
+    return 0;
+  });
+}
+
+//
+// The records (and their slots) are created up front so that we only measure
+// the enqueue -> dequeue -> sink -> release path.
+//
+
+Result MeasurePipeline(rsp::SinkType type, size_t metadata, size_t records, const std::filesystem::path &file) {
+  if (!file.empty()) {
+    std::filesystem::remove(file);
+  }
+
+  std::vector<rsp::ScopeInfo> infos;
+  infos.reserve(records);
+  for (size_t i = 0; i < records; ++i) {
+    infos.push_back(MakeRecord(metadata, i));
+  }
+
+  std::ofstream cout_file;
+  std::streambuf *previous = nullptr;
+  std::shared_ptr<rsp::SharedMemorySink> shm;
+  std::shared_ptr<rsp::FlightRecorder> flight;
+
+  switch (type) {
+    case rsp::SinkType::SILENT:
+      rsp::Instance().SetSinkToSilent();
+      break;
+    case rsp::SinkType::COUT:
+      cout_file.open(file);
+      previous = std::cout.rdbuf(cout_file.rdbuf());
+      rsp::Instance().SetSinkToCout();
+      break;
+    case rsp::SinkType::BINARY_DISK:
+      rsp::Instance().SetSinkToBinaryDisk(rsp::Profiler::CreateBinaryDiskSink(file));
+      break;
+    case rsp::SinkType::ASYNC_DISK:
+      rsp::Instance().SetSinkToAsyncDisk(rsp::Profiler::CreateAsyncDiskSink(file));
+      break;
+    case rsp::SinkType::SHARED_MEMORY:
+      shm = rsp::Profiler::CreateSharedMemorySink(file);
+      rsp::Instance().SetSinkToSharedMemory(shm);
+      break;
+    case rsp::SinkType::BLOCK_DISK:
+      rsp::Instance().SetSinkToBlockDisk(rsp::Profiler::CreateBlockDiskSink(file));
+      break;
+    case rsp::SinkType::CUSTOM:
+      rsp::Instance().SetSinks(rsp::Profiler::CreateBlockDiskSink(file), std::make_shared<rsp::SilentSink>());
+      break;
+    case rsp::SinkType::FLIGHT_RECORDER: {
+      rsp::FlightRecorderOptions options;
+      options.dump_signal   = 0;
+      options.dump_on_crash = false;
+
+      flight = rsp::Profiler::CreateFlightRecorder(file, options);
+      rsp::Instance().SetSinkToFlightRecorder(flight);
+      break;
+    }
+    case rsp::SinkType::UNIX_SOCKET:
+      return {};
+  }
+
+  //
+  // The flight recorder never goes through the sink thread, so records_sunk
+  // doesn't move - Add() returning is all there is to wait for.
+  //
+
+  Result r = Measure([&]() {
+    if (flight) {
+      for (const auto &info : infos) {
+        rsp::Instance().Add(info);
+      }
+      return uint64_t{0};
+    }
+
+    const uint64_t target = rsp::Instance().GetStats().records_sunk + records;
+    for (const auto &info : infos) {
+      rsp::Instance().Add(info);
+    }
+    while (rsp::Instance().GetStats().records_sunk < target) {
+      std::this_thread::yield();
+    }
+    std::cout.flush();
+    return uint64_t{0};
+  });
+
+  //
+  // Swapping back to the silent sink drops the profiler's reference to the
+  // disk sink, which closes (and flushes) the file.
+  //
+
+  rsp::Instance().SetSinkToSilent();
+  if (previous) {
+    std::cout.rdbuf(previous);
+  }
+
+  if (shm) {
+    r.bytes = shm->BytesWritten();
+  } else if (flight) {
+    flight->Dump();
+    r.bytes = std::filesystem::file_size(file);
+  } else if (type != rsp::SinkType::SILENT) {
+    r.bytes = std::filesystem::file_size(file);
+  }
+
+  return r;
+}
+
+const char *SinkName(rsp::SinkType type) {
+  switch (type) {
+    case rsp::SinkType::SILENT:
+      return "silent";
+    case rsp::SinkType::COUT:
+      return "cout";
+    case rsp::SinkType::BINARY_DISK:
+      return "binary_disk";
+    case rsp::SinkType::ASYNC_DISK:
+      return "async_disk";
+    case rsp::SinkType::SHARED_MEMORY:
+      return "shm";
+    case rsp::SinkType::BLOCK_DISK:
+      return "block_disk";
+    case rsp::SinkType::FLIGHT_RECORDER:
+      return "flight";
+    case rsp::SinkType::CUSTOM:
+      return "fan_out";
+    case rsp::SinkType::UNIX_SOCKET:
+      return "unix_socket";
+  }
+  return "unknown";
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  const size_t records = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+  std::vector<std::filesystem::path> dirs;
+  for (int i = 2; i < argc; ++i) {
+    dirs.emplace_back(argv[i]);
+  }
+  if (dirs.empty()) {
+    dirs = {"/dev/shm", "/tmp"};
+  }
+
+  constexpr std::array<size_t, 4> kMetadataCounts = {0, 1, 4, RSP_MAX_METADATA_ENTRIES};
+  constexpr std::array<rsp::SinkType, 8> kSinks   = {rsp::SinkType::SILENT,
+                                                     rsp::SinkType::COUT,
+                                                     rsp::SinkType::BINARY_DISK,
+                                                     rsp::SinkType::ASYNC_DISK,
+                                                     rsp::SinkType::SHARED_MEMORY,
+                                                     rsp::SinkType::BLOCK_DISK,
+                                                     rsp::SinkType::CUSTOM,
+                                                     rsp::SinkType::FLIGHT_RECORDER};
+
+  std::cout << "Records per measurement: " << records << "\n\n";
+  std::cout << std::setw(10) << "stage" << std::setw(13) << "sink" << std::setw(12) << "dir" << std::setw(10)
+            << "metadata" << std::setw(14) << "records/s" << std::setw(14) << "bytes/s" << std::setw(10) << "ns/rec"
+            << std::setw(12) << "allocs/rec"
+            << "\n";
+
+  for (size_t metadata : kMetadataCounts) {
+    const rsp::ScopeInfo info = MakeRecord(metadata, 0);
+
+    Report("serialize", "-", "-", metadata, records, MeasureSerialization(info, records));
+
+    for (rsp::SinkType type : kSinks) {
+      if (type == rsp::SinkType::SILENT) {
+        const std::filesystem::path unused;
+        Report("direct", SinkName(type), "-", metadata, records, MeasureDirect(type, info, records, unused));
+        Report("pipeline", SinkName(type), "-", metadata, records, MeasurePipeline(type, metadata, records, unused));
+        continue;
+      }
+
+      for (const auto &dir : dirs) {
+        const auto file = dir / "rsp_sink_throughput.bin";
+        Report("direct", SinkName(type), dir.string(), metadata, records, MeasureDirect(type, info, records, file));
+        Report("pipeline", SinkName(type), dir.string(), metadata, records,
+               MeasurePipeline(type, metadata, records, file));
+        std::filesystem::remove(file);
+      }
+    }
+
+    rsp::Instance().GetSlotStorage()->Release(info.metadata_ptr);
+  }
+
+  rsp::Stop();
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+//
+// Several processes streaming to one local collector.
+//
+// Start the collector, writing rotating captures and printing a live
+// latency table every couple of seconds:
+//
+//   rsp collect --socket /tmp/rsp.sock -o /tmp/rsp_collect/rsp.col --rotate-interval 5s --histogram 2s
+//
+// then run this. It forks workers that each send their scopes over their own
+// connection, tagged with their pid. Start it first instead and it buffers
+// until the collector turns up. Afterwards:
+//
+//   rsp scopes /tmp/rsp_collect
+//
+
+namespace {
+
+constexpr const char *kSocket = "/tmp/rsp.sock";
+
+constexpr int kWorkers = 4;
+
+void Work(int worker) {
+  std::mt19937 rng{static_cast<unsigned>(worker)};
+  std::exponential_distribution<double> service{1.0 / (100 + worker * 100)};
+
+  const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  for (int request = 0; std::chrono::steady_clock::now() < end; ++request) {
+    RSP_SCOPE("Handle request");
+    RSP_SCOPE_METADATA("Request", request);
+    RSP_SCOPE_METADATA("Worker", worker);
+    std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int>(service(rng))));
+  }
+}
+
+}  // namespace
+
+int main() {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  rsp::EnableForkFollowing();
+  rsp::Instance().SetSinkToUnixSocket(rsp::Profiler::CreateUnixSocketSink(kSocket));
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  std::vector<pid_t> workers;
+  for (int worker = 0; worker < kWorkers; ++worker) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      Work(worker);
+      rsp::Stop();
+      std::exit(0);
+    }
+    workers.push_back(pid);
+  }
+
+  for (const pid_t pid : workers) {
+    waitpid(pid, nullptr, 0);
+  }
+
+  rsp::Stop();
+
+  std::cout << "Done. " << kWorkers << " workers streamed to " << kSocket << "\n";
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+#include "afware/rsp/API.hpp"
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+//
+// String metadata.
+//
+// A toy key value store routing requests to shards. Each lookup is tagged
+// with its operation (short enough to be stored inline), its shard (interned
+// once, up front, with rsp::Intern) and the caller's plan (interned on the
+// fly). One shard is slow; find it with:
+//
+//   rsp group /tmp/rsp_strings.bin "Lookup" Shard
+//
+// or look at a single plan with --where 'Plan=enterprise'.
+//
+// Pass "block" to write a block capture instead.
+//
+
+namespace {
+
+constexpr const char *kOutput = "/tmp/rsp_strings.bin";
+
+constexpr std::array<std::string_view, 4> kShards = {"shard-us-east-1", "shard-us-west-2", "shard-eu-west-1",
+                                                     "shard-ap-south-1"};
+
+void Lookup(rsp::InternedString shard, bool slow, const char *op, const std::string &plan) {
+  RSP_SCOPE("Lookup");
+  RSP_SCOPE_METADATA("Op", op);
+  RSP_SCOPE_METADATA("Shard", shard);
+  RSP_SCOPE_METADATA("Plan", plan);
+
+  std::this_thread::sleep_for(std::chrono::microseconds(slow ? 400 : 50));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  std::filesystem::remove(kOutput);
+
+  if (argc > 1 && std::string_view{argv[1]} == "block") {
+    rsp::Instance().SetSinkToBlockDisk(rsp::Profiler::CreateBlockDiskSink(kOutput));
+  } else {
+    rsp::Instance().SetSinkToBinaryDisk(rsp::Profiler::CreateBinaryDiskSink(kOutput));
+  }
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  std::array<rsp::InternedString, kShards.size()> shards;
+  for (size_t i = 0; i < kShards.size(); ++i) {
+    shards[i] = rsp::Intern(kShards[i]);
+  }
+
+  const std::array<std::string, 3> plans = {"free", "team", "enterprise"};
+
+  for (int i = 0; i < 2000; ++i) {
+    const size_t shard = i * 7 % kShards.size();
+    Lookup(shards[shard], shard == 3 && i / 4 % 2 == 0, i % 5 == 0 ? "PUT" : "GET", plans[i % plans.size()]);
+  }
+
+  rsp::Stop();
+
+  std::cout << "Done. Wrote " << kOutput << "\n";
+
+  return 0;
+}
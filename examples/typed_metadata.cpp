@@ -0,0 +1,98 @@
+#include "afware/rsp/API.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <thread>
+
+//
+// Typed metadata.
+//
+// Every request records the same five fields, so rather than five
+// RSP_SCOPE_METADATA calls (each storing its own 32 byte key) they are
+// declared once as a schema and set in one go. The block capture written
+// here stores the field names once per block and just the values per scope;
+// readers see ordinary metadata either way, so you can still filter on it:
+//
+//   rsp percentiles /tmp/rsp_typed_metadata.bin "Handle request" --where 'status=503'
+//
+// The batch scope adds more untyped metadata than fits in a slot, which
+// spills over instead of failing.
+//
+// Pass "binary" to write a FlatBuffer capture instead.
+//
+
+namespace {
+
+constexpr const char *kOutput = "/tmp/rsp_typed_metadata.bin";
+
+enum class Method : uint8_t { GET, PUT, DELETE };
+
+struct RequestMetadata {
+  uint32_t bytes;
+  int16_t status;
+  Method method;
+  bool cached;
+  double ratio;
+};
+
+RSP_METADATA_SCHEMA(RequestMetadata, bytes, status, method, cached, ratio);
+
+void Handle(int id) {
+  RSP_SCOPE("Handle request");
+
+  const bool cached    = id % 3 == 0;
+  const int16_t status = id % 17 == 0 ? 503 : 200;
+  const uint32_t bytes = 512 + static_cast<uint32_t>(id % 11) * 1024;
+  const auto method    = static_cast<Method>(id % 3);
+  std::this_thread::sleep_for(std::chrono::microseconds(cached ? 10 : status == 503 ? 200 : 40));
+
+  RSP_SCOPE_TYPED_METADATA(RequestMetadata{bytes, status, method, cached, bytes / 16384.0});
+}
+
+void Batch(int batch) {
+  RSP_SCOPE("Batch");
+
+  //
+  // Twelve entries: eight inline, four spilled.
+  //
+
+  for (int i = 0; i < 12; ++i) {
+    Handle(batch * 12 + i);
+    RSP_SCOPE_METADATA("Request", batch * 12 + i);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (!rsp::Available()) {
+    std::cout << "Profiling not available\n";
+    return 1;
+  }
+
+  std::filesystem::remove(kOutput);
+
+  if (argc > 1 && std::string_view{argv[1]} == "binary") {
+    rsp::Instance().SetSinkToBinaryDisk(rsp::Profiler::CreateBinaryDiskSink(kOutput));
+  } else {
+    rsp::Instance().SetSinkToBlockDisk(rsp::Profiler::CreateBlockDiskSink(kOutput));
+  }
+
+  if (!rsp::Start()) {
+    std::cout << "Could not start profiling\n";
+    return 1;
+  }
+
+  for (int batch = 0; batch < 50; ++batch) {
+    Batch(batch);
+  }
+
+  rsp::Stop();
+
+  std::cout << "Handled " << 50 * 12 << " requests. Wrote " << kOutput << "\n";
+
+  return 0;
+}
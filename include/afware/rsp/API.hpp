@@ -16,17 +16,49 @@
 
 #pragma once
 
+#include "CallSites.hpp"
 #include "Macros.hpp"
+#include "StringTable.hpp"
+#include "ThreadPlacement.hpp"
+
+#include <filesystem>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #ifdef RSP_ENABLE
 
+#include "Allocations.hpp"
+#include "AsyncDiskSink.hpp"
+#include "BlockDiskSink.hpp"
+#include "FlightRecorder.hpp"
+#include "PerfCounters.hpp"
 #include "Profiler.hpp"
+#include "ResourceUsage.hpp"
 #include "Serialization.hpp"
+#include "SharedMemorySink.hpp"
 #include "Sinks.hpp"
+#include "Span.hpp"
+#include "UnixSocketSink.hpp"
 
 #define RSP_SCOPE RSP_SCOPE_IMPL
+#define RSP_CATEGORY_SCOPE RSP_CATEGORY_SCOPE_IMPL
+#define RSP_LEVEL_SCOPE RSP_LEVEL_SCOPE_IMPL
+#define RSP_DYNAMIC_SCOPE RSP_DYNAMIC_SCOPE_IMPL
 #define RSP_SCOPE_METADATA RSP_SCOPE_METADATA_IMPL
+#define RSP_METADATA_SCHEMA RSP_METADATA_SCHEMA_IMPL
+#define RSP_SCOPE_TYPED_METADATA RSP_SCOPE_TYPED_METADATA_IMPL
 #define RSP_FUNCTION_SCOPE RSP_FUNCTION_SCOPE_IMPL
+#define RSP_COUNTER RSP_COUNTER_IMPL
+#define RSP_GAUGE RSP_GAUGE_IMPL
+#define RSP_INSTANT RSP_INSTANT_IMPL
+#define RSP_BEGIN_SPAN RSP_BEGIN_SPAN_IMPL
+#define RSP_BEGIN_CATEGORY_SPAN RSP_BEGIN_CATEGORY_SPAN_IMPL
+#define RSP_BEGIN_LEVEL_SPAN RSP_BEGIN_LEVEL_SPAN_IMPL
+#define RSP_FLOW RSP_FLOW_IMPL
+#define RSP_FLOW_ENQUEUE RSP_FLOW_ENQUEUE_IMPL
+#define RSP_FLOW_DEQUEUE RSP_FLOW_DEQUEUE_IMPL
+#define RSP_SCOPE_FLOW RSP_SCOPE_FLOW_IMPL
 
 namespace rsp {
 
@@ -42,13 +74,145 @@ inline void Stop() {
   Instance().Stop();
 }
 
+inline void Pause() {
+  Instance().Pause();
+}
+
+inline void Resume() {
+  Instance().Resume();
+}
+
+inline bool Capturing() {
+  return Instance().Capturing();
+}
+
+//
+// Hardware counters on scopes (see PerfCounters.hpp). Returns false, and
+// leaves them off, where perf events aren't available.
+//
+
+inline bool EnablePerfCounters() {
+  return Instance().EnablePerfCounters();
+}
+
+inline void DisablePerfCounters() {
+  Instance().DisablePerfCounters();
+}
+
+//
+// Heap allocation counts on scopes (see Allocations.hpp). Returns false,
+// and leaves tracking off, unless AllocationHooks.hpp is compiled in.
+//
+
+inline bool EnableAllocationTracking() {
+  return Instance().EnableAllocationTracking();
+}
+
+inline void DisableAllocationTracking() {
+  Instance().DisableAllocationTracking();
+}
+
+//
+// Context switch and page fault counts on scopes (see ResourceUsage.hpp),
+// sampled on one in every `every` scopes per thread. Returns false, and
+// leaves them off, where getrusage(RUSAGE_THREAD) isn't available.
+//
+
+inline bool EnableResourceUsage(uint32_t every = 1) {
+  return Instance().EnableResourceUsage(every);
+}
+
+inline void DisableResourceUsage() {
+  Instance().DisableResourceUsage();
+}
+
+//
+// Restricts resource usage sampling to the matching call sites, with the
+// same rule syntax as ConfigureCallSites().
+//
+
+inline void ConfigureResourceUsageSites(std::string_view rules) {
+  CallSiteRegistry::Instance().ConfigureResourceUsage(rules);
+}
+
+//
+// Forked children carry on profiling into per-process captures, rather
+// than stopping (see Profiler::EnableForkFollowing).
+//
+
+inline void EnableForkFollowing() {
+  Instance().EnableForkFollowing();
+}
+
+inline void DisableForkFollowing() {
+  Instance().DisableForkFollowing();
+}
+
+//
+// Where the sink thread runs (see ThreadPlacement.hpp), from the next
+// Start().
+//
+
+inline void SetSinkThreadOptions(SinkThreadOptions options) {
+  Instance().SetSinkThreadOptions(std::move(options));
+}
+
+//
+// Call site switches (see CallSites.hpp for the rule syntax).
+//
+
+inline void ConfigureCallSites(std::string_view rules) {
+  CallSiteRegistry::Instance().Configure(rules);
+}
+
+inline void EnableCallSites(std::string_view pattern) {
+  CallSiteRegistry::Instance().AddRule(pattern, true);
+}
+
+inline void DisableCallSites(std::string_view pattern) {
+  CallSiteRegistry::Instance().AddRule(pattern, false);
+}
+
+inline void WatchCallSiteFile(const std::filesystem::path &path) {
+  CallSiteRegistry::Instance().SetControlFile(path);
+}
+
+inline std::vector<CallSiteInfo> ListCallSites() {
+  return CallSiteRegistry::Instance().Sites();
+}
+
+//
+// Interns a string once, up front, for use as metadata (see
+// StringTable.hpp): passing the handle costs the same as an integer.
+// Once the table is full the handle records as an empty string.
+//
+
+inline InternedString Intern(std::string_view s) {
+  return InternedString{StringTable::Instance().Intern(s)};
+}
+
 }  // namespace rsp
 
 #else
 
 #define RSP_SCOPE(name) ((void)0)
+#define RSP_CATEGORY_SCOPE(category, name) ((void)0)
+#define RSP_LEVEL_SCOPE(level, category, name) ((void)0)
+#define RSP_DYNAMIC_SCOPE(name) ((void)0)
 #define RSP_SCOPE_METADATA(tag, val) ((void)0)
+#define RSP_METADATA_SCHEMA(type, ...) static_assert(true, "")
+#define RSP_SCOPE_TYPED_METADATA(...) ((void)0)
 #define RSP_FUNCTION_SCOPE ((void)0)
+#define RSP_COUNTER(name, delta) ((void)0)
+#define RSP_GAUGE(name, value) ((void)0)
+#define RSP_INSTANT(name) ((void)0)
+#define RSP_BEGIN_SPAN(name) ::rsp::Span{}
+#define RSP_BEGIN_CATEGORY_SPAN(category, name) ::rsp::Span{}
+#define RSP_BEGIN_LEVEL_SPAN(level, category, name) ::rsp::Span{}
+#define RSP_FLOW(flow) ((void)0)
+#define RSP_FLOW_ENQUEUE(queue, flow) ((void)0)
+#define RSP_FLOW_DEQUEUE(flow) ((void)0)
+#define RSP_SCOPE_FLOW(flow) ((void)0)
 
 namespace rsp {
 
@@ -64,6 +228,111 @@ inline void Stop() {
   return;
 }
 
+inline void Pause() {
+  return;
+}
+
+inline void Resume() {
+  return;
+}
+
+inline bool Capturing() {
+  return false;
+}
+
+inline bool EnablePerfCounters() {
+  return false;
+}
+
+inline void DisablePerfCounters() {
+}
+
+inline bool EnableAllocationTracking() {
+  return false;
+}
+
+inline void DisableAllocationTracking() {
+}
+
+inline bool EnableResourceUsage(uint32_t = 1) {
+  return false;
+}
+
+inline void DisableResourceUsage() {
+}
+
+inline void ConfigureResourceUsageSites(std::string_view) {
+}
+
+inline void EnableForkFollowing() {
+}
+
+inline void DisableForkFollowing() {
+}
+
+inline void SetSinkThreadOptions(SinkThreadOptions) {
+}
+
+inline void ConfigureCallSites(std::string_view) {
+}
+
+inline void EnableCallSites(std::string_view) {
+}
+
+inline void DisableCallSites(std::string_view) {
+}
+
+inline void WatchCallSiteFile(const std::filesystem::path &) {
+}
+
+inline std::vector<CallSiteInfo> ListCallSites() {
+  return {};
+}
+
+inline InternedString Intern(std::string_view) {
+  return {};
+}
+
+inline uint64_t NewFlowId() {
+  return 0;
+}
+
+inline uint64_t CurrentFlow() {
+  return 0;
+}
+
+//
+// Keeps code holding span tokens compiling when profiling is compiled out.
+//
+
+class Span {
+public:
+  template <typename T>
+  void AddMetadata(const char *, T) {
+  }
+
+  template <typename T>
+  void SetTypedMetadata(const T &) {
+  }
+
+  void End() {
+  }
+
+  void Discard() {
+  }
+
+  void SetFlow(uint64_t) {
+  }
+
+  bool Open() const {
+    return false;
+  }
+
+  explicit operator bool() const {
+    return false;
+  }
+};
+
 }  // namespace rsp
 
 #endif
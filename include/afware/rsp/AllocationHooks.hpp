@@ -0,0 +1,242 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+//
+// Allocation hooks for rsp::EnableAllocationTracking() (see
+// Allocations.hpp). Include this in exactly ONE translation unit of the
+// program, after defining RSP_ENABLE as usual: it defines the replaceable
+// global operator new and delete, which may only be defined once.
+//
+// Those only see C++ allocations. Define RSP_INTERPOSE_MALLOC before
+// including it to interpose malloc, calloc and realloc instead (glibc only;
+// the default operator new calls malloc, so C++ allocations are still
+// counted, once). Allocations through posix_memalign, aligned_alloc and
+// friends aren't counted then.
+//
+// Without RSP_ENABLE this is empty.
+//
+
+#if defined(RSP_ENABLE)
+
+#include "Allocations.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(RSP_INTERPOSE_MALLOC)
+
+#if !defined(__GLIBC__)
+#error "rsp: RSP_INTERPOSE_MALLOC needs glibc"
+#endif
+
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+  rsp::CountAllocation(size);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  rsp::CountAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+//
+// A realloc counts as an allocation of the new size.
+//
+
+void *realloc(void *ptr, size_t size) {
+  rsp::CountAllocation(size);
+  return __libc_realloc(ptr, size);
+}
+}
+
+#else
+
+//
+// GCC sees free() on a pointer from operator new once these are inlined
+// into callers, and warns even though that's exactly how they pair up.
+//
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace rsp::detail {
+
+//
+// Like the default operator new, a failed allocation calls the new handler
+// (see std::set_new_handler) and tries again, and only throws when there
+// isn't one.
+//
+
+inline void RunNewHandler() {
+  std::new_handler handler = std::get_new_handler();
+  if (!handler) {
+    throw std::bad_alloc{};
+  }
+  handler();
+}
+
+inline void *HookedNew(std::size_t size) {
+  rsp::CountAllocation(size);
+  for (;;) {
+    if (void *p = std::malloc(size ? size : 1)) {
+      return p;
+    }
+    RunNewHandler();
+  }
+}
+
+inline void *HookedNew(std::size_t size, std::align_val_t align) {
+  rsp::CountAllocation(size);
+
+  //
+  // aligned_alloc wants a size that's a multiple of the alignment.
+  //
+
+  const auto alignment      = static_cast<std::size_t>(align);
+  const std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+  for (;;) {
+    if (void *p = std::aligned_alloc(alignment, rounded ? rounded : alignment)) {
+      return p;
+    }
+    RunNewHandler();
+  }
+}
+
+}  // namespace rsp::detail
+
+void *operator new(std::size_t size) {
+  return rsp::detail::HookedNew(size);
+}
+
+void *operator new[](std::size_t size) {
+  return rsp::detail::HookedNew(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return rsp::detail::HookedNew(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return rsp::detail::HookedNew(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+  return rsp::detail::HookedNew(size, align);
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+  return rsp::detail::HookedNew(size, align);
+}
+
+void *operator new(std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+  try {
+    return rsp::detail::HookedNew(size, align);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void *operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+  try {
+    return rsp::detail::HookedNew(size, align);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+namespace rsp::detail {
+
+[[maybe_unused]] static const bool allocation_hooks_registered = [] {
+  allocation_hooks_installed.store(true, std::memory_order_relaxed);
+  return true;
+}();
+
+}  // namespace rsp::detail
+
+#endif
@@ -0,0 +1,96 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "Scope.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace rsp {
+
+//
+// Heap allocation tracking.
+//
+// The allocation hooks (AllocationHooks.hpp, compiled into exactly one
+// translation unit) bump a pair of thread-local counters on every
+// allocation - that's their whole cost. With tracking enabled
+// (rsp::EnableAllocationTracking()), each scope reads the counters on entry
+// and exit, so records carry how many allocations, and how many bytes, the
+// scope made: inclusive of nested scopes, and exclusive of them (each scope
+// hands its inclusive total up to its parent when it ends).
+//
+// Frees aren't counted. Counts are per thread, so spans and event records
+// don't carry them.
+//
+
+namespace detail {
+
+inline constinit thread_local AllocationCounts thread_allocations{};
+
+inline std::atomic<bool> allocation_hooks_installed = false;
+
+}  // namespace detail
+
+inline void CountAllocation(size_t bytes) {
+  auto &counts = detail::thread_allocations;
+  ++counts.count;
+  counts.bytes += bytes;
+}
+
+inline AllocationCounts ThreadAllocations() {
+  return detail::thread_allocations;
+}
+
+inline bool AllocationHooksInstalled() {
+  return detail::allocation_hooks_installed.load(std::memory_order_relaxed);
+}
+
+//
+// Allocations made while one of these is alive aren't counted: the profiler
+// wraps its own bookkeeping (slot storage, the queue) in one, so a scope's
+// counts are only what the code inside it allocated.
+//
+
+class UncountedAllocations {
+public:
+  UncountedAllocations() : saved_{detail::thread_allocations} {
+  }
+
+  ~UncountedAllocations() {
+    detail::thread_allocations = saved_;
+  }
+
+  UncountedAllocations(const UncountedAllocations &)            = delete;
+  UncountedAllocations &operator=(const UncountedAllocations &) = delete;
+
+private:
+  AllocationCounts saved_;
+};
+
+inline AllocationCounts operator-(const AllocationCounts &a, const AllocationCounts &b) {
+  return AllocationCounts{a.count - b.count, a.bytes - b.bytes};
+}
+
+inline AllocationCounts &operator+=(AllocationCounts &a, const AllocationCounts &b) {
+  a.count += b.count;
+  a.bytes += b.bytes;
+  return a;
+}
+
+}  // namespace rsp
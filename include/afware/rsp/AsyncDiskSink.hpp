@@ -0,0 +1,1007 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "CaptureFormat.hpp"
+#include "Machine.hpp"
+#include "Queue.hpp"
+#include "Scope.hpp"
+#include "Segments.hpp"
+#include "Serialization.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+
+//
+// Headers from before IORING_REGISTER_PROBE (5.6) are too old to be of use.
+//
+
+#if defined(IO_URING_OP_SUPPORTED)
+#define RSP_HAVE_IO_URING 1
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+namespace rsp {
+
+//
+// An asynchronous, block-buffered alternative to BinaryDiskSink.
+//
+// The on-disk format is identical (framed by default, see CaptureFormat.hpp),
+// but records are serialized into one of a handful of large, aligned blocks.
+// Once a block fills up it is handed off to be written while serialization
+// carries on into the next one - the sink thread never waits on the disk
+// unless every block is in flight.
+//
+// Writes are submitted via io_uring where available. If io_uring can't be
+// set up (old kernel, seccomp, containers...) we fall back to a dedicated
+// writer thread using pwrite(), and we move over to one if the ring later
+// rejects our requests or stops working. Where the filesystem supports it, the file
+// is opened with O_DIRECT to keep the page cache (and its writeback stalls)
+// out of the picture entirely.
+//
+// Note that data is written a whole block at a time, so the tail of the
+// capture only reaches the file on Flush() (which Profiler::Stop() calls),
+// or when the sink is closed/destroyed.
+//
+
+#if !defined(RSP_ASYNC_DISK_SINK_BLOCK_SIZE)
+#define RSP_ASYNC_DISK_SINK_BLOCK_SIZE (1024 * 1024)
+#endif
+
+#if !defined(RSP_ASYNC_DISK_SINK_BLOCKS)
+#define RSP_ASYNC_DISK_SINK_BLOCKS 4
+#endif
+
+//
+// O_DIRECT needs buffer addresses, file offsets and lengths aligned to the
+// device's logical block size. 4096 covers anything we're likely to see.
+//
+
+#if !defined(RSP_ASYNC_DISK_SINK_ALIGNMENT)
+#define RSP_ASYNC_DISK_SINK_ALIGNMENT 4096
+#endif
+
+enum class DurabilityPolicy : uint8_t {
+  NONE               = 0,  // Whatever the OS/device gives us.
+  PERIODIC_FDATASYNC = 1,  // fdatasync() at most once per sync_interval, after the block writes before it.
+  PER_BLOCK          = 2,  // Each block is durable before its buffer is reused.
+};
+
+//
+// PERIODIC_FDATASYNC only checks the interval when a block is submitted, so
+// a sink that goes idle isn't synced again until its next block (or Close()).
+// Data in a partially filled block isn't on disk at all until then either.
+//
+
+struct AsyncDiskSinkOptions {
+  size_t block_size                       = RSP_ASYNC_DISK_SINK_BLOCK_SIZE;
+  size_t num_blocks                       = RSP_ASYNC_DISK_SINK_BLOCKS;
+  bool direct_io                          = true;
+  bool use_io_uring                       = true;
+  bool framed                             = true;
+  size_t frame_size                       = RSP_CAPTURE_FRAME_SIZE;
+  DurabilityPolicy durability             = DurabilityPolicy::NONE;
+  std::chrono::milliseconds sync_interval = std::chrono::milliseconds(1000);
+};
+
+namespace detail {
+
+inline int DataSync(int fd) {
+#if defined(__APPLE__)
+  return fsync(fd);
+#else
+  return fdatasync(fd);
+#endif
+}
+
+#if defined(RSP_HAVE_IO_URING)
+
+//
+// Just enough of io_uring (via the raw syscalls - we don't want a liburing
+// dependency) to submit writes/fsyncs and reap their completions from a
+// single thread.
+//
+
+class IoUring {
+public:
+  IoUring() = default;
+
+  IoUring(const IoUring &)            = delete;
+  IoUring &operator=(const IoUring &) = delete;
+
+  ~IoUring() {
+    if (sqes_) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_) {
+      munmap(sq_ptr_, sq_size_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  bool Init(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd_ < 0) {
+      return false;
+    }
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+
+    sq_ptr_ = Map(sq_size_, IORING_OFF_SQ_RING);
+    if (!sq_ptr_) {
+      return false;
+    }
+
+    cq_ptr_ = single_mmap ? sq_ptr_ : Map(cq_size_, IORING_OFF_CQ_RING);
+    if (!cq_ptr_) {
+      return false;
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_      = static_cast<io_uring_sqe *>(Map(sqes_size_, IORING_OFF_SQES));
+    if (!sqes_) {
+      return false;
+    }
+
+    auto *sq    = static_cast<uint8_t *>(sq_ptr_);
+    sq_head_    = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail_    = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_    = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_   = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    sqe_tail_   = *sq_tail_;
+
+    auto *cq = static_cast<uint8_t *>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_    = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    return Supports({IORING_OP_WRITE, IORING_OP_FSYNC});
+  }
+
+  //
+  // Whether the kernel knows every one of ops. A ring can be set up on
+  // kernels (or behind filters) that reject some opcodes, and we'd only
+  // find out from the first completion.
+  //
+
+  bool Supports(std::initializer_list<uint8_t> ops) {
+    constexpr unsigned kMaxOps = 256;
+
+    std::vector<uint8_t> buf(sizeof(io_uring_probe) + kMaxOps * sizeof(io_uring_probe_op));
+    auto *probe = reinterpret_cast<io_uring_probe *>(buf.data());
+    if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, kMaxOps) < 0) {
+      return false;
+    }
+
+    return std::all_of(ops.begin(), ops.end(), [probe](uint8_t op) {
+      return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    });
+  }
+
+  //
+  // Returns a zeroed SQE to fill in, or nullptr if the submission queue is full.
+  // Nothing is visible to the kernel until Submit().
+  //
+
+  io_uring_sqe *NextSqe() {
+    const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sqe_tail_ - head >= sq_entries_) {
+      return nullptr;
+    }
+
+    const unsigned idx = sqe_tail_ & sq_mask_;
+    io_uring_sqe *sqe  = &sqes_[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[idx] = idx;
+    ++sqe_tail_;
+    return sqe;
+  }
+
+  bool Submit() {
+    const unsigned to_submit = sqe_tail_ - *sq_tail_;
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+
+    while (true) {
+      if (Enter(to_submit, 0, 0) >= 0) {
+        return true;
+      }
+      if (errno != EINTR) {
+        return false;
+      }
+    }
+  }
+
+  //
+  // Pops one completion. If `wait` is set, blocks until one is available.
+  //
+
+  bool Reap(io_uring_cqe *out, bool wait) {
+    while (true) {
+      const unsigned head = *cq_head_;
+      const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      if (head != tail) {
+        *out = cqes_[head & cq_mask_];
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        return true;
+      }
+
+      if (!wait) {
+        return false;
+      }
+
+      if (Enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+        return false;
+      }
+    }
+  }
+
+private:
+  void *Map(size_t size, off_t offset) {
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+    return p == MAP_FAILED ? nullptr : p;
+  }
+
+  int Enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd_, to_submit, min_complete, flags, nullptr, 0));
+  }
+
+  int fd_ = -1;
+
+  void *sq_ptr_     = nullptr;
+  void *cq_ptr_     = nullptr;
+  size_t sq_size_   = 0;
+  size_t cq_size_   = 0;
+  size_t sqes_size_ = 0;
+
+  io_uring_sqe *sqes_  = nullptr;
+  unsigned *sq_head_   = nullptr;
+  unsigned *sq_tail_   = nullptr;
+  unsigned *sq_array_  = nullptr;
+  unsigned sq_mask_    = 0;
+  unsigned sq_entries_ = 0;
+  unsigned sqe_tail_   = 0;
+
+  io_uring_cqe *cqes_ = nullptr;
+  unsigned *cq_head_  = nullptr;
+  unsigned *cq_tail_  = nullptr;
+  unsigned cq_mask_   = 0;
+};
+
+#endif
+
+}  // namespace detail
+
+class AsyncDiskSink {
+public:
+  enum class Backend : uint8_t {
+    NONE          = 0,
+    IO_URING      = 1,
+    WRITER_THREAD = 2,
+  };
+
+  AsyncDiskSink(std::filesystem::path path, Machine *machine, AsyncDiskSinkOptions options = {})
+      : path_(path), machine_(machine), options_(options), framer_(options.frame_size) {
+    options_.num_blocks = std::max<size_t>(2, options_.num_blocks);
+    framed_             = options_.framed && ShouldWriteFramed(path);
+    options_.block_size = AlignUp(std::max<size_t>(RSP_ASYNC_DISK_SINK_ALIGNMENT, options_.block_size));
+
+    if (!Open(path)) {
+      return;
+    }
+
+    blocks_.resize(options_.num_blocks);
+    for (auto &block : blocks_) {
+      block.data = static_cast<uint8_t *>(std::aligned_alloc(RSP_ASYNC_DISK_SINK_ALIGNMENT, options_.block_size));
+      if (!block.data) {
+        failed_ = true;
+        return;
+      }
+    }
+
+#if defined(RSP_HAVE_IO_URING)
+    if (options_.use_io_uring && ring_.Init(RingEntries())) {
+      backend_ = Backend::IO_URING;
+      for (auto &block : blocks_) {
+        free_blocks_.push_back(&block);
+      }
+    }
+#endif
+
+    if (backend_ == Backend::NONE) {
+      backend_ = Backend::WRITER_THREAD;
+      for (auto &block : blocks_) {
+        writer_free_.enqueue(&block);
+      }
+      writer_ = std::thread([this]() { WriterLoop(); });
+    }
+
+    last_sync_ = std::chrono::steady_clock::now();
+    ResumeTail();
+
+    if (framed_ && initial_size_ == 0) {
+      const auto header = MakeCaptureHeader(machine_);
+      Append(header.data(), header.size());
+    }
+  }
+
+  AsyncDiskSink(const AsyncDiskSink &)            = delete;
+  AsyncDiskSink &operator=(const AsyncDiskSink &) = delete;
+
+  ~AsyncDiskSink() {
+    Close();
+    for (auto &block : blocks_) {
+      std::free(block.data);
+    }
+  }
+
+  void Sink(const ScopeInfo &info) {
+    if (fd_ < 0) {
+      return;
+    }
+
+    auto buf     = SerializeScopeInfo(&info, machine_, framed_ ? framer_.Strings() : &strings_);
+    uint32_t len = buf.size();
+
+    if (framed_) {
+      framer_.Add(buf.data(), len);
+      if (framer_.Full()) {
+        AppendFrame();
+      }
+      return;
+    }
+
+    Append(&len, sizeof(len));
+    Append(buf.data(), len);
+  }
+
+  //
+  // See SinkEncoded in Sinks.hpp. Frames from other threads are appended
+  // between our own.
+  //
+
+  using Encoder = FrameEncoder;
+
+  std::optional<Encoder> MakeEncoder() const {
+    if (!framed_) {
+      return std::nullopt;
+    }
+    return Encoder(machine_, options_.frame_size);
+  }
+
+  void SinkEncoded(std::span<const uint8_t> frame, uint32_t) {
+    if (fd_ >= 0) {
+      Append(frame.data(), frame.size());
+    }
+  }
+
+  bool OK() const {
+    return fd_ >= 0 && !failed_;
+  }
+
+  Backend GetBackend() const {
+    return backend_;
+  }
+
+  bool DirectIO() const {
+    return direct_;
+  }
+
+  bool Framed() const {
+    return framed_;
+  }
+
+  //
+  // Bytes accepted by this sink (which may still be sitting in a block).
+  //
+
+  uint64_t BytesWritten() const {
+    return logical_size_ - initial_size_;
+  }
+
+  //
+  // A sink like this one for a forked child, writing to PerProcessPath()
+  // (see Profiler::EnableForkFollowing). The child can't use this one at
+  // all: its writer thread stayed in the parent, and its io_uring is shared.
+  //
+
+  std::shared_ptr<AsyncDiskSink> ReopenForProcess(pid_t pid) const {
+    return std::make_shared<AsyncDiskSink>(PerProcessPath(path_, pid), machine_, options_);
+  }
+
+  //
+  // Writes out everything accepted so far, the partially filled block
+  // included, and waits for it to reach the file. That block carries on
+  // being filled, and is written again in full later; until then, with
+  // O_DIRECT, the file has zero padding after the last record.
+  //
+
+  void Flush() {
+    if (fd_ < 0) {
+      return;
+    }
+
+    AppendFrame();
+
+    if (current_ && current_->len > 0) {
+      current_->write_len = current_->len;
+      if (direct_) {
+        current_->write_len = AlignUp(current_->len);
+        std::memset(current_->data + current_->len, 0, current_->write_len - current_->len);
+      }
+      WriteRemaining(current_, 0);
+    }
+
+    WaitForWrites();
+
+    if (options_.durability != DurabilityPolicy::NONE) {
+      detail::DataSync(fd_);
+    }
+  }
+
+  //
+  // Writes out the partially filled block, waits for all outstanding I/O
+  // and closes the file. Called on destruction; the sink must not be used
+  // afterwards.
+  //
+
+  void Close() {
+    if (fd_ < 0) {
+      return;
+    }
+
+    AppendFrame();
+
+    if (current_ && current_->len > 0) {
+      Submit(current_);
+    }
+    current_ = nullptr;
+
+    WaitForAll();
+
+    //
+    // O_DIRECT forced us to pad the final block out to the alignment.
+    //
+
+    if (direct_ && ftruncate(fd_, static_cast<off_t>(logical_size_)) != 0) {
+      failed_ = true;
+    }
+
+    if (options_.durability != DurabilityPolicy::NONE) {
+      detail::DataSync(fd_);
+    }
+
+    close(fd_);
+    fd_ = -1;
+  }
+
+private:
+  struct Block {
+    uint8_t *data    = nullptr;
+    uint64_t offset  = 0;
+    size_t len       = 0;
+    size_t write_len = 0;
+    bool in_flight   = false;  // Submitted to the ring, not yet reaped.
+  };
+
+  static size_t AlignUp(size_t v) {
+    return (v + RSP_ASYNC_DISK_SINK_ALIGNMENT - 1) / RSP_ASYNC_DISK_SINK_ALIGNMENT * RSP_ASYNC_DISK_SINK_ALIGNMENT;
+  }
+
+  static uint64_t AlignDown(uint64_t v) {
+    return v / RSP_ASYNC_DISK_SINK_ALIGNMENT * RSP_ASYNC_DISK_SINK_ALIGNMENT;
+  }
+
+  bool Open(const std::filesystem::path &path) {
+    const int flags = O_RDWR | O_CREAT;
+
+#if defined(O_DIRECT)
+    if (options_.direct_io) {
+      fd_ = open(path.c_str(), flags | O_DIRECT, 0644);
+      direct_ = fd_ >= 0;
+    }
+#endif
+
+    //
+    // Not every filesystem supports O_DIRECT (tmpfs for one), so fall
+    // back to buffered I/O rather than failing.
+    //
+
+    if (fd_ < 0) {
+      fd_ = open(path.c_str(), flags, 0644);
+    }
+
+    if (fd_ < 0) {
+      return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+
+    initial_size_ = static_cast<uint64_t>(st.st_size);
+    logical_size_ = initial_size_;
+    next_offset_  = direct_ ? AlignDown(initial_size_) : initial_size_;
+    return true;
+  }
+
+  //
+  // Like BinaryDiskSink, we append to an existing capture. With O_DIRECT we
+  // can only write whole aligned blocks, so the existing partial tail is
+  // read back into the first block and rewritten along with the new data.
+  //
+
+  void ResumeTail() {
+    const size_t tail = initial_size_ - next_offset_;
+    if (tail == 0 || failed_) {
+      return;
+    }
+
+    current_ = AcquireBlock();
+
+    const ssize_t got = pread(fd_, current_->data, RSP_ASYNC_DISK_SINK_ALIGNMENT, static_cast<off_t>(current_->offset));
+    if (got < static_cast<ssize_t>(tail)) {
+      failed_ = true;
+      return;
+    }
+
+    current_->len = tail;
+  }
+
+  void Append(const void *data, size_t len) {
+    const auto *src = static_cast<const uint8_t *>(data);
+    logical_size_ += len;
+
+    while (len > 0) {
+      if (!current_) {
+        current_ = AcquireBlock();
+      }
+
+      const size_t n = std::min(len, options_.block_size - current_->len);
+      std::memcpy(current_->data + current_->len, src, n);
+      current_->len += n;
+      src += n;
+      len -= n;
+
+      if (current_->len == options_.block_size) {
+        Submit(current_);
+        current_ = nullptr;
+      }
+    }
+  }
+
+  void AppendFrame() {
+    if (framer_.Empty()) {
+      return;
+    }
+
+    const auto &frame = framer_.Seal();
+    Append(frame.data(), frame.size());
+    framer_.Clear();
+  }
+
+  Block *AcquireBlock() {
+    Block *block = nullptr;
+
+#if defined(RSP_HAVE_IO_URING)
+    if (backend_ == Backend::IO_URING && demote_) {
+      FallBackToWriterThread(true);
+    }
+
+    if (backend_ == Backend::IO_URING) {
+      while (free_blocks_.empty()) {
+        if (!ReapOne(true)) {
+          FallBackToWriterThread(false);
+          break;
+        }
+      }
+    }
+
+    if (backend_ == Backend::IO_URING) {
+      block = free_blocks_.back();
+      free_blocks_.pop_back();
+    }
+#endif
+
+    if (backend_ == Backend::WRITER_THREAD) {
+      writer_free_.wait_dequeue(block);
+    }
+
+    block->offset = next_offset_;
+    block->len    = 0;
+    next_offset_ += options_.block_size;
+    return block;
+  }
+
+  void Submit(Block *block) {
+    block->write_len = block->len;
+    if (direct_) {
+      block->write_len = AlignUp(block->len);
+      std::memset(block->data + block->len, 0, block->write_len - block->len);
+    }
+
+#if defined(RSP_HAVE_IO_URING)
+    if (backend_ == Backend::IO_URING && demote_) {
+      FallBackToWriterThread(true);
+    }
+
+    if (backend_ == Backend::IO_URING) {
+      SubmitToRing(block);
+      return;
+    }
+#endif
+
+    writer_pending_.enqueue(block);
+  }
+
+  //
+  // Writes whatever part of the block hasn't been written yet, synchronously.
+  //
+
+  bool WriteRemaining(Block *block, size_t written) {
+    while (written < block->write_len) {
+      const ssize_t n = pwrite(fd_,
+                               block->data + written,
+                               block->write_len - written,
+                               static_cast<off_t>(block->offset + written));
+      if (n < 0) {
+        if (errno == EINTR || errno == EAGAIN) {
+          continue;
+        }
+        failed_ = true;
+        return false;
+      }
+      written += static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  bool SyncDue() {
+    if (options_.durability != DurabilityPolicy::PERIODIC_FDATASYNC) {
+      return false;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_sync_ < options_.sync_interval) {
+      return false;
+    }
+
+    last_sync_ = now;
+    return true;
+  }
+
+  void WriterLoop() {
+    while (true) {
+      Block *block = nullptr;
+      writer_pending_.wait_dequeue(block);
+      if (!block) {
+        break;
+      }
+
+      WriteRemaining(block, 0);
+
+      if (options_.durability == DurabilityPolicy::PER_BLOCK || SyncDue()) {
+        detail::DataSync(fd_);
+      }
+
+      writer_free_.enqueue(block);
+    }
+  }
+
+  //
+  // Waits for the blocks submitted so far to be written, leaving the
+  // writer thread (if that's what we're using) running. It has written a
+  // block once it hands the buffer back, so we take every buffer it has
+  // and then return them.
+  //
+
+  void WaitForWrites() {
+#if defined(RSP_HAVE_IO_URING)
+    if (backend_ == Backend::IO_URING) {
+      while (in_flight_ > 0) {
+        if (!ReapOne(true)) {
+          FallBackToWriterThread(false);
+          break;
+        }
+      }
+    }
+
+    if (backend_ == Backend::IO_URING) {
+      return;
+    }
+#endif
+
+    std::vector<Block *> idle;
+    const size_t held = current_ ? 1 : 0;
+    while (idle.size() + held < blocks_.size()) {
+      Block *block = nullptr;
+      writer_free_.wait_dequeue(block);
+      idle.push_back(block);
+    }
+
+    for (auto *block : idle) {
+      writer_free_.enqueue(block);
+    }
+  }
+
+  void WaitForAll() {
+#if defined(RSP_HAVE_IO_URING)
+    if (backend_ == Backend::IO_URING) {
+      while (in_flight_ > 0) {
+        if (!ReapOne(true)) {
+          FallBackToWriterThread(false);
+          break;
+        }
+      }
+    }
+
+    if (backend_ == Backend::IO_URING) {
+      return;
+    }
+#endif
+
+    if (writer_.joinable()) {
+      writer_pending_.enqueue(nullptr);
+      writer_.join();
+    }
+  }
+
+#if defined(RSP_HAVE_IO_URING)
+  unsigned RingEntries() const {
+    //
+    // Room for every block to be in flight, plus the odd fsync.
+    //
+    unsigned entries = 1;
+    while (entries < 2 * options_.num_blocks + 2) {
+      entries <<= 1;
+    }
+    return entries;
+  }
+
+  io_uring_sqe *NextSqe() {
+    io_uring_sqe *sqe = ring_.NextSqe();
+    while (!sqe) {
+      if (!ReapOne(true)) {
+        return nullptr;
+      }
+      sqe = ring_.NextSqe();
+    }
+    return sqe;
+  }
+
+  void SubmitToRing(Block *block) {
+    io_uring_sqe *sqe = NextSqe();
+    if (!sqe) {
+      FallBackToWriterThread(false);
+      writer_pending_.enqueue(block);
+      return;
+    }
+
+    sqe->opcode    = IORING_OP_WRITE;
+    sqe->fd        = fd_;
+    sqe->addr      = reinterpret_cast<uint64_t>(block->data);
+    sqe->len       = static_cast<uint32_t>(block->write_len);
+    sqe->off       = block->offset;
+    sqe->user_data = reinterpret_cast<uint64_t>(block);
+    if (options_.durability == DurabilityPolicy::PER_BLOCK) {
+      sqe->rw_flags = RWF_DSYNC;
+    }
+    block->in_flight = true;
+    ++in_flight_;
+
+    //
+    // io_uring doesn't order requests, so the fsync drains: it only starts
+    // once every write submitted before it has completed.
+    //
+
+    if (SyncDue()) {
+      if (io_uring_sqe *sync = NextSqe()) {
+        sync->opcode      = IORING_OP_FSYNC;
+        sync->flags       = IOSQE_IO_DRAIN;
+        sync->fd          = fd_;
+        sync->fsync_flags = IORING_FSYNC_DATASYNC;
+        sync->user_data   = 0;
+        ++in_flight_;
+      }
+    }
+
+    if (!ring_.Submit()) {
+      FallBackToWriterThread(false);
+    }
+  }
+
+  bool ReapOne(bool wait) {
+    io_uring_cqe cqe;
+    if (!ring_.Reap(&cqe, wait)) {
+      return false;
+    }
+
+    --in_flight_;
+
+    //
+    // The ring works, but not for these requests (a filter, or a file that
+    // doesn't take them): we'll switch to the writer thread as soon as it's
+    // safe to.
+    //
+
+    if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+      demote_ = true;
+    }
+
+    auto *block = reinterpret_cast<Block *>(cqe.user_data);
+    if (!block) {
+      if (cqe.res < 0 && detail::DataSync(fd_) != 0) {
+        failed_ = true;
+      }
+      return true;
+    }
+
+    block->in_flight = false;
+
+    //
+    // Failed and short writes (EAGAIN, ENOSPC and friends) are rare enough
+    // that we just finish the job synchronously.
+    //
+
+    if (cqe.res < 0 || static_cast<size_t>(cqe.res) < block->write_len) {
+      const bool written = WriteRemaining(block, cqe.res < 0 ? 0 : static_cast<size_t>(cqe.res));
+      if (written && options_.durability == DurabilityPolicy::PER_BLOCK) {
+        detail::DataSync(fd_);
+      }
+    }
+
+    free_blocks_.push_back(block);
+    return true;
+  }
+
+  //
+  // Moves the sink over to the writer thread. If the ring still works we
+  // first wait for what's in flight. If it doesn't, the kernel may still be
+  // reading those blocks: we write them out ourselves (the same bytes to
+  // the same place, so it doesn't matter who gets there first) and give
+  // them fresh buffers, leaking the old ones rather than ever refilling
+  // one under the kernel's feet.
+  //
+  // Blocks held by the caller (current_, or one being submitted) are left
+  // to it.
+  //
+
+  void FallBackToWriterThread(bool ring_ok) {
+    while (ring_ok && in_flight_ > 0) {
+      ring_ok = ReapOne(true);
+    }
+
+    for (auto &block : blocks_) {
+      if (!block.in_flight) {
+        continue;
+      }
+
+      WriteRemaining(&block, 0);
+      block.in_flight = false;
+
+      auto *fresh = static_cast<uint8_t *>(std::aligned_alloc(RSP_ASYNC_DISK_SINK_ALIGNMENT, options_.block_size));
+      if (fresh) {
+        block.data = fresh;
+      } else {
+        failed_ = true;
+      }
+      free_blocks_.push_back(&block);
+    }
+
+    if (options_.durability != DurabilityPolicy::NONE) {
+      detail::DataSync(fd_);
+    }
+
+    in_flight_ = 0;
+    demote_    = false;
+    backend_   = Backend::WRITER_THREAD;
+
+    for (auto *block : free_blocks_) {
+      writer_free_.enqueue(block);
+    }
+    free_blocks_.clear();
+
+    writer_ = std::thread([this]() { WriterLoop(); });
+  }
+#endif
+
+  std::filesystem::path path_;
+  Machine *machine_;
+  AsyncDiskSinkOptions options_;
+
+  int fd_      = -1;
+  bool direct_ = false;
+
+  bool framed_ = true;
+  CaptureFramer framer_;
+  StringIdSet strings_;
+
+  //
+  // Set from the writer thread too, hence atomic.
+  //
+
+  std::atomic<bool> failed_ = false;
+
+  Backend backend_ = Backend::NONE;
+
+  std::vector<Block> blocks_;
+  Block *current_ = nullptr;
+
+  uint64_t initial_size_ = 0;
+  uint64_t logical_size_ = 0;
+  uint64_t next_offset_  = 0;
+
+  std::chrono::steady_clock::time_point last_sync_;
+
+#if defined(RSP_HAVE_IO_URING)
+  detail::IoUring ring_;
+  std::vector<Block *> free_blocks_;
+  size_t in_flight_ = 0;
+  bool demote_      = false;
+#endif
+
+  //
+  // Writer thread fallback - blocks go round in a loop between the two queues.
+  // A nullptr on the pending queue tells the writer to exit.
+  //
+
+  moodycamel::BlockingConcurrentQueue<Block *> writer_pending_;
+  moodycamel::BlockingConcurrentQueue<Block *> writer_free_;
+  std::thread writer_;
+};
+
+}  // namespace rsp
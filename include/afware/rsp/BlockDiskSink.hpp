@@ -0,0 +1,700 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "Machine.hpp"
+#include "Metadata.hpp"
+#include "Scope.hpp"
+#include "Segments.hpp"
+#include "Slots.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+namespace rsp {
+
+//
+// A compact, block oriented alternative to BinaryDiskSink.
+//
+// A FlatBuffer per scope repeats the tag string, both full 64 bit tick
+// counts, the machine frequency and every metadata key - ~150 bytes or more
+// per scope. Here records are packed into self-contained blocks instead:
+//
+//   file   := "RSPBLK02" block*
+//   block  := [uint32 raw_size][uint32 stored_size][uint8 flags][uint24 process id, 0 if unknown]
+//             [uint16 layout][uint16 extension_size][extension_size bytes]
+//             [stored_size bytes: the payload, LZ4 block compressed if flags & 1]
+//
+// flags & 1 (LZ4) is the only flag; the other bits are reserved, and zero.
+// layout says how the payload's records are laid out - there's only the
+// one below, layout 1, so far. A writer adding a record field bumps it, so
+// a reader only ever has one layout per number to deal with and can tell
+// the ones it doesn't know. The extension is room for more block header
+// fields; readers skip what they don't understand.
+//
+//   payload := nominal_freq_hz:varint
+//              record_count:varint
+//              base_ticks:varint
+//              tag_count:varint (len:varint bytes)*      tag dictionary
+//              key_count:varint (len:varint bytes)*      metadata key dictionary
+//              schema_count:varint (field_count:varint (key_id:varint type:uint8)*)*
+//                                       typed metadata schemas (see MetadataSchema.hpp)
+//              string_count:varint (len:varint bytes)*   interned string metadata (see StringTable.hpp)
+//              record*
+//
+//   record  := tag_id:varint
+//              start_delta:zigzag       from the previous record's start (the first from base_ticks)
+//              header:varint            metadata_count << 7 | has_schema << 6 | has_rusage << 5 | has_allocs << 4 |
+//                                       has_perf << 3 | has_flow << 2 | RecordKind
+//              [flow:varint]            if has_flow
+//              [cycles:varint instructions:varint llc_misses:varint branch_misses:varint]
+//                                       if has_perf
+//              [count:varint bytes:varint self_count:varint self_bytes:varint]
+//                                       if has_allocs (allocation tracking was on)
+//              [voluntary_switches:varint involuntary_switches:varint minor_faults:varint major_faults:varint]
+//                                       if has_rusage (the scope was sampled for resource usage)
+//              SCOPE:   duration:varint [schema_id:varint value*] (key_id:varint type:uint8 value)*
+//                                       the schema's values in field order, if has_schema
+//              COUNTER: delta:zigzag
+//              GAUGE:   8 raw bytes of the double
+//              INSTANT: nothing
+//
+// Captures from before the layout field ("RSPBLK01") have a 12 byte block
+// header, ending at the process id, and tell their layouts apart by flags
+// instead. flags & 4 (flow ids), & 8 (perf counters), & 16 (allocations),
+// & 32 (resource usage) and & 64 (typed metadata, which also brings the
+// schema dictionary) each add their bit to the header, in that order above
+// RecordKind, with metadata_count above the last; a block with flags & 4
+// but none of the others, say, has metadata_count << 3 | has_flow << 2 |
+// RecordKind. Without flags & 2 (record kinds) there is no header at all:
+// records are tag_id, start_delta, duration:varint, metadata_count:varint
+// and the metadata, and are all scopes. Without flags & 128 there is no
+// string dictionary. Layout 1 is what they call flags 2 through 128 all set.
+//
+// Metadata values are varints for unsigned types, zigzag varints for signed
+// ones (sign extended from their width), the raw 8 byte payload for
+// floating point, len:varint and the bytes for inline strings and an index
+// into the block's string dictionary for interned ones. Each block carries
+// its own dictionaries, so it can be decoded without having seen any other.
+//
+// The CLI detects this format by its magic and reads it transparently.
+//
+
+#if !defined(RSP_BLOCK_DISK_SINK_BLOCK_SIZE)
+#define RSP_BLOCK_DISK_SINK_BLOCK_SIZE (64 * 1024)
+#endif
+
+static constexpr std::array<char, 8> kBlockCaptureMagic = {'R', 'S', 'P', 'B', 'L', 'K', '0', '2'};
+
+static constexpr uint8_t kBlockFlagLZ4 = 1;
+
+static constexpr uint16_t kBlockLayout   = 1;
+static constexpr size_t kBlockHeaderSize = 16;
+
+struct BlockDiskSinkOptions {
+  //
+  // Encoded records are flushed once a block reaches this size. LZ4 can't
+  // see further back than 64KiB, so bigger blocks mostly buy fewer headers.
+  // Readers reject blocks over 64MiB as corrupt.
+  //
+
+  size_t block_size = RSP_BLOCK_DISK_SINK_BLOCK_SIZE;
+  bool compress     = true;
+};
+
+namespace detail {
+
+inline void PutVarint(std::vector<uint8_t> *out, uint64_t v) {
+  while (v >= 0x80) {
+    out->push_back(static_cast<uint8_t>(v) | 0x80);
+    v >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(v));
+}
+
+inline uint64_t ZigZag(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline void PutString(std::vector<uint8_t> *out, std::string_view s) {
+  PutVarint(out, s.size());
+  out->insert(out->end(), s.begin(), s.end());
+}
+
+//
+// A small greedy compressor producing the LZ4 block format
+// (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md), so the
+// output can be read by any LZ4 block decoder. Nowhere near as clever as the
+// real thing, but our blocks are dominated by short repeated byte patterns
+// and it catches most of those.
+//
+
+class Lz4Compressor {
+public:
+  static size_t Bound(size_t n) {
+    return n + n / 255 + 16;
+  }
+
+  //
+  // `dst` must have room for Bound(n) bytes. Returns the compressed size.
+  //
+
+  size_t Compress(const uint8_t *src, size_t n, uint8_t *dst) {
+    static constexpr size_t kMinMatch    = 4;
+    static constexpr size_t kLastLiteral = 5;   // The final 5 bytes are always literals.
+    static constexpr size_t kMatchLimit  = 12;  // No match may start in the last 12 bytes.
+    static constexpr size_t kMaxOffset   = 65535;
+
+    table_.fill(0);
+
+    uint8_t *op   = dst;
+    size_t anchor = 0;
+    size_t ip     = 0;
+
+    if (n >= kMatchLimit + 1) {
+      const size_t limit = n - kMatchLimit;
+
+      while (ip < limit) {
+        const uint32_t seq = Read32(src + ip);
+        uint32_t &slot     = table_[Hash(seq)];
+        const size_t ref   = slot;
+        slot               = static_cast<uint32_t>(ip + 1);
+
+        if (ref == 0 || ip - (ref - 1) > kMaxOffset || Read32(src + ref - 1) != seq) {
+          ++ip;
+          continue;
+        }
+
+        const size_t match = ref - 1;
+        size_t len         = kMinMatch;
+        while (ip + len < n - kLastLiteral && src[match + len] == src[ip + len]) {
+          ++len;
+        }
+
+        op = EmitSequence(op, src + anchor, ip - anchor, ip - match, len - kMinMatch);
+
+        ip += len;
+        anchor = ip;
+      }
+    }
+
+    //
+    // Trailing literals.
+    //
+
+    const size_t literals = n - anchor;
+    uint8_t *token        = op++;
+    *token                = static_cast<uint8_t>(std::min<size_t>(literals, 15) << 4);
+    op                    = PutLength(op, literals);
+    std::memcpy(op, src + anchor, literals);
+    op += literals;
+
+    return static_cast<size_t>(op - dst);
+  }
+
+private:
+  static constexpr size_t kHashBits = 12;
+
+  static uint32_t Read32(const uint8_t *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  static uint32_t Hash(uint32_t seq) {
+    return (seq * 2654435761u) >> (32 - kHashBits);
+  }
+
+  static uint8_t *PutLength(uint8_t *op, size_t len) {
+    if (len < 15) {
+      return op;
+    }
+    len -= 15;
+    while (len >= 255) {
+      *op++ = 255;
+      len -= 255;
+    }
+    *op++ = static_cast<uint8_t>(len);
+    return op;
+  }
+
+  static uint8_t *EmitSequence(uint8_t *op, const uint8_t *literals, size_t num_literals, size_t offset,
+                               size_t match_len) {
+    uint8_t *token = op++;
+    *token = static_cast<uint8_t>((std::min<size_t>(num_literals, 15) << 4) | std::min<size_t>(match_len, 15));
+
+    op = PutLength(op, num_literals);
+    std::memcpy(op, literals, num_literals);
+    op += num_literals;
+
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+
+    return PutLength(op, match_len);
+  }
+
+  std::array<uint32_t, 1 << kHashBits> table_ = {};
+};
+
+}  // namespace detail
+
+//
+// Encodes records into blocks. BlockDiskSink keeps one, and so does each
+// extra sink thread (see SinkEncoded in Sinks.hpp).
+//
+
+class BlockEncoder {
+public:
+  BlockEncoder(Machine *machine, BlockDiskSinkOptions options) : machine_(machine), options_(options) {
+    records_.reserve(options_.block_size + 1024);
+  }
+
+  void Add(const ScopeInfo &info) {
+    if (count_ == 0) {
+      base_ticks_ = info.ticks_start;
+      prev_start_ = info.ticks_start;
+    }
+
+    detail::PutVarint(&records_, Intern(&tags_, &tag_ids_, info.tag.c_str()));
+    detail::PutVarint(&records_, detail::ZigZag(static_cast<int64_t>(info.ticks_start - prev_start_)));
+    prev_start_ = info.ticks_start;
+
+    const uint64_t metadata_count = info.metadata_ptr ? info.metadata_ptr->MetadataCount() : 0;
+    const MetadataSchema *schema  = info.metadata_ptr ? info.metadata_ptr->schema : nullptr;
+    const bool has_perf           = !info.perf.Empty();
+    detail::PutVarint(&records_, metadata_count << 7 | uint64_t{schema != nullptr} << 6 |
+                                     uint64_t{info.rusage.sampled} << 5 | uint64_t{info.allocs.tracked} << 4 |
+                                     uint64_t{has_perf} << 3 | uint64_t{info.flow != 0} << 2 |
+                                     static_cast<uint8_t>(info.kind));
+    if (info.flow) {
+      detail::PutVarint(&records_, info.flow);
+    }
+    if (has_perf) {
+      detail::PutVarint(&records_, info.perf.cycles);
+      detail::PutVarint(&records_, info.perf.instructions);
+      detail::PutVarint(&records_, info.perf.llc_misses);
+      detail::PutVarint(&records_, info.perf.branch_misses);
+    }
+    if (info.allocs.tracked) {
+      detail::PutVarint(&records_, info.allocs.inclusive.count);
+      detail::PutVarint(&records_, info.allocs.inclusive.bytes);
+      detail::PutVarint(&records_, info.allocs.exclusive.count);
+      detail::PutVarint(&records_, info.allocs.exclusive.bytes);
+    }
+    if (info.rusage.sampled) {
+      detail::PutVarint(&records_, info.rusage.voluntary_switches);
+      detail::PutVarint(&records_, info.rusage.involuntary_switches);
+      detail::PutVarint(&records_, info.rusage.minor_faults);
+      detail::PutVarint(&records_, info.rusage.major_faults);
+    }
+
+    switch (info.kind) {
+      case RecordKind::SCOPE:
+        detail::PutVarint(&records_, info.ticks_end - info.ticks_start);
+        if (schema) {
+          detail::PutVarint(&records_, InternSchema(schema));
+          for (size_t i = 0; i < schema->field_count; ++i) {
+            const auto &field = schema->fields[i];
+
+            ValueData data = {};
+            std::memcpy(data.data(), info.metadata_ptr->typed.data() + field.offset, field.size);
+            PutValue(field.type, data);
+          }
+        }
+        for (size_t i = 0; i < metadata_count; ++i) {
+          const auto &m = info.metadata_ptr->MetadataAt(i);
+          detail::PutVarint(&records_, Intern(&keys_, &key_ids_, m.tag.c_str()));
+          records_.push_back(static_cast<uint8_t>(m.type));
+          PutValue(m.type, m.data);
+        }
+        break;
+      case RecordKind::COUNTER:
+        detail::PutVarint(&records_, detail::ZigZag(static_cast<int64_t>(info.value)));
+        break;
+      case RecordKind::GAUGE:
+        for (int shift = 0; shift < 64; shift += 8) {
+          records_.push_back(static_cast<uint8_t>(info.value >> shift));
+        }
+        break;
+      case RecordKind::INSTANT:
+        break;
+    }
+
+    ++count_;
+  }
+
+  bool Full() const {
+    return records_.size() >= options_.block_size;
+  }
+
+  bool Empty() const {
+    return count_ == 0;
+  }
+
+  uint32_t Count() const {
+    return count_;
+  }
+
+  //
+  // The finished block, header and all, valid until the next call. Room
+  // for the header is left at the front of both the payload and the
+  // compressed copy, so that whichever we keep needs no copying.
+  //
+
+  std::span<const uint8_t> Seal() {
+    payload_.assign(kBlockHeaderSize, 0);
+    detail::PutVarint(&payload_, machine_->GetNominalFreq());
+    detail::PutVarint(&payload_, count_);
+    detail::PutVarint(&payload_, base_ticks_);
+    detail::PutVarint(&payload_, tags_.size());
+    for (const auto &t : tags_) {
+      detail::PutString(&payload_, t);
+    }
+    detail::PutVarint(&payload_, keys_.size());
+    for (const auto &k : keys_) {
+      detail::PutString(&payload_, k);
+    }
+    detail::PutVarint(&payload_, schemas_.size());
+    for (const MetadataSchema *schema : schemas_) {
+      detail::PutVarint(&payload_, schema->field_count);
+      for (size_t i = 0; i < schema->field_count; ++i) {
+        detail::PutVarint(&payload_, Intern(&keys_, &key_ids_, schema->fields[i].name));
+        payload_.push_back(static_cast<uint8_t>(schema->fields[i].type));
+      }
+    }
+    detail::PutVarint(&payload_, strings_.size());
+    for (const auto s : strings_) {
+      detail::PutString(&payload_, s);
+    }
+    payload_.insert(payload_.end(), records_.begin(), records_.end());
+
+    const size_t raw_size = payload_.size() - kBlockHeaderSize;
+    uint8_t *block        = payload_.data();
+    size_t stored_size    = raw_size;
+    uint8_t flags         = 0;
+
+    if (options_.compress) {
+      compressed_.resize(kBlockHeaderSize + detail::Lz4Compressor::Bound(raw_size));
+      const size_t n =
+          compressor_.Compress(payload_.data() + kBlockHeaderSize, raw_size, compressed_.data() + kBlockHeaderSize);
+      if (n < raw_size) {
+        block       = compressed_.data();
+        stored_size = n;
+        flags |= kBlockFlagLZ4;
+      }
+    }
+
+    const uint32_t raw_size32    = static_cast<uint32_t>(raw_size);
+    const uint32_t stored_size32 = static_cast<uint32_t>(stored_size);
+    std::memcpy(block, &raw_size32, sizeof(raw_size32));
+    std::memcpy(block + 4, &stored_size32, sizeof(stored_size32));
+    block[8] = flags;
+
+    //
+    // Linux pids fit in 22 bits (PID_MAX_LIMIT).
+    //
+
+    const uint32_t pid = static_cast<uint32_t>(getpid()) & 0xFFFFFF;
+    block[9]           = static_cast<uint8_t>(pid);
+    block[10]          = static_cast<uint8_t>(pid >> 8);
+    block[11]          = static_cast<uint8_t>(pid >> 16);
+
+    //
+    // No extension yet, so the size (block[14..15]) stays zero.
+    //
+
+    block[12] = static_cast<uint8_t>(kBlockLayout);
+    block[13] = static_cast<uint8_t>(kBlockLayout >> 8);
+    block[14] = 0;
+    block[15] = 0;
+
+    return {block, kBlockHeaderSize + stored_size};
+  }
+
+  void Clear() {
+    records_.clear();
+    tags_.clear();
+    tag_ids_.clear();
+    keys_.clear();
+    key_ids_.clear();
+    schemas_.clear();
+    schema_ids_.clear();
+    strings_.clear();
+    string_ids_.clear();
+    count_ = 0;
+  }
+
+private:
+  struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view s) const {
+      return std::hash<std::string_view>{}(s);
+    }
+  };
+
+  using Dictionary = std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>>;
+
+  static uint32_t Intern(std::vector<std::string> *strings, Dictionary *ids, std::string_view s) {
+    if (auto it = ids->find(s); it != ids->end()) {
+      return it->second;
+    }
+
+    const uint32_t id = static_cast<uint32_t>(strings->size());
+    strings->emplace_back(s);
+    ids->emplace(strings->back(), id);
+    return id;
+  }
+
+  //
+  // Schemas are interned by address: each is a single static object. Their
+  // field names go in the key dictionary with everything else.
+  //
+
+  uint32_t InternSchema(const MetadataSchema *schema) {
+    if (auto it = schema_ids_.find(schema); it != schema_ids_.end()) {
+      return it->second;
+    }
+
+    for (size_t i = 0; i < schema->field_count; ++i) {
+      Intern(&keys_, &key_ids_, schema->fields[i].name);
+    }
+
+    const uint32_t id = static_cast<uint32_t>(schemas_.size());
+    schemas_.push_back(schema);
+    schema_ids_.emplace(schema, id);
+    return id;
+  }
+
+  //
+  // Interned strings are looked up by their process wide id, and the table
+  // keeps the text alive.
+  //
+
+  uint32_t InternString(uint32_t id) {
+    if (auto it = string_ids_.find(id); it != string_ids_.end()) {
+      return it->second;
+    }
+
+    const uint32_t index = static_cast<uint32_t>(strings_.size());
+    strings_.push_back(StringTable::Instance().Get(id));
+    string_ids_.emplace(id, index);
+    return index;
+  }
+
+  using ValueData = std::array<std::byte, MetadataEntry::MAX_METADATA_DATA_SIZE_BYTES>;
+
+  template <typename T>
+  static T Load(const ValueData &data) {
+    T v;
+    std::memcpy(&v, data.data(), sizeof(T));
+    return v;
+  }
+
+  void PutValue(MetadataType type, const ValueData &data) {
+    switch (type) {
+      case MetadataType::UNSET:
+        break;
+      case MetadataType::INT8:
+        detail::PutVarint(&records_, detail::ZigZag(Load<int8_t>(data)));
+        break;
+      case MetadataType::INT16:
+        detail::PutVarint(&records_, detail::ZigZag(Load<int16_t>(data)));
+        break;
+      case MetadataType::INT32:
+        detail::PutVarint(&records_, detail::ZigZag(Load<int32_t>(data)));
+        break;
+      case MetadataType::INT64:
+        detail::PutVarint(&records_, detail::ZigZag(Load<int64_t>(data)));
+        break;
+      case MetadataType::UINT8:
+        detail::PutVarint(&records_, Load<uint8_t>(data));
+        break;
+      case MetadataType::UINT16:
+        detail::PutVarint(&records_, Load<uint16_t>(data));
+        break;
+      case MetadataType::UINT32:
+        detail::PutVarint(&records_, Load<uint32_t>(data));
+        break;
+      case MetadataType::UINT64:
+        detail::PutVarint(&records_, Load<uint64_t>(data));
+        break;
+      case MetadataType::FLOAT:
+      case MetadataType::DOUBLE:
+        records_.insert(records_.end(),
+                        reinterpret_cast<const uint8_t *>(data.data()),
+                        reinterpret_cast<const uint8_t *>(data.data()) + data.size());
+        break;
+      case MetadataType::STRING: {
+        const std::string_view chars{reinterpret_cast<const char *>(data.data()), data.size()};
+        detail::PutString(&records_, chars.substr(0, chars.find('\0')));
+        break;
+      }
+      case MetadataType::STRING_ID:
+        detail::PutVarint(&records_, InternString(Load<uint32_t>(data)));
+        break;
+    }
+  }
+
+  Machine *machine_;
+  BlockDiskSinkOptions options_;
+
+  std::vector<uint8_t> records_;
+  std::vector<uint8_t> payload_;
+  std::vector<uint8_t> compressed_;
+  detail::Lz4Compressor compressor_;
+
+  std::vector<std::string> tags_;
+  Dictionary tag_ids_;
+  std::vector<std::string> keys_;
+  Dictionary key_ids_;
+  std::vector<const MetadataSchema *> schemas_;
+  std::unordered_map<const MetadataSchema *, uint32_t> schema_ids_;
+  std::vector<std::string_view> strings_;
+  std::unordered_map<uint32_t, uint32_t> string_ids_;
+
+  uint32_t count_      = 0;
+  uint64_t base_ticks_ = 0;
+  uint64_t prev_start_ = 0;
+};
+
+class BlockDiskSink {
+public:
+  BlockDiskSink(std::filesystem::path path, Machine *machine, BlockDiskSinkOptions options = {})
+      : path_(path), machine_(machine), options_(options), encoder_(machine, options) {
+    //
+    // Like BinaryDiskSink we append, but only onto a capture in the same format.
+    //
+
+    std::error_code ec;
+    const auto existing = std::filesystem::file_size(path, ec);
+    if (!ec && existing > 0) {
+      std::ifstream in(path, std::ios::binary);
+      std::array<char, kBlockCaptureMagic.size()> magic = {};
+      in.read(magic.data(), magic.size());
+      if (!in || magic != kBlockCaptureMagic) {
+        return;
+      }
+    }
+
+    fd_.open(path, std::ios::binary | std::ios::app);
+    if (fd_ && (ec || existing == 0)) {
+      fd_.write(kBlockCaptureMagic.data(), kBlockCaptureMagic.size());
+      bytes_written_ += kBlockCaptureMagic.size();
+    }
+  }
+
+  BlockDiskSink(const BlockDiskSink &)            = delete;
+  BlockDiskSink &operator=(const BlockDiskSink &) = delete;
+
+  ~BlockDiskSink() {
+    Flush();
+  }
+
+  void Sink(const ScopeInfo &info) {
+    encoder_.Add(info);
+    if (encoder_.Full()) {
+      WriteBlock();
+    }
+  }
+
+  //
+  // Writes out the current (partial) block, and the stream's buffer.
+  //
+
+  void Flush() {
+    WriteBlock();
+    fd_.flush();
+  }
+
+  //
+  // See SinkEncoded in Sinks.hpp. Blocks from other threads are written
+  // between our own.
+  //
+
+  using Encoder = BlockEncoder;
+
+  std::optional<Encoder> MakeEncoder() const {
+    return Encoder(machine_, options_);
+  }
+
+  void SinkEncoded(std::span<const uint8_t> block, uint32_t) {
+    if (fd_) {
+      Write(block);
+    }
+  }
+
+  bool OK() const {
+    return fd_.is_open();
+  }
+
+  //
+  // Bytes handed to the stream so far. Records still sitting in the current
+  // block aren't counted until it's flushed.
+  //
+
+  uint64_t BytesWritten() const {
+    return bytes_written_;
+  }
+
+  //
+  // A sink like this one for a forked child, writing to PerProcessPath()
+  // (see Profiler::EnableForkFollowing).
+  //
+
+  std::shared_ptr<BlockDiskSink> ReopenForProcess(pid_t pid) const {
+    return std::make_shared<BlockDiskSink>(PerProcessPath(path_, pid), machine_, options_);
+  }
+
+private:
+  void WriteBlock() {
+    if (encoder_.Empty() || !fd_) {
+      return;
+    }
+
+    Write(encoder_.Seal());
+    encoder_.Clear();
+  }
+
+  void Write(std::span<const uint8_t> block) {
+    fd_.write(reinterpret_cast<const char *>(block.data()), static_cast<std::streamsize>(block.size()));
+    bytes_written_ += block.size();
+  }
+
+  std::filesystem::path path_;
+  std::ofstream fd_;
+  Machine *machine_;
+  BlockDiskSinkOptions options_;
+  uint64_t bytes_written_ = 0;
+
+  BlockEncoder encoder_;
+};
+
+}  // namespace rsp
@@ -0,0 +1,452 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+
+#pragma once
+
+#include "Macros.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fnmatch.h>
+
+namespace rsp {
+
+//
+// Call sites.
+//
+// Every RSP_SCOPE (and friends) owns a static CallSite: its name, a category
+// and a level. Sites register themselves the first time they run, and can
+// then be switched on and off at runtime, one at a time or by category.
+//
+// Which sites are on is decided by an ordered list of rules. Each rule is a
+// glob (see fnmatch(3)), optionally prefixed with '-' to disable, matched
+// against a site's category, its name and its "file.cpp:line". Sites start
+// out enabled, and the last matching rule wins. For example:
+//
+//   -*, io, Worker Loop, -io/verbose*
+//
+// turns everything off, then the io category back on, then one site, and
+// finally the io categories that start with "io/verbose" off again.
+//
+// Rules come from three places, each replacing the previous set:
+//
+// - The RSP_SITES environment variable, at startup.
+// - A control file (RSP_SITES_FILE in the environment, or
+//   SetControlFile()), re-read by the sink thread whenever it changes. One
+//   or more rules per line, '#' starts a comment.
+// - ConfigureCallSites() and friends in API.hpp.
+//
+// A disabled site costs one relaxed load and a branch.
+//
+// A second, independent set of rules in the same syntax picks the sites
+// whose scopes may be sampled for resource usage (see ResourceUsage.hpp).
+// It comes from RSP_RUSAGE_SITES at startup, or
+// ConfigureResourceUsageSites(), and also starts out matching everything.
+//
+
+#if !defined(RSP_CALLSITE_CONTROL_POLL_MS)
+#define RSP_CALLSITE_CONTROL_POLL_MS 500
+#endif
+
+//
+// Compile time stripping. Sites above RSP_MAX_LEVEL (see the RSP_LEVEL_*
+// values in Macros.hpp), or in one of the comma separated categories in
+// RSP_STRIP_CATEGORIES, compile to a placeholder that never records - it
+// only keeps the thread's scope stack straight, so metadata inside it isn't
+// attached to an enclosing scope. A trailing '*' strips every category with
+// that prefix, e.g. -DRSP_STRIP_CATEGORIES='"io/verbose*,net"'.
+//
+
+#if !defined(RSP_MAX_LEVEL)
+#define RSP_MAX_LEVEL RSP_LEVEL_TRACE
+#endif
+
+#if !defined(RSP_STRIP_CATEGORIES)
+#define RSP_STRIP_CATEGORIES ""
+#endif
+
+constexpr bool CategoryStripped(std::string_view category, std::string_view stripped = RSP_STRIP_CATEGORIES) {
+  while (!stripped.empty()) {
+    const auto comma        = stripped.find(',');
+    std::string_view entry  = stripped.substr(0, comma);
+    stripped                = comma == std::string_view::npos ? std::string_view{} : stripped.substr(comma + 1);
+
+    while (!entry.empty() && entry.front() == ' ') {
+      entry.remove_prefix(1);
+    }
+    while (!entry.empty() && entry.back() == ' ') {
+      entry.remove_suffix(1);
+    }
+
+    if (!entry.empty() && entry.back() == '*') {
+      if (category.starts_with(entry.substr(0, entry.size() - 1))) {
+        return true;
+      }
+    } else if (!entry.empty() && category == entry) {
+      return true;
+    }
+  }
+  return false;
+}
+
+constexpr bool CompiledIn(int level, std::string_view category) {
+  return level <= RSP_MAX_LEVEL && !CategoryStripped(category);
+}
+
+class CallSite {
+public:
+  enum : uint8_t { UNREGISTERED = 0, ENABLED = 1, DISABLED = 2 };
+
+  constexpr CallSite(const char *name, const char *category, int level, const char *file, int line)
+      : name_(name), category_(category), file_(file), level_(level), line_(line) {
+  }
+
+  CallSite(const CallSite &)            = delete;
+  CallSite &operator=(const CallSite &) = delete;
+
+  bool Enabled() {
+    const uint8_t state = state_.load(std::memory_order_relaxed);
+    if (state == ENABLED) [[likely]] {
+      return true;
+    }
+    return state == UNREGISTERED && Register();
+  }
+
+  const char *Name() const {
+    return name_;
+  }
+
+  const char *Category() const {
+    return category_;
+  }
+
+  const char *File() const {
+    return file_;
+  }
+
+  int Level() const {
+    return level_;
+  }
+
+  int Line() const {
+    return line_;
+  }
+
+  //
+  // Whether the resource usage rules select this site. Only meaningful once
+  // Enabled() has registered it.
+  //
+
+  bool RusageSelected() const {
+    return rusage_.load(std::memory_order_relaxed);
+  }
+
+private:
+  bool Register();
+
+  const char *name_;
+  const char *category_;
+  const char *file_;
+  int level_;
+  int line_;
+
+  std::atomic<uint8_t> state_ = UNREGISTERED;
+  std::atomic<bool> rusage_   = true;
+
+  friend class CallSiteRegistry;
+};
+
+//
+// A snapshot of one registered site, for listing.
+//
+
+struct CallSiteInfo {
+  std::string name;
+  std::string category;
+  std::string file;
+  int line            = 0;
+  int level           = 0;
+  bool enabled        = false;
+  bool resource_usage = false;
+};
+
+class CallSiteRegistry {
+public:
+  static CallSiteRegistry &Instance() {
+    static CallSiteRegistry instance;
+    return instance;
+  }
+
+  CallSiteRegistry(const CallSiteRegistry &)            = delete;
+  CallSiteRegistry &operator=(const CallSiteRegistry &) = delete;
+
+  //
+  // Replaces the rules and re-evaluates every registered site.
+  //
+
+  void Configure(std::string_view spec) {
+    const std::scoped_lock lock{mutex_};
+    rules_ = ParseRules(spec);
+    ApplyLocked();
+  }
+
+  //
+  // Appends a single rule, so it overrides everything before it.
+  //
+
+  void AddRule(std::string_view pattern, bool enable) {
+    const std::scoped_lock lock{mutex_};
+    rules_.push_back(Rule{std::string(pattern), enable});
+    ApplyLocked();
+  }
+
+  //
+  // Replaces the resource usage rules.
+  //
+
+  void ConfigureResourceUsage(std::string_view spec) {
+    const std::scoped_lock lock{mutex_};
+    rusage_rules_ = ParseRules(spec);
+    ApplyLocked();
+  }
+
+  std::vector<CallSiteInfo> Sites() const {
+    const std::scoped_lock lock{mutex_};
+
+    std::vector<CallSiteInfo> out;
+    out.reserve(sites_.size());
+    for (const auto *site : sites_) {
+      out.push_back(CallSiteInfo{site->name_, site->category_, site->file_, site->line_, site->level_,
+                                 site->state_.load(std::memory_order_relaxed) == CallSite::ENABLED,
+                                 site->rusage_.load(std::memory_order_relaxed)});
+    }
+    return out;
+  }
+
+  //
+  // The control file is read straight away, and then re-read by
+  // PollControlFile() whenever its size or modification time changes. An
+  // empty path stops watching.
+  //
+
+  void SetControlFile(const std::filesystem::path &path) {
+    {
+      const std::scoped_lock lock{mutex_};
+      control_file_  = path;
+      control_stamp_ = {};
+    }
+    PollControlFile();
+  }
+
+  //
+  // Called periodically from the sink thread.
+  //
+
+  void PollControlFile() {
+    std::filesystem::path path;
+    {
+      const std::scoped_lock lock{mutex_};
+      path = control_file_;
+    }
+
+    if (path.empty()) {
+      return;
+    }
+
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+      return;
+    }
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+      return;
+    }
+
+    const ControlStamp stamp{size, mtime};
+    {
+      const std::scoped_lock lock{mutex_};
+      if (stamp == control_stamp_) {
+        return;
+      }
+      control_stamp_ = stamp;
+    }
+
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    Configure(contents.str());
+  }
+
+  //
+  // Held across fork() (see Profiler), so that a child never inherits the
+  // lock from the sink thread or a registering call site.
+  //
+
+  void LockForFork() {
+    mutex_.lock();
+  }
+
+  void UnlockAfterFork() {
+    mutex_.unlock();
+  }
+
+private:
+  struct Rule {
+    std::string pattern;
+    bool enable;
+  };
+
+  struct ControlStamp {
+    uintmax_t size                        = 0;
+    std::filesystem::file_time_type mtime = {};
+
+    bool operator==(const ControlStamp &) const = default;
+  };
+
+  CallSiteRegistry() {
+    if (const char *spec = std::getenv("RSP_SITES")) {
+      rules_ = ParseRules(spec);
+    }
+    if (const char *spec = std::getenv("RSP_RUSAGE_SITES")) {
+      rusage_rules_ = ParseRules(spec);
+    }
+    if (const char *file = std::getenv("RSP_SITES_FILE")) {
+      control_file_ = file;
+      PollControlFile();
+    }
+  }
+
+  //
+  // Splits on commas and newlines, dropping comments and whitespace.
+  //
+
+  static std::vector<Rule> ParseRules(std::string_view spec) {
+    std::vector<Rule> rules;
+
+    bool comment = false;
+    std::string current;
+
+    auto flush = [&]() {
+      const auto first = current.find_first_not_of(" \t\r");
+      if (first != std::string::npos) {
+        const auto last     = current.find_last_not_of(" \t\r");
+        std::string pattern = current.substr(first, last - first + 1);
+
+        bool enable = true;
+        if (pattern[0] == '-' || pattern[0] == '+') {
+          enable  = pattern[0] == '+';
+          pattern = pattern.substr(1);
+        }
+        if (!pattern.empty()) {
+          rules.push_back(Rule{std::move(pattern), enable});
+        }
+      }
+      current.clear();
+    };
+
+    for (char c : spec) {
+      if (c == '\n') {
+        comment = false;
+        flush();
+      } else if (comment) {
+        continue;
+      } else if (c == '#') {
+        comment = true;
+      } else if (c == ',') {
+        flush();
+      } else {
+        current.push_back(c);
+      }
+    }
+    flush();
+
+    return rules;
+  }
+
+  static bool Evaluate(const CallSite &site, const std::vector<Rule> &rules) {
+    std::string_view file{site.file_};
+    if (const auto slash = file.find_last_of('/'); slash != std::string_view::npos) {
+      file = file.substr(slash + 1);
+    }
+    const std::string location = std::string(file) + ":" + std::to_string(site.line_);
+
+    bool enabled = true;
+    for (const auto &rule : rules) {
+      const char *p = rule.pattern.c_str();
+      if (fnmatch(p, site.category_, 0) == 0 || fnmatch(p, site.name_, 0) == 0 ||
+          fnmatch(p, location.c_str(), 0) == 0) {
+        enabled = rule.enable;
+      }
+    }
+    return enabled;
+  }
+
+  void ApplyLocked() {
+    for (auto *site : sites_) {
+      site->state_.store(Evaluate(*site, rules_) ? CallSite::ENABLED : CallSite::DISABLED,
+                         std::memory_order_relaxed);
+      site->rusage_.store(Evaluate(*site, rusage_rules_), std::memory_order_relaxed);
+    }
+  }
+
+  bool Register(CallSite *site) {
+    const std::scoped_lock lock{mutex_};
+
+    //
+    // Another thread may have beaten us to it.
+    //
+
+    const uint8_t state = site->state_.load(std::memory_order_relaxed);
+    if (state != CallSite::UNREGISTERED) {
+      return state == CallSite::ENABLED;
+    }
+
+    sites_.push_back(site);
+    site->rusage_.store(Evaluate(*site, rusage_rules_), std::memory_order_relaxed);
+    const bool enabled = Evaluate(*site, rules_);
+    site->state_.store(enabled ? CallSite::ENABLED : CallSite::DISABLED, std::memory_order_relaxed);
+    return enabled;
+  }
+
+  mutable std::mutex mutex_;
+  std::vector<CallSite *> sites_;
+  std::vector<Rule> rules_;
+  std::vector<Rule> rusage_rules_;
+
+  std::filesystem::path control_file_;
+  ControlStamp control_stamp_;
+
+  friend class CallSite;
+};
+
+inline bool CallSite::Register() {
+  return CallSiteRegistry::Instance().Register(this);
+}
+
+}  // namespace rsp
@@ -0,0 +1,602 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "Machine.hpp"
+#include "Metadata.hpp"
+#include "Scope.hpp"
+#include "Slots.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rsp {
+
+//
+// The framed capture format, written by BinaryDiskSink and AsyncDiskSink.
+//
+// Records are the same [uint32 len][flatbuffer] pairs as ever, but the file
+// starts with a header describing where it came from, and the records are
+// grouped into frames that can be found and checked on their own:
+//
+//   header:  "RSPCAP01"
+//            [uint32 version][uint32 fields length]
+//            fields: [uint64 nominal freq]
+//                    [uint16 len][clock source]
+//                    [uint16 len][host]
+//                    [uint16 len][cpu model]
+//                    [uint16 len][build flags]
+//                    [uint32 process id]
+//            [uint32 crc32 of the fields]
+//
+//   frame:   [8 byte sync marker]
+//            [uint32 payload length][uint32 record count]
+//            [uint32 crc32 of the payload][uint32 crc32 of the previous 20 bytes]
+//            payload: [uint32 len][flatbuffer] * record count
+//
+// A reader that lands anywhere in the file (a corrupt length, a truncated
+// tail, or a split for parallel reading) scans forward for the next sync
+// marker, and trusts it only if the frame header's CRC checks out. For the
+// same reason, interned string metadata carries its text the first time its
+// id appears in each frame (see StringTable.hpp).
+//
+// Everything is little endian. Readers should ignore header fields past the
+// ones they know about.
+//
+
+#if !defined(RSP_CAPTURE_FRAME_SIZE)
+#define RSP_CAPTURE_FRAME_SIZE (64 * 1024)
+#endif
+
+inline constexpr std::array<char, 8> kCaptureMagic = {'R', 'S', 'P', 'C', 'A', 'P', '0', '1'};
+inline constexpr uint32_t kCaptureVersion          = 1;
+
+inline constexpr std::array<uint8_t, 8> kFrameSyncMarker = {0xF5, 0x52, 0x53, 0x50, 0x46, 0x52, 0x4D, 0xA7};
+inline constexpr size_t kFrameHeaderSize                 = 24;
+
+namespace detail {
+
+//
+// CRC-32 (IEEE, as in zlib and Go's hash/crc32), slicing by 8.
+//
+
+inline constexpr auto kCrc32Tables = []() {
+  std::array<std::array<uint32_t, 256>, 8> tables = {};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (int k = 0; k < 8; ++k) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    tables[0][i] = crc;
+  }
+  for (uint32_t i = 0; i < 256; ++i) {
+    for (size_t t = 1; t < 8; ++t) {
+      tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+    }
+  }
+  return tables;
+}();
+
+inline uint32_t Crc32(const void *data, size_t len, uint32_t crc = 0) {
+  const auto &t = kCrc32Tables;
+  const auto *p = static_cast<const uint8_t *>(data);
+  crc           = ~crc;
+
+  while (len >= 8) {
+    uint32_t lo, hi;
+    std::memcpy(&lo, p, 4);
+    std::memcpy(&hi, p + 4, 4);
+    lo ^= crc;
+    crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^ t[3][hi & 0xFF] ^
+          t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    p += 8;
+    len -= 8;
+  }
+
+  while (len-- > 0) {
+    crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  }
+
+  return ~crc;
+}
+
+template <typename T>
+inline void PutLE(std::vector<uint8_t> *out, T v) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    out->push_back(static_cast<uint8_t>(v >> (8 * i)));
+  }
+}
+
+template <typename T>
+inline T GetLE(const uint8_t *in) {
+  T v = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    v |= static_cast<T>(in[i]) << (8 * i);
+  }
+  return v;
+}
+
+template <typename T>
+inline void SetLE(uint8_t *out, T v) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    out[i] = static_cast<uint8_t>(v >> (8 * i));
+  }
+}
+
+inline void PutShortString(std::vector<uint8_t> *out, std::string_view s) {
+  s = s.substr(0, UINT16_MAX);
+  PutLE<uint16_t>(out, static_cast<uint16_t>(s.size()));
+  out->insert(out->end(), s.begin(), s.end());
+}
+
+inline std::string HostName() {
+  std::array<char, 256> name = {};
+  if (gethostname(name.data(), name.size() - 1) != 0) {
+    return "unknown";
+  }
+  return name.data();
+}
+
+inline std::string CpuModel() {
+  //
+  // x86 Linux has "model name"; arm64 Linux usually only has the
+  // implementer/part numbers, which is still enough to tell machines apart.
+  //
+
+  std::ifstream in("/proc/cpuinfo");
+  std::string line, implementer, part;
+  while (std::getline(in, line)) {
+    const auto colon = line.find(':');
+    if (colon == std::string::npos) {
+      continue;
+    }
+
+    const auto key   = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+    const auto value = colon + 2 <= line.size() ? line.substr(colon + 2) : std::string{};
+
+    if (key == "model name") {
+      return value;
+    } else if (key == "CPU implementer" && implementer.empty()) {
+      implementer = value;
+    } else if (key == "CPU part" && part.empty()) {
+      part = value;
+    }
+  }
+
+  if (!implementer.empty()) {
+    return "implementer " + implementer + " part " + part;
+  }
+
+  return "unknown";
+}
+
+inline std::string BuildFlags() {
+  std::string flags;
+
+#if defined(__VERSION__)
+  flags += "compiler=" __VERSION__;
+#endif
+#if defined(__OPTIMIZE__)
+  flags += " optimized";
+#endif
+#if defined(NDEBUG)
+  flags += " NDEBUG";
+#endif
+
+  flags += " RSP_MAX_METADATA_ENTRIES=" + std::to_string(RSP_MAX_METADATA_ENTRIES);
+  flags += " RSP_SCOPE_TAG_SIZE=" + std::to_string(RSP_SCOPE_TAG_SIZE);
+  flags += " RSP_SCOPE_METADATA_TAG_SIZE=" + std::to_string(RSP_SCOPE_METADATA_TAG_SIZE);
+
+  return flags;
+}
+
+}  // namespace detail
+
+inline std::vector<uint8_t> MakeCaptureHeader(Machine *machine) {
+  std::vector<uint8_t> fields;
+  detail::PutLE<uint64_t>(&fields, machine->GetNominalFreq());
+  detail::PutShortString(&fields, machine->GetClockSource());
+  detail::PutShortString(&fields, detail::HostName());
+  detail::PutShortString(&fields, detail::CpuModel());
+  detail::PutShortString(&fields, detail::BuildFlags());
+  detail::PutLE<uint32_t>(&fields, static_cast<uint32_t>(getpid()));
+
+  std::vector<uint8_t> header(kCaptureMagic.begin(), kCaptureMagic.end());
+  detail::PutLE<uint32_t>(&header, kCaptureVersion);
+  detail::PutLE<uint32_t>(&header, static_cast<uint32_t>(fields.size()));
+  header.insert(header.end(), fields.begin(), fields.end());
+  detail::PutLE<uint32_t>(&header, detail::Crc32(fields.data(), fields.size()));
+
+  return header;
+}
+
+//
+// How a disk sink should continue an existing file: we only add frames to a
+// framed capture, and carry on with bare records in anything else, so that
+// an old capture stays readable.
+//
+
+inline bool ShouldWriteFramed(const std::filesystem::path &path) {
+  std::error_code ec;
+  const auto existing = std::filesystem::file_size(path, ec);
+  if (ec || existing == 0) {
+    return true;
+  }
+
+  std::ifstream in(path, std::ios::binary);
+  std::array<char, kCaptureMagic.size()> magic = {};
+  in.read(magic.data(), magic.size());
+  return in && magic == kCaptureMagic;
+}
+
+//
+// Groups serialized records into frames: Add() records until Full(), write
+// out what Seal() returns, then Clear() for the next frame.
+//
+
+class CaptureFramer {
+public:
+  explicit CaptureFramer(size_t frame_size = RSP_CAPTURE_FRAME_SIZE) : frame_size_(frame_size) {
+    frame_.reserve(frame_size_ + kFrameHeaderSize + 1024);
+    Clear();
+  }
+
+  void Add(const uint8_t *data, uint32_t len) {
+    detail::PutLE<uint32_t>(&frame_, len);
+    frame_.insert(frame_.end(), data, data + len);
+    ++count_;
+  }
+
+  bool Full() const {
+    return frame_.size() - kFrameHeaderSize >= frame_size_;
+  }
+
+  bool Empty() const {
+    return count_ == 0;
+  }
+
+  uint32_t Count() const {
+    return count_;
+  }
+
+  //
+  // The interned strings this frame has written out so far.
+  //
+
+  StringIdSet *Strings() {
+    return &strings_;
+  }
+
+  const std::vector<uint8_t> &Seal() {
+    uint8_t *h       = frame_.data();
+    const size_t len = frame_.size() - kFrameHeaderSize;
+
+    std::memcpy(h, kFrameSyncMarker.data(), kFrameSyncMarker.size());
+    detail::SetLE<uint32_t>(h + 8, static_cast<uint32_t>(len));
+    detail::SetLE<uint32_t>(h + 12, count_);
+    detail::SetLE<uint32_t>(h + 16, detail::Crc32(h + kFrameHeaderSize, len));
+    detail::SetLE<uint32_t>(h + 20, detail::Crc32(h, 20));
+
+    return frame_;
+  }
+
+  void Clear() {
+    frame_.assign(kFrameHeaderSize, 0);
+    count_ = 0;
+    strings_.Clear();
+  }
+
+private:
+  size_t frame_size_;
+  std::vector<uint8_t> frame_;
+  uint32_t count_ = 0;
+  StringIdSet strings_;
+};
+
+//
+// Reads a capture written by BinaryDiskSink/AsyncDiskSink back, record by
+// record - framed, or the bare stream from before frames.
+//
+// Damaged frames are skipped (see SkippedBytes()), picking up again at the
+// next sync marker whose frame header checks out.
+//
+
+struct CaptureHeader {
+  uint32_t version      = 0;
+  uint64_t nominal_freq = 0;
+  std::string clock_source;
+  std::string host;
+  std::string cpu_model;
+  std::string build_flags;
+};
+
+class CaptureReader {
+public:
+  explicit CaptureReader(const std::filesystem::path &path) : in_(path, std::ios::binary) {
+    if (!in_ || !Fill(kCaptureMagic.size()) ||
+        !std::equal(kCaptureMagic.begin(), kCaptureMagic.end(), buf_.begin() + pos_)) {
+      return;
+    }
+
+    framed_ = true;
+    pos_ += kCaptureMagic.size();
+
+    if (!ReadHeader()) {
+      header_ok_ = false;
+    }
+  }
+
+  bool OK() const {
+    return in_.is_open();
+  }
+
+  bool Framed() const {
+    return framed_;
+  }
+
+  //
+  // Null for bare captures, and framed ones whose header is damaged.
+  //
+
+  const CaptureHeader *Header() const {
+    return framed_ && header_ok_ ? &header_ : nullptr;
+  }
+
+  //
+  // The next record's FlatBuffer, which stays valid until the following
+  // call. Returns false at the end of the capture.
+  //
+
+  bool Next(const uint8_t **data, uint32_t *len) {
+    if (!framed_) {
+      if (!Fill(sizeof(uint32_t))) {
+        truncated_ = Buffered() > 0;
+        return false;
+      }
+
+      //
+      // With nothing to resync on, a corrupt length ends the capture - but
+      // without first reading up to 4GiB to find that out.
+      //
+
+      *len = detail::GetLE<uint32_t>(&buf_[pos_]);
+      if (*len > kMaxBareRecordSize || !Fill(sizeof(uint32_t) + *len)) {
+        truncated_ = true;
+        return false;
+      }
+
+      *data = &buf_[pos_ + sizeof(uint32_t)];
+      pos_ += sizeof(uint32_t) + *len;
+      return true;
+    }
+
+    for (;;) {
+      while (remaining_ == 0) {
+        if (!NextFrame()) {
+          return false;
+        }
+      }
+
+      //
+      // A record running past the end of its frame means the frame's
+      // contents are bad despite the CRC, so the rest of it is skipped and
+      // we carry on with the next one.
+      //
+
+      const size_t left = frame_.size() - frame_pos_;
+      if (left >= sizeof(uint32_t)) {
+        *len = detail::GetLE<uint32_t>(&frame_[frame_pos_]);
+        if (left - sizeof(uint32_t) >= *len) {
+          *data = &frame_[frame_pos_ + sizeof(uint32_t)];
+          frame_pos_ += sizeof(uint32_t) + *len;
+          --remaining_;
+          return true;
+        }
+      }
+
+      skipped_ += left;
+      frame_pos_ = frame_.size();
+      remaining_ = 0;
+    }
+  }
+
+  uint64_t SkippedBytes() const {
+    return skipped_;
+  }
+
+  bool Truncated() const {
+    return truncated_;
+  }
+
+private:
+  //
+  // No record comes anywhere near this; a bare capture claiming one is
+  // corrupt.
+  //
+
+  static constexpr uint32_t kMaxBareRecordSize = 1u << 20;
+
+  size_t Buffered() const {
+    return buf_.size() - pos_;
+  }
+
+  //
+  // Makes sure at least n bytes are buffered, if the file has them.
+  //
+
+  bool Fill(size_t n) {
+    if (Buffered() >= n) {
+      return true;
+    }
+
+    buf_.erase(buf_.begin(), buf_.begin() + static_cast<std::ptrdiff_t>(pos_));
+    pos_ = 0;
+
+    const size_t want = std::max<size_t>(n, kReadSize);
+    const size_t have = buf_.size();
+    buf_.resize(have + want);
+    in_.read(reinterpret_cast<char *>(buf_.data() + have), static_cast<std::streamsize>(want));
+    buf_.resize(have + static_cast<size_t>(in_.gcount()));
+
+    return Buffered() >= n;
+  }
+
+  bool ReadHeader() {
+    if (!Fill(8)) {
+      return false;
+    }
+
+    header_.version     = detail::GetLE<uint32_t>(&buf_[pos_]);
+    const uint32_t size = detail::GetLE<uint32_t>(&buf_[pos_ + 4]);
+    if (header_.version != kCaptureVersion || size > (1u << 20) || !Fill(8 + size + 4)) {
+      return false;
+    }
+
+    const uint8_t *fields = &buf_[pos_ + 8];
+    if (detail::Crc32(fields, size) != detail::GetLE<uint32_t>(fields + size)) {
+      return false;
+    }
+
+    pos_ += 8 + size + 4;
+
+    const uint8_t *end = fields + size;
+    if (end - fields >= 8) {
+      header_.nominal_freq = detail::GetLE<uint64_t>(fields);
+      fields += 8;
+    }
+
+    for (auto *s : {&header_.clock_source, &header_.host, &header_.cpu_model, &header_.build_flags}) {
+      if (end - fields < 2) {
+        break;
+      }
+      const uint16_t n = detail::GetLE<uint16_t>(fields);
+      if (end - fields - 2 < n) {
+        break;
+      }
+      s->assign(reinterpret_cast<const char *>(fields + 2), n);
+      fields += 2 + n;
+    }
+
+    return true;
+  }
+
+  //
+  // Skips forward to the next sync marker; false if there isn't one.
+  //
+
+  bool Resync() {
+    for (;;) {
+      const auto begin = buf_.begin() + static_cast<std::ptrdiff_t>(pos_);
+      const auto it    = std::search(begin, buf_.end(), kFrameSyncMarker.begin(), kFrameSyncMarker.end());
+      if (it != buf_.end()) {
+        skipped_ += static_cast<uint64_t>(it - begin);
+        pos_ += static_cast<size_t>(it - begin);
+        return true;
+      }
+
+      //
+      // Keep the tail, in case it's the start of a marker.
+      //
+
+      const size_t keep = std::min(Buffered(), kFrameSyncMarker.size() - 1);
+      skipped_ += Buffered() - keep;
+      pos_ = buf_.size() - keep;
+
+      if (!Fill(keep + 1)) {
+        skipped_ += Buffered();
+        pos_ = buf_.size();
+        return false;
+      }
+    }
+  }
+
+  bool NextFrame() {
+    for (;;) {
+      if (!Fill(kFrameHeaderSize)) {
+        if (Buffered() > 0) {
+          truncated_ = true;
+          skipped_ += Buffered();
+          pos_ = buf_.size();
+        }
+        return false;
+      }
+
+      const uint8_t *h = &buf_[pos_];
+      if (!std::equal(kFrameSyncMarker.begin(), kFrameSyncMarker.end(), h) ||
+          detail::Crc32(h, 20) != detail::GetLE<uint32_t>(h + 20)) {
+        ++pos_;
+        ++skipped_;
+        if (!Resync()) {
+          return false;
+        }
+        continue;
+      }
+
+      const uint32_t len   = detail::GetLE<uint32_t>(h + 8);
+      const uint32_t count = detail::GetLE<uint32_t>(h + 12);
+      const uint32_t crc   = detail::GetLE<uint32_t>(h + 16);
+
+      if (!Fill(kFrameHeaderSize + len)) {
+        truncated_ = true;
+        skipped_ += Buffered();
+        pos_ = buf_.size();
+        return false;
+      }
+
+      const uint8_t *payload = &buf_[pos_ + kFrameHeaderSize];
+      pos_ += kFrameHeaderSize + len;
+
+      if (detail::Crc32(payload, len) != crc) {
+        skipped_ += kFrameHeaderSize + len;
+        continue;
+      }
+
+      frame_.assign(payload, payload + len);
+      frame_pos_ = 0;
+      remaining_ = count;
+      return true;
+    }
+  }
+
+  static constexpr size_t kReadSize = 1 << 20;
+
+  std::ifstream in_;
+  std::vector<uint8_t> buf_;
+  size_t pos_ = 0;
+
+  bool framed_    = false;
+  bool header_ok_ = true;
+  CaptureHeader header_;
+
+  std::vector<uint8_t> frame_;
+  size_t frame_pos_   = 0;
+  uint32_t remaining_ = 0;
+
+  uint64_t skipped_ = 0;
+  bool truncated_   = false;
+};
+
+}  // namespace rsp
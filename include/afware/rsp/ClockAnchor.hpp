@@ -0,0 +1,104 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "Machine.hpp"
+
+#include <cstdint>
+#include <ctime>
+
+//
+// Clock anchors tie a capture's ticks to wall clock time.
+//
+// Ticks are only meaningful on the machine that counted them: they start at
+// an arbitrary point, and the nominal frequency is an estimate. So while a
+// session runs, the sink thread records an anchor every
+// RSP_CLOCK_ANCHOR_INTERVAL_MS - the tick count alongside CLOCK_REALTIME and
+// CLOCK_MONOTONIC - plus one when the session starts and stops. Two anchors
+// give the tick rate actually observed, so `rsp align` can put captures from
+// several hosts on one (wall clock) timeline, correcting for drift as it
+// goes.
+//
+// Setting RSP_CLOCK_ANCHOR_INTERVAL_MS to 0 keeps just the start and stop
+// anchors. Each anchor is a pair of ordinary counter records on the same
+// tick, one per clock, whose values are the clock in nanoseconds - so every
+// sink and capture format carries them as is.
+//
+
+#if !defined(RSP_CLOCK_ANCHOR_INTERVAL_MS)
+#define RSP_CLOCK_ANCHOR_INTERVAL_MS 1000
+#endif
+
+//
+// How many times we read the clocks for each anchor, keeping the reading
+// that the two tick reads bracket most tightly.
+//
+
+#if !defined(RSP_CLOCK_ANCHOR_READS)
+#define RSP_CLOCK_ANCHOR_READS 5
+#endif
+
+namespace rsp {
+
+inline constexpr const char *kClockAnchorRealtimeTag  = "rsp.clock.realtime";
+inline constexpr const char *kClockAnchorMonotonicTag = "rsp.clock.monotonic";
+
+struct ClockAnchor {
+  uint64_t ticks       = 0;
+  int64_t realtime_ns  = 0;
+  int64_t monotonic_ns = 0;
+
+  //
+  // Ticks between the reads either side of the clocks: the anchor's
+  // uncertainty.
+  //
+
+  uint64_t window = 0;
+};
+
+namespace detail {
+
+inline int64_t ClockNs(clockid_t clock) {
+  timespec ts{};
+  clock_gettime(clock, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+}  // namespace detail
+
+inline ClockAnchor ReadClockAnchor() {
+  ClockAnchor best;
+  best.window = UINT64_MAX;
+
+  for (int i = 0; i < RSP_CLOCK_ANCHOR_READS; ++i) {
+    const uint64_t before   = Now();
+    const int64_t realtime  = detail::ClockNs(CLOCK_REALTIME);
+    const int64_t monotonic = detail::ClockNs(CLOCK_MONOTONIC);
+    const uint64_t after    = Now();
+
+    if (after - before < best.window) {
+      best.ticks        = before + (after - before) / 2;
+      best.realtime_ns  = realtime;
+      best.monotonic_ns = monotonic;
+      best.window       = after - before;
+    }
+  }
+
+  return best;
+}
+
+}  // namespace rsp
@@ -0,0 +1,687 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "CaptureFormat.hpp"
+#include "Machine.hpp"
+#include "Scope.hpp"
+#include "Segments.hpp"
+#include "Slots.hpp"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace rsp {
+
+//
+// Flight recorder mode: rather than streaming everything to a sink, every
+// thread keeps its last RSP_FLIGHT_RECORDER_RECORDS scopes in its own
+// overwrite-oldest ring, and nothing is written until something asks for a
+// dump - an API call, a signal, or a crash.
+//
+// Recording a scope is a copy into the calling thread's ring: no queue, no
+// sink thread, no locks. Rings are claimed on a thread's first scope and
+// never freed; when a thread exits its ring (and what's in it) is handed to
+// the next new thread, so churning threads don't grow memory.
+//
+// Dump() only uses open/write/close on preallocated memory, so it is safe to
+// call from a signal handler - including a fatal one, which is the point. A
+// thread that is interrupted mid-record just loses that one record (each
+// slot carries a seqlock style sequence).
+//
+// The handlers run on an alternate signal stack, so that a stack overflow
+// can still be dumped. Each thread that records (and the one that sets the
+// recorder up) gets one of RSP_FLIGHT_RECORDER_SIGNAL_STACK bytes, unless
+// it already has its own; a thread that never records a scope overflows
+// without a dump.
+//
+// Dump file layout (little endian):
+//
+//   "RSPFLT01"
+//   [uint32 version][uint32 reason: the signal number, or 0 for an API call]
+//   [uint64 ticks at the time of the dump]
+//   capture header, as in CaptureFormat.hpp ("RSPCAP01"...)
+//   records, oldest first per thread:
+//     [uint64 thread id][uint64 ticks_start][uint64 ticks_end]
+//     [uint8 len][tag]
+//     [uint8 record kind][uint64 value]   (see RecordKind in Scope.hpp)
+//     [uint64 flow id]
+//     [uint64 cycles][uint64 instructions][uint64 llc misses][uint64 branch misses]
+//                                          (see PerfCounts in Scope.hpp)
+//     [uint8 allocations tracked][uint64 count][uint64 bytes][uint64 self count][uint64 self bytes]
+//                                          (see ScopeAllocations in Scope.hpp)
+//     [uint8 rusage sampled][uint64 voluntary switches][uint64 involuntary switches]
+//     [uint64 minor faults][uint64 major faults]
+//                                          (see ResourceUsage in Scope.hpp)
+//     [uint8 metadata count]
+//     per metadata: [uint8 len][key][uint8 type][8 byte value]
+//                   [uint16 len][text] if the type is STRING_ID
+//                                          (typed metadata fields first, see MetadataSchema.hpp)
+//
+// Version 1 dumps predate event records and have no kind or value, version
+// 2 dumps have no flow id, version 3 dumps no perf counters, version 4
+// dumps no allocation counts, version 5 dumps no resource usage and version
+// 6 dumps no interned string text.
+//
+
+#if !defined(RSP_FLIGHT_RECORDER_RECORDS)
+#define RSP_FLIGHT_RECORDER_RECORDS 4096
+#endif
+
+#if !defined(RSP_FLIGHT_RECORDER_MAX_THREADS)
+#define RSP_FLIGHT_RECORDER_MAX_THREADS 256
+#endif
+
+#if !defined(RSP_FLIGHT_RECORDER_SIGNAL_STACK)
+#define RSP_FLIGHT_RECORDER_SIGNAL_STACK (64 * 1024)
+#endif
+
+static_assert((RSP_FLIGHT_RECORDER_RECORDS & (RSP_FLIGHT_RECORDER_RECORDS - 1)) == 0,
+              "RSP_FLIGHT_RECORDER_RECORDS must be a power of two");
+
+inline constexpr std::array<char, 8> kFlightDumpMagic = {'R', 'S', 'P', 'F', 'L', 'T', '0', '1'};
+inline constexpr uint32_t kFlightDumpVersion          = 7;
+
+struct FlightRecorderOptions {
+  //
+  // Dump (and carry on) on this signal; 0 for none.
+  //
+  int dump_signal = SIGUSR2;
+
+  //
+  // Dump on SIGSEGV, SIGBUS, SIGILL, SIGFPE and SIGABRT, then hand the
+  // signal on to whatever handler was there before us.
+  //
+  bool dump_on_crash = true;
+};
+
+namespace detail {
+
+struct FlightRecordData {
+  uint64_t thread_id;
+  uint64_t ticks_start;
+  uint64_t ticks_end;
+  uint64_t value;
+  uint64_t flow;
+  PerfCounts perf;
+  ScopeAllocations allocs;
+  ResourceUsage rusage;
+  RecordKind kind;
+  uint8_t metadata_count;
+  char tag[RSP_SCOPE_TAG_SIZE];
+
+  struct Metadata {
+    char key[RSP_SCOPE_METADATA_TAG_SIZE];
+    uint8_t type;
+    std::array<std::byte, MetadataEntry::MAX_METADATA_DATA_SIZE_BYTES> data;
+  } metadata[RSP_MAX_METADATA_ENTRIES];
+
+  //
+  // Typed metadata stays packed until a dump spells it out. Schemas are
+  // static, so the pointer outlives any record.
+  //
+
+  const MetadataSchema *schema;
+  std::array<std::byte, RSP_TYPED_METADATA_SIZE> typed;
+};
+
+struct FlightRecord {
+  //
+  // 2n + 1 while the n'th record of the ring is being written, 2n + 2 once
+  // it's complete.
+  //
+  std::atomic<uint64_t> seq = 0;
+  FlightRecordData data;
+};
+
+struct FlightRing {
+  enum : uint32_t { OWNED = 1, RETIRED = 2 };
+
+  std::atomic<uint32_t> state = OWNED;
+  std::atomic<uint64_t> head  = 0;
+  FlightRecord records[RSP_FLIGHT_RECORDER_RECORDS];
+};
+
+//
+// Every ring ever claimed. Constant initialized, so a signal handler can
+// walk it at any time.
+//
+
+inline std::array<std::atomic<FlightRing *>, RSP_FLIGHT_RECORDER_MAX_THREADS> g_flight_rings = {};
+
+//
+// Scopes dropped because every ring was taken.
+//
+
+inline std::atomic<uint64_t> g_flight_dropped = 0;
+
+inline uint64_t CurrentThreadId() {
+#if defined(__linux__)
+  return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+  return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pthread_self()));
+#endif
+}
+
+inline FlightRing *ClaimFlightRing() {
+  //
+  // Prefer a fresh ring, so that what dead threads left behind survives as
+  // long as possible.
+  //
+
+  for (auto &slot : g_flight_rings) {
+    if (slot.load(std::memory_order_acquire) == nullptr) {
+      auto ring            = std::make_unique<FlightRing>();
+      FlightRing *expected = nullptr;
+      if (slot.compare_exchange_strong(expected, ring.get(), std::memory_order_acq_rel)) {
+        return ring.release();
+      }
+    }
+  }
+
+  for (auto &slot : g_flight_rings) {
+    FlightRing *ring  = slot.load(std::memory_order_acquire);
+    uint32_t expected = FlightRing::RETIRED;
+    if (ring && ring->state.compare_exchange_strong(expected, FlightRing::OWNED, std::memory_order_acq_rel)) {
+      return ring;
+    }
+  }
+
+  return nullptr;
+}
+
+//
+// The calling thread's alternate signal stack (see above), set up on first
+// use and taken down when the thread exits.
+//
+
+class SignalStack {
+public:
+  SignalStack() {
+    stack_t current = {};
+    if (sigaltstack(nullptr, &current) != 0 || !(current.ss_flags & SS_DISABLE)) {
+      return;
+    }
+
+    memory_ = static_cast<char *>(std::malloc(RSP_FLIGHT_RECORDER_SIGNAL_STACK));
+    if (!memory_) {
+      return;
+    }
+
+    stack_t stack  = {};
+    stack.ss_sp    = memory_;
+    stack.ss_size  = RSP_FLIGHT_RECORDER_SIGNAL_STACK;
+    stack.ss_flags = 0;
+    if (sigaltstack(&stack, nullptr) != 0) {
+      std::free(memory_);
+      memory_ = nullptr;
+    }
+  }
+
+  SignalStack(const SignalStack &)            = delete;
+  SignalStack &operator=(const SignalStack &) = delete;
+
+  ~SignalStack() {
+    if (!memory_) {
+      return;
+    }
+
+    stack_t current = {};
+    if (sigaltstack(nullptr, &current) != 0) {
+      return;
+    }
+
+    if (current.ss_sp == memory_) {
+      if (current.ss_flags & SS_ONSTACK) {
+        return;
+      }
+      stack_t disable  = {};
+      disable.ss_flags = SS_DISABLE;
+      sigaltstack(&disable, nullptr);
+    }
+    std::free(memory_);
+  }
+
+private:
+  char *memory_ = nullptr;
+};
+
+inline void EnsureSignalStack() {
+  thread_local SignalStack stack;
+}
+
+struct FlightRingHandle {
+  FlightRing *ring   = nullptr;
+  uint64_t thread_id = 0;
+  bool claimed       = false;
+
+  ~FlightRingHandle() {
+    if (ring) {
+      ring->state.store(FlightRing::RETIRED, std::memory_order_release);
+    }
+  }
+};
+
+inline FlightRingHandle *LocalFlightRing() {
+  thread_local FlightRingHandle handle;
+  if (!handle.claimed) {
+    handle.claimed   = true;
+    handle.ring      = ClaimFlightRing();
+    handle.thread_id = CurrentThreadId();
+    EnsureSignalStack();
+  }
+  return &handle;
+}
+
+inline void CopyTag(char *dst, const char *src, size_t size) {
+  std::memcpy(dst, src, size);
+  dst[size - 1] = '\0';
+}
+
+inline size_t TagLength(const char *s, size_t size) {
+  size_t n = 0;
+  while (n < size && s[n] != '\0') {
+    ++n;
+  }
+  return n;
+}
+
+//
+// Buffered writes to a file descriptor, using only write(2).
+//
+
+class SignalSafeWriter {
+public:
+  SignalSafeWriter(int fd, uint8_t *buf, size_t size) : fd_(fd), buf_(buf), size_(size) {
+  }
+
+  void Put(const void *data, size_t len) {
+    const auto *p = static_cast<const uint8_t *>(data);
+    while (len > 0) {
+      if (len_ == size_) {
+        Flush();
+      }
+      const size_t n = len < size_ - len_ ? len : size_ - len_;
+      std::memcpy(buf_ + len_, p, n);
+      len_ += n;
+      p += n;
+      len -= n;
+    }
+  }
+
+  template <typename T>
+  void PutLE(T v) {
+    uint8_t bytes[sizeof(T)];
+    SetLE<T>(bytes, v);
+    Put(bytes, sizeof(T));
+  }
+
+  bool Flush() {
+    size_t done = 0;
+    while (done < len_) {
+      const ssize_t n = ::write(fd_, buf_ + done, len_ - done);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        ok_ = false;
+        break;
+      }
+      done += static_cast<size_t>(n);
+    }
+    len_ = 0;
+    return ok_;
+  }
+
+private:
+  int fd_;
+  uint8_t *buf_;
+  size_t size_;
+  size_t len_ = 0;
+  bool ok_    = true;
+};
+
+}  // namespace detail
+
+class FlightRecorder {
+public:
+  FlightRecorder(std::filesystem::path path, Machine *machine, FlightRecorderOptions options = {})
+      : machine_(machine),
+        path_(path.string()),
+        capture_header_(MakeCaptureHeader(machine)),
+        buffer_(new uint8_t[kBufferSize]) {
+    detail::EnsureSignalStack();
+    InstallSignalHandlers(options);
+  }
+
+  FlightRecorder(const FlightRecorder &)            = delete;
+  FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+  ~FlightRecorder() {
+    RemoveSignalHandlers();
+  }
+
+  void Sink(const ScopeInfo &info) {
+    auto *local = detail::LocalFlightRing();
+    if (!local->ring) {
+      detail::g_flight_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    auto *ring       = local->ring;
+    const uint64_t n = ring->head.load(std::memory_order_relaxed);
+    auto &record     = ring->records[n & (RSP_FLIGHT_RECORDER_RECORDS - 1)];
+
+    record.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto &data       = record.data;
+    data.thread_id   = local->thread_id;
+    data.ticks_start = info.ticks_start;
+    data.ticks_end   = info.ticks_end;
+    data.value       = info.value;
+    data.flow        = info.flow;
+    data.perf        = info.perf;
+    data.allocs      = info.allocs;
+    data.rusage      = info.rusage;
+    data.kind        = info.kind;
+    detail::CopyTag(data.tag, info.tag.c_str(), sizeof(data.tag));
+
+    //
+    // Only the inline entries fit in a record; spilled ones are dropped.
+    //
+
+    const uint8_t count = info.metadata_ptr ? info.metadata_ptr->metadata_idx : 0;
+    data.metadata_count = count;
+    for (uint8_t i = 0; i < count; ++i) {
+      const auto &m = info.metadata_ptr->metadata[i];
+      detail::CopyTag(data.metadata[i].key, m.tag.c_str(), sizeof(data.metadata[i].key));
+      data.metadata[i].type = static_cast<uint8_t>(m.type);
+      data.metadata[i].data = m.data;
+    }
+
+    data.schema = info.metadata_ptr ? info.metadata_ptr->schema : nullptr;
+    if (data.schema) {
+      std::memcpy(data.typed.data(), info.metadata_ptr->typed.data(), data.schema->size);
+    }
+
+    record.seq.store(2 * n + 2, std::memory_order_release);
+    ring->head.store(n + 1, std::memory_order_release);
+  }
+
+  bool OK() const {
+    return !path_.empty();
+  }
+
+  //
+  // Called in a forked child (see Profiler::EnableForkFollowing): from here
+  // on dumps go to PerProcessPath(), and say they came from the child, so
+  // that a child crashing never overwrites its parent's dump. The rings,
+  // with the parent's history up to the fork, are kept; the forking thread
+  // carries on in its own, under its new thread id.
+  //
+
+  void AfterFork(pid_t pid) {
+    path_           = PerProcessPath(path_, pid).string();
+    capture_header_ = MakeCaptureHeader(machine_);
+    dumping_.store(false, std::memory_order_release);
+
+    detail::LocalFlightRing()->thread_id = detail::CurrentThreadId();
+  }
+
+  //
+  // Writes every thread's ring to the configured path (replacing it).
+  // Returns false if the file couldn't be written, or another dump was
+  // already in progress.
+  //
+
+  bool Dump() {
+    return Dump(path_.c_str(), 0);
+  }
+
+  //
+  // Async-signal-safe; `reason` is recorded in the dump (the signal number,
+  // by convention).
+  //
+
+  bool Dump(const char *path, int reason) {
+    if (dumping_.exchange(true, std::memory_order_acquire)) {
+      return false;
+    }
+
+    const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      dumping_.store(false, std::memory_order_release);
+      return false;
+    }
+
+    detail::SignalSafeWriter out(fd, buffer_.get(), kBufferSize);
+    out.Put(kFlightDumpMagic.data(), kFlightDumpMagic.size());
+    out.PutLE<uint32_t>(kFlightDumpVersion);
+    out.PutLE<uint32_t>(static_cast<uint32_t>(reason));
+    out.PutLE<uint64_t>(Now());
+    out.Put(capture_header_.data(), capture_header_.size());
+
+    for (auto &slot : detail::g_flight_rings) {
+      if (const auto *ring = slot.load(std::memory_order_acquire)) {
+        DumpRing(ring, &out);
+      }
+    }
+
+    const bool ok = out.Flush();
+    ::close(fd);
+
+    dumping_.store(false, std::memory_order_release);
+    return ok;
+  }
+
+  //
+  // Scopes lost because more than RSP_FLIGHT_RECORDER_MAX_THREADS threads
+  // were recording at once.
+  //
+
+  static uint64_t Dropped() {
+    return detail::g_flight_dropped.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr size_t kBufferSize = 64 * 1024;
+
+  static constexpr std::array<int, 5> kCrashSignals = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+
+  void DumpRing(const detail::FlightRing *ring, detail::SignalSafeWriter *out) {
+    const uint64_t head  = ring->head.load(std::memory_order_acquire);
+    const uint64_t first = head > RSP_FLIGHT_RECORDER_RECORDS ? head - RSP_FLIGHT_RECORDER_RECORDS : 0;
+
+    for (uint64_t n = first; n < head; ++n) {
+      const auto &record = ring->records[n & (RSP_FLIGHT_RECORDER_RECORDS - 1)];
+
+      //
+      // The owner may still be writing (or may be the thread we interrupted),
+      // so take a copy and only keep it if the sequence didn't move.
+      //
+
+      if (record.seq.load(std::memory_order_acquire) != 2 * n + 2) {
+        continue;
+      }
+      std::memcpy(&scratch_, &record.data, sizeof(scratch_));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (record.seq.load(std::memory_order_relaxed) != 2 * n + 2) {
+        continue;
+      }
+
+      const auto &d = scratch_;
+      out->PutLE<uint64_t>(d.thread_id);
+      out->PutLE<uint64_t>(d.ticks_start);
+      out->PutLE<uint64_t>(d.ticks_end);
+
+      const auto tag_len = static_cast<uint8_t>(detail::TagLength(d.tag, sizeof(d.tag)));
+      out->PutLE<uint8_t>(tag_len);
+      out->Put(d.tag, tag_len);
+
+      out->PutLE<uint8_t>(static_cast<uint8_t>(d.kind));
+      out->PutLE<uint64_t>(d.value);
+      out->PutLE<uint64_t>(d.flow);
+      out->PutLE<uint64_t>(d.perf.cycles);
+      out->PutLE<uint64_t>(d.perf.instructions);
+      out->PutLE<uint64_t>(d.perf.llc_misses);
+      out->PutLE<uint64_t>(d.perf.branch_misses);
+      out->PutLE<uint8_t>(d.allocs.tracked ? 1 : 0);
+      out->PutLE<uint64_t>(d.allocs.inclusive.count);
+      out->PutLE<uint64_t>(d.allocs.inclusive.bytes);
+      out->PutLE<uint64_t>(d.allocs.exclusive.count);
+      out->PutLE<uint64_t>(d.allocs.exclusive.bytes);
+      out->PutLE<uint8_t>(d.rusage.sampled ? 1 : 0);
+      out->PutLE<uint64_t>(d.rusage.voluntary_switches);
+      out->PutLE<uint64_t>(d.rusage.involuntary_switches);
+      out->PutLE<uint64_t>(d.rusage.minor_faults);
+      out->PutLE<uint64_t>(d.rusage.major_faults);
+
+      //
+      // The string table is lock free to read, so this is fine from a
+      // signal handler.
+      //
+
+      const auto put_text = [out](MetadataType type, const std::byte *data) {
+        if (type != MetadataType::STRING_ID) {
+          return;
+        }
+        uint32_t id;
+        std::memcpy(&id, data, sizeof(id));
+        const auto text = StringTable::Instance().Get(id).substr(0, UINT16_MAX);
+        out->PutLE<uint16_t>(static_cast<uint16_t>(text.size()));
+        out->Put(text.data(), text.size());
+      };
+
+      const uint8_t count = d.metadata_count <= RSP_MAX_METADATA_ENTRIES ? d.metadata_count : 0;
+      const uint8_t typed = d.schema ? d.schema->field_count : 0;
+      out->PutLE<uint8_t>(static_cast<uint8_t>(typed + count));
+      for (uint8_t i = 0; i < typed; ++i) {
+        const auto &field  = d.schema->fields[i];
+        const auto key_len = static_cast<uint8_t>(detail::TagLength(field.name, RSP_SCOPE_METADATA_TAG_SIZE - 1));
+
+        std::array<std::byte, MetadataEntry::MAX_METADATA_DATA_SIZE_BYTES> value = {};
+        std::memcpy(value.data(), d.typed.data() + field.offset, field.size);
+        out->PutLE<uint8_t>(key_len);
+        out->Put(field.name, key_len);
+        out->PutLE<uint8_t>(static_cast<uint8_t>(field.type));
+        out->Put(value.data(), value.size());
+        put_text(field.type, value.data());
+      }
+      for (uint8_t i = 0; i < count; ++i) {
+        const auto &m      = d.metadata[i];
+        const auto key_len = static_cast<uint8_t>(detail::TagLength(m.key, sizeof(m.key)));
+        out->PutLE<uint8_t>(key_len);
+        out->Put(m.key, key_len);
+        out->PutLE<uint8_t>(m.type);
+        out->Put(m.data.data(), m.data.size());
+        put_text(static_cast<MetadataType>(m.type), m.data.data());
+      }
+    }
+  }
+
+  //
+  // Only one recorder owns the signal handlers at a time.
+  //
+
+  static inline std::atomic<FlightRecorder *> active_ = nullptr;
+  static inline struct sigaction previous_[NSIG]  = {};
+
+  static void OnDumpSignal(int sig) {
+    const int saved_errno = errno;
+    if (auto *recorder = active_.load(std::memory_order_acquire)) {
+      recorder->Dump(recorder->path_.c_str(), sig);
+    }
+    errno = saved_errno;
+  }
+
+  static void OnCrashSignal(int sig) {
+    OnDumpSignal(sig);
+
+    //
+    // Put back whatever was there before and let it have the signal: a
+    // fault re-triggers on return, anything else we re-raise.
+    //
+
+    sigaction(sig, &previous_[sig], nullptr);
+    raise(sig);
+  }
+
+  void InstallSignalHandlers(const FlightRecorderOptions &options) {
+    FlightRecorder *expected = nullptr;
+    if (!active_.compare_exchange_strong(expected, this, std::memory_order_acq_rel)) {
+      return;
+    }
+
+    struct sigaction action = {};
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART | SA_ONSTACK;
+
+    if (options.dump_signal > 0 && options.dump_signal < NSIG) {
+      action.sa_handler = &FlightRecorder::OnDumpSignal;
+      if (sigaction(options.dump_signal, &action, &previous_[options.dump_signal]) == 0) {
+        installed_.push_back(options.dump_signal);
+      }
+    }
+
+    if (options.dump_on_crash) {
+      action.sa_handler = &FlightRecorder::OnCrashSignal;
+      for (int sig : kCrashSignals) {
+        if (sigaction(sig, &action, &previous_[sig]) == 0) {
+          installed_.push_back(sig);
+        }
+      }
+    }
+  }
+
+  void RemoveSignalHandlers() {
+    if (active_.load(std::memory_order_acquire) != this) {
+      return;
+    }
+
+    for (int sig : installed_) {
+      sigaction(sig, &previous_[sig], nullptr);
+    }
+    active_.store(nullptr, std::memory_order_release);
+  }
+
+  Machine *machine_;
+  std::string path_;
+  std::vector<uint8_t> capture_header_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  detail::FlightRecordData scratch_;
+  std::atomic<bool> dumping_ = false;
+  std::vector<int> installed_;
+};
+
+}  // namespace rsp
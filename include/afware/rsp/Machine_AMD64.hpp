@@ -51,6 +51,20 @@ inline uint64_t Now() {
   return ((uint64_t)hi << 32) | lo;
 }
 
+//
+// Read a hardware performance counter from userspace (RDPMC). Only valid for
+// a counter the kernel has handed us through a perf_event mmap page (see
+// PerfCounters.hpp), otherwise it faults.
+//
+
+inline constexpr bool kHaveUserPmc = true;
+
+inline uint64_t ReadPmc(uint32_t counter) {
+  unsigned lo, hi;
+  __asm__ __volatile__("rdpmc" : "=a"(lo), "=d"(hi) : "c"(counter));
+  return ((uint64_t)hi << 32) | lo;
+}
+
 //
 // Detect an invariant TSC.
 //
@@ -171,6 +185,14 @@ public:
     return nominal_tsc_hz_;
   }
 
+  //
+  // What the ticks in a capture are counting, recorded in its header.
+  //
+
+  const char *GetClockSource() const {
+    return "tsc (lfence; rdtsc, invariant)";
+  }
+
 private:
   bool tsc_invar_          = false;
   uint64_t nominal_tsc_hz_ = 0;
@@ -52,6 +52,17 @@ inline uint64_t Now() {
   return v;
 }
 
+//
+// Userspace PMU access (PMUSERENR_EL0) is rarely enabled, so perf counters
+// are always read through the kernel here (see PerfCounters.hpp).
+//
+
+inline constexpr bool kHaveUserPmc = false;
+
+inline uint64_t ReadPmc(uint32_t) {
+  return 0;
+}
+
 //
 // Read CNTFRQ_EL0 (counter frequency, ticks/sec).
 //
@@ -102,6 +113,14 @@ public:
     return nominal_cnt_hz_;
   }
 
+  //
+  // What the ticks in a capture are counting, recorded in its header.
+  //
+
+  const char *GetClockSource() const {
+    return "cntvct_el0 (isb; mrs)";
+  }
+
 private:
   bool ok_                 = false;
   uint64_t nominal_cnt_hz_ = 0;
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <bit>
+#include <cstdint>
 #include <source_location>
 
 namespace rsp {
@@ -30,7 +32,37 @@ namespace rsp {
 #define RSP_CONCAT_IMPL(a, b) a##b
 #define RSP_CONCAT(a, b) RSP_CONCAT_IMPL(a, b)
 
-#define RSP_SCOPE_IMPL(TAG_STR) ::rsp::ActiveScope RSP_CONCAT(_active_scope_, __COUNTER__)(TAG_STR)
+//
+// Scope levels, for compile time stripping with RSP_MAX_LEVEL (see
+// CallSites.hpp). RSP_SCOPE and RSP_CATEGORY_SCOPE are RSP_LEVEL_DEFAULT.
+//
+
+#define RSP_LEVEL_ESSENTIAL 0
+#define RSP_LEVEL_DEFAULT 1
+#define RSP_LEVEL_DETAIL 2
+#define RSP_LEVEL_TRACE 3
+
+//
+// Each site gets a constant initialized CallSite (so no guard variable)
+// that the scope checks before doing anything else.
+//
+
+#define RSP_SITE_SCOPE_IMPL2(ID, LEVEL, CATEGORY, TAG_STR)                                                    \
+  static constinit ::rsp::CallSite RSP_CONCAT(_rsp_site_, ID){TAG_STR, CATEGORY, LEVEL, __FILE__, __LINE__}; \
+  ::rsp::SiteScope<::rsp::CompiledIn(LEVEL, CATEGORY)> RSP_CONCAT(_active_scope_, ID)(RSP_CONCAT(_rsp_site_, ID))
+
+#define RSP_SITE_SCOPE_IMPL(LEVEL, CATEGORY, TAG_STR) RSP_SITE_SCOPE_IMPL2(__COUNTER__, LEVEL, CATEGORY, TAG_STR)
+
+#define RSP_SCOPE_IMPL(TAG_STR) RSP_SITE_SCOPE_IMPL(RSP_LEVEL_DEFAULT, "default", TAG_STR)
+#define RSP_CATEGORY_SCOPE_IMPL(CATEGORY, TAG_STR) RSP_SITE_SCOPE_IMPL(RSP_LEVEL_DEFAULT, CATEGORY, TAG_STR)
+#define RSP_LEVEL_SCOPE_IMPL(LEVEL, CATEGORY, TAG_STR) RSP_SITE_SCOPE_IMPL(LEVEL, CATEGORY, TAG_STR)
+
+//
+// A scope whose name is only known at run time. It has no CallSite, so it
+// can't be switched off or stripped, and it skips the site registry.
+//
+
+#define RSP_DYNAMIC_SCOPE_IMPL(NAME) ::rsp::ActiveScope RSP_CONCAT(_active_scope_, __COUNTER__)(NAME)
 
 #define RSP_SCOPE_METADATA_IMPL(TAG_STR, VALUE)                      \
   do {                                                               \
@@ -41,3 +73,107 @@ namespace rsp {
   } while (0)
 
 #define RSP_FUNCTION_SCOPE_IMPL RSP_SCOPE_IMPL(::rsp::current_function());
+
+//
+// Typed metadata (see MetadataSchema.hpp). RSP_METADATA_SCHEMA(TYPE, ...)
+// names up to 16 of TYPE's fields, and goes in TYPE's namespace.
+//
+
+#define RSP_METADATA_FIELD(TYPE, FIELD) ::rsp::MetadataSchemaMember<TYPE, decltype(TYPE::FIELD)>{#FIELD, &TYPE::FIELD}
+#define RSP_METADATA_FIELDS_1(TYPE, F) RSP_METADATA_FIELD(TYPE, F)
+#define RSP_METADATA_FIELDS_2(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_1(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_3(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_2(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_4(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_3(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_5(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_4(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_6(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_5(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_7(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_6(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_8(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_7(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_9(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_8(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_10(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_9(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_11(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_10(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_12(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_11(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_13(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_12(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_14(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_13(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_15(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_14(TYPE, __VA_ARGS__)
+#define RSP_METADATA_FIELDS_16(TYPE, F, ...) RSP_METADATA_FIELD(TYPE, F), RSP_METADATA_FIELDS_15(TYPE, __VA_ARGS__)
+
+#define RSP_METADATA_NARGS_IMPL(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, ...) N
+#define RSP_METADATA_NARGS(...) RSP_METADATA_NARGS_IMPL(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+#define RSP_METADATA_FIELDS(TYPE, ...) \
+  RSP_CONCAT(RSP_METADATA_FIELDS_, RSP_METADATA_NARGS(__VA_ARGS__))(TYPE, __VA_ARGS__)
+
+#define RSP_METADATA_SCHEMA_IMPL(TYPE, ...)                                  \
+  [[maybe_unused]] constexpr auto RspMetadataFields(const TYPE *) {          \
+    return ::std::make_tuple(#TYPE, RSP_METADATA_FIELDS(TYPE, __VA_ARGS__)); \
+  }                                                                          \
+  static_assert(true, "")
+
+#define RSP_SCOPE_TYPED_METADATA_IMPL(...)               \
+  do {                                                   \
+    auto *current = ::rsp::GetScopeManager()->Current(); \
+    if (current) {                                       \
+      current->info.SetTypedMetadata(__VA_ARGS__);       \
+    }                                                    \
+  } while (0)
+
+//
+// Counter, gauge and instant events get a call site too, so they can be
+// switched at runtime like scopes. VALUE and FLOW are only evaluated when the
+// event is actually recorded.
+//
+
+#define RSP_EVENT_IMPL2(ID, KIND, TAG_STR, VALUE, FLOW)                    \
+  do {                                                                     \
+    static constinit ::rsp::CallSite RSP_CONCAT(_rsp_site_, ID){           \
+        TAG_STR, "default", RSP_LEVEL_DEFAULT, __FILE__, __LINE__};        \
+    if constexpr (::rsp::CompiledIn(RSP_LEVEL_DEFAULT, "default")) {       \
+      if (::rsp::EventEnabled(RSP_CONCAT(_rsp_site_, ID))) {               \
+        ::rsp::RecordEvent(RSP_CONCAT(_rsp_site_, ID), KIND, VALUE, FLOW); \
+      }                                                                    \
+    }                                                                      \
+  } while (0)
+
+#define RSP_EVENT_IMPL(KIND, TAG_STR, VALUE, FLOW) RSP_EVENT_IMPL2(__COUNTER__, KIND, TAG_STR, VALUE, FLOW)
+
+#define RSP_COUNTER_IMPL(TAG_STR, DELTA)                                                                     \
+  RSP_EVENT_IMPL(::rsp::RecordKind::COUNTER, TAG_STR, static_cast<uint64_t>(static_cast<int64_t>(DELTA)), \
+                 ::rsp::CurrentFlow())
+#define RSP_GAUGE_IMPL(TAG_STR, VALUE)                                                                        \
+  RSP_EVENT_IMPL(::rsp::RecordKind::GAUGE, TAG_STR, ::std::bit_cast<uint64_t>(static_cast<double>(VALUE)), \
+                 ::rsp::CurrentFlow())
+#define RSP_INSTANT_IMPL(TAG_STR) \
+  RSP_EVENT_IMPL(::rsp::RecordKind::INSTANT, TAG_STR, uint64_t{0}, ::rsp::CurrentFlow())
+
+//
+// Flows. RSP_FLOW (or RSP_FLOW_DEQUEUE, on the consumer side of a queue) tags
+// everything the thread records until the end of the enclosing block with
+// FLOW. RSP_FLOW_ENQUEUE marks FLOW being handed to QUEUE_STR, and
+// RSP_SCOPE_FLOW tags just the current scope.
+//
+
+#define RSP_FLOW_IMPL(FLOW) ::rsp::FlowGuard RSP_CONCAT(_rsp_flow_, __COUNTER__)(FLOW)
+#define RSP_FLOW_DEQUEUE_IMPL(FLOW) RSP_FLOW_IMPL(FLOW)
+#define RSP_FLOW_ENQUEUE_IMPL(QUEUE_STR, FLOW) \
+  RSP_EVENT_IMPL(::rsp::RecordKind::INSTANT, QUEUE_STR, uint64_t{0}, static_cast<uint64_t>(FLOW))
+
+#define RSP_SCOPE_FLOW_IMPL(FLOW)                        \
+  do {                                                   \
+    auto *current = ::rsp::GetScopeManager()->Current(); \
+    if (current) {                                       \
+      current->info.flow = static_cast<uint64_t>(FLOW);  \
+    }                                                    \
+  } while (0)
+
+//
+// Spans are expressions (so the token can be assigned anywhere), so their
+// call site lives in an immediately invoked lambda instead.
+//
+
+#define RSP_BEGIN_LEVEL_SPAN_IMPL(LEVEL, CATEGORY, TAG_STR)                              \
+  ::rsp::Span::Begin<::rsp::CompiledIn(LEVEL, CATEGORY)>([]() -> ::rsp::CallSite & {     \
+    static constinit ::rsp::CallSite site{TAG_STR, CATEGORY, LEVEL, __FILE__, __LINE__}; \
+    return site;                                                                         \
+  }())
+
+#define RSP_BEGIN_SPAN_IMPL(TAG_STR) RSP_BEGIN_LEVEL_SPAN_IMPL(RSP_LEVEL_DEFAULT, "default", TAG_STR)
+#define RSP_BEGIN_CATEGORY_SPAN_IMPL(CATEGORY, TAG_STR) RSP_BEGIN_LEVEL_SPAN_IMPL(RSP_LEVEL_DEFAULT, CATEGORY, TAG_STR)
@@ -17,9 +17,11 @@
 #pragma once
 
 #include "ConstexprString.hpp"
+#include "StringTable.hpp"
 
 #include <array>
 #include <cstring>
+#include <string_view>
 #include <type_traits>
 
 namespace rsp {
@@ -40,6 +42,7 @@ inline constexpr bool always_false_v = false;
 //
 // - Each metadata has a tag of no more than 32 bytes (using a constexpr string to avoid allocation)
 // - Each metadata value can be one of the common types below - restricting to 8 bytes maximum.
+// - Strings of up to 8 bytes are stored inline; longer ones are interned (see StringTable.hpp) and stored as an id.
 //
 
 #if !defined(RSP_SCOPE_METADATA_TAG_SIZE)
@@ -60,6 +63,8 @@ enum class MetadataType : uint8_t {
   UINT64,  // NOTE: this is the same as size_t
   DOUBLE,
   FLOAT,
+  STRING,     // Up to 8 bytes, inline and NUL padded.
+  STRING_ID,  // A StringTable id, as a uint32_t.
 };
 
 struct MetadataEntry {
@@ -153,6 +158,28 @@ inline MetadataEntry MakeScopeMetadata<double>(MetadataTag tag, double val) {
   return entry;
 }
 
+template <>
+inline MetadataEntry MakeScopeMetadata<InternedString>(MetadataTag tag, InternedString val) {
+  MetadataEntry entry{tag, MetadataType::STRING_ID};
+  std::memcpy(entry.data.data(), &val.id, sizeof(uint32_t));
+  return entry;
+}
+
+template <>
+inline MetadataEntry MakeScopeMetadata<std::string_view>(MetadataTag tag, std::string_view val) {
+  if (val.size() > MetadataEntry::MAX_METADATA_DATA_SIZE_BYTES) {
+    const uint32_t id = StringTable::Instance().Intern(val);
+    if (id != StringTable::kFull) {
+      return MakeScopeMetadata<InternedString>(tag, InternedString{id});
+    }
+    val = val.substr(0, MetadataEntry::MAX_METADATA_DATA_SIZE_BYTES);
+  }
+
+  MetadataEntry entry{tag, MetadataType::STRING};
+  std::memcpy(entry.data.data(), val.data(), val.size());
+  return entry;
+}
+
 //
 // We add a default template and route accordingly. This is mainly for
 // macOS as there's some additional fun and games due to how
@@ -170,6 +197,10 @@ inline MetadataEntry MakeScopeMetadata(MetadataTag tag, T val) {
                        std::is_same_v<U, uint64_t> || std::is_same_v<U, int64_t> || std::is_same_v<U, float> ||
                        std::is_same_v<U, double>) {
     return MakeScopeMetadata<U>(tag, val);
+  } else if constexpr (std::is_same_v<U, InternedString>) {
+    return MakeScopeMetadata<InternedString>(tag, val);
+  } else if constexpr (std::is_convertible_v<const U &, std::string_view>) {
+    return MakeScopeMetadata<std::string_view>(tag, std::string_view{val});
   } else if constexpr (std::is_enum_v<U>) {
     using E = std::underlying_type_t<U>;
     return MakeScopeMetadata<E>(tag, static_cast<E>(val));
@@ -204,4 +235,23 @@ inline MetadataEntry MakeScopeMetadata(MetadataTag tag, T val) {
   }
 }
 
+//
+// The text of a STRING or STRING_ID entry.
+//
+
+inline uint32_t MetadataStringId(const MetadataEntry &m) {
+  uint32_t id;
+  std::memcpy(&id, m.data.data(), sizeof(id));
+  return id;
+}
+
+inline std::string_view MetadataString(const MetadataEntry &m) {
+  if (m.type == MetadataType::STRING_ID) {
+    return StringTable::Instance().Get(MetadataStringId(m));
+  }
+
+  const std::string_view chars{reinterpret_cast<const char *>(m.data.data()), m.data.size()};
+  return chars.substr(0, chars.find('\0'));
+}
+
 }  // namespace rsp
@@ -0,0 +1,261 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "Metadata.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace rsp {
+
+//
+// Typed metadata schemas.
+//
+// Every RSP_SCOPE_METADATA stores a 32 byte tag and a type next to its 8
+// byte value. For a scope whose metadata is always the same handful of
+// fields, declare them once as a struct instead - in the struct's own
+// namespace, as the schema is found by argument dependent lookup:
+//
+//   struct RequestMetadata {
+//     uint32_t bytes;
+//     int32_t status;
+//     double ratio;
+//   };
+//
+//   RSP_METADATA_SCHEMA(RequestMetadata, bytes, status, ratio);
+//
+// and set them all at once:
+//
+//   RSP_SCOPE("Handle request");
+//   RSP_SCOPE_TYPED_METADATA(RequestMetadata{bytes, 200, ratio});
+//
+// Field names, types and offsets are all worked out at compile time. The
+// scope keeps a pointer to the schema and the values packed back to back -
+// 16 bytes here, against three full entries - and packing them is a few
+// stores. The block sink writes each schema once per block and after that
+// only the values; the other formats spell the fields out as ordinary
+// metadata, so readers see the same thing either way.
+//
+// A scope holds one typed value (setting it again replaces it), alongside
+// any untyped metadata. Fields can be integers, floats, bools, enums and
+// rsp::InternedString handles (see rsp::Intern). A schema has at most
+// RSP_MAX_METADATA_SCHEMA_FIELDS fields, RSP_TYPED_METADATA_SIZE bytes once
+// packed.
+//
+
+#if !defined(RSP_MAX_METADATA_SCHEMA_FIELDS)
+#define RSP_MAX_METADATA_SCHEMA_FIELDS 16
+#endif
+
+#if !defined(RSP_TYPED_METADATA_SIZE)
+#define RSP_TYPED_METADATA_SIZE 64
+#endif
+
+//
+// The metadata type a field of type T is stored as, routed the same way as
+// MakeScopeMetadata.
+//
+
+template <typename T>
+constexpr MetadataType MetadataTypeOf() {
+  using U = std::remove_cv_t<T>;
+
+  if constexpr (std::is_same_v<U, bool>) {
+    return MetadataType::UINT8;
+  } else if constexpr (std::is_same_v<U, InternedString>) {
+    return MetadataType::STRING_ID;
+  } else if constexpr (std::is_enum_v<U>) {
+    return MetadataTypeOf<std::underlying_type_t<U>>();
+  } else if constexpr (std::is_same_v<U, float>) {
+    return MetadataType::FLOAT;
+  } else if constexpr (std::is_same_v<U, double>) {
+    return MetadataType::DOUBLE;
+  } else if constexpr (std::is_integral_v<U> && sizeof(U) == 1) {
+    return std::is_signed_v<U> ? MetadataType::INT8 : MetadataType::UINT8;
+  } else if constexpr (std::is_integral_v<U> && sizeof(U) == 2) {
+    return std::is_signed_v<U> ? MetadataType::INT16 : MetadataType::UINT16;
+  } else if constexpr (std::is_integral_v<U> && sizeof(U) == 4) {
+    return std::is_signed_v<U> ? MetadataType::INT32 : MetadataType::UINT32;
+  } else if constexpr (std::is_integral_v<U> && sizeof(U) == 8) {
+    return std::is_signed_v<U> ? MetadataType::INT64 : MetadataType::UINT64;
+  } else {
+    static_assert(detail::always_false_v<U>, "MetadataTypeOf: unsupported field type");
+  }
+}
+
+template <MetadataType>
+struct MetadataCType;
+
+template <>
+struct MetadataCType<MetadataType::INT8> {
+  using type = int8_t;
+};
+
+template <>
+struct MetadataCType<MetadataType::UINT8> {
+  using type = uint8_t;
+};
+
+template <>
+struct MetadataCType<MetadataType::INT16> {
+  using type = int16_t;
+};
+
+template <>
+struct MetadataCType<MetadataType::UINT16> {
+  using type = uint16_t;
+};
+
+template <>
+struct MetadataCType<MetadataType::INT32> {
+  using type = int32_t;
+};
+
+template <>
+struct MetadataCType<MetadataType::UINT32> {
+  using type = uint32_t;
+};
+
+template <>
+struct MetadataCType<MetadataType::INT64> {
+  using type = int64_t;
+};
+
+template <>
+struct MetadataCType<MetadataType::UINT64> {
+  using type = uint64_t;
+};
+
+template <>
+struct MetadataCType<MetadataType::FLOAT> {
+  using type = float;
+};
+
+template <>
+struct MetadataCType<MetadataType::DOUBLE> {
+  using type = double;
+};
+
+template <>
+struct MetadataCType<MetadataType::STRING_ID> {
+  using type = uint32_t;
+};
+
+struct MetadataSchemaField {
+  const char *name    = "";
+  MetadataType type   = MetadataType::UNSET;
+  uint8_t offset      = 0;
+  uint8_t size        = 0;
+};
+
+struct MetadataSchema {
+  const char *name    = "";
+  uint8_t field_count = 0;
+  uint8_t size        = 0;
+  std::array<MetadataSchemaField, RSP_MAX_METADATA_SCHEMA_FIELDS> fields = {};
+
+  //
+  // Field i of a packed value, spelled out as an ordinary metadata entry.
+  //
+
+  MetadataEntry Entry(const std::byte *packed, size_t i) const {
+    MetadataEntry m{MetadataTag{fields[i].name}, fields[i].type};
+    std::memcpy(m.data.data(), packed + fields[i].offset, fields[i].size);
+    return m;
+  }
+};
+
+//
+// What RSP_METADATA_SCHEMA declares for each field.
+//
+
+template <typename Struct, typename Member>
+struct MetadataSchemaMember {
+  const char *name;
+  Member Struct::*ptr;
+};
+
+namespace detail {
+
+template <typename... Members>
+constexpr MetadataSchema BuildMetadataSchema(const char *name, Members... members) {
+  static_assert(sizeof...(Members) > 0, "A metadata schema needs at least one field");
+  static_assert(sizeof...(Members) <= RSP_MAX_METADATA_SCHEMA_FIELDS, "Too many fields in a metadata schema");
+
+  MetadataSchema schema;
+  schema.name = name;
+
+  size_t offset = 0;
+  auto add      = [&]<typename Struct, typename Member>(const MetadataSchemaMember<Struct, Member> &member) {
+    constexpr MetadataType type = MetadataTypeOf<Member>();
+    constexpr size_t size       = sizeof(typename MetadataCType<type>::type);
+
+    schema.fields[schema.field_count++] = MetadataSchemaField{member.name, type, static_cast<uint8_t>(offset),
+                                                              static_cast<uint8_t>(size)};
+    offset += size;
+  };
+  (add(members), ...);
+
+  schema.size = static_cast<uint8_t>(offset);
+  return schema;
+}
+
+template <typename Member>
+inline void PackMetadataField(const Member &value, std::byte *out) {
+  if constexpr (std::is_same_v<Member, InternedString>) {
+    std::memcpy(out, &value.id, sizeof(value.id));
+  } else {
+    using C       = typename MetadataCType<MetadataTypeOf<Member>()>::type;
+    const C field = static_cast<C>(value);
+    std::memcpy(out, &field, sizeof(C));
+  }
+}
+
+}  // namespace detail
+
+//
+// RSP_METADATA_SCHEMA(T, ...) defines RspMetadataFields(const T *), returning
+// the struct's name and its fields.
+//
+
+template <typename T>
+inline constexpr auto kMetadataFields = RspMetadataFields(static_cast<const T *>(nullptr));
+
+template <typename T>
+inline constexpr MetadataSchema kMetadataSchema = std::apply(
+    [](const char *name, auto... members) { return detail::BuildMetadataSchema(name, members...); },
+    kMetadataFields<T>);
+
+template <typename T>
+inline void PackMetadata(const T &value, std::byte *out) {
+  static_assert(kMetadataSchema<T>.size <= RSP_TYPED_METADATA_SIZE,
+                "Metadata schema is larger than RSP_TYPED_METADATA_SIZE");
+
+  [&]<size_t... I>(std::index_sequence<I...>) {
+    (detail::PackMetadataField(value.*(std::get<I + 1>(kMetadataFields<T>).ptr),
+                               out + kMetadataSchema<T>.fields[I].offset),
+     ...);
+  }(std::make_index_sequence<kMetadataSchema<T>.field_count>{});
+}
+
+}  // namespace rsp
@@ -0,0 +1,271 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "Machine.hpp"
+#include "Scope.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#define RSP_HAVE_PERF_EVENTS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace rsp {
+
+//
+// Hardware performance counters over scopes.
+//
+// With perf counters enabled (rsp::EnablePerfCounters()), each thread opens
+// one perf_event group the first time it enters a scope: cycles (the group
+// leader), instructions, last level cache misses and branch mispredictions,
+// counted in user space only. Every scope reads the group on entry and on
+// exit and stores the difference in ScopeInfo::perf.
+//
+// Reads are done with RDPMC straight from user space when the kernel allows
+// it (the mmap page advertises cap_user_rdpmc and the counter is currently
+// on the PMU), which costs a few dozen cycles per counter. Otherwise, e.g.
+// on ARM64 or with rdpmc disabled, it's one read() of the whole group per
+// scope edge - a system call, so expect scopes to get noticeably heavier.
+//
+// The group is scheduled on the PMU all or nothing, so the four counters are
+// always consistent with each other; we don't scale for multiplexing.
+//
+// Nothing here is fatal. If perf events aren't there - no PMU in the VM, a
+// container's seccomp profile, perf_event_paranoid - the group doesn't
+// open, the thread just records no counters, and scopes cost what they did.
+// An event the PMU lacks is left out of the group and reads as zero.
+//
+// Counters are per thread, so spans (which may end on another thread) and
+// event records don't carry them.
+//
+
+class PerfGroup {
+public:
+  PerfGroup() {
+    Open();
+  }
+
+  ~PerfGroup() {
+    Close();
+  }
+
+  PerfGroup(const PerfGroup &)            = delete;
+  PerfGroup &operator=(const PerfGroup &) = delete;
+
+  bool OK() const {
+    return fds_[0] >= 0;
+  }
+
+  //
+  // Counters opened before a fork() go on counting the parent's thread, so
+  // a child opens its own.
+  //
+
+  void Reopen() {
+    Close();
+    Open();
+  }
+
+  PerfCounts Read() const {
+    std::array<uint64_t, kEvents> values{};
+    if (!ReadUser(&values)) {
+      ReadKernel(&values);
+    }
+    return PerfCounts{values[0], values[1], values[2], values[3]};
+  }
+
+private:
+  static constexpr size_t kEvents = 4;
+
+#if defined(RSP_HAVE_PERF_EVENTS)
+
+  static constexpr std::array<uint64_t, kEvents> kConfigs = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES,
+  };
+
+  void Open() {
+    const long page_size = sysconf(_SC_PAGESIZE);
+
+    for (size_t i = 0; i < kEvents; ++i) {
+      perf_event_attr attr{};
+      attr.size           = sizeof(attr);
+      attr.type           = PERF_TYPE_HARDWARE;
+      attr.config         = kConfigs[i];
+      attr.disabled       = i == 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv     = 1;
+      attr.read_format    = PERF_FORMAT_GROUP;
+
+      const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, fds_[0], PERF_FLAG_FD_CLOEXEC));
+      if (fd < 0) {
+        if (i == 0) {
+          return;
+        }
+        continue;
+      }
+
+      fds_[i]   = fd;
+      slots_[i] = opened_++;
+
+      void *page = mmap(nullptr, page_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (page != MAP_FAILED) {
+        pages_[i] = static_cast<volatile perf_event_mmap_page *>(page);
+      }
+    }
+
+    ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+  void Close() {
+    const long page_size = sysconf(_SC_PAGESIZE);
+
+    for (size_t i = 0; i < kEvents; ++i) {
+      if (pages_[i]) {
+        munmap(const_cast<perf_event_mmap_page *>(pages_[i]), page_size);
+      }
+      if (fds_[i] >= 0) {
+        close(fds_[i]);
+      }
+      fds_[i]   = -1;
+      slots_[i] = -1;
+      pages_[i] = nullptr;
+    }
+    opened_ = 0;
+  }
+
+  //
+  // The seqlock protocol from the perf_event_mmap_page documentation: index
+  // is the hardware counter + 1 while the event is on the PMU (0 when it
+  // isn't), and offset brings the raw, pmc_width bit value up to the full
+  // count. Bails out to read() if any counter can't be read directly.
+  //
+
+  bool ReadUser(std::array<uint64_t, kEvents> *values) const {
+    if constexpr (!kHaveUserPmc) {
+      return false;
+    }
+
+    for (size_t i = 0; i < kEvents; ++i) {
+      if (fds_[i] < 0) {
+        continue;
+      }
+
+      const auto *page = pages_[i];
+      if (!page) {
+        return false;
+      }
+
+      uint32_t seq;
+      uint64_t count;
+      do {
+        seq = page->lock;
+        __asm__ __volatile__("" ::: "memory");
+
+        const uint32_t index = page->index;
+        const uint16_t width = page->pmc_width;
+        if (!page->cap_user_rdpmc || index == 0 || width == 0 || width > 64) {
+          return false;
+        }
+
+        int64_t pmc          = static_cast<int64_t>(ReadPmc(index - 1));
+        pmc                  = static_cast<int64_t>(static_cast<uint64_t>(pmc) << (64 - width)) >> (64 - width);
+        count                = static_cast<uint64_t>(page->offset + pmc);
+
+        __asm__ __volatile__("" ::: "memory");
+      } while (page->lock != seq);
+
+      (*values)[i] = count;
+    }
+
+    return true;
+  }
+
+  void ReadKernel(std::array<uint64_t, kEvents> *values) const {
+    std::array<uint64_t, 1 + kEvents> buf{};
+    if (read(fds_[0], buf.data(), sizeof(buf)) < static_cast<ssize_t>(sizeof(uint64_t))) {
+      return;
+    }
+
+    for (size_t i = 0; i < kEvents; ++i) {
+      if (slots_[i] >= 0 && static_cast<uint64_t>(slots_[i]) < buf[0]) {
+        (*values)[i] = buf[1 + slots_[i]];
+      }
+    }
+  }
+
+  std::array<int, kEvents> fds_{-1, -1, -1, -1};
+  std::array<int, kEvents> slots_{-1, -1, -1, -1};
+  std::array<volatile perf_event_mmap_page *, kEvents> pages_{};
+  int opened_ = 0;
+
+#else
+
+  void Open() {
+  }
+
+  void Close() {
+  }
+
+  bool ReadUser(std::array<uint64_t, kEvents> *) const {
+    return false;
+  }
+
+  void ReadKernel(std::array<uint64_t, kEvents> *) const {
+  }
+
+  std::array<int, kEvents> fds_{-1, -1, -1, -1};
+
+#endif
+};
+
+//
+// The calling thread's group, opened on first use.
+//
+
+inline PerfGroup &ThreadPerfGroup() {
+  thread_local PerfGroup group;
+  return group;
+}
+
+//
+// The same, or nullptr if perf events aren't available to the thread.
+//
+
+inline PerfGroup *GetPerfGroup() {
+  auto &group = ThreadPerfGroup();
+  return group.OK() ? &group : nullptr;
+}
+
+inline PerfCounts PerfDelta(const PerfCounts &start, const PerfCounts &end) {
+  return PerfCounts{end.cycles - start.cycles,
+                    end.instructions - start.instructions,
+                    end.llc_misses - start.llc_misses,
+                    end.branch_misses - start.branch_misses};
+}
+
+}  // namespace rsp
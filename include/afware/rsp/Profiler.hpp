@@ -16,25 +16,45 @@
 
 #pragma once
 
+#include "Allocations.hpp"
+#include "AsyncDiskSink.hpp"
+#include "BlockDiskSink.hpp"
+#include "CallSites.hpp"
+#include "ClockAnchor.hpp"
 #include "ConstexprString.hpp"
+#include "FlightRecorder.hpp"
 #include "Machine.hpp"
 #include "Macros.hpp"
+#include "PerfCounters.hpp"
+#include "ResourceUsage.hpp"
 #include "Scope.hpp"
+#include "SharedMemorySink.hpp"
 #include "Slots.hpp"
 #include "Sinks.hpp"
 #include "Queue.hpp"
+#include "ThreadPlacement.hpp"
+#include "UnixSocketSink.hpp"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <filesystem>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
+#include <pthread.h>
+#include <unistd.h>
+
 namespace rsp {
 
 //
@@ -56,8 +76,39 @@ namespace rsp {
 #define RSP_PROFILER_DEQUEUE_WAIT_MS 10
 #endif
 
+//
+// With a sink thread per NUMA node, how long a node's partially encoded
+// frame or block can wait for more records before it's written anyway.
+//
+
+#if !defined(RSP_PROFILER_IDLE_SEAL_MS)
+#define RSP_PROFILER_IDLE_SEAL_MS 1000
+#endif
+
+//
+// The most records the sink thread takes off the queue, and hands to the
+// sink, at a time.
+//
+
+#if !defined(RSP_PROFILER_SINK_BATCH)
+#define RSP_PROFILER_SINK_BATCH 256
+#endif
+
 using SlotStorage = MetadataSlotStorage<RSP_PROFILER_DEFAULT_STORAGE_SLOTS>;
 
+//
+// A point-in-time snapshot of the pipeline's internal state. None of
+// these values are exact when producers are active (the queue size in
+// particular is only approximate), but they're good enough to spot
+// backlog and slot pool growth.
+//
+
+struct ProfilerStats {
+  uint64_t records_sunk = 0;
+  size_t queue_depth    = 0;
+  size_t slot_count     = 0;
+};
+
 //
 // The profiler is a Singleton that is really just a resource
 // manager and aggregator. All of the scope-specific information
@@ -77,7 +128,7 @@ class Profiler;
 Profiler &Instance();
 
 class Profiler {
-  using SinkFunc      = std::function<void(const ScopeInfo &)>;
+  using SinkFunc      = std::function<void(std::span<const ScopeInfo>)>;
   using ProfilerQueue = moodycamel::BlockingConcurrentQueue<ScopeInfo>;
 
 public:
@@ -90,43 +141,251 @@ public:
     return machine_.OK();
   }
 
+  //
+  // Start() and Stop() bracket a session: Start() spins up the sink thread,
+  // Stop() drains the queue into the sink and joins it. Sessions can be
+  // started and stopped as many times as you like.
+  //
+
   bool Start() {
-    stop_ = false;
+    const std::scoped_lock lock{lifecycle_mutex_};
     if (!Ready()) {
       return false;
     }
 
-    this->StartSinkThread();
+    ReopenAfterFork();
+
+    if (!sink_thread_.joinable()) {
+      this->StartSinkThread();
+    }
+
+    running_.store(true, std::memory_order_release);
+    UpdateCapturing();
     return true;
   }
 
   void Stop() {
-    stop_ = true;
+    const std::scoped_lock lock{lifecycle_mutex_};
+    running_.store(false, std::memory_order_release);
+    UpdateCapturing();
+    if (sink_thread_.joinable()) {
+      RecordClockAnchor();
+    }
+    StopSinkThread();
+    if (flush_) {
+      flush_();
+    }
+  }
+
+  //
+  // Pause() and Resume() open and close capture windows within a session,
+  // without touching the sink thread. While paused a scope costs a single
+  // relaxed load: no slot, no clock reads, nothing queued. Scopes already
+  // open when we pause are still recorded.
+  //
+  // Pausing before Start() makes the session start paused.
+  //
+
+  void Pause() {
+    const std::scoped_lock lock{lifecycle_mutex_};
+    paused_.store(true, std::memory_order_release);
+    UpdateCapturing();
+  }
+
+  void Resume() {
+    const std::scoped_lock lock{lifecycle_mutex_};
+    paused_.store(false, std::memory_order_release);
+    UpdateCapturing();
+  }
+
+  bool Capturing() const {
+    return capturing_.load(std::memory_order_relaxed);
+  }
+
+  bool Paused() const {
+    return paused_.load(std::memory_order_acquire);
+  }
+
+  //
+  // Hardware counters on scopes (see PerfCounters.hpp). Enabling probes for
+  // perf events on the calling thread and returns false, leaving them off,
+  // if there aren't any.
+  //
+
+  bool EnablePerfCounters() {
+    if (!GetPerfGroup()) {
+      return false;
+    }
+
+    perf_counters_.store(true, std::memory_order_relaxed);
+    return true;
+  }
+
+  void DisablePerfCounters() {
+    perf_counters_.store(false, std::memory_order_relaxed);
+  }
+
+  bool PerfCountersEnabled() const {
+    return perf_counters_.load(std::memory_order_relaxed);
+  }
+
+  //
+  // Heap allocation counts on scopes (see Allocations.hpp). Returns false,
+  // leaving tracking off, unless AllocationHooks.hpp is compiled in.
+  //
+
+  bool EnableAllocationTracking() {
+    if (!AllocationHooksInstalled()) {
+      return false;
+    }
+
+    allocation_tracking_.store(true, std::memory_order_relaxed);
+    return true;
+  }
+
+  void DisableAllocationTracking() {
+    allocation_tracking_.store(false, std::memory_order_relaxed);
+  }
+
+  bool AllocationTrackingEnabled() const {
+    return allocation_tracking_.load(std::memory_order_relaxed);
+  }
+
+  //
+  // Context switch and page fault counts on scopes (see ResourceUsage.hpp):
+  // one in every `every` scopes on each thread, at the call sites the
+  // resource usage rules select. Returns false, leaving them off, where
+  // getrusage(RUSAGE_THREAD) isn't available.
+  //
+
+  bool EnableResourceUsage(uint32_t every = 1) {
+    ResourceUsage probe;
+    if (!ReadResourceUsage(&probe)) {
+      return false;
+    }
+
+    rusage_every_.store(every ? every : 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  void DisableResourceUsage() {
+    rusage_every_.store(0, std::memory_order_relaxed);
+  }
+
+  //
+  // 0 when off.
+  //
+
+  uint32_t ResourceUsageEvery() const {
+    return rusage_every_.load(std::memory_order_relaxed);
+  }
+
+  //
+  // What a fork()ed child does. Either way it drops what it inherited - the
+  // sink thread, which stayed in the parent, the records still queued,
+  // which are the parent's to write, and the sinks, which share files and
+  // buffered records with the parent - without flushing or joining any of
+  // it. By default it then stops profiling. Following forks, it carries on
+  // as the parent was (capturing or not) into sinks of its own: a sink
+  // with a ReopenForProcess() member is replaced by the one that returns,
+  // writing to PerProcessPath() (e.g. /tmp/app.pid4242.bin for
+  // /tmp/app.bin), and any other sink by the child's copy of it. Records
+  // carry the pid in their capture or block header, and `rsp merge` puts
+  // the processes back on one timeline.
+  //
+  // The child's sinks are only opened, and its sink thread started, on its
+  // first record or Start(), so a child that goes straight to exec() leaves
+  // no empty capture behind.
+  //
+
+  void EnableForkFollowing() {
+    follow_forks_.store(true, std::memory_order_relaxed);
+  }
+
+  void DisableForkFollowing() {
+    follow_forks_.store(false, std::memory_order_relaxed);
+  }
+
+  bool ForkFollowingEnabled() const {
+    return follow_forks_.load(std::memory_order_relaxed);
+  }
+
+  //
+  // Where the sink thread runs, and whether there's one per NUMA node (see
+  // ThreadPlacement.hpp). Takes effect when the sink thread next starts -
+  // at the next Start() after a Stop(), or now if it isn't running.
+  //
+
+  void SetSinkThreadOptions(SinkThreadOptions options) {
+    const std::scoped_lock lock{lifecycle_mutex_};
+    sink_thread_options_ = std::move(options);
+  }
+
+  //
+  // False if the sink thread(s) couldn't apply all of their options, e.g. a
+  // CPU outside the process' cpuset, or a negative nice value without
+  // CAP_SYS_NICE. Whatever could be applied still is.
+  //
+
+  bool SinkThreadPlaced() const {
+    return sink_thread_placed_.load(std::memory_order_acquire);
+  }
+
+  //
+  // Records a clock anchor (see ClockAnchor.hpp) now, on top of the
+  // periodic ones - after stepping the clock, say.
+  //
+
+  void RecordClockAnchor() {
+    const ClockAnchor anchor = ReadClockAnchor();
+
+    ScopeInfo info{ScopeTag{kClockAnchorRealtimeTag}};
+    info.ticks_start = anchor.ticks;
+    info.ticks_end   = anchor.ticks;
+    info.kind        = RecordKind::COUNTER;
+    info.value       = static_cast<uint64_t>(anchor.realtime_ns);
+    Add(info);
+
+    info.tag   = ScopeTag{kClockAnchorMonotonicTag};
+    info.value = static_cast<uint64_t>(anchor.monotonic_ns);
+    Add(info);
   }
 
   void Add(ScopeInfo scope_info) {
-    if (stop_) {
+    const UncountedAllocations uncounted;
+
+    if (stop_ && !ReopenOnFirstAdd()) {
+      GetSlotStorage()->Release(scope_info.metadata_ptr);
+      return;
+    }
+
+    //
+    // The flight recorder keeps scopes in the calling thread's ring, so
+    // the queue and the sink thread are skipped entirely.
+    //
+
+    if (auto *recorder = flight_recorder_.load(std::memory_order_acquire)) {
+      recorder->Sink(scope_info);
+      GetSlotStorage()->Release(scope_info.metadata_ptr);
       return;
     }
 
-    queue_.enqueue(std::move(scope_info));
+    ProducerQueue().enqueue(std::move(scope_info));
   }
 
   //
   // We deal with sinks this way - all explicit and gross-like - to avoid
-  // inheritience/virtual function overhead.
+  // inheritience/virtual function overhead: the sink thread makes one
+  // indirect call per batch, and each sink's own type is known below it
+  // (see SinkBatch in Sinks.hpp).
   //
 
   void SetSinkToSilent() {
-    sink_ = [&](const ScopeInfo &info) { (void)info; };
-
-    sink_type_ = SinkType::SILENT;
+    SwapSinks(SinkType::SILENT, std::make_shared<SilentSink>());
   }
 
   void SetSinkToCout() {
-    sink_ = [&](const ScopeInfo &info) { std::cout << info << "\n"; };
-
-    sink_type_ = SinkType::COUT;
+    SwapSinks(SinkType::COUT, std::make_shared<CoutSink>());
   }
 
   void SetSinkToBinaryDisk(std::shared_ptr<BinaryDiskSink> sink_ptr) {
@@ -134,17 +393,120 @@ public:
       throw std::runtime_error("Could not set up BinaryDiskSink.");  // TODO(ajf): exception type?
     }
 
-    sink_ = [sink_ptr](const ScopeInfo &info) { sink_ptr->Sink(info); };
+    SwapSinks(SinkType::BINARY_DISK, std::move(sink_ptr));
+  }
+
+  void SetSinkToAsyncDisk(std::shared_ptr<AsyncDiskSink> sink_ptr) {
+    if (!sink_ptr || !sink_ptr->OK()) {
+      throw std::runtime_error("Could not set up AsyncDiskSink.");
+    }
 
-    sink_type_ = SinkType::BINARY_DISK;
+    SwapSinks(SinkType::ASYNC_DISK, std::move(sink_ptr));
+  }
+
+  void SetSinkToSharedMemory(std::shared_ptr<SharedMemorySink> sink_ptr) {
+    if (!sink_ptr || !sink_ptr->OK()) {
+      throw std::runtime_error("Could not set up SharedMemorySink.");
+    }
+
+    SwapSinks(SinkType::SHARED_MEMORY, std::move(sink_ptr));
+  }
+
+  void SetSinkToBlockDisk(std::shared_ptr<BlockDiskSink> sink_ptr) {
+    if (!sink_ptr || !sink_ptr->OK()) {
+      throw std::runtime_error("Could not set up BlockDiskSink.");
+    }
+
+    SwapSinks(SinkType::BLOCK_DISK, std::move(sink_ptr));
+  }
+
+  void SetSinkToUnixSocket(std::shared_ptr<UnixSocketSink> sink_ptr) {
+    if (!sink_ptr || !sink_ptr->OK()) {
+      throw std::runtime_error("Could not set up UnixSocketSink.");
+    }
+
+    SwapSinks(SinkType::UNIX_SOCKET, std::move(sink_ptr));
+  }
+
+  //
+  // Any sink type (see Sinks.hpp), or several at once: each batch goes to
+  // every sink in turn, on the sink thread, e.g.
+  //
+  //   Instance().SetSinks(Profiler::CreateBlockDiskSink(path), std::make_shared<MyHistogramSink>());
+  //
+  // Sinks with an OK() member are checked, like the built in ones.
+  //
+
+  template <typename... Sinks>
+  void SetSinks(std::shared_ptr<Sinks>... sinks) {
+    static_assert(sizeof...(Sinks) > 0, "SetSinks needs at least one sink");
+
+    if (!(Usable(sinks) && ...)) {
+      throw std::runtime_error("Could not set up sink.");
+    }
+
+    SwapSinks(SinkType::CUSTOM, std::move(sinks)...);
+  }
+
+  template <typename S>
+  void SetSink(std::shared_ptr<S> sink) {
+    SetSinks(std::move(sink));
+  }
+
+  //
+  // Scopes are recorded on the threads that produce them, and nothing is
+  // written until the recorder is asked to Dump() (see FlightRecorder.hpp).
+  //
+
+  void SetSinkToFlightRecorder(std::shared_ptr<FlightRecorder> recorder_ptr) {
+    if (!recorder_ptr || !recorder_ptr->OK()) {
+      throw std::runtime_error("Could not set up FlightRecorder.");
+    }
+
+    SwapSinks(SinkType::FLIGHT_RECORDER, std::make_shared<SilentSink>());
+
+    //
+    // We hold on to the recorder until the next one replaces it, since a
+    // producer may still be inside Sink() after we switch away.
+    //
+
+    const std::scoped_lock lock{lifecycle_mutex_};
+    flight_recorder_owner_ = recorder_ptr;
+    flight_recorder_.store(recorder_ptr.get(), std::memory_order_release);
   }
 
   SinkType GetSinkType() const {
     return sink_type_;
   }
 
-  static std::shared_ptr<BinaryDiskSink> CreateBinaryDiskSink(const std::filesystem::path &path) {
-    return std::make_shared<BinaryDiskSink>(path, Instance().GetMachine());
+  static std::shared_ptr<BinaryDiskSink> CreateBinaryDiskSink(const std::filesystem::path &path,
+                                                              const BinaryDiskSinkOptions &options = {}) {
+    return std::make_shared<BinaryDiskSink>(path, Instance().GetMachine(), options);
+  }
+
+  static std::shared_ptr<AsyncDiskSink> CreateAsyncDiskSink(const std::filesystem::path &path,
+                                                            const AsyncDiskSinkOptions &options = {}) {
+    return std::make_shared<AsyncDiskSink>(path, Instance().GetMachine(), options);
+  }
+
+  static std::shared_ptr<SharedMemorySink> CreateSharedMemorySink(const std::filesystem::path &path,
+                                                                  uint64_t capacity = RSP_SHM_RING_CAPACITY) {
+    return std::make_shared<SharedMemorySink>(path, Instance().GetMachine(), capacity);
+  }
+
+  static std::shared_ptr<BlockDiskSink> CreateBlockDiskSink(const std::filesystem::path &path,
+                                                            const BlockDiskSinkOptions &options = {}) {
+    return std::make_shared<BlockDiskSink>(path, Instance().GetMachine(), options);
+  }
+
+  static std::shared_ptr<UnixSocketSink> CreateUnixSocketSink(const std::filesystem::path &path,
+                                                              const UnixSocketSinkOptions &options = {}) {
+    return std::make_shared<UnixSocketSink>(path, Instance().GetMachine(), options);
+  }
+
+  static std::shared_ptr<FlightRecorder> CreateFlightRecorder(const std::filesystem::path &path,
+                                                              const FlightRecorderOptions &options = {}) {
+    return std::make_shared<FlightRecorder>(path, Instance().GetMachine(), options);
   }
 
   SlotStorage *GetSlotStorage() {
@@ -155,43 +517,509 @@ public:
     return &machine_;
   }
 
+  ProfilerStats GetStats() const {
+    ProfilerStats stats;
+    stats.records_sunk = records_sunk_.load(std::memory_order_acquire);
+    stats.queue_depth  = queue_.size_approx();
+    if (const auto *node_queues = node_queues_.load(std::memory_order_acquire)) {
+      for (size_t i = 1; i < node_queues->queues.size(); ++i) {
+        stats.queue_depth += node_queues->queues[i]->size_approx();
+      }
+    }
+    stats.slot_count   = slot_storage_.SlotCount();
+    return stats;
+  }
+
 private:
   Profiler() : machine_(Machine()), slot_storage_{} {
     SetSinkToSilent();
+    pthread_atfork(&Profiler::PrepareFork, &Profiler::ParentAfterFork, &Profiler::ChildAfterFork);
   }
 
   ~Profiler() {
     StopSinkThread();
   }
 
+  //
+  // Per NUMA node queues (see SinkThreadOptions::per_numa_node). The first
+  // node uses queue_, so queues[0] is empty. They're made the first time
+  // they're asked for and kept for good, since a producer may still be
+  // enqueueing to one after a session without them has started; node_queues_
+  // is null while producers should use queue_.
+  //
+
+  struct NodeQueues {
+    std::vector<NumaNode> nodes;
+    std::vector<std::unique_ptr<ProfilerQueue>> queues;
+    std::vector<size_t> index;  // By node id.
+  };
+
   void StartSinkThread() {
     stop_ = false;
+    sink_thread_placed_.store(true, std::memory_order_release);
+
+    const SinkThreadOptions options = sink_thread_options_;
+
+    NodeQueues *node_queues = options.per_numa_node ? GetNodeQueues() : nullptr;
+    node_queues_.store(node_queues, std::memory_order_release);
+
+    if (node_queues) {
+      for (size_t i = 1; i < node_queues->nodes.size(); ++i) {
+        node_threads_.emplace_back([this, options, node_queues, i, make_node_sink = make_node_sink_]() {
+          const NumaNode &node = node_queues->nodes[i];
+          PlaceSinkThread(options, options.name + "-n" + std::to_string(node.id), &node);
+
+          //
+          // Records are encoded here, on the node, and the sinks only get
+          // finished chunks - handed over as they fill up, or once the
+          // queue goes quiet.
+          //
+
+          const NodeSink node_sink = make_node_sink();
+
+          ProfilerQueue &queue = *node_queues->queues[i];
+          std::vector<ScopeInfo> batch(RSP_PROFILER_SINK_BATCH, ScopeInfo::Blank());
+
+          while (!stop_) {
+            const size_t dequeued = queue.wait_dequeue_bulk_timed(
+                batch.begin(), batch.size(), std::chrono::milliseconds(RSP_PROFILER_DEQUEUE_WAIT_MS));
+            if (dequeued) {
+              DrainBatch(batch, dequeued, &node_sink.sink);
+            } else {
+              node_sink.seal(std::chrono::milliseconds(RSP_PROFILER_IDLE_SEAL_MS));
+            }
+          }
+
+          DrainQueue(&queue, &batch, &node_sink.sink);
+          node_sink.seal({});
+        });
+      }
+    }
+
+    sink_thread_ = std::thread([this, options, node_queues, make_node_sink = make_node_sink_]() {
+      PlaceSinkThread(options, options.name, node_queues ? &node_queues->nodes[0] : nullptr);
+
+      //
+      // The call site control file is checked from here, at most every
+      // RSP_CALLSITE_CONTROL_POLL_MS, and clock anchors are recorded every
+      // RSP_CLOCK_ANCHOR_INTERVAL_MS. We only look at the clock when idle or
+      // every so many records, to keep it off the per-record path.
+      //
+
+      const auto poll_interval   = std::chrono::milliseconds(RSP_CALLSITE_CONTROL_POLL_MS);
+      const auto anchor_interval = std::chrono::milliseconds(RSP_CLOCK_ANCHOR_INTERVAL_MS);
+      auto next_poll             = std::chrono::steady_clock::now() + poll_interval;
+      auto next_anchor           = std::chrono::steady_clock::now() + anchor_interval;
+      uint64_t since_poll        = 0;
+
+      RecordClockAnchor();
+
+      //
+      // With a sink thread per node, this is the first node's, and encodes
+      // its records itself like the others.
+      //
+
+      const NodeSink node_sink = node_queues ? make_node_sink() : NodeSink();
+      const SinkFunc *own_sink = node_queues ? &node_sink.sink : nullptr;
+
+      std::vector<ScopeInfo> batch(RSP_PROFILER_SINK_BATCH, ScopeInfo::Blank());
 
-    sink_thread_ = std::thread([this]() {
       while (!stop_) {
-        ScopeInfo info = ScopeInfo::Blank();
-        if (queue_.wait_dequeue_timed(info, std::chrono::milliseconds(RSP_PROFILER_DEQUEUE_WAIT_MS))) {
-          sink_(info);
-          GetSlotStorage()->Release(info.metadata_ptr);
+        const size_t dequeued = queue_.wait_dequeue_bulk_timed(
+            batch.begin(), batch.size(), std::chrono::milliseconds(RSP_PROFILER_DEQUEUE_WAIT_MS));
+        if (dequeued) {
+          DrainBatch(batch, dequeued, own_sink);
+        } else {
+          if (own_sink) {
+            node_sink.seal(std::chrono::milliseconds(RSP_PROFILER_IDLE_SEAL_MS));
+          }
+          tick_();
+        }
+
+        since_poll += dequeued;
+        if (!dequeued || since_poll >= 1024) {
+          since_poll     = 0;
+          const auto now = std::chrono::steady_clock::now();
+          if (now >= next_poll) {
+            CallSiteRegistry::Instance().PollControlFile();
+            next_poll = now + poll_interval;
+          }
+          if (RSP_CLOCK_ANCHOR_INTERVAL_MS > 0 && now >= next_anchor) {
+            RecordClockAnchor();
+            next_anchor = now + anchor_interval;
+          }
         }
       }
 
-      ScopeInfo info = ScopeInfo::Blank();
-      while (queue_.try_dequeue(info)) {
-        sink_(info);
-        GetSlotStorage()->Release(info.metadata_ptr);
-        info = ScopeInfo::Blank();
+      DrainQueue(&queue_, &batch, own_sink);
+      if (own_sink) {
+        node_sink.seal({});
+      }
+
+      //
+      // Records a producer put on a node queue just as an earlier per-node
+      // session ended.
+      //
+
+      if (!node_queues && node_queues_owner_) {
+        for (size_t i = 1; i < node_queues_owner_->queues.size(); ++i) {
+          DrainQueue(node_queues_owner_->queues[i].get(), &batch);
+        }
       }
     });
   }
 
+  void PlaceSinkThread(const SinkThreadOptions &options, const std::string &name, const NumaNode *node) {
+    std::vector<int> cpus = options.cpus;
+
+    if (node) {
+      std::vector<int> on_node;
+      for (const int cpu : node->cpus) {
+        if (cpus.empty() || std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+          on_node.push_back(cpu);
+        }
+      }
+      if (!on_node.empty()) {
+        cpus = std::move(on_node);
+      }
+    }
+
+    if (!PlaceCurrentThread(name, cpus, options.nice, options.idle)) {
+      sink_thread_placed_.store(false, std::memory_order_release);
+    }
+  }
+
+  //
+  // The queue the calling thread's records go on: its NUMA node's, when
+  // there's a sink thread per node. A thread's node is looked up once, so
+  // one that moves between nodes keeps using its first node's queue.
+  //
+
+  ProfilerQueue &ProducerQueue() {
+    auto *node_queues = node_queues_.load(std::memory_order_acquire);
+    if (!node_queues) {
+      return queue_;
+    }
+
+    thread_local const int node = CurrentNumaNode();
+    if (node < 0 || static_cast<size_t>(node) >= node_queues->index.size()) {
+      return queue_;
+    }
+
+    const size_t i = node_queues->index[node];
+    return i ? *node_queues->queues[i] : queue_;
+  }
+
+  //
+  // Null on a single node host.
+  //
+
+  NodeQueues *GetNodeQueues() {
+    if (!node_queues_owner_) {
+      std::vector<NumaNode> nodes = NumaNodes();
+      if (nodes.size() < 2) {
+        return nullptr;
+      }
+
+      auto node_queues = std::make_unique<NodeQueues>();
+      node_queues->index.assign(nodes.back().id + 1, 0);
+      node_queues->queues.resize(nodes.size());
+      for (size_t i = 0; i < nodes.size(); ++i) {
+        node_queues->index[nodes[i].id] = i;
+        if (i) {
+          node_queues->queues[i] = std::make_unique<ProfilerQueue>();
+        }
+      }
+      node_queues->nodes = std::move(nodes);
+
+      node_queues_owner_ = std::move(node_queues);
+    }
+
+    return node_queues_owner_.get();
+  }
+
+  void DrainQueue(ProfilerQueue *queue, std::vector<ScopeInfo> *batch, const SinkFunc *node_sink = nullptr) {
+    while (const size_t dequeued = queue->try_dequeue_bulk(batch->begin(), batch->size())) {
+      DrainBatch(*batch, dequeued, node_sink);
+    }
+  }
+
+  //
+  // Hands the first n records of batch to the sink (or, with a sink thread
+  // per node, the calling thread's node_sink), then gives their slots back.
+  //
+
+  void DrainBatch(const std::vector<ScopeInfo> &batch, size_t n, const SinkFunc *node_sink = nullptr) {
+    const std::span<const ScopeInfo> records{batch.data(), n};
+    if (node_sink) {
+      (*node_sink)(records);
+    } else {
+      sink_(records);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+      GetSlotStorage()->Release(batch[i].metadata_ptr);
+    }
+    records_sunk_.fetch_add(n, std::memory_order_release);
+  }
+
+  template <typename S>
+  static bool Usable(const std::shared_ptr<S> &sink) {
+    if constexpr (requires { sink->OK(); }) {
+      return sink && sink->OK();
+    } else {
+      return sink != nullptr;
+    }
+  }
+
+  //
+  // What a forked child uses in place of sink (see EnableForkFollowing).
+  //
+
+  template <typename S>
+  static std::shared_ptr<S> ReopenForProcess(const std::shared_ptr<S> &sink, pid_t pid) {
+    if constexpr (requires { sink->ReopenForProcess(pid); }) {
+      return sink->ReopenForProcess(pid);
+    } else {
+      return sink;
+    }
+  }
+
+  //
+  // The sink threads call the sinks without a lock, so a running session's
+  // are stopped first (draining what's queued into the old sinks) and
+  // started again on the new ones.
+  //
+
+  template <typename... Sinks>
+  void SwapSinks(SinkType type, std::shared_ptr<Sinks>... sinks) {
+    const std::scoped_lock lock{lifecycle_mutex_};
+
+    bool restart = sink_thread_.joinable();
+
+    //
+    // A forked child replacing the sinks it was yet to reopen.
+    //
+
+    if (reopen_pending_.exchange(false, std::memory_order_acq_rel)) {
+      restart = running_.load(std::memory_order_acquire);
+    }
+
+    if (restart) {
+      StopSinkThread();
+      if (flush_) {
+        flush_();
+      }
+    }
+
+    InstallSinks(type, std::move(sinks)...);
+
+    if (restart) {
+      StartSinkThread();
+    }
+  }
+
+  //
+  // Called with lifecycle_mutex_ held and no sink thread running.
+  //
+
+  template <typename... Sinks>
+  void InstallSinks(SinkType type, std::shared_ptr<Sinks>... sinks) {
+    reopen_ = [type, sinks...](pid_t pid) {
+      return [type](auto... reopened) {
+        if (!(Usable(reopened) && ...)) {
+          return false;
+        }
+        Instance().InstallSinks(type, std::move(reopened)...);
+        return true;
+      }(ReopenForProcess(sinks, pid)...);
+    };
+
+    make_node_sink_ = [mutex = &sink_mutex_, sinks...]() -> NodeSink {
+      auto shared = std::make_shared<std::tuple<SharedSink<Sinks>...>>(SharedSink<Sinks>(sinks, mutex)...);
+      return {
+          [shared](std::span<const ScopeInfo> batch) {
+            std::apply([batch](auto &...sinks) { (sinks.SinkBatch(batch), ...); }, *shared);
+          },
+          [shared](std::chrono::milliseconds min_age) {
+            std::apply([min_age](auto &...sinks) { (sinks.Seal(min_age), ...); }, *shared);
+          },
+      };
+    };
+
+    flush_ = [sinks...]() { (rsp::FlushSink(*sinks), ...); };
+    tick_  = [mutex = &sink_mutex_, sinks...]() {
+      const std::scoped_lock lock{*mutex};
+      (rsp::TickSink(*sinks), ...);
+    };
+    sink_  = [... sinks = std::move(sinks)](std::span<const ScopeInfo> batch) { (rsp::SinkBatch(*sinks, batch), ...); };
+
+    sink_type_ = type;
+    flight_recorder_.store(nullptr, std::memory_order_release);
+  }
+
+  //
+  // Replaces *object with a new one without destroying it (or anything it
+  // owns).
+  //
+
+  template <typename T>
+  static void Abandon(T *object) {
+    new (object) T();
+  }
+
+  //
+  // pthread_atfork() handlers. The locks a child could otherwise inherit
+  // mid-use are held across the fork, always taken in this order: the
+  // session lock, the call site registry's, the string table's, then the
+  // slot pool's. None of them is ever held while taking an earlier one.
+  //
+
+  static void PrepareFork() {
+    Instance().lifecycle_mutex_.lock();
+    CallSiteRegistry::Instance().LockForFork();
+    StringTable::Instance().LockForFork();
+    Instance().slot_storage_.LockForFork();
+  }
+
+  static void ParentAfterFork() {
+    Instance().slot_storage_.UnlockAfterFork();
+    StringTable::Instance().UnlockAfterFork();
+    CallSiteRegistry::Instance().UnlockAfterFork();
+    Instance().lifecycle_mutex_.unlock();
+  }
+
+  static void ChildAfterFork() {
+    Instance().slot_storage_.UnlockAfterFork();
+    StringTable::Instance().UnlockAfterFork();
+    CallSiteRegistry::Instance().UnlockAfterFork();
+    Instance().ResetAfterFork();
+    Instance().lifecycle_mutex_.unlock();
+  }
+
+  //
+  // See EnableForkFollowing. Only the forking thread exists in the child.
+  //
+
+  void ResetAfterFork() {
+    const UncountedAllocations uncounted;
+    const pid_t pid = getpid();
+
+    //
+    // The sink threads only exist in the parent, so their handles can be
+    // neither joined nor destroyed; the sinks' destructors would write the
+    // parent's buffered records out again; and the queued records are the
+    // parent's to write, besides which the queue may have been mid-dequeue
+    // on the sink thread. We abandon all three, as they are, for new ones -
+    // and the lock the sink threads take turns with, which one of them may
+    // have held. The queued records' slots go with them, so the slot pool
+    // is rebuilt (see MetadataSlotStorage::ResetAfterFork).
+    //
+
+    Abandon(&sink_thread_);
+    Abandon(&node_threads_);
+    Abandon(&sink_mutex_);
+    Abandon(&sink_);
+    Abandon(&flush_);
+    Abandon(&tick_);
+    Abandon(&make_node_sink_);
+    Abandon(&queue_);
+    if (node_queues_owner_) {
+      for (size_t i = 1; i < node_queues_owner_->queues.size(); ++i) {
+        Abandon(node_queues_owner_->queues[i].get());
+      }
+    }
+    slot_storage_.ResetAfterFork();
+    records_sunk_.store(0, std::memory_order_release);
+
+    if (PerfCountersEnabled()) {
+      ThreadPerfGroup().Reopen();
+    }
+
+    //
+    // The flight recorder moves to its own dump path either way, so that a
+    // crash in the child can't overwrite the parent's dump.
+    //
+
+    if (flight_recorder_owner_) {
+      flight_recorder_owner_->AfterFork(pid);
+    }
+
+    //
+    // That's all a fork handler should do. The child's own sinks are set up
+    // on its first record, or its next Start(), whichever comes first (see
+    // ReopenAfterFork) - until then there's no sink thread, and records are
+    // dropped like after a Stop().
+    //
+
+    stop_ = true;
+    reopen_pending_.store(true, std::memory_order_release);
+    if (!ForkFollowingEnabled()) {
+      flight_recorder_.store(nullptr, std::memory_order_release);
+      running_.store(false, std::memory_order_release);
+      UpdateCapturing();
+    }
+  }
+
+  //
+  // A forked child's sinks: its own (see EnableForkFollowing), or silent
+  // ones if it isn't following or they can't be opened. Called with
+  // lifecycle_mutex_ held; does nothing outside a child that has yet to
+  // set them up.
+  //
+
+  void ReopenAfterFork() {
+    if (!reopen_pending_.exchange(false, std::memory_order_acq_rel)) {
+      return;
+    }
+
+    const UncountedAllocations uncounted;
+    auto *recorder = flight_recorder_.load(std::memory_order_acquire);
+
+    const auto reopen = std::move(reopen_);
+    if (ForkFollowingEnabled() && reopen && reopen(getpid())) {
+      flight_recorder_.store(recorder, std::memory_order_release);
+    } else {
+      InstallSinks(SinkType::SILENT, std::make_shared<SilentSink>());
+      running_.store(false, std::memory_order_release);
+      UpdateCapturing();
+    }
+  }
+
+  //
+  // The slow path of a child's first Add(). Returns whether records are
+  // being taken now.
+  //
+
+  bool ReopenOnFirstAdd() {
+    if (!reopen_pending_.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    const std::scoped_lock lock{lifecycle_mutex_};
+    ReopenAfterFork();
+    if (running_.load(std::memory_order_acquire) && !sink_thread_.joinable()) {
+      StartSinkThread();
+    }
+    return !stop_;
+  }
+
   void StopSinkThread() {
     stop_ = true;
+    for (auto &thread : node_threads_) {
+      thread.join();
+    }
+    node_threads_.clear();
     if (sink_thread_.joinable()) {
       sink_thread_.join();
     }
   }
 
+  void UpdateCapturing() {
+    capturing_.store(running_.load(std::memory_order_relaxed) && !paused_.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+  }
+
   //
   // Machine abstraction.
   //
@@ -206,19 +1034,103 @@ private:
   SinkFunc sink_;
   SinkType sink_type_;
 
+  //
+  // Calls each sink's Flush(), where it has one.
+  //
+
+  std::function<void()> flush_;
+
+  //
+  // Calls each sink's Tick(), where it has one, from the sink thread when
+  // it's idle. Takes sink_mutex_, as the node sink threads may be handing
+  // the sinks chunks at the same time.
+  //
+
+  std::function<void()> tick_;
+
+  //
+  // What a node sink thread calls in place of sink_ (see SharedSink in
+  // Sinks.hpp): sink encodes a batch, and seal hands over whatever's still
+  // being encoded, if it has waited at least min_age.
+  //
+
+  struct NodeSink {
+    SinkFunc sink;
+    std::function<void(std::chrono::milliseconds min_age)> seal;
+  };
+
+  std::function<NodeSink()> make_node_sink_;
+
+  //
+  // Installs the sinks a forked child uses in place of the current ones,
+  // returning false if they couldn't be set up.
+  //
+
+  std::function<bool(pid_t)> reopen_;
+
+  //
+  // Set in a forked child until ReopenAfterFork() has run.
+  //
+
+  std::atomic<bool> reopen_pending_ = false;
+
+  std::shared_ptr<FlightRecorder> flight_recorder_owner_;
+  std::atomic<FlightRecorder *> flight_recorder_ = nullptr;
+
   //
   // Queue for holding finalized scope info.
   //
 
   ProfilerQueue queue_;
 
+  //
+  // See NodeQueues.
+  //
+
+  std::unique_ptr<NodeQueues> node_queues_owner_;
+  std::atomic<NodeQueues *> node_queues_ = nullptr;
+
+  //
+  // Only ever written by the sink threads. Release/acquire so that seeing a
+  // record counted also means the sink has finished with it.
+  //
+
+  std::atomic<uint64_t> records_sunk_ = 0;
+
   //
   // Thread control.
   //
 
   std::thread sink_thread_;
+  std::vector<std::thread> node_threads_;
   std::atomic<bool> stop_ = false;
 
+  SinkThreadOptions sink_thread_options_;
+  std::atomic<bool> sink_thread_placed_ = true;
+
+  //
+  // What the sink threads take turns with the sinks under, while there's
+  // one per node - only to write, for sinks that can take chunks encoded
+  // elsewhere.
+  //
+
+  std::mutex sink_mutex_;
+
+  //
+  // Session state. capturing_ is running_ && !paused_, kept separately so
+  // that scopes only have the one flag to check.
+  //
+
+  std::mutex lifecycle_mutex_;
+  std::atomic<bool> running_   = false;
+  std::atomic<bool> paused_    = false;
+  std::atomic<bool> capturing_ = false;
+
+  std::atomic<bool> perf_counters_       = false;
+  std::atomic<bool> allocation_tracking_ = false;
+  std::atomic<uint32_t> rusage_every_    = 0;
+  std::atomic<bool> follow_forks_        = false;
+
   friend Profiler &Instance();
 };
 
@@ -281,8 +1193,30 @@ public:
     }
   }
 
+  ActiveScope *Parent() {
+    if (scopes_.size() < 2) {
+      return nullptr;
+    } else {
+      return scopes_[scopes_.size() - 2];
+    }
+  }
+
+  //
+  // The flow id new scopes, spans and events on this thread are tagged with
+  // (see FlowGuard).
+  //
+
+  uint64_t Flow() const {
+    return flow_;
+  }
+
+  void SetFlow(uint64_t flow) {
+    flow_ = flow;
+  }
+
 private:
   std::vector<ActiveScope *> scopes_;
+  uint64_t flow_ = 0;
 };
 
 //
@@ -294,6 +1228,47 @@ inline ScopeManager *GetScopeManager() {
   return &mgr;
 }
 
+//
+// Flows.
+//
+// A flow id ties together the records of one request or task as it moves
+// between threads: the producer's scope, the hand off to a queue, and the
+// worker's scopes. Inside a FlowGuard (RSP_FLOW, RSP_FLOW_DEQUEUE) every
+// scope, span and event the thread opens carries the flow, and
+// RSP_FLOW_ENQUEUE marks the moment it's handed to a queue - which is what
+// lets `rsp flows` split queueing delay from service time.
+//
+// Ids are the pid in the top 24 bits and a counter below, so they don't
+// collide across the processes of one capture either.
+//
+
+inline uint64_t NewFlowId() {
+  static std::atomic<uint64_t> next{1};
+  const uint64_t n = next.fetch_add(1, std::memory_order_relaxed) & ((uint64_t{1} << 40) - 1);
+  return (static_cast<uint64_t>(getpid()) & 0xffffff) << 40 | n;
+}
+
+inline uint64_t CurrentFlow() {
+  return GetScopeManager()->Flow();
+}
+
+class FlowGuard {
+public:
+  explicit FlowGuard(uint64_t flow) : previous_(GetScopeManager()->Flow()) {
+    GetScopeManager()->SetFlow(flow);
+  }
+
+  ~FlowGuard() {
+    GetScopeManager()->SetFlow(previous_);
+  }
+
+  FlowGuard(const FlowGuard &)            = delete;
+  FlowGuard &operator=(const FlowGuard &) = delete;
+
+private:
+  uint64_t previous_;
+};
+
 //
 // An ActiveScope is what gets instantiated by the profiling macros.
 // It's responsible for collecting timing info (on construction and destruction),
@@ -309,11 +1284,32 @@ public:
   // The start time is collected upon construction, but we are careful to measure
   // only after we've set ourselves up to keep our operations out of the timing scope.
   //
-  ActiveScope(const char *name) : info(name) {
-    info.metadata_ptr = Instance().GetSlotStorage()->Acquire();
-    GetScopeManager()->Push(this);
+  // When we aren't capturing we skip even copying the tag, but still push a
+  // (null) entry so that metadata inside this scope isn't attached to an
+  // enclosing one.
+  //
+  ActiveScope(const char *name) : info(ScopeTag{""}), capturing_(Instance().Capturing()) {
+    if (!capturing_) {
+      GetScopeManager()->Push(nullptr);
+      return;
+    }
 
-    info.ticks_start = Now();
+    Begin(name);
+  }
+
+  //
+  // What the macros use: the call site is checked first, so a disabled site
+  // doesn't even look at the profiler.
+  //
+
+  explicit ActiveScope(CallSite &site)
+      : info(ScopeTag{""}), capturing_(site.Enabled() && Instance().Capturing()) {
+    if (!capturing_) {
+      GetScopeManager()->Push(nullptr);
+      return;
+    }
+
+    Begin(site.Name(), site.RusageSelected());
   }
 
   //
@@ -322,12 +1318,126 @@ public:
   //
 
   ~ActiveScope() {
+    if (!capturing_) {
+      GetScopeManager()->Pop();
+      return;
+    }
+
     info.ticks_end = Now();
+    if (perf_) {
+      info.perf = PerfDelta(info.perf, perf_->Read());
+    }
+    if (info.rusage.sampled) {
+      EndResourceUsage();
+    }
+    if (info.allocs.tracked) {
+      EndAllocations();
+    }
     Instance().Add(info);
     GetScopeManager()->Pop();
   }
 
   ScopeInfo info;
+
+private:
+  void Begin(const char *name, bool rusage_site = true) {
+    const UncountedAllocations uncounted;
+
+    if (Instance().AllocationTrackingEnabled()) {
+      info.allocs.tracked   = true;
+      info.allocs.inclusive = ThreadAllocations();
+    }
+
+    info.tag          = ScopeTag{name};
+    info.metadata_ptr = Instance().GetSlotStorage()->Acquire();
+
+    auto *mgr = GetScopeManager();
+    info.flow = mgr->Flow();
+    mgr->Push(this);
+
+    const uint32_t rusage_every = Instance().ResourceUsageEvery();
+    if (rusage_every && rusage_site && SampleResourceUsage(rusage_every)) {
+      ReadResourceUsage(&info.rusage);
+    }
+
+    if (Instance().PerfCountersEnabled()) {
+      perf_ = GetPerfGroup();
+      if (perf_) {
+        info.perf = perf_->Read();
+      }
+    }
+
+    info.ticks_start = Now();
+  }
+
+  //
+  // Until now rusage held the counts at entry.
+  //
+
+  void EndResourceUsage() {
+    ResourceUsage now;
+    info.rusage = ReadResourceUsage(&now) ? ResourceUsageDelta(info.rusage, now) : ResourceUsage{};
+  }
+
+  //
+  // Until now allocs.inclusive held the counts at entry. The parent is
+  // whatever is below us on the scope stack; it's only credited if it's
+  // tracking too (it may predate tracking being switched on).
+  //
+
+  void EndAllocations() {
+    auto &allocs     = info.allocs;
+    allocs.inclusive = ThreadAllocations() - allocs.inclusive;
+    allocs.exclusive = allocs.inclusive - children_allocs_;
+
+    auto *parent = GetScopeManager()->Parent();
+    if (parent && parent->info.allocs.tracked) {
+      parent->children_allocs_ += allocs.inclusive;
+    }
+  }
+
+  bool capturing_;
+  PerfGroup *perf_ = nullptr;
+  AllocationCounts children_allocs_;
+};
+
+//
+// Stands in for an ActiveScope whose site was stripped at compile time (see
+// RSP_MAX_LEVEL and RSP_STRIP_CATEGORIES in CallSites.hpp).
+//
+
+class StrippedScope {
+public:
+  explicit StrippedScope(CallSite &) {
+    GetScopeManager()->Push(nullptr);
+  }
+
+  ~StrippedScope() {
+    GetScopeManager()->Pop();
+  }
 };
 
+template <bool CompiledIn>
+using SiteScope = std::conditional_t<CompiledIn, ActiveScope, StrippedScope>;
+
+//
+// Counter, gauge and instant records (RSP_COUNTER, RSP_GAUGE, RSP_INSTANT):
+// one clock read, no metadata slot, and nothing pushed on the scope stack,
+// so RSP_SCOPE_METADATA still lands on the enclosing scope.
+//
+
+inline bool EventEnabled(CallSite &site) {
+  return site.Enabled() && Instance().Capturing();
+}
+
+inline void RecordEvent(CallSite &site, RecordKind kind, uint64_t value, uint64_t flow) {
+  ScopeInfo info{ScopeTag{site.Name()}};
+  info.ticks_start = Now();
+  info.ticks_end   = info.ticks_start;
+  info.kind        = kind;
+  info.value       = value;
+  info.flow        = flow;
+  Instance().Add(info);
+}
+
 }  // namespace rsp
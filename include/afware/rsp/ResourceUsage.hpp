@@ -0,0 +1,103 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "Scope.hpp"
+
+#include <cstdint>
+
+#if defined(__linux__)
+#define RSP_HAVE_RUSAGE_THREAD
+#include <sys/resource.h>
+#endif
+
+namespace rsp {
+
+//
+// Context switches and page faults over scopes.
+//
+// With resource usage enabled (rsp::EnableResourceUsage()), sampled scopes
+// call getrusage(RUSAGE_THREAD) on entry and on exit and store the
+// difference in ScopeInfo::rusage: voluntary context switches (the thread
+// blocked - on a lock, I/O, a sleep), involuntary ones (it was preempted),
+// and minor and major page faults. That's usually enough to tell whether a
+// slow call was slow on the CPU or off it.
+//
+// Each read is a system call, so a sampled scope costs a microsecond or so
+// more. Two ways to keep that down, which combine:
+//
+// - Sample only every Nth scope each thread enters.
+// - Sample only the call sites matching the resource usage rules. They take
+//   the same syntax as the call site rules (see CallSites.hpp), so
+//   "-*, Handle*" samples just the sites named Handle-something; they come
+//   from the RSP_RUSAGE_SITES environment variable at startup, or
+//   rsp::ConfigureResourceUsageSites().
+//
+// RUSAGE_THREAD is Linux only; elsewhere enabling fails and scopes cost what
+// they did. Counts are per thread, so spans and event records don't carry
+// them.
+//
+
+inline bool ReadResourceUsage(ResourceUsage *out) {
+#if defined(RSP_HAVE_RUSAGE_THREAD)
+  struct rusage usage;
+  if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+    return false;
+  }
+
+  out->sampled              = true;
+  out->voluntary_switches   = static_cast<uint64_t>(usage.ru_nvcsw);
+  out->involuntary_switches = static_cast<uint64_t>(usage.ru_nivcsw);
+  out->minor_faults         = static_cast<uint64_t>(usage.ru_minflt);
+  out->major_faults         = static_cast<uint64_t>(usage.ru_majflt);
+  return true;
+#else
+  (void)out;
+  return false;
+#endif
+}
+
+inline ResourceUsage ResourceUsageDelta(const ResourceUsage &start, const ResourceUsage &end) {
+  return ResourceUsage{true,
+                       end.voluntary_switches - start.voluntary_switches,
+                       end.involuntary_switches - start.involuntary_switches,
+                       end.minor_faults - start.minor_faults,
+                       end.major_faults - start.major_faults};
+}
+
+namespace detail {
+
+inline constinit thread_local uint32_t rusage_skip = 0;
+
+}  // namespace detail
+
+//
+// True for one in every `every` calls on this thread, starting with the
+// first.
+//
+
+inline bool SampleResourceUsage(uint32_t every) {
+  auto &skip = detail::rusage_skip;
+  if (skip == 0 || skip >= every) {
+    skip = every - 1;
+    return true;
+  }
+  --skip;
+  return false;
+}
+
+}  // namespace rsp
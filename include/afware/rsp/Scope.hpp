@@ -21,6 +21,8 @@
 #include "Slots.hpp"
 
 #include <array>
+#include <bit>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <stdexcept>
@@ -45,6 +47,82 @@ namespace rsp {
 
 using ScopeTag = ConstexprString<RSP_SCOPE_TAG_SIZE>;
 
+//
+// Not every record is a timed scope. Counters, gauges and instant events are
+// point-in-time records: a single timestamp (ticks_end == ticks_start), no
+// metadata slot, and the sample carried in `value` - the int64_t delta for a
+// counter, the bit pattern of the double for a gauge, and nothing for an
+// instant. They travel the same queue and sinks as scopes.
+//
+
+enum class RecordKind : uint8_t {
+  SCOPE   = 0,
+  COUNTER = 1,
+  GAUGE   = 2,
+  INSTANT = 3,
+};
+
+inline const char *RecordKindToString(RecordKind kind) {
+  switch (kind) {
+    case RecordKind::SCOPE:
+      return "SCOPE";
+    case RecordKind::COUNTER:
+      return "COUNTER";
+    case RecordKind::GAUGE:
+      return "GAUGE";
+    case RecordKind::INSTANT:
+      return "INSTANT";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+//
+// Hardware counter deltas over a scope (see PerfCounters.hpp). All zero when
+// they weren't captured: perf counters are off, or unavailable on the thread.
+//
+
+struct PerfCounts {
+  uint64_t cycles        = 0;
+  uint64_t instructions  = 0;
+  uint64_t llc_misses    = 0;
+  uint64_t branch_misses = 0;
+
+  bool Empty() const {
+    return (cycles | instructions | llc_misses | branch_misses) == 0;
+  }
+};
+
+//
+// Heap allocations over a scope (see Allocations.hpp): inclusive of the
+// scopes nested in it, and exclusive - what the scope allocated itself.
+// tracked is false when allocation tracking was off.
+//
+
+struct AllocationCounts {
+  uint64_t count = 0;
+  uint64_t bytes = 0;
+};
+
+struct ScopeAllocations {
+  bool tracked = false;
+  AllocationCounts inclusive;
+  AllocationCounts exclusive;
+};
+
+//
+// Context switches and page faults over a scope, from getrusage (see
+// ResourceUsage.hpp). sampled is false when the scope wasn't sampled.
+//
+
+struct ResourceUsage {
+  bool sampled                  = false;
+  uint64_t voluntary_switches   = 0;
+  uint64_t involuntary_switches = 0;
+  uint64_t minor_faults         = 0;
+  uint64_t major_faults         = 0;
+};
+
 struct ScopeInfo {
   ScopeTag tag;
 
@@ -53,6 +131,22 @@ struct ScopeInfo {
 
   MetadataSlot *metadata_ptr = nullptr;
 
+  RecordKind kind = RecordKind::SCOPE;
+  uint64_t value  = 0;
+
+  //
+  // Causality: records sharing a non-zero flow id belong to the same
+  // request/task, whichever thread they were recorded on (see RSP_FLOW).
+  //
+
+  uint64_t flow = 0;
+
+  PerfCounts perf;
+
+  ScopeAllocations allocs;
+
+  ResourceUsage rusage;
+
   constexpr ScopeInfo(ScopeTag t) : tag(t) {
   }
 
@@ -65,6 +159,15 @@ struct ScopeInfo {
     metadata_ptr->template AddMetadata<T>(tag, val);
   }
 
+  template <typename T>
+  void SetTypedMetadata(const T &value) {
+    if (!metadata_ptr) {
+      throw std::runtime_error("No metadata slot allotted.");
+    }
+
+    metadata_ptr->SetTypedMetadata(value);
+  }
+
   static ScopeInfo Blank() {
     return ScopeInfo{ScopeTag{"DEFAULT"}};
   }
@@ -101,6 +204,10 @@ inline const char *MetadataTypeToString(MetadataType type) {
       return "DOUBLE";
     case MetadataType::FLOAT:
       return "FLOAT";
+    case MetadataType::STRING:
+      return "STRING";
+    case MetadataType::STRING_ID:
+      return "STRING_ID";
     default:
       return "UNKNOWN";
   }
@@ -139,6 +246,10 @@ inline std::ostream &operator<<(std::ostream &os, const MetadataEntry &m) {
     case MetadataType::DOUBLE:
       os << *reinterpret_cast<const double *>(m.data.data());
       break;
+    case MetadataType::STRING:
+    case MetadataType::STRING_ID:
+      os << MetadataString(m);
+      break;
     default:
       os << "(unset)";
       break;
@@ -147,13 +258,48 @@ inline std::ostream &operator<<(std::ostream &os, const MetadataEntry &m) {
 }
 
 inline std::ostream &operator<<(std::ostream &os, const ScopeInfo &s) {
-  os << "Scope[" << s.tag.c_str() << "] "
-     << "ticks_start=" << s.ticks_start << " ticks_end=" << s.ticks_end << " metadata={";
+  switch (s.kind) {
+    case RecordKind::COUNTER:
+      os << "Counter[" << s.tag.c_str() << "] ticks=" << s.ticks_start << " delta=" << static_cast<int64_t>(s.value);
+      break;
+    case RecordKind::GAUGE:
+      os << "Gauge[" << s.tag.c_str() << "] ticks=" << s.ticks_start << " value=" << std::bit_cast<double>(s.value);
+      break;
+    case RecordKind::INSTANT:
+      os << "Instant[" << s.tag.c_str() << "] ticks=" << s.ticks_start;
+      break;
+    default:
+      os << "Scope[" << s.tag.c_str() << "] "
+         << "ticks_start=" << s.ticks_start << " ticks_end=" << s.ticks_end;
+      break;
+  }
+
+  if (s.flow) os << " flow=" << s.flow;
+  if (!s.perf.Empty()) {
+    os << " cycles=" << s.perf.cycles << " instructions=" << s.perf.instructions
+       << " llc_misses=" << s.perf.llc_misses << " branch_misses=" << s.perf.branch_misses;
+  }
+  if (s.allocs.tracked) {
+    os << " allocs=" << s.allocs.inclusive.count << "/" << s.allocs.inclusive.bytes << "B"
+       << " self=" << s.allocs.exclusive.count << "/" << s.allocs.exclusive.bytes << "B";
+  }
+  if (s.rusage.sampled) {
+    os << " vcsw=" << s.rusage.voluntary_switches << " ivcsw=" << s.rusage.involuntary_switches
+       << " minflt=" << s.rusage.minor_faults << " majflt=" << s.rusage.major_faults;
+  }
+  if (s.kind != RecordKind::SCOPE) return os;
+
+  os << " metadata={";
   bool first = true;
-  for (const auto &m : s.metadata_ptr->metadata) {
-    if (m.type != MetadataType::UNSET) {
+  if (s.metadata_ptr) {
+    for (size_t i = 0; i < s.metadata_ptr->TypedCount(); ++i) {
+      if (!first) os << ", ";
+      os << s.metadata_ptr->TypedAt(i);
+      first = false;
+    }
+    for (size_t i = 0; i < s.metadata_ptr->MetadataCount(); ++i) {
       if (!first) os << ", ";
-      os << m;
+      os << s.metadata_ptr->MetadataAt(i);
       first = false;
     }
   }
@@ -0,0 +1,168 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace rsp {
+
+//
+// Capture segments.
+//
+// A rotating disk sink writes a series of files in place of the one it was
+// given, each a complete capture of its own. For /var/log/app/rsp.bin:
+//
+//   /var/log/app/rsp.000001.20261018T182131Z.bin
+//   /var/log/app/rsp.000002.20261018T192131Z.bin
+//   ...
+//
+// numbered in the order they were written - carrying on from whatever is
+// already there, so restarts don't overwrite anything - and stamped with the
+// UTC time they were opened. The CLI reads a directory or glob of them as a
+// single capture.
+//
+
+struct CaptureSegment {
+  uint64_t sequence = 0;
+  std::filesystem::path path;
+  uint64_t bytes = 0;
+};
+
+inline std::filesystem::path SegmentPath(const std::filesystem::path &base, uint64_t sequence,
+                                         std::chrono::system_clock::time_point opened) {
+  const std::time_t t = std::chrono::system_clock::to_time_t(opened);
+  std::tm utc         = {};
+  gmtime_r(&t, &utc);
+
+  char stamp[32] = {};
+  std::strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", &utc);
+
+  char name[64] = {};
+  std::snprintf(name, sizeof(name), ".%06llu.%s", static_cast<unsigned long long>(sequence), stamp);
+
+  return base.parent_path() / (base.stem().string() + name + base.extension().string());
+}
+
+//
+// Where a forked child writes in place of path (see
+// Profiler::EnableForkFollowing): /var/log/app/rsp.bin becomes
+// /var/log/app/rsp.pid4242.bin, and a rotating sink's segments go next to
+// that as rsp.pid4242.000001.20261018T182131Z.bin and so on.
+//
+
+inline std::filesystem::path PerProcessPath(const std::filesystem::path &path, pid_t pid) {
+  return path.parent_path() / (path.stem().string() + ".pid" + std::to_string(pid) + path.extension().string());
+}
+
+//
+// The segments of base on disk, oldest first.
+//
+
+inline std::vector<CaptureSegment> ListSegments(const std::filesystem::path &base) {
+  std::vector<CaptureSegment> segments;
+
+  const auto dir         = base.parent_path().empty() ? std::filesystem::path{"."} : base.parent_path();
+  const std::string stem = base.stem().string() + ".";
+  const std::string ext  = base.extension().string();
+
+  //
+  // Between the stem and the extension: "<sequence>.YYYYmmddTHHMMSSZ".
+  //
+
+  constexpr size_t kStampSize = 16;
+
+  std::error_code ec;
+  for (const auto &entry : std::filesystem::directory_iterator(dir, ec)) {
+    const std::string name = entry.path().filename().string();
+    if (name.size() <= stem.size() + ext.size() + kStampSize + 1 || !name.starts_with(stem) || !name.ends_with(ext)) {
+      continue;
+    }
+
+    const std::string_view middle = std::string_view{name}.substr(stem.size(), name.size() - stem.size() - ext.size());
+    const size_t dot              = middle.find('.');
+    if (dot == std::string_view::npos || middle.size() - dot - 1 != kStampSize || middle.back() != 'Z') {
+      continue;
+    }
+
+    CaptureSegment segment;
+    const auto [end, err] = std::from_chars(middle.data(), middle.data() + dot, segment.sequence);
+    if (err != std::errc{} || end != middle.data() + dot) {
+      continue;
+    }
+
+    std::error_code size_ec;
+    segment.path  = entry.path();
+    segment.bytes = entry.file_size(size_ec);
+    segments.push_back(std::move(segment));
+  }
+
+  std::sort(segments.begin(), segments.end(),
+            [](const CaptureSegment &a, const CaptureSegment &b) { return a.sequence < b.sequence; });
+
+  return segments;
+}
+
+//
+// Deletes the oldest segments of base until no more than max_segments are
+// left, taking up no more than max_bytes between them (0 for no limit).
+// The segment at keep, the one being written, is never deleted.
+//
+
+inline void PruneSegments(const std::filesystem::path &base, size_t max_segments, uint64_t max_bytes,
+                          const std::filesystem::path &keep) {
+  if (max_segments == 0 && max_bytes == 0) {
+    return;
+  }
+
+  const auto segments = ListSegments(base);
+
+  size_t count   = segments.size();
+  uint64_t total = 0;
+  for (const auto &segment : segments) {
+    total += segment.bytes;
+  }
+
+  for (const auto &segment : segments) {
+    const bool over = (max_segments && count > max_segments) || (max_bytes && total > max_bytes);
+    if (!over) {
+      break;
+    }
+    if (segment.path == keep) {
+      continue;
+    }
+
+    std::error_code ec;
+    if (std::filesystem::remove(segment.path, ec)) {
+      count--;
+      total -= segment.bytes;
+    }
+  }
+}
+
+}  // namespace rsp
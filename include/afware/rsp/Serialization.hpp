@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "CaptureFormat.hpp"
 #include "Machine.hpp"
 #include "Metadata.hpp"
 #include "Scope.hpp"
@@ -24,28 +25,55 @@
 #include "scope_info_generated.h"
 
 #include <array>
+#include <span>
 
 #include <flatbuffers/flatbuffers.h>
 
 namespace rsp {
 
-inline flatbuffers::DetachedBuffer SerializeScopeInfo(const ScopeInfo *scope_info, Machine *machine) {
+//
+// STRING_ID metadata carries its text the first time its id appears in
+// the current frame (or, for a bare stream, the file), as tracked by
+// written; without a StringIdSet, every record carries it.
+//
+
+inline flatbuffers::DetachedBuffer SerializeScopeInfo(const ScopeInfo *scope_info,
+                                                      Machine *machine,
+                                                      StringIdSet *written = nullptr) {
   flatbuffers::FlatBufferBuilder builder;
 
   auto tag_offset = builder.CreateString(scope_info->tag.c_str());
 
   std::vector<flatbuffers::Offset<RSP::MetadataEntry>> metadata_offsets;
-  uint8_t max_offset = scope_info->metadata_ptr->metadata_idx;
-  for (uint8_t i = 0; i < max_offset; ++i) {
-    const auto &m = scope_info->metadata_ptr->metadata[i];
-
+  auto add_metadata = [&](const MetadataEntry &m) {
     uint64_t value = 0;
     std::memcpy(&value, m.data.data(), sizeof(uint64_t));
 
+    flatbuffers::Offset<flatbuffers::String> m_text = 0;
+    if (m.type == MetadataType::STRING_ID && (!written || written->Insert(MetadataStringId(m)))) {
+      const auto text = MetadataString(m);
+      m_text          = builder.CreateString(text.data(), text.size());
+    }
+
     auto m_tag   = builder.CreateString(m.tag.c_str());
-    auto m_entry = RSP::CreateMetadataEntry(builder, m_tag, static_cast<RSP::MetadataType>(m.type), value);
+    auto m_entry = RSP::CreateMetadataEntry(builder, m_tag, static_cast<RSP::MetadataType>(m.type), value, m_text);
     metadata_offsets.push_back(m_entry);
+  };
+
+  //
+  // Typed metadata is spelled out field by field, ahead of the untyped
+  // entries (and any that spilled), so readers see one flat list.
+  //
+
+  if (const MetadataSlot *slot = scope_info->metadata_ptr) {
+    for (size_t i = 0; i < slot->TypedCount(); ++i) {
+      add_metadata(slot->TypedAt(i));
+    }
+    for (size_t i = 0; i < slot->MetadataCount(); ++i) {
+      add_metadata(slot->MetadataAt(i));
+    }
   }
+  const auto max_offset = static_cast<uint8_t>(metadata_offsets.size());
 
   auto metadata_vector = builder.CreateVector(metadata_offsets);
 
@@ -56,15 +84,76 @@ inline flatbuffers::DetachedBuffer SerializeScopeInfo(const ScopeInfo *scope_inf
                                        machine->GetNominalFreq(),
                                        max_offset,
                                        max_offset,
-                                       metadata_vector);
+                                       metadata_vector,
+                                       static_cast<RSP::RecordKind>(scope_info->kind),
+                                       scope_info->value,
+                                       scope_info->flow,
+                                       scope_info->perf.cycles,
+                                       scope_info->perf.instructions,
+                                       scope_info->perf.llc_misses,
+                                       scope_info->perf.branch_misses,
+                                       scope_info->allocs.tracked,
+                                       scope_info->allocs.inclusive.count,
+                                       scope_info->allocs.inclusive.bytes,
+                                       scope_info->allocs.exclusive.count,
+                                       scope_info->allocs.exclusive.bytes,
+                                       scope_info->rusage.sampled,
+                                       scope_info->rusage.voluntary_switches,
+                                       scope_info->rusage.involuntary_switches,
+                                       scope_info->rusage.minor_faults,
+                                       scope_info->rusage.major_faults);
 
   builder.Finish(scope_fb);
   return builder.Release();
 }
 
+//
+// Serializes records into frames of their own, for a sink that takes whole
+// frames from other threads (see SinkEncoded in Sinks.hpp).
+//
+
+class FrameEncoder {
+public:
+  FrameEncoder(Machine *machine, size_t frame_size) : machine_(machine), framer_(frame_size) {
+  }
+
+  void Add(const ScopeInfo &info) {
+    const auto buf = SerializeScopeInfo(&info, machine_, framer_.Strings());
+    framer_.Add(buf.data(), static_cast<uint32_t>(buf.size()));
+  }
+
+  bool Full() const {
+    return framer_.Full();
+  }
+
+  bool Empty() const {
+    return framer_.Empty();
+  }
+
+  uint32_t Count() const {
+    return framer_.Count();
+  }
+
+  std::span<const uint8_t> Seal() {
+    return framer_.Seal();
+  }
+
+  void Clear() {
+    framer_.Clear();
+  }
+
+private:
+  Machine *machine_;
+  CaptureFramer framer_;
+};
+
 inline std::ostream &operator<<(std::ostream &os, const RSP::MetadataEntry &m) {
   os << "{tag=" << (m.tag() ? m.tag()->c_str() : "<null>") << ", type=" << static_cast<int>(m.type())
-     << ", value=" << m.value() << "}";
+     << ", value=" << m.value();
+  if (m.text()) {
+    os << ", text=" << m.text()->c_str();
+  }
+  os << "}";
   return os;
 }
 
@@ -72,8 +161,32 @@ inline std::ostream &operator<<(std::ostream &os, const RSP::ScopeInfo *scope) {
   if (!scope) return os;
 
   os << "Scope[" << (scope->tag() ? scope->tag()->c_str() : "<null>") << "] " << "ticks_start=" << scope->ticks_start()
-     << " ticks_end=" << scope->ticks_end() << " machine_nominal_freq_hz=" << scope->machine_nominal_freq_hz()
-     << " metadata={";
+     << " ticks_end=" << scope->ticks_end() << " machine_nominal_freq_hz=" << scope->machine_nominal_freq_hz();
+
+  if (scope->kind() != RSP::RecordKind_SCOPE) {
+    os << " kind=" << RSP::EnumNameRecordKind(scope->kind()) << " value=" << scope->value();
+  }
+
+  if (scope->flow()) {
+    os << " flow=" << scope->flow();
+  }
+
+  if (scope->perf_cycles() || scope->perf_instructions()) {
+    os << " cycles=" << scope->perf_cycles() << " instructions=" << scope->perf_instructions()
+       << " llc_misses=" << scope->perf_llc_misses() << " branch_misses=" << scope->perf_branch_misses();
+  }
+
+  if (scope->allocs_tracked()) {
+    os << " allocs=" << scope->alloc_count() << "/" << scope->alloc_bytes() << "B"
+       << " self=" << scope->alloc_self_count() << "/" << scope->alloc_self_bytes() << "B";
+  }
+
+  if (scope->rusage_sampled()) {
+    os << " vcsw=" << scope->voluntary_switches() << " ivcsw=" << scope->involuntary_switches()
+       << " minflt=" << scope->minor_faults() << " majflt=" << scope->major_faults();
+  }
+
+  os << " metadata={";
 
   bool first        = true;
   auto metadata_vec = scope->metadata();
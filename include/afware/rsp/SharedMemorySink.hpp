@@ -0,0 +1,438 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "Machine.hpp"
+#include "Scope.hpp"
+#include "Segments.hpp"
+#include "Serialization.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rsp {
+
+//
+// A sink that publishes records into a memory mapped ring (normally a file
+// under /dev/shm), so that any number of other processes can tail the
+// profile live, without any file I/O and without the producer ever waiting
+// on them. Readers that fall behind get lapped and lose records - they never
+// slow the producer down.
+//
+// Layout of the mapping (all integers little endian):
+//
+//   [0, 4096)     ShmRingHeader
+//   [4096, ...)   `capacity` bytes of ring data (a power of two)
+//
+// Each record in the ring is
+//
+//   [uint64 sequence][uint32 len][uint32 reserved][flatbuffer: len bytes]
+//
+// padded out to 8 bytes. Records wrap byte-wise around the end of the ring.
+// Positions (`write_pos`, `oldest_pos`) are monotonically increasing byte
+// counts; the offset into the ring is `pos & (capacity - 1)`.
+//
+// The protocol is a seqlock over `oldest_pos`. The single writer:
+//
+//   1. Advances `oldest_pos` past every record the new one will overwrite,
+//      followed by a release fence.
+//   2. Copies the record in.
+//   3. Publishes it by storing the new `write_pos` (release).
+//
+// A reader holding its own position `pos`:
+//
+//   1. Loads `write_pos` (acquire). Nothing new if it equals `pos`.
+//   2. Copies the record at `pos` out.
+//   3. Issues an acquire fence and reloads `oldest_pos`. If it has moved
+//      past `pos`, the copy may be torn: the reader was lapped, so it drops
+//      the copy and resynchronizes at `oldest_pos`.
+//
+// The sequence numbers let readers count exactly how many records they lost.
+//
+
+#if !defined(RSP_SHM_RING_CAPACITY)
+#define RSP_SHM_RING_CAPACITY (64 * 1024 * 1024)
+#endif
+
+static constexpr uint64_t kShmRingMagic   = 0x31524d4853505352;  // "RSPSHMR1"
+static constexpr uint32_t kShmRingVersion = 1;
+
+struct ShmRingHeader {
+  std::atomic<uint64_t> magic;
+  uint32_t version;
+  uint32_t header_size;
+  uint64_t capacity;
+  uint64_t machine_nominal_freq_hz;
+  uint64_t writer_pid;
+
+  //
+  // Writer and reader state live on separate cache lines.
+  //
+
+  alignas(64) std::atomic<uint64_t> write_pos;
+  uint64_t next_sequence;
+  alignas(64) std::atomic<uint64_t> oldest_pos;
+};
+
+static_assert(sizeof(ShmRingHeader) <= 4096);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+static constexpr size_t kShmRingDataOffset   = 4096;
+static constexpr size_t kShmRingRecordHeader = 16;
+
+namespace detail {
+
+inline uint64_t ShmRecordSize(uint32_t len) {
+  return (kShmRingRecordHeader + len + 7) & ~uint64_t{7};
+}
+
+inline void ShmRingWrite(uint8_t *ring, uint64_t capacity, uint64_t pos, const void *src, size_t len) {
+  const uint64_t off   = pos & (capacity - 1);
+  const size_t first   = std::min<uint64_t>(len, capacity - off);
+  const auto *src_data = static_cast<const uint8_t *>(src);
+  std::memcpy(ring + off, src_data, first);
+  std::memcpy(ring, src_data + first, len - first);
+}
+
+inline void ShmRingRead(const uint8_t *ring, uint64_t capacity, uint64_t pos, void *dst, size_t len) {
+  const uint64_t off = pos & (capacity - 1);
+  const size_t first = std::min<uint64_t>(len, capacity - off);
+  auto *dst_data     = static_cast<uint8_t *>(dst);
+  std::memcpy(dst_data, ring + off, first);
+  std::memcpy(dst_data + first, ring, len - first);
+}
+
+}  // namespace detail
+
+class SharedMemorySink {
+public:
+  //
+  // `capacity` is rounded up to a power of two. The file is created (or
+  // truncated) and left in place on destruction so late readers can still
+  // drain it - remove it yourself when you're done.
+  //
+
+  SharedMemorySink(std::filesystem::path path, Machine *machine, uint64_t capacity = RSP_SHM_RING_CAPACITY)
+      : path_(path), machine_(machine) {
+    capacity_ = std::bit_ceil(std::max<uint64_t>(capacity, 4096));
+
+    //
+    // Readers of a previous ring at this path may still have it mapped, and
+    // truncating it under them would SIGBUS them. Start on a fresh inode.
+    //
+
+    unlink(path.c_str());
+
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return;
+    }
+
+    map_size_ = kShmRingDataOffset + capacity_;
+    if (ftruncate(fd, static_cast<off_t>(map_size_)) != 0) {
+      close(fd);
+      return;
+    }
+
+    void *p = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+      return;
+    }
+
+    map_    = static_cast<uint8_t *>(p);
+    header_ = new (map_) ShmRingHeader{};
+    ring_   = map_ + kShmRingDataOffset;
+
+    header_->version                 = kShmRingVersion;
+    header_->header_size             = kShmRingDataOffset;
+    header_->capacity                = capacity_;
+    header_->machine_nominal_freq_hz = machine_->GetNominalFreq();
+    header_->writer_pid              = static_cast<uint64_t>(getpid());
+
+    //
+    // The magic goes in last, so a reader that sees it sees a complete header.
+    //
+
+    header_->magic.store(kShmRingMagic, std::memory_order_release);
+  }
+
+  SharedMemorySink(const SharedMemorySink &)            = delete;
+  SharedMemorySink &operator=(const SharedMemorySink &) = delete;
+
+  ~SharedMemorySink() {
+    if (map_) {
+      munmap(map_, map_size_);
+    }
+  }
+
+  //
+  // Readers attach at any point and the ring overwrites, so every record
+  // spells out its interned strings.
+  //
+
+  void Sink(const ScopeInfo &info) {
+    auto buf = SerializeScopeInfo(&info, machine_);
+    Publish(buf.data(), buf.size());
+  }
+
+  //
+  // Copies one already serialized record into the ring. Records larger than
+  // the ring are dropped.
+  //
+
+  void Publish(const uint8_t *data, size_t len) {
+    const uint64_t size = detail::ShmRecordSize(static_cast<uint32_t>(len));
+    if (!map_ || size > capacity_) {
+      return;
+    }
+
+    const uint64_t write_pos = header_->write_pos.load(std::memory_order_relaxed);
+    uint64_t oldest_pos      = header_->oldest_pos.load(std::memory_order_relaxed);
+
+    //
+    // Retire whatever we're about to overwrite, and tell readers before we
+    // touch a byte of it.
+    //
+
+    if (write_pos + size - oldest_pos > capacity_) {
+      while (write_pos + size - oldest_pos > capacity_) {
+        uint32_t old_len = 0;
+        detail::ShmRingRead(ring_, capacity_, oldest_pos + sizeof(uint64_t), &old_len, sizeof(old_len));
+        oldest_pos += detail::ShmRecordSize(old_len);
+      }
+      header_->oldest_pos.store(oldest_pos, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    uint8_t record_header[kShmRingRecordHeader] = {};
+    const uint64_t sequence                     = header_->next_sequence++;
+    const uint32_t len32                        = static_cast<uint32_t>(len);
+    std::memcpy(record_header, &sequence, sizeof(sequence));
+    std::memcpy(record_header + sizeof(sequence), &len32, sizeof(len32));
+
+    detail::ShmRingWrite(ring_, capacity_, write_pos, record_header, sizeof(record_header));
+    detail::ShmRingWrite(ring_, capacity_, write_pos + kShmRingRecordHeader, data, len);
+
+    header_->write_pos.store(write_pos + size, std::memory_order_release);
+  }
+
+  bool OK() const {
+    return map_ != nullptr;
+  }
+
+  uint64_t Capacity() const {
+    return capacity_;
+  }
+
+  //
+  // Bytes published into the ring since it was created, framing included.
+  //
+
+  uint64_t BytesWritten() const {
+    return map_ ? header_->write_pos.load(std::memory_order_relaxed) : 0;
+  }
+
+  //
+  // A ring like this one for a forked child, at PerProcessPath() (see
+  // Profiler::EnableForkFollowing): a ring only has the one writer.
+  //
+
+  std::shared_ptr<SharedMemorySink> ReopenForProcess(pid_t pid) const {
+    return std::make_shared<SharedMemorySink>(PerProcessPath(path_, pid), machine_, capacity_);
+  }
+
+private:
+  std::filesystem::path path_;
+  Machine *machine_      = nullptr;
+  uint8_t *map_          = nullptr;
+  size_t map_size_       = 0;
+  ShmRingHeader *header_ = nullptr;
+  uint8_t *ring_         = nullptr;
+  uint64_t capacity_     = 0;
+};
+
+//
+// Tails a ring written by SharedMemorySink. Lock-free and read-only: readers
+// don't coordinate with the writer or each other.
+//
+
+class SharedMemoryReader {
+public:
+  enum class Status : uint8_t {
+    OK     = 0,  // A record was copied out.
+    EMPTY  = 1,  // Caught up with the writer.
+    LAPPED = 2,  // Fell behind and skipped ahead; see Dropped(). Just call Next() again.
+  };
+
+  //
+  // Starts at the oldest record still in the ring; pass `from_start = false`
+  // to only see records published from now on.
+  //
+
+  explicit SharedMemoryReader(const std::filesystem::path &path, bool from_start = true) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kShmRingDataOffset) {
+      close(fd);
+      return;
+    }
+
+    map_size_ = static_cast<size_t>(st.st_size);
+    void *p   = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+      return;
+    }
+
+    map_    = static_cast<const uint8_t *>(p);
+    header_ = reinterpret_cast<const ShmRingHeader *>(map_);
+
+    const uint64_t magic = header_->magic.load(std::memory_order_acquire);
+    if (magic != kShmRingMagic || header_->version != kShmRingVersion ||
+        header_->header_size + header_->capacity > map_size_ || !std::has_single_bit(header_->capacity)) {
+      munmap(const_cast<uint8_t *>(map_), map_size_);
+      map_ = nullptr;
+      return;
+    }
+
+    capacity_ = header_->capacity;
+    ring_     = map_ + header_->header_size;
+    pos_      = from_start ? header_->oldest_pos.load(std::memory_order_acquire)
+                           : header_->write_pos.load(std::memory_order_acquire);
+  }
+
+  SharedMemoryReader(const SharedMemoryReader &)            = delete;
+  SharedMemoryReader &operator=(const SharedMemoryReader &) = delete;
+
+  ~SharedMemoryReader() {
+    if (map_) {
+      munmap(const_cast<uint8_t *>(map_), map_size_);
+    }
+  }
+
+  //
+  // Copies the next record's flatbuffer into `out`. Verify it (as you would
+  // one read from disk) before use.
+  //
+
+  Status Next(std::vector<uint8_t> *out, uint64_t *sequence = nullptr) {
+    if (!map_) {
+      return Status::EMPTY;
+    }
+
+    if (header_->write_pos.load(std::memory_order_acquire) == pos_) {
+      return Status::EMPTY;
+    }
+
+    uint8_t record_header[kShmRingRecordHeader];
+    detail::ShmRingRead(ring_, capacity_, pos_, record_header, sizeof(record_header));
+
+    uint64_t seq = 0;
+    uint32_t len = 0;
+    std::memcpy(&seq, record_header, sizeof(seq));
+    std::memcpy(&len, record_header + sizeof(seq), sizeof(len));
+
+    //
+    // A torn header can hold any length; only trust it once validated below.
+    //
+
+    const bool sane = detail::ShmRecordSize(len) <= capacity_;
+    if (sane) {
+      out->resize(len);
+      detail::ShmRingRead(ring_, capacity_, pos_ + kShmRingRecordHeader, out->data(), len);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t oldest = header_->oldest_pos.load(std::memory_order_relaxed);
+
+    if (oldest > pos_) {
+      pos_ = oldest;
+      return Status::LAPPED;
+    }
+
+    //
+    // Not lapped, yet the length is garbage - the ring is corrupt. Skip
+    // everything published so far rather than spin on it.
+    //
+
+    if (!sane) {
+      pos_           = header_->write_pos.load(std::memory_order_acquire);
+      have_sequence_ = false;
+      return Status::LAPPED;
+    }
+
+    if (have_sequence_ && seq != next_sequence_) {
+      dropped_ += seq - next_sequence_;
+    }
+
+    next_sequence_ = seq + 1;
+    have_sequence_ = true;
+    pos_ += detail::ShmRecordSize(len);
+
+    if (sequence) {
+      *sequence = seq;
+    }
+
+    return Status::OK;
+  }
+
+  bool OK() const {
+    return map_ != nullptr;
+  }
+
+  //
+  // Records that were overwritten before we got to them.
+  //
+
+  uint64_t Dropped() const {
+    return dropped_;
+  }
+
+  uint64_t GetNominalFreq() const {
+    return map_ ? header_->machine_nominal_freq_hz : 0;
+  }
+
+private:
+  const uint8_t *map_          = nullptr;
+  size_t map_size_             = 0;
+  const ShmRingHeader *header_ = nullptr;
+  const uint8_t *ring_         = nullptr;
+  uint64_t capacity_           = 0;
+  uint64_t pos_                = 0;
+  uint64_t next_sequence_      = 0;
+  bool have_sequence_          = false;
+  uint64_t dropped_            = 0;
+};
+
+}  // namespace rsp
@@ -16,50 +16,468 @@
 
 #pragma once
 
+#include "CaptureFormat.hpp"
 #include "Machine.hpp"
 #include "Metadata.hpp"
+#include "Segments.hpp"
 #include "Serialization.hpp"
 
+#include <chrono>
+#include <concepts>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
 
 namespace rsp {
 
 enum class SinkType : uint8_t {
-  SILENT      = 0,
-  COUT        = 1,
-  BINARY_DISK = 2,
+  SILENT          = 0,
+  COUT            = 1,
+  BINARY_DISK     = 2,
+  ASYNC_DISK      = 3,
+  SHARED_MEMORY   = 4,
+  BLOCK_DISK      = 5,
+  FLIGHT_RECORDER = 6,
+  CUSTOM          = 7,  // A user sink, or several sinks at once (see Profiler::SetSinks).
+  UNIX_SOCKET     = 8,
+};
+
+//
+// A sink is any type with one of
+//
+//   void Sink(const ScopeInfo &info);
+//   void SinkBatch(std::span<const ScopeInfo> batch);
+//
+// The sink thread hands records over in batches (of up to
+// RSP_PROFILER_SINK_BATCH), through one indirect call per batch; sinks
+// without SinkBatch() get the records one at a time from a loop compiled
+// against their concrete type, so there's no indirect call per record.
+// Records (and their metadata) are only valid for the duration of the call.
+//
+// A sink that writes self-contained chunks - frames, blocks - can also have
+//
+//   using Encoder = ...;
+//   std::optional<Encoder> MakeEncoder() const;
+//   void SinkEncoded(std::span<const uint8_t> chunk, uint32_t records);
+//
+// where an Encoder has Add(const ScopeInfo &), Full(), Empty(), Count(),
+// Seal() (the finished chunk) and Clear(), like FrameEncoder. The extra
+// sink threads (see SinkThreadOptions::per_numa_node) then each encode into
+// chunks of their own, and only hand the sink finished ones; MakeEncoder()
+// returns nothing when the sink can't take chunks as it's set up.
+//
+// A sink that holds records back (a partial frame or block, a stream
+// buffer) can have
+//
+//   void Flush();
+//
+// to write them out, which Profiler::Stop() calls once the sink threads
+// have finished. And one with work that falls due by the clock rather
+// than per record (time-based rotation) can have
+//
+//   void Tick();
+//
+// which the sink thread calls whenever it finds the queue empty, so that
+// work doesn't wait on the next record.
+//
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool kHasSinkBatch = requires(T &sink, std::span<const ScopeInfo> batch) { sink.SinkBatch(batch); };
+
+template <typename T>
+inline constexpr bool kHasSink = requires(T &sink, const ScopeInfo &info) { sink.Sink(info); };
+
+template <typename T>
+inline constexpr bool kHasFlush = requires(T &sink) { sink.Flush(); };
+
+template <typename T>
+inline constexpr bool kHasTick = requires(T &sink) { sink.Tick(); };
+
+template <typename T>
+inline constexpr bool kHasEncoder = requires(T &sink, std::span<const uint8_t> chunk, uint32_t records) {
+  typename T::Encoder;
+  { sink.MakeEncoder() } -> std::same_as<std::optional<typename T::Encoder>>;
+  sink.SinkEncoded(chunk, records);
+};
+
+struct NoEncoder {};
+
+template <typename T>
+struct EncoderOf {
+  using type = NoEncoder;
+};
+
+template <typename T>
+  requires kHasEncoder<T>
+struct EncoderOf<T> {
+  using type = typename T::Encoder;
+};
+
+}  // namespace detail
+
+template <typename T>
+inline void SinkBatch(T &sink, std::span<const ScopeInfo> batch) {
+  static_assert(detail::kHasSinkBatch<T> || detail::kHasSink<T>,
+                "A sink needs a Sink(const ScopeInfo &) or SinkBatch(std::span<const ScopeInfo>) member");
+
+  if constexpr (detail::kHasSinkBatch<T>) {
+    sink.SinkBatch(batch);
+  } else {
+    for (const auto &info : batch) {
+      sink.Sink(info);
+    }
+  }
+}
+
+template <typename T>
+inline void FlushSink(T &sink) {
+  if constexpr (detail::kHasFlush<T>) {
+    sink.Flush();
+  }
+}
+
+template <typename T>
+inline void TickSink(T &sink) {
+  if constexpr (detail::kHasTick<T>) {
+    sink.Tick();
+  }
+}
+
+//
+// A sink as one of several sink threads sees it, the threads taking turns
+// with the sink itself under mutex. Records are encoded on the calling
+// thread where the sink has an encoder, and handed over a chunk at a time
+// as chunks fill up or on Seal(); otherwise they're handed over as they
+// come.
+//
+
+template <typename T>
+class SharedSink {
+public:
+  SharedSink(std::shared_ptr<T> sink, std::mutex *mutex) : sink_(std::move(sink)), mutex_(mutex) {
+    if constexpr (detail::kHasEncoder<T>) {
+      encoder_ = sink_->MakeEncoder();
+    }
+  }
+
+  void SinkBatch(std::span<const ScopeInfo> batch) {
+    if constexpr (detail::kHasEncoder<T>) {
+      if (encoder_) {
+        for (const auto &info : batch) {
+          if (encoder_->Empty()) {
+            opened_ = std::chrono::steady_clock::now();
+          }
+          encoder_->Add(info);
+          if (encoder_->Full()) {
+            HandOver();
+          }
+        }
+        return;
+      }
+    }
+
+    const std::scoped_lock lock{*mutex_};
+    rsp::SinkBatch(*sink_, batch);
+  }
+
+  //
+  // Hands over the partial chunk, if any, once its first record has waited
+  // at least min_age - so that a quiet thread doesn't write a tiny chunk
+  // every time it wakes up.
+  //
+
+  void Seal(std::chrono::milliseconds min_age = {}) {
+    if constexpr (detail::kHasEncoder<T>) {
+      if (encoder_ && !encoder_->Empty() &&
+          (min_age.count() == 0 || std::chrono::steady_clock::now() - opened_ >= min_age)) {
+        HandOver();
+      }
+    }
+  }
+
+private:
+  void HandOver() {
+    const auto chunk = encoder_->Seal();
+    {
+      const std::scoped_lock lock{*mutex_};
+      sink_->SinkEncoded(chunk, encoder_->Count());
+    }
+    encoder_->Clear();
+  }
+
+  std::shared_ptr<T> sink_;
+  std::mutex *mutex_;
+  std::optional<typename detail::EncoderOf<T>::type> encoder_;
+  std::chrono::steady_clock::time_point opened_;
+};
+
+//
+// Discards everything - handy for measuring the cost of the pipeline itself.
+//
+
+class SilentSink {
+public:
+  void Sink(const ScopeInfo &info) {
+    (void)info;
+  }
+};
+
+//
+// Human readable output, one scope per line.
+//
+
+class CoutSink {
+public:
+  void Sink(const ScopeInfo &info) {
+    std::cout << info << "\n";
+  }
+
+  void Flush() {
+    std::cout.flush();
+  }
 };
 
 //
 // Serialize the output to disk as a Flatbuffer.
 //
+// By default records are written in frames (see CaptureFormat.hpp), so a
+// frame's worth of records (RSP_CAPTURE_FRAME_SIZE) is held back until it
+// fills up, the session stops (see Flush()) or the sink is destroyed. Set framed = false for the bare
+// [uint32 len][flatbuffer] stream older tools expect.
+//
+// Set rotate_bytes and/or rotate_interval to write a series of segments
+// (see Segments.hpp) rather than the one file: path then only names the
+// series, and the sink moves on to a new segment once the current one has
+// taken rotate_bytes, or has been open for rotate_interval (checked as
+// records arrive, and by Tick() while there are none). Each segment is a complete capture with its own header,
+// ending on a frame boundary - so may run over rotate_bytes by up to a frame.
+//
+// max_segments and max_total_bytes bound what's kept on disk: on rotating,
+// the oldest segments are deleted until both hold (0 for no limit).
+//
+
+struct BinaryDiskSinkOptions {
+  bool framed                          = true;
+  size_t frame_size                    = RSP_CAPTURE_FRAME_SIZE;
+  uint64_t rotate_bytes                = 0;
+  std::chrono::seconds rotate_interval = std::chrono::seconds{0};
+  size_t max_segments                  = 0;
+  uint64_t max_total_bytes             = 0;
+};
 
 class BinaryDiskSink {
 public:
-  BinaryDiskSink(std::filesystem::path path, Machine *machine) {
+  BinaryDiskSink(std::filesystem::path path, Machine *machine, BinaryDiskSinkOptions options = {})
+      : framer_(options.frame_size) {
     machine_ = machine;
-    fd_.open(path, std::ios::binary | std::ios::app);
+    path_    = std::move(path);
+    options_ = options;
+
+    if (Rotating()) {
+      const auto existing = ListSegments(path_);
+      sequence_           = existing.empty() ? 1 : existing.back().sequence + 1;
+      OpenSegment();
+      return;
+    }
+
+    framed_ = options_.framed && ShouldWriteFramed(path_);
+
+    std::error_code ec;
+    const auto existing = std::filesystem::file_size(path_, ec);
+    const bool fresh    = ec || existing == 0;
+
+    fd_.open(path_, std::ios::binary | std::ios::app);
+
+    if (fd_ && framed_ && fresh) {
+      const auto header = MakeCaptureHeader(machine_);
+      Write(header.data(), header.size());
+    }
+  }
+
+  BinaryDiskSink(const BinaryDiskSink &)            = delete;
+  BinaryDiskSink &operator=(const BinaryDiskSink &) = delete;
+
+  ~BinaryDiskSink() {
+    Flush();
   }
 
   void Sink(const ScopeInfo &info) {
-    auto buf     = SerializeScopeInfo(&info, machine_);
+    auto buf     = SerializeScopeInfo(&info, machine_, framed_ ? framer_.Strings() : &strings_);
     uint32_t len = buf.size();
-    fd_.write(reinterpret_cast<char *>(&len), sizeof(len));
-    fd_.write(reinterpret_cast<const char *>(buf.data()), len);
+
+    if (framed_) {
+      framer_.Add(buf.data(), len);
+      if (framer_.Full()) {
+        Flush();
+      }
+    } else {
+      Write(&len, sizeof(len));
+      Write(buf.data(), len);
+    }
+
+    if (Rotating() && RotationDue()) {
+      Rotate();
+    }
+  }
+
+  //
+  // See Encoder above. Frames from other threads go straight to the file,
+  // between our own.
+  //
+
+  using Encoder = FrameEncoder;
+
+  std::optional<Encoder> MakeEncoder() const {
+    if (!framed_) {
+      return std::nullopt;
+    }
+    return Encoder(machine_, options_.frame_size);
+  }
+
+  void SinkEncoded(std::span<const uint8_t> frame, uint32_t) {
+    Write(frame.data(), frame.size());
+
+    if (Rotating() && RotationDue()) {
+      Rotate();
+    }
+  }
+
+  //
+  // Writes out the current (partial) frame, and the stream's buffer.
+  //
+
+  void Flush() {
+    if (!framer_.Empty()) {
+      const auto &frame = framer_.Seal();
+      Write(frame.data(), frame.size());
+      framer_.Clear();
+    }
+    fd_.flush();
+  }
+
+  //
+  // Rotates a segment that's been open for rotate_interval, when no records
+  // have come along to do it.
+  //
+
+  void Tick() {
+    if (Rotating() && RotationDue()) {
+      Rotate();
+    }
+  }
+
+  //
+  // Closes the current segment and starts the next one. Only meaningful for
+  // a rotating sink.
+  //
+
+  void Rotate() {
+    if (!Rotating()) {
+      return;
+    }
+
+    Flush();
+    fd_.close();
+
+    sequence_++;
+    OpenSegment();
+
+    PruneSegments(path_, options_.max_segments, options_.max_total_bytes, segment_path_);
   }
 
   bool OK() const {
     return fd_.is_open();
   }
 
+  bool Framed() const {
+    return framed_;
+  }
+
+  bool Rotating() const {
+    return options_.rotate_bytes > 0 || options_.rotate_interval.count() > 0;
+  }
+
+  //
+  // The file being written to: path itself, or the current segment.
+  //
+
+  const std::filesystem::path &CurrentPath() const {
+    return Rotating() ? segment_path_ : path_;
+  }
+
+  uint64_t Sequence() const {
+    return sequence_;
+  }
+
+  //
+  // A sink like this one for a forked child, writing to PerProcessPath()
+  // (see Profiler::EnableForkFollowing).
+  //
+
+  std::shared_ptr<BinaryDiskSink> ReopenForProcess(pid_t pid) const {
+    return std::make_shared<BinaryDiskSink>(PerProcessPath(path_, pid), machine_, options_);
+  }
+
+  //
+  // Bytes handed to the stream by this sink (which may not have hit the disk yet).
+  //
+
+  uint64_t BytesWritten() const {
+    return bytes_written_;
+  }
+
 private:
+  void OpenSegment() {
+    segment_path_   = SegmentPath(path_, sequence_, std::chrono::system_clock::now());
+    segment_opened_ = std::chrono::steady_clock::now();
+    segment_bytes_  = 0;
+    framed_         = options_.framed;
+    strings_.Clear();
+
+    fd_.open(segment_path_, std::ios::binary | std::ios::trunc);
+
+    if (fd_ && framed_) {
+      const auto header = MakeCaptureHeader(machine_);
+      Write(header.data(), header.size());
+    }
+  }
+
+  bool RotationDue() const {
+    if (options_.rotate_bytes > 0 && segment_bytes_ >= options_.rotate_bytes) {
+      return true;
+    }
+    return options_.rotate_interval.count() > 0 &&
+           std::chrono::steady_clock::now() - segment_opened_ >= options_.rotate_interval;
+  }
+
+  void Write(const void *data, size_t len) {
+    fd_.write(static_cast<const char *>(data), static_cast<std::streamsize>(len));
+    bytes_written_ += len;
+    segment_bytes_ += len;
+  }
+
   std::ofstream fd_;
   Machine *machine_;
+  std::filesystem::path path_;
+  BinaryDiskSinkOptions options_;
+  bool framed_ = true;
+  CaptureFramer framer_;
+  StringIdSet strings_;
+  uint64_t bytes_written_ = 0;
+
+  std::filesystem::path segment_path_;
+  std::chrono::steady_clock::time_point segment_opened_;
+  uint64_t sequence_      = 0;
+  uint64_t segment_bytes_ = 0;
 };
 
 }  // namespace rsp
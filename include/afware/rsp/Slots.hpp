@@ -17,12 +17,15 @@
 #pragma once
 
 #include "Metadata.hpp"
+#include "MetadataSchema.hpp"
 #include "Queue.hpp"
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <stdexcept>
 #include <vector>
 
@@ -32,20 +35,75 @@ namespace rsp {
 #define RSP_MAX_METADATA_ENTRIES 8
 #endif
 
+//
+// Untyped metadata past RSP_MAX_METADATA_ENTRIES goes to a per-slot spill
+// vector, up to this many more entries; anything after that is dropped. The
+// vector's capacity stays with the slot, so a scope that keeps spilling only
+// allocates the first time round.
+//
+
+#if !defined(RSP_MAX_METADATA_SPILL)
+#define RSP_MAX_METADATA_SPILL 128
+#endif
+
+static_assert(RSP_MAX_METADATA_ENTRIES + RSP_MAX_METADATA_SPILL + RSP_MAX_METADATA_SCHEMA_FIELDS <= 255,
+              "Metadata counts are stored in a byte");
+
 struct MetadataSlot {
   uint8_t metadata_idx                                         = 0;
   std::array<MetadataEntry, RSP_MAX_METADATA_ENTRIES> metadata = {};
+  std::vector<MetadataEntry> spill;
+
+  //
+  // Typed metadata (see MetadataSchema.hpp): the schema, and the values
+  // packed as it lays them out.
+  //
+
+  const MetadataSchema *schema                         = nullptr;
+  std::array<std::byte, RSP_TYPED_METADATA_SIZE> typed = {};
 
   void MakePristine() {
     for (uint8_t i = 0; i < metadata_idx; ++i) {
       metadata[i] = MetadataEntry();
     }
     metadata_idx = 0;
+    spill.clear();
+    schema = nullptr;
   }
 
   template <typename T>
   void AddMetadata(MetadataTag tag, T val) {
-    metadata.at(metadata_idx++) = MakeScopeMetadata<T>(tag, val);
+    if (metadata_idx < RSP_MAX_METADATA_ENTRIES) {
+      metadata[metadata_idx++] = MakeScopeMetadata<T>(tag, val);
+    } else if (spill.size() < RSP_MAX_METADATA_SPILL) {
+      spill.push_back(MakeScopeMetadata<T>(tag, val));
+    }
+  }
+
+  template <typename T>
+  void SetTypedMetadata(const T &value) {
+    PackMetadata(value, typed.data());
+    schema = &kMetadataSchema<T>;
+  }
+
+  //
+  // Untyped entries, inline ones first and then the spill.
+  //
+
+  size_t MetadataCount() const {
+    return metadata_idx + spill.size();
+  }
+
+  const MetadataEntry &MetadataAt(size_t i) const {
+    return i < metadata_idx ? metadata[i] : spill[i - metadata_idx];
+  }
+
+  size_t TypedCount() const {
+    return schema ? schema->field_count : 0;
+  }
+
+  MetadataEntry TypedAt(size_t i) const {
+    return schema->Entry(typed.data(), i);
   }
 };
 
@@ -62,6 +120,8 @@ public:
       slots_.emplace_back(std::make_unique<Slot>());
       free_list_.enqueue(slots_.back().get());
     }
+
+    slot_count_ = slots_.size();
   }
 
   Slot *Acquire() {
@@ -109,14 +169,69 @@ public:
   }
 
   void Release(Slot *slot) {
+    //
+    // Event records (counters, gauges, instants) never take a slot.
+    //
+
+    if (!slot) {
+      return;
+    }
+
     slot->MakePristine();
     free_list_.enqueue(slot);
   }
 
+  //
+  // Total number of slots owned by the storage (in use or free). This only
+  // ever grows, so it's a handy way to spot pool expansion.
+  //
+
+  size_t SlotCount() const {
+    return slot_count_.load(std::memory_order_relaxed);
+  }
+
+  //
+  // Held across fork() (see Profiler), so that a child never inherits the
+  // expansion lock from a thread that doesn't exist there.
+  //
+
+  void LockForFork() {
+    expansion_mutex_.lock();
+  }
+
+  void UnlockAfterFork() {
+    expansion_mutex_.unlock();
+  }
+
+  //
+  // Rebuilds the pool in a forked child. The slots out in the child can't
+  // be told apart - records still queued for the parent's sink thread,
+  // scopes open on threads the child doesn't have, and scopes open on the
+  // forking thread, which will still be released - so every existing slot
+  // is left as it is, never freed, and the pool starts over with fresh
+  // ones. A released old slot simply joins the new pool.
+  //
+
+  void ResetAfterFork() {
+    for (auto &slot : slots_) {
+      static_cast<void>(slot.release());
+    }
+    slots_.clear();
+    new (&free_list_) FreeList();
+
+    for (size_t i = 0; i < NumSlots; ++i) {
+      slots_.emplace_back(std::make_unique<Slot>());
+      free_list_.enqueue(slots_.back().get());
+    }
+
+    slot_count_.store(slots_.size(), std::memory_order_relaxed);
+  }
+
 private:
   std::vector<std::unique_ptr<Slot>> slots_;
   FreeList free_list_;
   std::mutex expansion_mutex_;
+  std::atomic<size_t> slot_count_ = 0;
 
   //
   // I couldn't think of a better strategy here.
@@ -132,6 +247,8 @@ private:
       slots_.emplace_back(std::make_unique<Slot>());
       free_list_.enqueue(slots_.back().get());
     }
+
+    slot_count_.store(slots_.size(), std::memory_order_relaxed);
   }
 };
 
@@ -0,0 +1,164 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "CallSites.hpp"
+#include "Machine.hpp"
+#include "Metadata.hpp"
+#include "Profiler.hpp"
+#include "Scope.hpp"
+
+#include <utility>
+
+namespace rsp {
+
+//
+// An explicitly ended scope, for work that doesn't stay on one thread's
+// stack: coroutines that suspend and resume elsewhere, tasks handed between
+// pool threads, request pipelines.
+//
+// Unlike ActiveScope, a Span never touches the thread-local scope stack.
+// Beginning one acquires a metadata slot and reads the clock; the token can
+// then be moved anywhere - into a coroutine frame, a task, a lambda capture -
+// and metadata is attached through it rather than RSP_SCOPE_METADATA. End()
+// may be called on any thread; a span that is still open when its token is
+// destroyed ends there, and Discard() drops it without recording anything.
+//
+// A span is not synchronized: only one thread should be using it at a time,
+// with the usual happens-before on the hand off (which a queue, a mutex or a
+// coroutine resumption all provide).
+//
+// Nothing here allocates: the token is a ScopeInfo and a flag, and the
+// metadata lives in a pooled slot.
+//
+
+class Span {
+public:
+  //
+  // An empty span, which records nothing.
+  //
+
+  Span() : info_(ScopeTag{""}) {
+  }
+
+  //
+  // What RSP_BEGIN_SPAN uses: stays empty if the site is disabled or the
+  // profiler isn't capturing.
+  //
+
+  explicit Span(CallSite &site) : info_(ScopeTag{""}) {
+    if (site.Enabled() && Instance().Capturing()) {
+      Begin(site.Name());
+    }
+  }
+
+  template <bool CompiledIn>
+  static Span Begin(CallSite &site) {
+    if constexpr (CompiledIn) {
+      return Span{site};
+    } else {
+      return Span{};
+    }
+  }
+
+  Span(Span &&other) noexcept : info_(other.info_), open_(std::exchange(other.open_, false)) {
+  }
+
+  Span &operator=(Span &&other) noexcept {
+    if (this != &other) {
+      End();
+      info_ = other.info_;
+      open_ = std::exchange(other.open_, false);
+    }
+    return *this;
+  }
+
+  Span(const Span &)            = delete;
+  Span &operator=(const Span &) = delete;
+
+  ~Span() {
+    End();
+  }
+
+  template <typename T>
+  void AddMetadata(MetadataTag tag, T val) {
+    if (open_) {
+      info_.AddMetadata(tag, val);
+    }
+  }
+
+  template <typename T>
+  void SetTypedMetadata(const T &value) {
+    if (open_) {
+      info_.SetTypedMetadata(value);
+    }
+  }
+
+  void End() {
+    if (!open_) {
+      return;
+    }
+
+    open_           = false;
+    info_.ticks_end = Now();
+    Instance().Add(info_);
+  }
+
+  void Discard() {
+    if (!open_) {
+      return;
+    }
+
+    open_ = false;
+    Instance().GetSlotStorage()->Release(info_.metadata_ptr);
+    info_.metadata_ptr = nullptr;
+  }
+
+  //
+  // Spans inherit the flow current on the thread that begins them; this
+  // overrides it, e.g. once the request they time has been given an id.
+  //
+
+  void SetFlow(uint64_t flow) {
+    info_.flow = flow;
+  }
+
+  bool Open() const {
+    return open_;
+  }
+
+  explicit operator bool() const {
+    return open_;
+  }
+
+private:
+  void Begin(const char *name) {
+    const UncountedAllocations uncounted;
+
+    info_.tag          = ScopeTag{name};
+    info_.metadata_ptr = Instance().GetSlotStorage()->Acquire();
+    info_.flow         = GetScopeManager()->Flow();
+    open_              = true;
+
+    info_.ticks_start = Now();
+  }
+
+  ScopeInfo info_;
+  bool open_ = false;
+};
+
+}  // namespace rsp
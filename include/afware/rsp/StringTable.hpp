@@ -0,0 +1,202 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace rsp {
+
+//
+// Interned strings for string metadata.
+//
+// Strings of up to 8 bytes are stored inline in a metadata entry. Longer
+// ones are interned here once, process wide, and the entry carries the id;
+// sinks write each string out the first time it shows up in a frame or
+// block, so repeated values cost an id per record.
+//
+// Interning takes a shared lock and a hash of the string on every call. For
+// values known up front (symbol names, shard names), intern them once with
+// rsp::Intern() and pass the handle as metadata instead, which costs
+// nothing.
+//
+// Strings live for the life of the process. Past RSP_MAX_INTERNED_STRINGS
+// distinct strings, values are truncated to their first 8 bytes instead.
+//
+
+#if !defined(RSP_MAX_INTERNED_STRINGS)
+#define RSP_MAX_INTERNED_STRINGS (1 << 20)
+#endif
+
+struct InternedString {
+  uint32_t id = 0;
+};
+
+class StringTable {
+public:
+  static constexpr uint32_t kFull = UINT32_MAX;
+
+  static StringTable &Instance() {
+    //
+    // Never destroyed: the sink thread and the flight recorder's signal
+    // handlers may still be reading while statics are torn down.
+    //
+
+    static StringTable *table = new StringTable();
+    return *table;
+  }
+
+  //
+  // Returns the string's id, or kFull when the table is full.
+  //
+
+  uint32_t Intern(std::string_view s) {
+    {
+      const std::shared_lock lock{mutex_};
+      if (auto it = ids_.find(s); it != ids_.end()) {
+        return it->second;
+      }
+    }
+
+    const std::unique_lock lock{mutex_};
+    if (auto it = ids_.find(s); it != ids_.end()) {
+      return it->second;
+    }
+
+    const uint32_t id = size_.load(std::memory_order_relaxed);
+    if (id >= RSP_MAX_INTERNED_STRINGS) {
+      return kFull;
+    }
+
+    auto *chunk = chunks_[id / kChunkSize].load(std::memory_order_relaxed);
+    if (!chunk) {
+      chunk = new Entry[kChunkSize];
+      chunks_[id / kChunkSize].store(chunk, std::memory_order_release);
+    }
+
+    char *copy = new char[s.size() + 1];
+    std::memcpy(copy, s.data(), s.size());
+    copy[s.size()] = '\0';
+
+    chunk[id % kChunkSize] = Entry{copy, static_cast<uint32_t>(s.size())};
+    size_.store(id + 1, std::memory_order_release);
+    ids_.emplace(std::string_view{copy, s.size()}, id);
+
+    return id;
+  }
+
+  //
+  // The string for an id, or an empty view for an unknown one. Lock free,
+  // and safe from a signal handler.
+  //
+
+  std::string_view Get(uint32_t id) const {
+    if (id >= size_.load(std::memory_order_acquire)) {
+      return {};
+    }
+
+    const auto *chunk = chunks_[id / kChunkSize].load(std::memory_order_acquire);
+    return {chunk[id % kChunkSize].data, chunk[id % kChunkSize].len};
+  }
+
+  size_t Size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  //
+  // Held across fork() (see Profiler), so that a child never inherits the
+  // lock from a thread interning a string.
+  //
+
+  void LockForFork() {
+    mutex_.lock();
+  }
+
+  void UnlockAfterFork() {
+    mutex_.unlock();
+  }
+
+private:
+  StringTable() = default;
+
+  struct Entry {
+    const char *data = nullptr;
+    uint32_t len     = 0;
+  };
+
+  static constexpr size_t kChunkSize = 4096;
+  static constexpr size_t kChunks    = (RSP_MAX_INTERNED_STRINGS + kChunkSize - 1) / kChunkSize;
+
+  std::array<std::atomic<Entry *>, kChunks> chunks_ = {};
+  std::atomic<uint32_t> size_                       = 0;
+
+  std::shared_mutex mutex_;
+  std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+//
+// The ids a sink has already written out in the current frame or block.
+// Clear() only touches the ids that were set, so it's cheap per frame.
+//
+
+class StringIdSet {
+public:
+  //
+  // True if id wasn't in the set yet. Ids the table can't have handed out
+  // (StringTable::kFull) always are; they read back as empty strings.
+  //
+
+  bool Insert(uint32_t id) {
+    if (id >= RSP_MAX_INTERNED_STRINGS) {
+      return true;
+    }
+
+    const size_t word  = id / 64;
+    const uint64_t bit = uint64_t{1} << (id % 64);
+
+    if (word >= bits_.size()) {
+      bits_.resize(word + 1);
+    }
+    if (bits_[word] & bit) {
+      return false;
+    }
+
+    bits_[word] |= bit;
+    ids_.push_back(id);
+    return true;
+  }
+
+  void Clear() {
+    for (const uint32_t id : ids_) {
+      bits_[id / 64] = 0;
+    }
+    ids_.clear();
+  }
+
+private:
+  std::vector<uint64_t> bits_;
+  std::vector<uint32_t> ids_;
+};
+
+}  // namespace rsp
@@ -0,0 +1,221 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//
+// Where the sink thread runs.
+//
+// Left alone, the sink thread floats over every CPU the process may use:
+// including the cores latency critical threads are pinned to, and the
+// other socket's, from which it then pulls every record's cache lines. So
+// it can be confined to some CPUs, given a lower priority (or SCHED_IDLE,
+// to only ever run when a CPU has nothing else to do) and a name to find it
+// by in top and perf.
+//
+// On a multi-socket host it can also be split into one sink thread per
+// NUMA node. Each producer thread then enqueues to its own node's queue,
+// and that node's sink thread - kept on the node's CPUs - drains it, so
+// records don't cross the interconnect until they reach the sink. The
+// sinks themselves aren't thread safe, so the threads take turns with them.
+// For the disk, block and socket sinks each thread serializes (and
+// compresses) its node's records into frames or blocks of its own first,
+// and only takes its turn to write finished ones, so the encoding spreads
+// across the nodes too; other sinks get batches of records, a thread at a
+// time.
+//
+
+namespace rsp {
+
+struct SinkThreadOptions {
+  //
+  // At most 15 characters are kept. Sink threads for nodes after the first
+  // get "-n<node>" on the end.
+  //
+
+  std::string name = "rsp-sink";
+
+  //
+  // CPUs to keep the sink thread(s) on. Empty for no restriction.
+  //
+
+  std::vector<int> cpus;
+
+  //
+  // setpriority(2) value for the sink thread(s). Raising priority (a
+  // negative value) needs CAP_SYS_NICE.
+  //
+
+  std::optional<int> nice;
+
+  //
+  // Run under SCHED_IDLE.
+  //
+
+  bool idle = false;
+
+  //
+  // One sink thread per NUMA node, each on its node's CPUs (those of them
+  // in `cpus`, if any are). Has no effect on a single node host.
+  //
+
+  bool per_numa_node = false;
+};
+
+struct NumaNode {
+  int id = 0;
+  std::vector<int> cpus;
+};
+
+//
+// Parses a kernel CPU list, e.g. "0-3,8-11".
+//
+
+inline std::vector<int> ParseCpuList(const std::string &list) {
+  std::vector<int> cpus;
+
+  size_t at = 0;
+  while (at < list.size()) {
+    size_t end = list.find(',', at);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+
+    int first = 0;
+    int last  = 0;
+    switch (std::sscanf(list.substr(at, end - at).c_str(), "%d-%d", &first, &last)) {
+      case 1:
+        cpus.push_back(first);
+        break;
+      case 2:
+        for (int cpu = first; cpu <= last; ++cpu) {
+          cpus.push_back(cpu);
+        }
+        break;
+      default:
+        break;
+    }
+
+    at = end + 1;
+  }
+
+  return cpus;
+}
+
+//
+// The host's NUMA nodes with CPUs, from sysfs, in order of id. Empty where
+// sysfs doesn't say.
+//
+
+inline std::vector<NumaNode> NumaNodes() {
+  std::vector<NumaNode> nodes;
+
+  std::error_code ec;
+  for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+    const std::string name = entry.path().filename().string();
+
+    int id = 0;
+    if (std::sscanf(name.c_str(), "node%d", &id) != 1) {
+      continue;
+    }
+
+    std::ifstream in(entry.path() / "cpulist");
+    std::string list;
+    if (!std::getline(in, list)) {
+      continue;
+    }
+
+    NumaNode node;
+    node.id   = id;
+    node.cpus = ParseCpuList(list);
+    if (!node.cpus.empty()) {
+      nodes.push_back(std::move(node));
+    }
+  }
+
+  std::sort(nodes.begin(), nodes.end(), [](const NumaNode &a, const NumaNode &b) { return a.id < b.id; });
+  return nodes;
+}
+
+//
+// The node the calling thread is running on right now, or -1.
+//
+
+inline int CurrentNumaNode() {
+  unsigned cpu  = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+    return -1;
+  }
+  return static_cast<int>(node);
+}
+
+//
+// Applies a name, CPUs, nice value and scheduling class to the calling
+// thread. Everything that can be is applied; returns false if any of it
+// couldn't be.
+//
+
+inline bool PlaceCurrentThread(const std::string &name, const std::vector<int> &cpus, std::optional<int> nice,
+                               bool idle) {
+  bool ok = true;
+
+  if (!name.empty()) {
+    ok &= pthread_setname_np(pthread_self(), name.substr(0, 15).c_str()) == 0;
+  }
+
+  if (!cpus.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : cpus) {
+      if (cpu >= 0 && cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &set);
+      }
+    }
+    ok &= pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+  }
+
+  //
+  // On Linux, nice values are per thread.
+  //
+
+  if (nice) {
+    ok &= setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), *nice) == 0;
+  }
+
+  if (idle) {
+    sched_param param{};
+    ok &= pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) == 0;
+  }
+
+  return ok;
+}
+
+}  // namespace rsp
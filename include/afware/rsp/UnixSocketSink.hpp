@@ -0,0 +1,337 @@
+// Copyright © 2025, AFWare LLC <ajf@afware.io>
+//
+// Permission to use, copy, modify, and/or distribute this software
+// for any purpose with or without fee is hereby granted, provided
+// that the above copyright notice and this permission notice appear
+// in all copies.
+//
+// THE SOFTWARE IS PROVIDED “AS IS” AND ISC DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY
+// DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+// WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+// ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+// OF THIS SOFTWARE.
+
+#pragma once
+
+#include "CaptureFormat.hpp"
+#include "Machine.hpp"
+#include "Scope.hpp"
+#include "Serialization.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace rsp {
+
+//
+// A sink that streams records over a Unix domain socket to a collector on
+// the same machine (`rsp collect`), so many processes can feed one set of
+// captures without each writing its own.
+//
+// The stream is exactly a framed capture (see CaptureFormat.hpp): a header,
+// carrying our pid, then frames of records. Every batch from the sink
+// thread is sealed into frames straight away, so the collector is never
+// more than a batch behind.
+//
+// The socket is non-blocking. Frames the collector hasn't taken yet are
+// held, up to buffer_bytes; past that, new frames are dropped and counted
+// (DroppedRecords()). When there's no collector, or it goes away, we keep
+// buffering and try to connect again at most every reconnect_interval,
+// starting each connection with a fresh header. A frame cut short by a
+// disconnect is dropped, so every frame the collector sees is whole.
+//
+// On destruction, what's still buffered gets up to linger to go out.
+//
+
+#if !defined(RSP_UNIX_SOCKET_SINK_BUFFER)
+#define RSP_UNIX_SOCKET_SINK_BUFFER (16 * 1024 * 1024)
+#endif
+
+#if !defined(RSP_UNIX_SOCKET_SINK_RECONNECT_MS)
+#define RSP_UNIX_SOCKET_SINK_RECONNECT_MS 1000
+#endif
+
+#if !defined(RSP_UNIX_SOCKET_SINK_LINGER_MS)
+#define RSP_UNIX_SOCKET_SINK_LINGER_MS 1000
+#endif
+
+struct UnixSocketSinkOptions {
+  size_t frame_size                            = RSP_CAPTURE_FRAME_SIZE;
+  size_t buffer_bytes                          = RSP_UNIX_SOCKET_SINK_BUFFER;
+  std::chrono::milliseconds reconnect_interval = std::chrono::milliseconds{RSP_UNIX_SOCKET_SINK_RECONNECT_MS};
+  std::chrono::milliseconds linger             = std::chrono::milliseconds{RSP_UNIX_SOCKET_SINK_LINGER_MS};
+};
+
+class UnixSocketSink {
+public:
+  UnixSocketSink(std::filesystem::path path, Machine *machine, UnixSocketSinkOptions options = {})
+      : path_(std::move(path)), machine_(machine), options_(options), framer_(options.frame_size) {
+    header_ = MakeCaptureHeader(machine_);
+    Connect();
+  }
+
+  UnixSocketSink(const UnixSocketSink &)            = delete;
+  UnixSocketSink &operator=(const UnixSocketSink &) = delete;
+
+  ~UnixSocketSink() {
+    Seal();
+
+    const auto deadline = std::chrono::steady_clock::now() + options_.linger;
+    while (fd_ >= 0 && Pending()) {
+      const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline -
+                                                                              std::chrono::steady_clock::now());
+      if (left.count() <= 0) {
+        break;
+      }
+
+      pollfd p{fd_, POLLOUT, 0};
+      if (poll(&p, 1, static_cast<int>(left.count())) <= 0) {
+        break;
+      }
+      Send();
+    }
+
+    for (const auto &frame : frames_) {
+      dropped_ += frame.records;
+    }
+
+    Disconnect();
+  }
+
+  void SinkBatch(std::span<const ScopeInfo> batch) {
+    for (const auto &info : batch) {
+      const auto buf = SerializeScopeInfo(&info, machine_, framer_.Strings());
+      framer_.Add(buf.data(), static_cast<uint32_t>(buf.size()));
+      if (framer_.Full()) {
+        Seal();
+      }
+    }
+
+    Seal();
+    Flush();
+  }
+
+  //
+  // See SinkEncoded in Sinks.hpp.
+  //
+
+  using Encoder = FrameEncoder;
+
+  std::optional<Encoder> MakeEncoder() const {
+    return Encoder(machine_, options_.frame_size);
+  }
+
+  void SinkEncoded(std::span<const uint8_t> frame, uint32_t records) {
+    Queue(frame, records);
+    Flush();
+  }
+
+  //
+  // The socket path fitting in a sockaddr_un is all we can check up front:
+  // the collector may well start after us.
+  //
+
+  bool OK() const {
+    return !path_.empty() && path_.native().size() < sizeof(sockaddr_un::sun_path);
+  }
+
+  bool Connected() const {
+    return fd_ >= 0;
+  }
+
+  //
+  // Records dropped because the buffer was full, or their frame was cut
+  // short by a disconnect.
+  //
+
+  uint64_t DroppedRecords() const {
+    return dropped_;
+  }
+
+  uint64_t Connections() const {
+    return connections_;
+  }
+
+  uint64_t BytesSent() const {
+    return bytes_sent_;
+  }
+
+  size_t BufferedBytes() const {
+    return buffered_;
+  }
+
+  //
+  // A forked child gets a connection of its own, whose header carries its
+  // pid (see Profiler::EnableForkFollowing).
+  //
+
+  std::shared_ptr<UnixSocketSink> ReopenForProcess(pid_t) const {
+    return std::make_shared<UnixSocketSink>(path_, machine_, options_);
+  }
+
+private:
+  struct Frame {
+    std::vector<uint8_t> bytes;
+    uint32_t records = 0;
+    size_t sent      = 0;
+  };
+
+  bool Pending() const {
+    return header_sent_ < header_.size() || !frames_.empty();
+  }
+
+  //
+  // Queues the partial frame, if any.
+  //
+
+  void Seal() {
+    if (framer_.Empty()) {
+      return;
+    }
+
+    Queue(framer_.Seal(), framer_.Count());
+    framer_.Clear();
+  }
+
+  void Queue(std::span<const uint8_t> sealed, uint32_t records) {
+    if (buffered_ + sealed.size() > options_.buffer_bytes) {
+      dropped_ += records;
+    } else {
+      frames_.push_back(Frame{std::vector<uint8_t>(sealed.begin(), sealed.end()), records, 0});
+      buffered_ += sealed.size();
+    }
+  }
+
+  //
+  // Sends what's queued, reconnecting first if it's time to.
+  //
+
+  void Flush() {
+    if (fd_ < 0 && std::chrono::steady_clock::now() >= next_connect_) {
+      Connect();
+    }
+    Send();
+  }
+
+  void Connect() {
+    next_connect_ = std::chrono::steady_clock::now() + options_.reconnect_interval;
+    if (!OK()) {
+      return;
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      return;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path_.c_str(), path_.native().size());
+
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+      close(fd);
+      return;
+    }
+
+    fd_          = fd;
+    header_sent_ = 0;
+    ++connections_;
+  }
+
+  void Disconnect() {
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+
+    if (!frames_.empty() && frames_.front().sent > 0) {
+      dropped_ += frames_.front().records;
+      buffered_ -= frames_.front().bytes.size();
+      frames_.pop_front();
+    }
+  }
+
+  //
+  // Writes as much as the socket takes without blocking.
+  //
+
+  void Send() {
+    while (fd_ >= 0 && Pending()) {
+      const bool header = header_sent_ < header_.size();
+      const uint8_t *data;
+      size_t len;
+
+      if (header) {
+        data = header_.data() + header_sent_;
+        len  = header_.size() - header_sent_;
+      } else {
+        data = frames_.front().bytes.data() + frames_.front().sent;
+        len  = frames_.front().bytes.size() - frames_.front().sent;
+      }
+
+      const ssize_t n = send(fd_, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          Disconnect();
+        }
+        return;
+      }
+
+      bytes_sent_ += static_cast<uint64_t>(n);
+
+      if (header) {
+        header_sent_ += static_cast<size_t>(n);
+        continue;
+      }
+
+      auto &frame = frames_.front();
+      frame.sent += static_cast<size_t>(n);
+      if (frame.sent == frame.bytes.size()) {
+        buffered_ -= frame.bytes.size();
+        frames_.pop_front();
+      }
+    }
+  }
+
+  std::filesystem::path path_;
+  Machine *machine_;
+  UnixSocketSinkOptions options_;
+  CaptureFramer framer_;
+
+  std::vector<uint8_t> header_;
+  size_t header_sent_ = 0;
+
+  std::deque<Frame> frames_;
+  size_t buffered_ = 0;
+
+  int fd_ = -1;
+  std::chrono::steady_clock::time_point next_connect_;
+
+  uint64_t dropped_     = 0;
+  uint64_t connections_ = 0;
+  uint64_t bytes_sent_  = 0;
+};
+
+}  // namespace rsp
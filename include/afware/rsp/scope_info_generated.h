@@ -33,11 +33,13 @@ enum MetadataType : int8_t {
   MetadataType_UINT64 = 8,
   MetadataType_FLOAT = 9,
   MetadataType_DOUBLE = 10,
+  MetadataType_STRING = 11,
+  MetadataType_STRING_ID = 12,
   MetadataType_MIN = MetadataType_UNSET,
-  MetadataType_MAX = MetadataType_DOUBLE
+  MetadataType_MAX = MetadataType_STRING_ID
 };
 
-inline const MetadataType (&EnumValuesMetadataType())[11] {
+inline const MetadataType (&EnumValuesMetadataType())[13] {
   static const MetadataType values[] = {
     MetadataType_UNSET,
     MetadataType_INT8,
@@ -49,13 +51,15 @@ inline const MetadataType (&EnumValuesMetadataType())[11] {
     MetadataType_INT64,
     MetadataType_UINT64,
     MetadataType_FLOAT,
-    MetadataType_DOUBLE
+    MetadataType_DOUBLE,
+    MetadataType_STRING,
+    MetadataType_STRING_ID
   };
   return values;
 }
 
 inline const char * const *EnumNamesMetadataType() {
-  static const char * const names[12] = {
+  static const char * const names[14] = {
     "UNSET",
     "INT8",
     "UINT8",
@@ -67,23 +71,62 @@ inline const char * const *EnumNamesMetadataType() {
     "UINT64",
     "FLOAT",
     "DOUBLE",
+    "STRING",
+    "STRING_ID",
     nullptr
   };
   return names;
 }
 
 inline const char *EnumNameMetadataType(MetadataType e) {
-  if (::flatbuffers::IsOutRange(e, MetadataType_UNSET, MetadataType_DOUBLE)) return "";
+  if (::flatbuffers::IsOutRange(e, MetadataType_UNSET, MetadataType_STRING_ID)) return "";
   const size_t index = static_cast<size_t>(e);
   return EnumNamesMetadataType()[index];
 }
 
+enum RecordKind : uint8_t {
+  RecordKind_SCOPE = 0,
+  RecordKind_COUNTER = 1,
+  RecordKind_GAUGE = 2,
+  RecordKind_INSTANT = 3,
+  RecordKind_MIN = RecordKind_SCOPE,
+  RecordKind_MAX = RecordKind_INSTANT
+};
+
+inline const RecordKind (&EnumValuesRecordKind())[4] {
+  static const RecordKind values[] = {
+    RecordKind_SCOPE,
+    RecordKind_COUNTER,
+    RecordKind_GAUGE,
+    RecordKind_INSTANT
+  };
+  return values;
+}
+
+inline const char * const *EnumNamesRecordKind() {
+  static const char * const names[5] = {
+    "SCOPE",
+    "COUNTER",
+    "GAUGE",
+    "INSTANT",
+    nullptr
+  };
+  return names;
+}
+
+inline const char *EnumNameRecordKind(RecordKind e) {
+  if (::flatbuffers::IsOutRange(e, RecordKind_SCOPE, RecordKind_INSTANT)) return "";
+  const size_t index = static_cast<size_t>(e);
+  return EnumNamesRecordKind()[index];
+}
+
 struct MetadataEntry FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   typedef MetadataEntryBuilder Builder;
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
     VT_TAG = 4,
     VT_TYPE = 6,
-    VT_VALUE = 8
+    VT_VALUE = 8,
+    VT_TEXT = 10
   };
   const ::flatbuffers::String *tag() const {
     return GetPointer<const ::flatbuffers::String *>(VT_TAG);
@@ -94,12 +137,17 @@ struct MetadataEntry FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   uint64_t value() const {
     return GetField<uint64_t>(VT_VALUE, 0);
   }
+  const ::flatbuffers::String *text() const {
+    return GetPointer<const ::flatbuffers::String *>(VT_TEXT);
+  }
   bool Verify(::flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyOffset(verifier, VT_TAG) &&
            verifier.VerifyString(tag()) &&
            VerifyField<int8_t>(verifier, VT_TYPE, 1) &&
            VerifyField<uint64_t>(verifier, VT_VALUE, 8) &&
+           VerifyOffset(verifier, VT_TEXT) &&
+           verifier.VerifyString(text()) &&
            verifier.EndTable();
   }
 };
@@ -117,6 +165,9 @@ struct MetadataEntryBuilder {
   void add_value(uint64_t value) {
     fbb_.AddElement<uint64_t>(MetadataEntry::VT_VALUE, value, 0);
   }
+  void add_text(::flatbuffers::Offset<::flatbuffers::String> text) {
+    fbb_.AddOffset(MetadataEntry::VT_TEXT, text);
+  }
   explicit MetadataEntryBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -132,9 +183,11 @@ inline ::flatbuffers::Offset<MetadataEntry> CreateMetadataEntry(
     ::flatbuffers::FlatBufferBuilder &_fbb,
     ::flatbuffers::Offset<::flatbuffers::String> tag = 0,
     RSP::MetadataType type = RSP::MetadataType_UNSET,
-    uint64_t value = 0) {
+    uint64_t value = 0,
+    ::flatbuffers::Offset<::flatbuffers::String> text = 0) {
   MetadataEntryBuilder builder_(_fbb);
   builder_.add_value(value);
+  builder_.add_text(text);
   builder_.add_tag(tag);
   builder_.add_type(type);
   return builder_.Finish();
@@ -144,13 +197,16 @@ inline ::flatbuffers::Offset<MetadataEntry> CreateMetadataEntryDirect(
     ::flatbuffers::FlatBufferBuilder &_fbb,
     const char *tag = nullptr,
     RSP::MetadataType type = RSP::MetadataType_UNSET,
-    uint64_t value = 0) {
+    uint64_t value = 0,
+    const char *text = nullptr) {
   auto tag__ = tag ? _fbb.CreateString(tag) : 0;
+  auto text__ = text ? _fbb.CreateString(text) : 0;
   return RSP::CreateMetadataEntry(
       _fbb,
       tag__,
       type,
-      value);
+      value,
+      text__);
 }
 
 struct ScopeInfo FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
@@ -162,7 +218,24 @@ struct ScopeInfo FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
     VT_MACHINE_NOMINAL_FREQ_HZ = 10,
     VT_MAX_BUFFER_SIZE = 12,
     VT_MAX_OFFSET = 14,
-    VT_METADATA = 16
+    VT_METADATA = 16,
+    VT_KIND = 18,
+    VT_VALUE = 20,
+    VT_FLOW = 22,
+    VT_PERF_CYCLES = 24,
+    VT_PERF_INSTRUCTIONS = 26,
+    VT_PERF_LLC_MISSES = 28,
+    VT_PERF_BRANCH_MISSES = 30,
+    VT_ALLOCS_TRACKED = 32,
+    VT_ALLOC_COUNT = 34,
+    VT_ALLOC_BYTES = 36,
+    VT_ALLOC_SELF_COUNT = 38,
+    VT_ALLOC_SELF_BYTES = 40,
+    VT_RUSAGE_SAMPLED = 42,
+    VT_VOLUNTARY_SWITCHES = 44,
+    VT_INVOLUNTARY_SWITCHES = 46,
+    VT_MINOR_FAULTS = 48,
+    VT_MAJOR_FAULTS = 50
   };
   const ::flatbuffers::String *tag() const {
     return GetPointer<const ::flatbuffers::String *>(VT_TAG);
@@ -185,6 +258,57 @@ struct ScopeInfo FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
   const ::flatbuffers::Vector<::flatbuffers::Offset<RSP::MetadataEntry>> *metadata() const {
     return GetPointer<const ::flatbuffers::Vector<::flatbuffers::Offset<RSP::MetadataEntry>> *>(VT_METADATA);
   }
+  RSP::RecordKind kind() const {
+    return static_cast<RSP::RecordKind>(GetField<uint8_t>(VT_KIND, 0));
+  }
+  uint64_t value() const {
+    return GetField<uint64_t>(VT_VALUE, 0);
+  }
+  uint64_t flow() const {
+    return GetField<uint64_t>(VT_FLOW, 0);
+  }
+  uint64_t perf_cycles() const {
+    return GetField<uint64_t>(VT_PERF_CYCLES, 0);
+  }
+  uint64_t perf_instructions() const {
+    return GetField<uint64_t>(VT_PERF_INSTRUCTIONS, 0);
+  }
+  uint64_t perf_llc_misses() const {
+    return GetField<uint64_t>(VT_PERF_LLC_MISSES, 0);
+  }
+  uint64_t perf_branch_misses() const {
+    return GetField<uint64_t>(VT_PERF_BRANCH_MISSES, 0);
+  }
+  bool allocs_tracked() const {
+    return GetField<uint8_t>(VT_ALLOCS_TRACKED, 0) != 0;
+  }
+  uint64_t alloc_count() const {
+    return GetField<uint64_t>(VT_ALLOC_COUNT, 0);
+  }
+  uint64_t alloc_bytes() const {
+    return GetField<uint64_t>(VT_ALLOC_BYTES, 0);
+  }
+  uint64_t alloc_self_count() const {
+    return GetField<uint64_t>(VT_ALLOC_SELF_COUNT, 0);
+  }
+  uint64_t alloc_self_bytes() const {
+    return GetField<uint64_t>(VT_ALLOC_SELF_BYTES, 0);
+  }
+  bool rusage_sampled() const {
+    return GetField<uint8_t>(VT_RUSAGE_SAMPLED, 0) != 0;
+  }
+  uint64_t voluntary_switches() const {
+    return GetField<uint64_t>(VT_VOLUNTARY_SWITCHES, 0);
+  }
+  uint64_t involuntary_switches() const {
+    return GetField<uint64_t>(VT_INVOLUNTARY_SWITCHES, 0);
+  }
+  uint64_t minor_faults() const {
+    return GetField<uint64_t>(VT_MINOR_FAULTS, 0);
+  }
+  uint64_t major_faults() const {
+    return GetField<uint64_t>(VT_MAJOR_FAULTS, 0);
+  }
   bool Verify(::flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyOffset(verifier, VT_TAG) &&
@@ -197,6 +321,23 @@ struct ScopeInfo FLATBUFFERS_FINAL_CLASS : private ::flatbuffers::Table {
            VerifyOffset(verifier, VT_METADATA) &&
            verifier.VerifyVector(metadata()) &&
            verifier.VerifyVectorOfTables(metadata()) &&
+           VerifyField<uint8_t>(verifier, VT_KIND, 1) &&
+           VerifyField<uint64_t>(verifier, VT_VALUE, 8) &&
+           VerifyField<uint64_t>(verifier, VT_FLOW, 8) &&
+           VerifyField<uint64_t>(verifier, VT_PERF_CYCLES, 8) &&
+           VerifyField<uint64_t>(verifier, VT_PERF_INSTRUCTIONS, 8) &&
+           VerifyField<uint64_t>(verifier, VT_PERF_LLC_MISSES, 8) &&
+           VerifyField<uint64_t>(verifier, VT_PERF_BRANCH_MISSES, 8) &&
+           VerifyField<uint8_t>(verifier, VT_ALLOCS_TRACKED, 1) &&
+           VerifyField<uint64_t>(verifier, VT_ALLOC_COUNT, 8) &&
+           VerifyField<uint64_t>(verifier, VT_ALLOC_BYTES, 8) &&
+           VerifyField<uint64_t>(verifier, VT_ALLOC_SELF_COUNT, 8) &&
+           VerifyField<uint64_t>(verifier, VT_ALLOC_SELF_BYTES, 8) &&
+           VerifyField<uint8_t>(verifier, VT_RUSAGE_SAMPLED, 1) &&
+           VerifyField<uint64_t>(verifier, VT_VOLUNTARY_SWITCHES, 8) &&
+           VerifyField<uint64_t>(verifier, VT_INVOLUNTARY_SWITCHES, 8) &&
+           VerifyField<uint64_t>(verifier, VT_MINOR_FAULTS, 8) &&
+           VerifyField<uint64_t>(verifier, VT_MAJOR_FAULTS, 8) &&
            verifier.EndTable();
   }
 };
@@ -226,6 +367,57 @@ struct ScopeInfoBuilder {
   void add_metadata(::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<RSP::MetadataEntry>>> metadata) {
     fbb_.AddOffset(ScopeInfo::VT_METADATA, metadata);
   }
+  void add_kind(RSP::RecordKind kind) {
+    fbb_.AddElement<uint8_t>(ScopeInfo::VT_KIND, static_cast<uint8_t>(kind), 0);
+  }
+  void add_value(uint64_t value) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_VALUE, value, 0);
+  }
+  void add_flow(uint64_t flow) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_FLOW, flow, 0);
+  }
+  void add_perf_cycles(uint64_t perf_cycles) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_PERF_CYCLES, perf_cycles, 0);
+  }
+  void add_perf_instructions(uint64_t perf_instructions) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_PERF_INSTRUCTIONS, perf_instructions, 0);
+  }
+  void add_perf_llc_misses(uint64_t perf_llc_misses) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_PERF_LLC_MISSES, perf_llc_misses, 0);
+  }
+  void add_perf_branch_misses(uint64_t perf_branch_misses) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_PERF_BRANCH_MISSES, perf_branch_misses, 0);
+  }
+  void add_allocs_tracked(bool allocs_tracked) {
+    fbb_.AddElement<uint8_t>(ScopeInfo::VT_ALLOCS_TRACKED, static_cast<uint8_t>(allocs_tracked), 0);
+  }
+  void add_alloc_count(uint64_t alloc_count) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_ALLOC_COUNT, alloc_count, 0);
+  }
+  void add_alloc_bytes(uint64_t alloc_bytes) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_ALLOC_BYTES, alloc_bytes, 0);
+  }
+  void add_alloc_self_count(uint64_t alloc_self_count) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_ALLOC_SELF_COUNT, alloc_self_count, 0);
+  }
+  void add_alloc_self_bytes(uint64_t alloc_self_bytes) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_ALLOC_SELF_BYTES, alloc_self_bytes, 0);
+  }
+  void add_rusage_sampled(bool rusage_sampled) {
+    fbb_.AddElement<uint8_t>(ScopeInfo::VT_RUSAGE_SAMPLED, static_cast<uint8_t>(rusage_sampled), 0);
+  }
+  void add_voluntary_switches(uint64_t voluntary_switches) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_VOLUNTARY_SWITCHES, voluntary_switches, 0);
+  }
+  void add_involuntary_switches(uint64_t involuntary_switches) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_INVOLUNTARY_SWITCHES, involuntary_switches, 0);
+  }
+  void add_minor_faults(uint64_t minor_faults) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_MINOR_FAULTS, minor_faults, 0);
+  }
+  void add_major_faults(uint64_t major_faults) {
+    fbb_.AddElement<uint64_t>(ScopeInfo::VT_MAJOR_FAULTS, major_faults, 0);
+  }
   explicit ScopeInfoBuilder(::flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -245,15 +437,49 @@ inline ::flatbuffers::Offset<ScopeInfo> CreateScopeInfo(
     uint64_t machine_nominal_freq_hz = 0,
     uint64_t max_buffer_size = 0,
     uint8_t max_offset = 0,
-    ::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<RSP::MetadataEntry>>> metadata = 0) {
+    ::flatbuffers::Offset<::flatbuffers::Vector<::flatbuffers::Offset<RSP::MetadataEntry>>> metadata = 0,
+    RSP::RecordKind kind = RSP::RecordKind_SCOPE,
+    uint64_t value = 0,
+    uint64_t flow = 0,
+    uint64_t perf_cycles = 0,
+    uint64_t perf_instructions = 0,
+    uint64_t perf_llc_misses = 0,
+    uint64_t perf_branch_misses = 0,
+    bool allocs_tracked = false,
+    uint64_t alloc_count = 0,
+    uint64_t alloc_bytes = 0,
+    uint64_t alloc_self_count = 0,
+    uint64_t alloc_self_bytes = 0,
+    bool rusage_sampled = false,
+    uint64_t voluntary_switches = 0,
+    uint64_t involuntary_switches = 0,
+    uint64_t minor_faults = 0,
+    uint64_t major_faults = 0) {
   ScopeInfoBuilder builder_(_fbb);
+  builder_.add_major_faults(major_faults);
+  builder_.add_minor_faults(minor_faults);
+  builder_.add_involuntary_switches(involuntary_switches);
+  builder_.add_voluntary_switches(voluntary_switches);
+  builder_.add_alloc_self_bytes(alloc_self_bytes);
+  builder_.add_alloc_self_count(alloc_self_count);
+  builder_.add_alloc_bytes(alloc_bytes);
+  builder_.add_alloc_count(alloc_count);
+  builder_.add_perf_branch_misses(perf_branch_misses);
+  builder_.add_perf_llc_misses(perf_llc_misses);
+  builder_.add_perf_instructions(perf_instructions);
+  builder_.add_perf_cycles(perf_cycles);
+  builder_.add_flow(flow);
+  builder_.add_value(value);
   builder_.add_max_buffer_size(max_buffer_size);
   builder_.add_machine_nominal_freq_hz(machine_nominal_freq_hz);
   builder_.add_ticks_end(ticks_end);
   builder_.add_ticks_start(ticks_start);
   builder_.add_metadata(metadata);
   builder_.add_tag(tag);
+  builder_.add_kind(kind);
   builder_.add_max_offset(max_offset);
+  builder_.add_rusage_sampled(rusage_sampled);
+  builder_.add_allocs_tracked(allocs_tracked);
   return builder_.Finish();
 }
 
@@ -265,7 +491,24 @@ inline ::flatbuffers::Offset<ScopeInfo> CreateScopeInfoDirect(
     uint64_t machine_nominal_freq_hz = 0,
     uint64_t max_buffer_size = 0,
     uint8_t max_offset = 0,
-    const std::vector<::flatbuffers::Offset<RSP::MetadataEntry>> *metadata = nullptr) {
+    const std::vector<::flatbuffers::Offset<RSP::MetadataEntry>> *metadata = nullptr,
+    RSP::RecordKind kind = RSP::RecordKind_SCOPE,
+    uint64_t value = 0,
+    uint64_t flow = 0,
+    uint64_t perf_cycles = 0,
+    uint64_t perf_instructions = 0,
+    uint64_t perf_llc_misses = 0,
+    uint64_t perf_branch_misses = 0,
+    bool allocs_tracked = false,
+    uint64_t alloc_count = 0,
+    uint64_t alloc_bytes = 0,
+    uint64_t alloc_self_count = 0,
+    uint64_t alloc_self_bytes = 0,
+    bool rusage_sampled = false,
+    uint64_t voluntary_switches = 0,
+    uint64_t involuntary_switches = 0,
+    uint64_t minor_faults = 0,
+    uint64_t major_faults = 0) {
   auto tag__ = tag ? _fbb.CreateString(tag) : 0;
   auto metadata__ = metadata ? _fbb.CreateVector<::flatbuffers::Offset<RSP::MetadataEntry>>(*metadata) : 0;
   return RSP::CreateScopeInfo(
@@ -276,7 +519,24 @@ inline ::flatbuffers::Offset<ScopeInfo> CreateScopeInfoDirect(
       machine_nominal_freq_hz,
       max_buffer_size,
       max_offset,
-      metadata__);
+      metadata__,
+      kind,
+      value,
+      flow,
+      perf_cycles,
+      perf_instructions,
+      perf_llc_misses,
+      perf_branch_misses,
+      allocs_tracked,
+      alloc_count,
+      alloc_bytes,
+      alloc_self_count,
+      alloc_self_bytes,
+      rusage_sampled,
+      voluntary_switches,
+      involuntary_switches,
+      minor_faults,
+      major_faults);
 }
 
 inline const RSP::ScopeInfo *GetScopeInfo(const void *buf) {